@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <functional>
 #include <iostream>
 
 #ifdef _WIN32
@@ -32,6 +33,19 @@
 #include "paddle/fluid/distributed/collective/process_group_gloo.h"
 #include "paddle/fluid/framework/fleet/gloo_wrapper.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_bool(
+    gloo_shm_transport,
+    false,
+    "Run the Gloo AllReduce, Broadcast and AllGather among the ranks on a "
+    "host by shared memory, and among the hosts by Gloo between one leader "
+    "rank of every host.");
+PADDLE_DEFINE_EXPORTED_int64(
+    gloo_shm_slot_mb,
+    4,
+    "The size in MB of the shared memory of every rank for "
+    "FLAGS_gloo_shm_transport, larger collectives run in chunks of it.");
 
 namespace paddle {
 namespace distributed {
@@ -189,8 +203,77 @@ ProcessGroupGloo::ProcessGroupGloo(
   auto prefix_store =
       ::gloo::rendezvous::PrefixStore(std::to_string(gid), *_store);
   _context->connectFullMesh(prefix_store, options->device);
+  if (FLAGS_gloo_shm_transport) {
+    CreateShmCommunicator(store, gid, options);
+  }
+}
+
+template <typename T>
+void leader_allreduce(const std::shared_ptr<gloo::Context>& context,
+                      void* data,
+                      size_t count,
+                      ReduceOp op,
+                      uint32_t tag) {
+  gloo::AllreduceOptions opts(context);
+  opts.setOutput(reinterpret_cast<T*>(data), count);
+  opts.setReduceFunction(get_function<T>(op));
+  opts.setTag(tag);
+  gloo::allreduce(opts);
+}
+
+void ProcessGroupGloo::CreateShmCommunicator(
+    const std::shared_ptr<phi::distributed::Store>& store,
+    int gid,
+    const std::shared_ptr<GlooOptions>& options) {
+  _shm = ShmCommunicator::Create(
+      store, rank_, size_, gid, FLAGS_gloo_shm_slot_mb << 20);
+  if (_shm == nullptr) {
+    return;
+  }
+  _shm->SetTimeout(_context->getTimeout());
+  if (_shm->single_host() || !_shm->is_leader()) {
+    return;
+  }
+  _leader_context = std::make_shared<gloo::rendezvous::Context>(
+      _shm->host_index(), _shm->num_hosts());
+  auto prefix_store = ::gloo::rendezvous::PrefixStore(
+      std::to_string(gid) + "/shm_leaders", *_store);
+  _leader_context->connectFullMesh(prefix_store, options->device);
+  _shm->SetLeaderCollectives(
+      [this](void* data, size_t count, phi::DataType dtype, ReduceOp op) {
+        GENERATE_FUNC(dtype,
+                      leader_allreduce,
+                      _leader_context,
+                      data,
+                      count,
+                      op,
+                      _leader_tag++);
+      },
+      [this](void* data, size_t bytes, int root_host) {
+        gloo::BroadcastOptions opts(_leader_context);
+        opts.setOutput(reinterpret_cast<uint8_t*>(data), bytes);
+        opts.setRoot(root_host);
+        opts.setTag(_leader_tag++);
+        gloo::broadcast(opts);
+      });
 }
 
+// Runs a collective by the shared memory communicator.
+class ShmGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  ShmGlooTask(int rank,
+              const std::vector<phi::DenseTensor>& inputs,
+              CommType comm_type,
+              std::function<void()> fn)
+      : ProcessGroupGloo::GlooTask(rank, inputs, comm_type),
+        _fn(std::move(fn)) {}
+
+  void Run() override { _fn(); }
+
+ private:
+  std::function<void()> _fn;
+};
+
 class BroadcastGlooTask : public ProcessGroupGloo::GlooTask {
  public:
   BroadcastGlooTask(const std::shared_ptr<gloo::Context>& context,
@@ -252,6 +335,20 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Broadcast(
     const BroadcastOptions& opts,
     bool sync_op) {
   auto root = opts.source_rank;
+  if (_shm != nullptr && inputs.size() == 1 && outputs.size() == 1) {
+    auto task = std::make_shared<ShmGlooTask>(
+        rank_,
+        inputs,
+        CommType::BROADCAST,
+        [shm = _shm.get(), in = inputs[0], out = outputs[0], root]() mutable {
+          shm->Broadcast(in.data(),
+                         out.data(),
+                         out.numel() * phi::SizeOf(out.dtype()),
+                         root);
+        });
+    task->Run();
+    return task;
+  }
   std::unique_ptr<BroadcastGlooTask> task;
   auto tag = next_tag();
   auto context = get_context();
@@ -332,6 +429,23 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     std::vector<phi::DenseTensor>& outputs,
     const AllreduceOptions& opts,
     bool sync_op) {
+  if (_shm != nullptr && inputs.size() == 1 && outputs.size() == 1 &&
+      ShmCommunicator::IsSupported(inputs[0].dtype()) &&
+      opts.reduce_op != ReduceOp::AVG) {
+    auto task = std::make_shared<ShmGlooTask>(
+        rank_,
+        inputs,
+        CommType::ALLREDUCE,
+        [shm = _shm.get(),
+         in = inputs[0],
+         out = outputs[0],
+         reduce_op = opts.reduce_op]() mutable {
+          shm->AllReduce(
+              in.data(), out.data(), in.numel(), in.dtype(), reduce_op);
+        });
+    task->Run();
+    return task;
+  }
   auto tag = next_tag();
   std::shared_ptr<GlooTask> task;
   auto context = get_context();
@@ -421,6 +535,19 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllGather(
     std::vector<phi::DenseTensor>& in_tensors,
     std::vector<phi::DenseTensor>& out_tensors,
     bool sync_op) {
+  if (_shm != nullptr && _shm->single_host() && in_tensors.size() == 1 &&
+      out_tensors.size() == 1) {
+    auto task = std::make_shared<ShmGlooTask>(
+        rank_,
+        in_tensors,
+        CommType::ALLGATHER,
+        [shm = _shm.get(), in = in_tensors[0], out = out_tensors[0]]() mutable {
+          shm->AllGather(
+              in.data(), out.data(), in.numel() * phi::SizeOf(in.dtype()));
+        });
+    task->Run();
+    return task;
+  }
   std::shared_ptr<AllgatherGlooTask> task;
   auto tag = next_tag();
   auto context = get_context();
@@ -20,6 +20,7 @@
 
 #include "paddle/fluid/distributed/collective/process_group.h"
 #include "paddle/fluid/distributed/collective/process_group_without_stream.h"
+#include "paddle/fluid/distributed/collective/shm_communicator.h"
 #include "paddle/phi/core/distributed/store/store.h"
 #include "paddle/phi/core/distributed/store/tcp_store.h"
 
@@ -204,9 +205,21 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
   static std::shared_ptr<::gloo::transport::Device> createDefaultDevice();
 
  private:
+  void CreateShmCommunicator(
+      const std::shared_ptr<phi::distributed::Store>& store,
+      int gid,
+      const std::shared_ptr<GlooOptions>& options);
+
   uint32_t _tag;
   std::shared_ptr<gloo::rendezvous::Context> _context;
   std::shared_ptr<::gloo::rendezvous::Store> _store;
+  // Runs the collectives among the ranks on a host by shared memory, if
+  // FLAGS_gloo_shm_transport is set.
+  std::unique_ptr<ShmCommunicator> _shm;
+  // The context of the leaders of the hosts, for the collectives among the
+  // hosts of _shm. Only set on the leaders.
+  std::shared_ptr<gloo::rendezvous::Context> _leader_context;
+  uint32_t _leader_tag{0};
 };
 
 }  // namespace distributed
@@ -13,17 +13,47 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/collective/reducer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <numeric>
+
 #include "paddle/phi/backends/device_guard.h"
 #include "paddle/phi/backends/device_manager.h"
+#include "paddle/phi/core/flags.h"
 
 DECLARE_bool(use_stream_safe_cuda_allocator);
 DECLARE_string(allocator_strategy);
 
+PADDLE_DEFINE_EXPORTED_int64(
+    eager_reducer_rebuild_steps,
+    0,
+    "If greater than 0, the DataParallel reducer records the time the grad "
+    "of every parameter is ready in this many steps, and then regroups the "
+    "parameters in the order their grads are ready on all the ranks, so that "
+    "every group is allreduced as early as possible. Not used with "
+    "find_unused_parameters=True.");
+PADDLE_DEFINE_EXPORTED_bool(
+    eager_reducer_cpu_comm_overlap,
+    false,
+    "If true, the DataParallel reducer of CPU parameters copies every grad "
+    "to its group as soon as it is ready, and allreduces the groups in "
+    "chunks on a thread of its own, overlapped with the rest of backward. "
+    "The grads are then views of the groups, so neither concat nor split is "
+    "needed. Not used with sparse grads.");
+PADDLE_DEFINE_EXPORTED_int64(
+    eager_reducer_chunk_size_kb,
+    1024,
+    "The size in KB of the chunks allreduced by "
+    "FLAGS_eager_reducer_cpu_comm_overlap.");
+
 namespace paddle {
 namespace distributed {
 
 static bool IsStreamSafeAllocator() {
-  return FLAGS_allocator_strategy == "auto_growth" &&
+  return (FLAGS_allocator_strategy == "auto_growth" ||
+          FLAGS_allocator_strategy == "size_class") &&
          FLAGS_use_stream_safe_cuda_allocator;
 }
 
@@ -476,6 +506,16 @@ EagerReducer::EagerReducer(
 
   nranks_ = process_group_->GetSize();
 
+  use_bucket_view_ =
+      FLAGS_eager_reducer_cpu_comm_overlap && !tensors_.empty() &&
+      platform::is_cpu_place(tensors_.front().place()) &&
+      std::none_of(is_sparse_gradient_.begin(),
+                   is_sparse_gradient_.end(),
+                   [](bool is_sparse) { return is_sparse; });
+  if (use_bucket_view_) {
+    comm_pool_.reset(new phi::ThreadPool(1));
+  }
+
   // initialize groups
   InitializeGroups(group_indices);
 
@@ -504,6 +544,11 @@ EagerReducer::EagerReducer(
   vars_marked_ready_.resize(tensors_.size(), false);
   local_used_vars_.resize(tensors_.size(), 0);
 
+  if (!find_unused_vars_each_step_) {
+    rebuild_steps_ = FLAGS_eager_reducer_rebuild_steps;
+    ready_time_us_.resize(tensors_.size(), 0);
+  }
+
   if (find_unused_vars_each_step_) {
     global_used_vars_ = paddle::experimental::empty(
         IntArray({static_cast<int32_t>(tensors_.size())}),
@@ -616,6 +661,51 @@ void EagerReducer::InitializeDenseGroups(
     }
   }
   p_group->all_length_ = all_length;
+
+  if (use_bucket_view_) {
+    InitializeBucketView(p_group);
+  }
+}
+
+void EagerReducer::InitializeBucketView(EagerGroup *p_group) {
+  p_group->dense_contents_ = paddle::experimental::empty(
+      IntArray({p_group->all_length_}), p_group->dtype_, inner_place_);
+
+  p_group->offsets_.clear();
+  int64_t offset = 0;
+  for (auto length : p_group->length_) {
+    p_group->offsets_.push_back(offset);
+    offset += length;
+  }
+
+  int64_t chunk_length = std::max<int64_t>(
+      1,
+      FLAGS_eager_reducer_chunk_size_kb * 1024 /
+          static_cast<int64_t>(experimental::SizeOf(p_group->dtype_)));
+  p_group->chunk_ends_.clear();
+  for (int64_t end = chunk_length; end < p_group->all_length_;
+       end += chunk_length) {
+    p_group->chunk_ends_.push_back(end);
+  }
+  p_group->chunk_ends_.push_back(p_group->all_length_);
+
+  p_group->chunk_num_tensors_.assign(p_group->chunk_ends_.size(), 0);
+  for (size_t index = 0; index < p_group->length_.size(); ++index) {
+    int64_t begin = p_group->offsets_[index];
+    int64_t end = begin + p_group->length_[index];
+    size_t chunk = std::upper_bound(p_group->chunk_ends_.begin(),
+                                    p_group->chunk_ends_.end(),
+                                    begin) -
+                   p_group->chunk_ends_.begin();
+    for (; chunk < p_group->chunk_ends_.size(); ++chunk) {
+      ++p_group->chunk_num_tensors_[chunk];
+      if (p_group->chunk_ends_[chunk] >= end) {
+        break;
+      }
+    }
+  }
+  p_group->chunk_pending_ = p_group->chunk_num_tensors_;
+  p_group->next_chunk_ = 0;
 }
 
 void EagerReducer::TraverseBackwardGraph(const std::vector<Tensor> &outputs) {
@@ -675,7 +765,10 @@ void EagerReducer::PrepareForBackward(const std::vector<Tensor> &outputs) {
   std::for_each(groups_.begin(), groups_.end(), [](EagerGroup &group) {
     group.pending_ = group.tensor_indices_.size();
     group.sparse_contents_ = Tensor();
+    group.chunk_pending_ = group.chunk_num_tensors_;
+    group.next_chunk_ = 0;
   });
+  backward_start_ = std::chrono::steady_clock::now();
 
   // reinitialize vars_marked_ready_ for next iteration
   vars_marked_ready_.clear();
@@ -814,6 +907,13 @@ void EagerReducer::MarkVarReady(const size_t var_index,
   }
   groups_need_finalize_ = true;
 
+  if (step_ < rebuild_steps_) {
+    ready_time_us_[var_index] +=
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - backward_start_)
+            .count();
+  }
+
   const auto &var_locator = variable_locators_[var_index];
   const auto group_index = var_locator.group_index;
   const auto inside_group_index = var_locator.inside_group_index;
@@ -822,7 +922,9 @@ void EagerReducer::MarkVarReady(const size_t var_index,
   auto &group_tensor = group.dense_tensors_[inside_group_index];
   const auto length = group.length_[inside_group_index];
 
-  if (!group.is_sparse_) {
+  if (use_bucket_view_) {
+    CopyGradToBucket(var_index, is_used_var);
+  } else if (!group.is_sparse_) {
     if (is_used_var) {
       auto *autograd_meta = tensors_[var_index].get_autograd_meta();
       auto &grad_tensor =
@@ -891,7 +993,11 @@ void EagerReducer::MarkVarReady(const size_t var_index,
     group.sparse_contents_.set_impl(grad_tensor.impl());
   }
 
-  if (--group.pending_ == 0) {
+  if (use_bucket_view_) {
+    --group.pending_;
+    MarkChunksReady(&group, inside_group_index);
+    AllReduceReadyChunks();
+  } else if (--group.pending_ == 0) {
     // can start allreduce
     MarkGroupReady(group_index);
   }
@@ -930,6 +1036,190 @@ void EagerReducer::MarkGroupReady(size_t group_index) {
   }
 }
 
+void EagerReducer::CopyGradToBucket(size_t var_index, bool is_used_var) {
+  const auto &var_locator = variable_locators_[var_index];
+  auto &group = groups_[var_locator.group_index];
+  const auto inside_group_index = var_locator.inside_group_index;
+  const int64_t offset = group.offsets_[inside_group_index];
+  const int64_t length = group.length_[inside_group_index];
+  auto *bucket =
+      std::dynamic_pointer_cast<phi::DenseTensor>(group.dense_contents_.impl())
+          .get();
+  phi::DenseTensor bucket_slice = bucket->Slice(offset, offset + length);
+
+  if (is_used_var || HasGrad(var_index)) {
+    auto *grad_tensor = egr::EagerUtils::mutable_grad(tensors_[var_index]);
+    auto *grad_dense_tensor =
+        std::dynamic_pointer_cast<phi::DenseTensor>(grad_tensor->impl())
+            .get();
+    PADDLE_ENFORCE_EQ(
+        grad_dense_tensor->numel(),
+        length,
+        platform::errors::PreconditionNotMet(
+            "The grad of Tensor %s has %d elements, but %d are expected.",
+            tensors_[var_index].name(),
+            grad_dense_tensor->numel(),
+            length));
+    // The grad is a view of the bucket since the last step, and the grads
+    // of this step were added to it in place.
+    if (grad_dense_tensor->data() != bucket_slice.data()) {
+      std::memcpy(bucket_slice.data(),
+                  grad_dense_tensor->data(),
+                  length * experimental::SizeOf(group.dtype_));
+    }
+  } else {
+    VLOG(3) << "Tensor[" << tensors_[var_index].name()
+            << "] doesn't have grad";
+    auto *dev_ctx = platform::DeviceContextPool::Instance().Get(inner_place_);
+    phi::funcs::set_constant(*dev_ctx, &bucket_slice, 0.0);
+  }
+  group.dense_tensors_[inside_group_index].ShareDataWith(bucket_slice);
+}
+
+void EagerReducer::MarkChunksReady(EagerGroup *group,
+                                   size_t inside_group_index) {
+  const int64_t begin = group->offsets_[inside_group_index];
+  const int64_t end = begin + group->length_[inside_group_index];
+  size_t chunk =
+      std::upper_bound(
+          group->chunk_ends_.begin(), group->chunk_ends_.end(), begin) -
+      group->chunk_ends_.begin();
+  for (; chunk < group->chunk_ends_.size(); ++chunk) {
+    --group->chunk_pending_[chunk];
+    if (group->chunk_ends_[chunk] >= end) {
+      break;
+    }
+  }
+}
+
+void EagerReducer::AllReduceReadyChunks() {
+  // Every rank issues the chunks in the same order, the order of the groups
+  // and of the chunks in a group, whatever order they are ready in.
+  for (; next_group_ < groups_.size(); ++next_group_) {
+    auto &group = groups_[next_group_];
+    for (; group.next_chunk_ < group.chunk_ends_.size() &&
+           group.chunk_pending_[group.next_chunk_] == 0;
+         ++group.next_chunk_) {
+      const int64_t begin =
+          group.next_chunk_ == 0 ? 0
+                                 : group.chunk_ends_[group.next_chunk_ - 1];
+      const int64_t end = group.chunk_ends_[group.next_chunk_];
+      auto chunk = std::make_shared<phi::DenseTensor>(
+          std::dynamic_pointer_cast<phi::DenseTensor>(
+              group.dense_contents_.impl())
+              ->Slice(begin, end));
+      VLOG(3) << "group [" << next_group_ << "] start allreduce of chunk ["
+              << begin << ", " << end << ").";
+      comm_futures_.emplace_back(comm_pool_->Run([this, chunk] {
+        // div nranks
+        Tensor chunk_tensor(chunk);
+        paddle::experimental::scale_(chunk_tensor, 1.0 / nranks_, 0.0, false);
+
+        distributed::AllreduceOptions opts;
+        opts.reduce_op = ReduceOp::SUM;
+        std::vector<phi::DenseTensor> in_out = {*chunk};
+        process_group_->AllReduce(in_out, in_out, opts)->Synchronize();
+      }));
+    }
+    if (group.next_chunk_ < group.chunk_ends_.size()) {
+      break;
+    }
+  }
+}
+
+void EagerReducer::ShareGradsWithBuckets() {
+  std::exception_ptr error;
+  for (auto &future : comm_futures_) {
+    try {
+      future.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  comm_futures_.clear();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  for (size_t var_index = 0; var_index < tensors_.size(); ++var_index) {
+    if (!HasGrad(var_index)) {
+      continue;
+    }
+    const auto &var_locator = variable_locators_[var_index];
+    const auto &group = groups_[var_locator.group_index];
+    const auto &bucket_slice =
+        group.dense_tensors_[var_locator.inside_group_index];
+    auto *grad_tensor = egr::EagerUtils::mutable_grad(tensors_[var_index]);
+    auto grad_dense_tensor =
+        std::dynamic_pointer_cast<phi::DenseTensor>(grad_tensor->impl());
+    if (grad_dense_tensor->data() == bucket_slice.data()) {
+      continue;
+    }
+    // Replace the grad instead of changing its DenseTensor, which may be
+    // shared by other tensors.
+    auto grad_view = std::make_shared<phi::DenseTensor>();
+    grad_view->ShareDataWith(bucket_slice).Resize(grad_dense_tensor->dims());
+    grad_tensor->set_impl(grad_view);
+  }
+}
+
+void EagerReducer::RebuildGroupsByReadyTime() {
+  // Sum the ready times of all the ranks, so that every rank plans the same
+  // groups.
+  const auto *dev_ctx =
+      platform::DeviceContextPool::Instance().Get(inner_place_);
+  Tensor ready_time = paddle::experimental::empty(
+      IntArray({static_cast<int64_t>(tensors_.size())}),
+      DataType::INT64,
+      inner_place_);
+  auto *ready_time_tensor =
+      std::dynamic_pointer_cast<phi::DenseTensor>(ready_time.impl()).get();
+  framework::TensorFromVector<int64_t>(
+      ready_time_us_, *dev_ctx, ready_time_tensor);
+
+  distributed::AllreduceOptions opts;
+  opts.reduce_op = ReduceOp::SUM;
+  std::vector<phi::DenseTensor> in_out = {*ready_time_tensor};
+  process_group_->AllReduce(in_out, in_out, opts)->Synchronize();
+
+  framework::TensorToVector<int64_t>(
+      *ready_time_tensor, *dev_ctx, &ready_time_us_);
+  dev_ctx->Wait();
+
+  std::vector<int64_t> ready_order(tensors_.size());
+  std::iota(ready_order.begin(), ready_order.end(), 0);
+  std::stable_sort(ready_order.begin(),
+                   ready_order.end(),
+                   [this](int64_t x, int64_t y) {
+                     return ready_time_us_[x] < ready_time_us_[y];
+                   });
+  std::vector<size_t> ready_position(tensors_.size());
+  std::vector<Tensor> ready_tensors;
+  for (size_t position = 0; position < ready_order.size(); ++position) {
+    ready_position[ready_order[position]] = position;
+    ready_tensors.push_back(tensors_[ready_order[position]]);
+  }
+  VLOG(3) << "The order of parameter ready: "
+          << string::join_strings(ready_order, ',');
+
+  auto group_indices = Eager_AssignGroupBySize(
+      ready_tensors, is_sparse_gradient_, group_size_limits_, ready_order);
+  // The groups are allreduced in order, the tensors of every group are in
+  // the order they are ready.
+  std::stable_sort(
+      group_indices.begin(),
+      group_indices.end(),
+      [&ready_position](const std::vector<size_t> &x,
+                        const std::vector<size_t> &y) {
+        return ready_position[x.front()] < ready_position[y.front()];
+      });
+  group_indices_ = std::move(group_indices);
+  InitializeGroups(group_indices_);
+  ready_time_us_.clear();
+}
+
 bool EagerReducer::HasGrad(size_t var_index) {
   auto grad = egr::EagerUtils::mutable_grad(tensors_[var_index]);
   if (grad && grad->initialized()) {
@@ -1014,8 +1304,11 @@ void EagerReducer::ProcessUnusedDenseVars() {
 void EagerReducer::FinalizeBackward() {
   groups_need_finalize_ = false;
   grad_need_hooks_ = false;
+  if (use_bucket_view_) {
+    ShareGradsWithBuckets();
+  }
   for (auto &group : groups_) {
-    if (!group.is_sparse_) {
+    if (!group.is_sparse_ && !use_bucket_view_) {
       group.task->Synchronize();
       if (!IsStreamSafeAllocator()) {
         auto *default_ctx =
@@ -1032,6 +1325,11 @@ void EagerReducer::FinalizeBackward() {
     VLOG(3) << "ProcessUnusedDenseVars is finished.";
   }
 
+  if (step_ < rebuild_steps_ && ++step_ == rebuild_steps_) {
+    VLOG(3) << "Start rebuilding the groups";
+    RebuildGroupsByReadyTime();
+  }
+
   VLOG(3) << "In the batch, Reducer is finished.";
 }
 
@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <chrono>
+#include <future>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "paddle/fluid/distributed/collective/process_group.h"
@@ -28,6 +31,7 @@
 #include "paddle/phi/api/include/api.h"
 #include "paddle/phi/api/include/tensor.h"
 #include "paddle/phi/common/data_type.h"
+#include "paddle/phi/core/threadpool.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 #include "paddle/utils/string/string_helper.h"
 
@@ -70,6 +74,17 @@ class EagerGroup {
   // help to sync
   std::shared_ptr<ProcessGroup::Task> task;
 
+  // With bucket views, the grads are copied to dense_contents_ at these
+  // offsets as soon as they are ready, and dense_contents_ is allreduced in
+  // chunks: chunk_ends_ are the ends of the chunks, chunk_num_tensors_ the
+  // numbers of tensors every chunk overlaps, and chunk_pending_ the numbers
+  // of them not ready yet.
+  std::vector<int64_t> offsets_;
+  std::vector<int64_t> chunk_ends_;
+  std::vector<size_t> chunk_num_tensors_;
+  std::vector<size_t> chunk_pending_;
+  size_t next_chunk_ = 0;
+
   // context is used to select the stream for concat
   void ConcatTensors(const platform::Place &);
 
@@ -114,6 +129,18 @@ class EagerReducer {
   void ProcessUnusedDenseVars();
   bool HasGrad(size_t var_index);
 
+  // Used when the grads are kept in the buckets, see
+  // FLAGS_eager_reducer_cpu_comm_overlap.
+  void InitializeBucketView(EagerGroup *p_group);
+  void CopyGradToBucket(size_t var_index, bool is_used_var);
+  void MarkChunksReady(EagerGroup *group, size_t inside_group_index);
+  void AllReduceReadyChunks();
+  void ShareGradsWithBuckets();
+
+  // Regroup the tensors by the time their grads are ready, see
+  // FLAGS_eager_reducer_rebuild_steps.
+  void RebuildGroupsByReadyTime();
+
  private:
   std::vector<Tensor> tensors_;
   std::vector<std::vector<size_t>> group_indices_;
@@ -140,6 +167,19 @@ class EagerReducer {
   bool find_unused_vars_once_{true};
   bool groups_need_finalize_{false};
   Tensor global_used_vars_;
+
+  // Following variables are to help rebuild groups
+  int64_t rebuild_steps_{0};
+  int64_t step_{0};
+  std::chrono::steady_clock::time_point backward_start_;
+  std::vector<int64_t> ready_time_us_;
+
+  // Following variables are to help bucket views
+  bool use_bucket_view_{false};
+  std::vector<std::future<void>> comm_futures_;
+  // Runs the allreduce of the chunks in the order they are issued, declared
+  // last to be destroyed before the members its tasks use.
+  std::unique_ptr<phi::ThreadPool> comm_pool_;
 };
 
 }  //  namespace distributed
@@ -0,0 +1,445 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/collective/shm_communicator.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>  // NOLINT
+
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+struct ShmCommunicator::Flag {
+  std::atomic<uint64_t> value;
+  char padding[64 - sizeof(std::atomic<uint64_t>)];
+};
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+constexpr int kSpinsBeforeYield = 1000;
+// The parts of a chunk reduced by the ranks are aligned to this many
+// elements, so that every part is reduced by whole vector instructions.
+constexpr size_t kPartAlignment = 16;
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+#ifdef __linux__
+// The ranks of a host share a segment if they have the same host name and
+// the same boot id, the host name alone may be the same on several hosts.
+std::string HostId() {
+  char hostname[256] = {0};
+  gethostname(hostname, sizeof(hostname) - 1);
+  std::string boot_id;
+  std::ifstream file("/proc/sys/kernel/random/boot_id");
+  std::getline(file, boot_id);
+  return std::string(hostname) + "/" + boot_id;
+}
+#endif
+
+template <typename T, typename Op>
+void ReduceInto(T* dst, const T* src, size_t count, Op op) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = op(dst[i], src[i]);
+  }
+}
+
+template <typename T>
+void ReduceTyped(T* dst, const T* src, size_t count, ReduceOp op) {
+  switch (op) {
+    case ReduceOp::SUM:
+      ReduceInto(dst, src, count, [](T x, T y) { return x + y; });
+      break;
+    case ReduceOp::PRODUCT:
+      ReduceInto(dst, src, count, [](T x, T y) { return x * y; });
+      break;
+    case ReduceOp::MAX:
+      ReduceInto(dst, src, count, [](T x, T y) { return x > y ? x : y; });
+      break;
+    case ReduceOp::MIN:
+      ReduceInto(dst, src, count, [](T x, T y) { return x < y ? x : y; });
+      break;
+    default:
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "Unsupported ReduceOp %d of shared memory AllReduce.",
+          static_cast<int>(op)));
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<ShmCommunicator> ShmCommunicator::Create(
+    const std::shared_ptr<phi::distributed::Store>& store,
+    int rank,
+    int world_size,
+    int gid,
+    size_t slot_bytes,
+    const std::string& host_id) {
+#ifdef __linux__
+  const std::string prefix = "shm/" + std::to_string(gid) + "/";
+  const std::string id = host_id.empty() ? HostId() : host_id;
+  store->set(prefix + "host/" + std::to_string(rank),
+             std::vector<uint8_t>(id.begin(), id.end()));
+
+  // Number the hosts in the order of their lowest ranks, and the ranks of a
+  // host in the order of the ranks.
+  std::vector<std::string> host_ids;
+  std::vector<int> host_sizes;
+  std::vector<int> host_of_rank(world_size);
+  std::vector<int> local_rank_of_rank(world_size);
+  for (int r = 0; r < world_size; ++r) {
+    const std::string key = prefix + "host/" + std::to_string(r);
+    store->wait(key);
+    auto value = store->get(key);
+    auto iter = std::find(host_ids.begin(),
+                          host_ids.end(),
+                          std::string(value.begin(), value.end()));
+    int host = static_cast<int>(iter - host_ids.begin());
+    if (iter == host_ids.end()) {
+      host_ids.emplace_back(value.begin(), value.end());
+      host_sizes.push_back(0);
+    }
+    host_of_rank[r] = host;
+    local_rank_of_rank[r] = host_sizes[host]++;
+  }
+  if (*std::max_element(host_sizes.begin(), host_sizes.end()) == 1) {
+    return nullptr;
+  }
+
+  int host_index = host_of_rank[rank];
+  int local_rank = local_rank_of_rank[rank];
+  int leader_rank = static_cast<int>(
+      std::find(host_of_rank.begin(), host_of_rank.end(), host_index) -
+      host_of_rank.begin());
+  std::unique_ptr<ShmCommunicator> communicator(
+      new ShmCommunicator(rank,
+                          local_rank,
+                          host_sizes[host_index],
+                          host_index,
+                          static_cast<int>(host_ids.size()),
+                          std::move(host_of_rank),
+                          std::move(local_rank_of_rank),
+                          slot_bytes));
+  communicator->Map(store, prefix, leader_rank);
+  VLOG(3) << "Rank " << rank << " uses shared memory as local rank "
+          << communicator->local_rank() << " of "
+          << communicator->local_size() << " on host " << host_index << " of "
+          << communicator->num_hosts();
+  return communicator;
+#else
+  return nullptr;
+#endif
+}
+
+ShmCommunicator::ShmCommunicator(int rank,
+                                 int local_rank,
+                                 int local_size,
+                                 int host_index,
+                                 int num_hosts,
+                                 std::vector<int> host_of_rank,
+                                 std::vector<int> local_rank_of_rank,
+                                 size_t slot_bytes)
+    : rank_(rank),
+      local_rank_(local_rank),
+      local_size_(local_size),
+      host_index_(host_index),
+      num_hosts_(num_hosts),
+      host_of_rank_(std::move(host_of_rank)),
+      local_rank_of_rank_(std::move(local_rank_of_rank)),
+      slot_bytes_(AlignUp(std::max<size_t>(slot_bytes, 1), kPageSize)) {}
+
+ShmCommunicator::~ShmCommunicator() {
+#ifdef __linux__
+  if (segment_ != nullptr) {
+    munmap(segment_, segment_bytes_);
+  }
+#endif
+}
+
+bool ShmCommunicator::IsSupported(phi::DataType dtype) {
+  return dtype == phi::DataType::FLOAT32 || dtype == phi::DataType::FLOAT64 ||
+         dtype == phi::DataType::INT32 || dtype == phi::DataType::INT64;
+}
+
+void ShmCommunicator::SetLeaderCollectives(LeaderAllReduce all_reduce,
+                                           LeaderBroadcast broadcast) {
+  leader_all_reduce_ = std::move(all_reduce);
+  leader_broadcast_ = std::move(broadcast);
+}
+
+void ShmCommunicator::Map(const std::shared_ptr<phi::distributed::Store>& store,
+                          const std::string& prefix,
+                          int leader_rank) {
+#ifdef __linux__
+  size_t flags_bytes = AlignUp(local_size_ * sizeof(Flag), kPageSize);
+  segment_bytes_ = flags_bytes + local_size_ * slot_bytes_;
+  const std::string name_key =
+      prefix + "segment/" + std::to_string(leader_rank);
+  const std::string attached_key =
+      prefix + "attached/" + std::to_string(leader_rank);
+
+  std::string name;
+  int fd = -1;
+  if (is_leader()) {
+    static std::atomic<int> next_segment{0};
+    name = "/paddle_gloo_shm_" + std::to_string(getpid()) + "_" +
+           std::to_string(next_segment++);
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    PADDLE_ENFORCE_GE(fd,
+                      0,
+                      phi::errors::Unavailable(
+                          "Failed to create shared memory %s, error code "
+                          "is %d.",
+                          name,
+                          errno));
+    PADDLE_ENFORCE_EQ(
+        ftruncate(fd, segment_bytes_),
+        0,
+        phi::errors::ResourceExhausted(
+            "Failed to resize shared memory %s to %d bytes, error code is "
+            "%d. Please enlarge /dev/shm or decrease FLAGS_gloo_shm_slot_mb.",
+            name,
+            segment_bytes_,
+            errno));
+  } else {
+    store->wait(name_key);
+    auto value = store->get(name_key);
+    name.assign(value.begin(), value.end());
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+    PADDLE_ENFORCE_GE(fd,
+                      0,
+                      phi::errors::Unavailable(
+                          "Failed to open shared memory %s, error code is %d.",
+                          name,
+                          errno));
+  }
+  segment_ = mmap(
+      nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(segment_,
+                    MAP_FAILED,
+                    phi::errors::Unavailable(
+                        "Failed to map shared memory %s, error code is %d.",
+                        name,
+                        errno));
+  flags_ = reinterpret_cast<Flag*>(segment_);
+  slots_ = reinterpret_cast<char*>(segment_) + flags_bytes;
+
+  if (is_leader()) {
+    for (int i = 0; i < local_size_; ++i) {
+      new (&flags_[i].value) std::atomic<uint64_t>(0);
+    }
+    store->set(name_key, std::vector<uint8_t>(name.begin(), name.end()));
+  }
+
+  // Remove the name once every rank has mapped the segment, so that it is
+  // freed when the ranks exit, however they exit.
+  store->add(attached_key, 1);
+  if (is_leader()) {
+    while (store->add(attached_key, 0) < local_size_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    shm_unlink(name.c_str());
+  }
+#endif
+}
+
+void ShmCommunicator::Barrier() {
+  // The flags only grow, so a rank may enter the next barrier while the
+  // others are still leaving this one.
+  ++epoch_;
+  flags_[local_rank_].value.store(epoch_, std::memory_order_release);
+  // The clock is only read once the rank starts to yield.
+  std::chrono::steady_clock::time_point deadline;
+  bool has_deadline = false;
+  for (int i = 0; i < local_size_; ++i) {
+    int spins = 0;
+    while (flags_[i].value.load(std::memory_order_acquire) < epoch_) {
+      if (++spins > kSpinsBeforeYield) {
+        auto now = std::chrono::steady_clock::now();
+        if (!has_deadline) {
+          deadline = now + timeout_;
+          has_deadline = true;
+        } else if (now > deadline) {
+          PADDLE_THROW(phi::errors::Unavailable(
+              "Rank %d timed out after %d ms waiting for local rank %d in "
+              "the shared memory communicator, which may have exited or "
+              "be running another collective.",
+              rank_,
+              timeout_.count(),
+              i));
+        }
+        std::this_thread::yield();
+      }
+    }
+  }
+}
+
+void ShmCommunicator::ReduceSlots(size_t offset,
+                                  size_t count,
+                                  phi::DataType dtype,
+                                  ReduceOp op) {
+  for (int i = 1; i < local_size_; ++i) {
+    switch (dtype) {
+      case phi::DataType::FLOAT32:
+        ReduceTyped(reinterpret_cast<float*>(Slot(0)) + offset,
+                    reinterpret_cast<const float*>(Slot(i)) + offset,
+                    count,
+                    op);
+        break;
+      case phi::DataType::FLOAT64:
+        ReduceTyped(reinterpret_cast<double*>(Slot(0)) + offset,
+                    reinterpret_cast<const double*>(Slot(i)) + offset,
+                    count,
+                    op);
+        break;
+      case phi::DataType::INT32:
+        ReduceTyped(reinterpret_cast<int32_t*>(Slot(0)) + offset,
+                    reinterpret_cast<const int32_t*>(Slot(i)) + offset,
+                    count,
+                    op);
+        break;
+      case phi::DataType::INT64:
+        ReduceTyped(reinterpret_cast<int64_t*>(Slot(0)) + offset,
+                    reinterpret_cast<const int64_t*>(Slot(i)) + offset,
+                    count,
+                    op);
+        break;
+      default:
+        PADDLE_THROW(phi::errors::Unimplemented(
+            "Unsupported data type %s of shared memory AllReduce.", dtype));
+    }
+  }
+}
+
+void ShmCommunicator::AllReduce(const void* in,
+                                void* out,
+                                size_t count,
+                                phi::DataType dtype,
+                                ReduceOp op) {
+  PADDLE_ENFORCE_EQ(
+      single_host() || leader_all_reduce_,
+      true,
+      phi::errors::PreconditionNotMet(
+          "The leader collectives of ShmCommunicator are not set."));
+  const size_t element_bytes = phi::SizeOf(dtype);
+  const size_t chunk_count = slot_bytes_ / element_bytes;
+  const char* src = reinterpret_cast<const char*>(in);
+  char* dst = reinterpret_cast<char*>(out);
+  for (size_t begin = 0; begin < count; begin += chunk_count) {
+    size_t n = std::min(chunk_count, count - begin);
+    std::memcpy(
+        Slot(local_rank_), src + begin * element_bytes, n * element_bytes);
+    Barrier();
+
+    // Every rank reduces a part of the chunk of all the slots to slot 0.
+    size_t part = AlignUp((n + local_size_ - 1) / local_size_, kPartAlignment);
+    size_t part_begin = std::min(n, part * local_rank_);
+    size_t part_end = std::min(n, part_begin + part);
+    if (part_end > part_begin) {
+      ReduceSlots(part_begin, part_end - part_begin, dtype, op);
+    }
+    Barrier();
+
+    if (!single_host()) {
+      if (is_leader()) {
+        leader_all_reduce_(Slot(0), n, dtype, op);
+      }
+      Barrier();
+    }
+
+    std::memcpy(dst + begin * element_bytes, Slot(0), n * element_bytes);
+    // Slot 0 is written by the next chunk.
+    Barrier();
+  }
+}
+
+void ShmCommunicator::Broadcast(const void* in,
+                                void* out,
+                                size_t bytes,
+                                int root) {
+  PADDLE_ENFORCE_EQ(
+      single_host() || leader_broadcast_,
+      true,
+      phi::errors::PreconditionNotMet(
+          "The leader collectives of ShmCommunicator are not set."));
+  PADDLE_ENFORCE_LT(
+      root,
+      static_cast<int>(host_of_rank_.size()),
+      phi::errors::InvalidArgument("The root %d of Broadcast is not a rank.",
+                                   root));
+  const int root_host = host_of_rank_[root];
+  // The leaders of the other hosts receive the chunks to their slots.
+  char* chunk = host_index_ == root_host ? Slot(local_rank_of_rank_[root])
+                                         : Slot(0);
+  const char* src = reinterpret_cast<const char*>(in);
+  char* dst = reinterpret_cast<char*>(out);
+  for (size_t begin = 0; begin < bytes; begin += slot_bytes_) {
+    size_t n = std::min(slot_bytes_, bytes - begin);
+    if (rank_ == root) {
+      std::memcpy(chunk, src + begin, n);
+    }
+    Barrier();
+
+    if (!single_host()) {
+      if (is_leader()) {
+        leader_broadcast_(chunk, n, root_host);
+      }
+      Barrier();
+    }
+
+    if (rank_ != root || dst != src) {
+      std::memcpy(dst + begin, chunk, n);
+    }
+    Barrier();
+  }
+}
+
+void ShmCommunicator::AllGather(const void* in, void* out, size_t bytes) {
+  PADDLE_ENFORCE_EQ(single_host(),
+                    true,
+                    phi::errors::PreconditionNotMet(
+                        "AllGather of ShmCommunicator is only for the ranks "
+                        "on a single host."));
+  const char* src = reinterpret_cast<const char*>(in);
+  char* dst = reinterpret_cast<char*>(out);
+  for (size_t begin = 0; begin < bytes; begin += slot_bytes_) {
+    size_t n = std::min(slot_bytes_, bytes - begin);
+    std::memcpy(Slot(local_rank_), src + begin, n);
+    Barrier();
+    // The local ranks are the ranks on a single host.
+    for (int i = 0; i < local_size_; ++i) {
+      std::memcpy(dst + i * bytes + begin, Slot(i), n);
+    }
+    Barrier();
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,147 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/collective/types.h"
+#include "paddle/phi/common/data_type.h"
+#include "paddle/phi/core/distributed/store/store.h"
+
+namespace paddle {
+namespace distributed {
+
+/*
+ * Runs the collectives of the ranks on one host through a POSIX shared
+ * memory segment instead of the loopback network. Every rank of the host
+ * owns a slot of the segment, and the ranks step through the phases of a
+ * collective together by spinning on a flag of every rank.
+ *
+ * The collectives are hierarchical when the ranks are on several hosts: the
+ * ranks of a host reduce to the segment, the leaders of the hosts (the
+ * lowest rank of every host) run the collective among themselves by the
+ * leader collectives, and the result is read back from the segment.
+ *
+ * A collective larger than a slot runs in chunks of the slot size. Like the
+ * Gloo collectives, the methods must be called by all the ranks in the same
+ * order, and by one thread of a rank at a time. A rank which waits longer
+ * than the timeout for the others throws, and the communicator must not be
+ * used afterwards.
+ */
+class ShmCommunicator {
+ public:
+  // The collectives among the leaders of the hosts, run by the leaders on
+  // the buffers in the segment. The broadcast is rooted at the leader of
+  // root_host.
+  using LeaderAllReduce = std::function<void(
+      void* data, size_t count, phi::DataType dtype, ReduceOp op)>;
+  using LeaderBroadcast =
+      std::function<void(void* data, size_t bytes, int root_host)>;
+
+  // Find the ranks on the same host by store, and map the segment of the
+  // host. The host is identified by host_id, or by the name and boot id of
+  // the host if it is empty. Returns nullptr if shared memory is not
+  // supported, or if no host has more than one rank.
+  static std::unique_ptr<ShmCommunicator> Create(
+      const std::shared_ptr<phi::distributed::Store>& store,
+      int rank,
+      int world_size,
+      int gid,
+      size_t slot_bytes,
+      const std::string& host_id = "");
+
+  ~ShmCommunicator();
+
+  // Whether AllReduce supports the dtype.
+  static bool IsSupported(phi::DataType dtype);
+
+  int local_rank() const { return local_rank_; }
+  int local_size() const { return local_size_; }
+  int host_index() const { return host_index_; }
+  int num_hosts() const { return num_hosts_; }
+  bool is_leader() const { return local_rank_ == 0; }
+  bool single_host() const { return num_hosts_ == 1; }
+
+  void SetLeaderCollectives(LeaderAllReduce all_reduce,
+                            LeaderBroadcast broadcast);
+
+  // How long a rank waits for the others in a phase of a collective.
+  void SetTimeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+
+  // in and out may be the same buffer.
+  void AllReduce(const void* in,
+                 void* out,
+                 size_t count,
+                 phi::DataType dtype,
+                 ReduceOp op);
+  // Broadcast bytes from in of the rank root to out of every rank.
+  void Broadcast(const void* in, void* out, size_t bytes, int root);
+  // Gather bytes from in of every rank to out, in the order of the ranks.
+  // Only for a single host.
+  void AllGather(const void* in, void* out, size_t bytes);
+
+ private:
+  struct Flag;
+
+  ShmCommunicator(int rank,
+                  int local_rank,
+                  int local_size,
+                  int host_index,
+                  int num_hosts,
+                  std::vector<int> host_of_rank,
+                  std::vector<int> local_rank_of_rank,
+                  size_t slot_bytes);
+
+  void Map(const std::shared_ptr<phi::distributed::Store>& store,
+           const std::string& prefix,
+           int leader_rank);
+  void Barrier();
+  char* Slot(int local_rank) const {
+    return slots_ + static_cast<size_t>(local_rank) * slot_bytes_;
+  }
+  // Reduce count elements at offset of all the slots to slot 0.
+  void ReduceSlots(size_t offset,
+                   size_t count,
+                   phi::DataType dtype,
+                   ReduceOp op);
+
+  int rank_;
+  int local_rank_;
+  int local_size_;
+  int host_index_;
+  int num_hosts_;
+  std::vector<int> host_of_rank_;
+  std::vector<int> local_rank_of_rank_;
+  size_t slot_bytes_;
+
+  void* segment_{nullptr};
+  size_t segment_bytes_{0};
+  Flag* flags_{nullptr};
+  char* slots_{nullptr};
+  uint64_t epoch_{0};
+  std::chrono::milliseconds timeout_{std::chrono::minutes(30)};
+
+  LeaderAllReduce leader_all_reduce_;
+  LeaderBroadcast leader_broadcast_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
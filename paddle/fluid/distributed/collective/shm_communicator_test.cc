@@ -0,0 +1,245 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/collective/shm_communicator.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+// A store shared by the ranks of a test, which run as threads.
+class MemoryStore : public phi::distributed::Store {
+ public:
+  int64_t add(const std::string& key, int64_t value) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& counter = counters_[key];
+    counter += value;
+    cv_.notify_all();
+    return counter;
+  }
+
+  std::vector<uint8_t> get(const std::string& key) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return values_[key];
+  }
+
+  void wait(const std::string& key) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return values_.count(key) > 0; });
+  }
+
+  void set(const std::string& key, const std::vector<uint8_t>& value) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    values_[key] = value;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<std::string, int64_t> counters_;
+  std::map<std::string, std::vector<uint8_t>> values_;
+};
+
+// The collectives of the leaders of the hosts, run by the leader threads on
+// buffers exchanged through memory.
+class LeaderGroup {
+ public:
+  explicit LeaderGroup(int num_hosts)
+      : num_hosts_(num_hosts), buffers_(num_hosts) {}
+
+  void AllReduceSum(int host, float* data, size_t count) {
+    buffers_[host] = data;
+    Barrier();
+    std::vector<float> sum(count, 0);
+    for (int i = 0; i < num_hosts_; ++i) {
+      for (size_t j = 0; j < count; ++j) {
+        sum[j] += reinterpret_cast<float*>(buffers_[i])[j];
+      }
+    }
+    Barrier();
+    std::memcpy(data, sum.data(), count * sizeof(float));
+    Barrier();
+  }
+
+  void Broadcast(int host, void* data, size_t bytes, int root_host) {
+    buffers_[host] = data;
+    Barrier();
+    if (host != root_host) {
+      std::memcpy(data, buffers_[root_host], bytes);
+    }
+    Barrier();
+  }
+
+ private:
+  void Barrier() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int generation = generation_;
+    if (++arrived_ == num_hosts_) {
+      arrived_ = 0;
+      ++generation_;
+      cv_.notify_all();
+    } else {
+      cv_.wait(lock, [&]() { return generation_ != generation; });
+    }
+  }
+
+  int num_hosts_;
+  std::vector<void*> buffers_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int arrived_{0};
+  int generation_{0};
+};
+
+constexpr int kWorldSize = 4;
+// Larger than the slot, so the collectives run in several chunks.
+constexpr size_t kCount = 10000;
+constexpr size_t kSlotBytes = 4096;
+
+template <typename Fn>
+void RunRanks(Fn fn) {
+  std::vector<std::thread> threads;
+  for (int rank = 0; rank < kWorldSize; ++rank) {
+    threads.emplace_back(fn, rank);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(ShmCommunicator, single_host) {
+  auto store = std::make_shared<MemoryStore>();
+  RunRanks([&](int rank) {
+    auto shm = ShmCommunicator::Create(store, rank, kWorldSize, 0, kSlotBytes);
+    ASSERT_NE(shm, nullptr);
+    EXPECT_EQ(shm->local_rank(), rank);
+    EXPECT_EQ(shm->local_size(), kWorldSize);
+    EXPECT_TRUE(shm->single_host());
+
+    std::vector<float> in(kCount);
+    for (size_t i = 0; i < kCount; ++i) {
+      in[i] = static_cast<float>(rank + i);
+    }
+    std::vector<float> out(kCount);
+    shm->AllReduce(
+        in.data(), out.data(), kCount, phi::DataType::FLOAT32, ReduceOp::SUM);
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(out[i], static_cast<float>(6 + 4 * i));
+    }
+
+    std::vector<int64_t> values(kCount, rank);
+    shm->AllReduce(values.data(),
+                   values.data(),
+                   kCount,
+                   phi::DataType::INT64,
+                   ReduceOp::MAX);
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(values[i], kWorldSize - 1);
+    }
+
+    std::vector<int32_t> broadcast(kCount, rank);
+    shm->Broadcast(broadcast.data(),
+                   broadcast.data(),
+                   kCount * sizeof(int32_t),
+                   /*root=*/2);
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(broadcast[i], 2);
+    }
+
+    std::vector<int32_t> gathered(kCount * kWorldSize);
+    std::vector<int32_t> part(kCount, rank);
+    shm->AllGather(part.data(), gathered.data(), kCount * sizeof(int32_t));
+    for (int r = 0; r < kWorldSize; ++r) {
+      for (size_t i = 0; i < kCount; ++i) {
+        ASSERT_EQ(gathered[r * kCount + i], r);
+      }
+    }
+  });
+}
+
+TEST(ShmCommunicator, hierarchical) {
+  auto store = std::make_shared<MemoryStore>();
+  LeaderGroup leaders(2);
+  RunRanks([&](int rank) {
+    // Ranks 0 and 2 on host a, ranks 1 and 3 on host b.
+    auto shm = ShmCommunicator::Create(
+        store, rank, kWorldSize, 1, kSlotBytes, rank % 2 == 0 ? "a" : "b");
+    ASSERT_NE(shm, nullptr);
+    EXPECT_EQ(shm->host_index(), rank % 2);
+    EXPECT_EQ(shm->num_hosts(), 2);
+    EXPECT_EQ(shm->local_rank(), rank / 2);
+    int host = shm->host_index();
+    shm->SetLeaderCollectives(
+        [&](void* data, size_t count, phi::DataType dtype, ReduceOp op) {
+          leaders.AllReduceSum(host, reinterpret_cast<float*>(data), count);
+        },
+        [&](void* data, size_t bytes, int root_host) {
+          leaders.Broadcast(host, data, bytes, root_host);
+        });
+
+    std::vector<float> values(kCount);
+    for (size_t i = 0; i < kCount; ++i) {
+      values[i] = static_cast<float>(rank * i);
+    }
+    shm->AllReduce(values.data(),
+                   values.data(),
+                   kCount,
+                   phi::DataType::FLOAT32,
+                   ReduceOp::SUM);
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(values[i], static_cast<float>(6 * i));
+    }
+
+    std::vector<int64_t> broadcast(kCount, rank);
+    shm->Broadcast(broadcast.data(),
+                   broadcast.data(),
+                   kCount * sizeof(int64_t),
+                   /*root=*/3);
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(broadcast[i], 3);
+    }
+  });
+}
+
+// Rank 0 never joins the collective, so the others time out in the barrier.
+TEST(ShmCommunicator, timeout) {
+  auto store = std::make_shared<MemoryStore>();
+  RunRanks([&](int rank) {
+    auto shm = ShmCommunicator::Create(store, rank, kWorldSize, 2, kSlotBytes);
+    ASSERT_NE(shm, nullptr);
+    shm->SetTimeout(std::chrono::milliseconds(100));
+    if (rank == 0) {
+      return;
+    }
+    std::vector<float> values(kCount, 1);
+    EXPECT_THROW(shm->AllReduce(values.data(),
+                                values.data(),
+                                kCount,
+                                phi::DataType::FLOAT32,
+                                ReduceOp::SUM),
+                 phi::enforce::EnforceNotMet);
+  });
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -147,6 +147,17 @@ Interceptor* Carrier::GetInterceptor(int64_t interceptor_id) {
   return iter->second.get();
 }
 
+Interceptor* Carrier::GetLocalInterceptor(int64_t interceptor_id) {
+  auto rank_iter = interceptor_id_to_rank_.find(interceptor_id);
+  if (rank_iter == interceptor_id_to_rank_.end() ||
+      rank_iter->second != rank_) {
+    return nullptr;
+  }
+  auto iter = interceptor_idx_to_interceptor_.find(interceptor_id);
+  return iter == interceptor_idx_to_interceptor_.end() ? nullptr
+                                                       : iter->second.get();
+}
+
 void Carrier::Wait() {
   std::unique_lock<std::mutex> lock(running_mutex_);
   cond_var_.wait(lock);
@@ -237,6 +248,7 @@ Interceptor* Carrier::SetInterceptor(int64_t interceptor_id,
   PADDLE_ENFORCE_NOT_NULL(
       loop, platform::errors::Fatal("thread task loop must not null"));
   interceptor->RegisterTaskLoop(loop);
+  interceptor->RegisterLocalQueues(thread_pool_.GetAllLoops());
 
   auto* ptr = interceptor.get();
   interceptor_idx_to_interceptor_.insert(
@@ -77,6 +77,10 @@ class Carrier final {
   // get interceptor based on the interceptor id
   Interceptor* GetInterceptor(int64_t interceptor_id);
 
+  // get interceptor of the rank of the carrier, or nullptr if it is in
+  // another rank
+  Interceptor* GetLocalInterceptor(int64_t interceptor_id);
+
   // set interceptor with interceptor id
   Interceptor* SetInterceptor(int64_t interceptor_id,
                               std::unique_ptr<Interceptor>);
@@ -17,6 +17,14 @@
 #include "paddle/fluid/distributed/fleet_executor/carrier.h"
 #include "paddle/fluid/distributed/fleet_executor/task_loop.h"
 #include "paddle/fluid/distributed/fleet_executor/task_node.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_bool(
+    fleet_executor_local_message,
+    true,
+    "Pass the messages between the interceptors of a carrier through lock "
+    "free queues, and coalesce the data notifications sent while handling "
+    "a batch of messages.");
 
 namespace paddle {
 namespace distributed {
@@ -39,19 +47,22 @@ void Interceptor::Handle(const InterceptorMessage& msg) {
                           platform::errors::PreconditionNotMet(
                               "Message handle is not registered."));
   handle_(msg);
+  handled_message_count_.fetch_add(1, std::memory_order_relaxed);
 }
 
 void Interceptor::LoopOnce() {
+  loop_scheduled_.store(false);
+  // Pairs with the fence of ScheduleLoopOnce, a message enqueued after the
+  // flag is cleared is either drained below or schedules another LoopOnce.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
   std::deque<InterceptorMessage> tmp_messages;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     messages_.swap(tmp_messages);
   }
-  PADDLE_ENFORCE_EQ(tmp_messages.empty(),
-                    false,
-                    platform::errors::PreconditionNotMet(
-                        "tmp_messages must not empty in task loop"));
 
+  handling_ = true;
   for (auto& msg : tmp_messages) {
     const MessageType message_type = msg.message_type();
     VLOG(3) << "Interceptor " << interceptor_id_ << " has received a message"
@@ -60,6 +71,32 @@ void Interceptor::LoopOnce() {
 
     Handle(msg);
   }
+  for (auto& item : local_queues_) {
+    LocalInterceptorMessage local;
+    while (item.second->Pop(&local)) {
+      VLOG(3) << "Interceptor " << interceptor_id_
+              << " has received a local message from interceptor "
+              << local.src_id << " with message: " << local.message_type
+              << " of count " << local.count << ".";
+      InterceptorMessage msg;
+      msg.set_src_id(local.src_id);
+      msg.set_dst_id(local.dst_id);
+      msg.set_message_type(local.message_type);
+      msg.set_scope_idx(local.scope_idx);
+      for (int64_t i = 0; i < local.count; ++i) {
+        Handle(msg);
+      }
+    }
+  }
+  handling_ = false;
+  outbox_.Flush(loop_);
+}
+
+void Interceptor::ScheduleLoopOnce() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!loop_scheduled_.exchange(true)) {
+    loop_->QueueInLoop([this]() { LoopOnce(); });
+  }
 }
 
 void Interceptor::StopCarrier() {
@@ -75,23 +112,90 @@ void Interceptor::EnqueueRemoteInterceptorMessage(
   VLOG(3) << "Enqueue message: " << message.message_type() << " into "
           << interceptor_id_ << "'s remote mailbox.";
 
-  bool empty = false;
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    empty = messages_.empty();
     messages_.emplace_back(message);
   }
-  if (empty) {
-    loop_->QueueInLoop([this]() { LoopOnce(); });
+  ScheduleLoopOnce();
+}
+
+void Interceptor::RegisterLocalQueues(const std::vector<TaskLoop*>& loops) {
+  for (auto* loop : loops) {
+    local_queues_.emplace(
+        loop, std::make_unique<SpscQueue<LocalInterceptorMessage>>());
+  }
+}
+
+void Interceptor::EnqueueLocalInterceptorMessage(
+    TaskLoop* producer, const LocalInterceptorMessage& message) {
+  auto iter = local_queues_.find(producer);
+  PADDLE_ENFORCE_NE(iter,
+                    local_queues_.end(),
+                    platform::errors::NotFound(
+                        "Interceptor %lld has no local mailbox for the task "
+                        "loop of interceptor %lld.",
+                        interceptor_id_,
+                        message.src_id));
+  iter->second->Push(message);
+  ScheduleLoopOnce();
+}
+
+void Interceptor::SendLocal(Interceptor* dst, const InterceptorMessage& msg) {
+  LocalInterceptorMessage local{msg.src_id(),
+                                msg.dst_id(),
+                                msg.message_type(),
+                                msg.scope_idx(),
+                                /*count=*/1};
+  if (handling_) {
+    outbox_.Add(dst, local);
+  } else {
+    dst->EnqueueLocalInterceptorMessage(loop_, local);
   }
 }
 
+void LocalMessageOutbox::Add(Interceptor* dst,
+                             const LocalInterceptorMessage& message) {
+  // Coalesce with the last message to dst if it is the same notification.
+  if (message.message_type == DATA_IS_READY ||
+      message.message_type == DATA_IS_USELESS) {
+    for (auto iter = items_.rbegin(); iter != items_.rend(); ++iter) {
+      if (iter->second.dst_id != message.dst_id) {
+        continue;
+      }
+      if (iter->second.message_type == message.message_type &&
+          iter->second.scope_idx == message.scope_idx) {
+        iter->second.count += message.count;
+        return;
+      }
+      break;
+    }
+  }
+  items_.emplace_back(dst, message);
+}
+
+void LocalMessageOutbox::Flush(TaskLoop* producer) {
+  for (auto& item : items_) {
+    item.first->EnqueueLocalInterceptorMessage(producer, item.second);
+  }
+  items_.clear();
+}
+
 bool Interceptor::Send(int64_t dst_id, InterceptorMessage& msg) {
   PADDLE_ENFORCE_NOT_NULL(
       carrier_,
       platform::errors::PreconditionNotMet("Carrier is not registered."));
   msg.set_src_id(interceptor_id_);
   msg.set_dst_id(dst_id);
+  // Only the messages sent in the task loop can use the local mailboxes,
+  // which have one producer each.
+  if (FLAGS_fleet_executor_local_message && !msg.ctrl_message() &&
+      loop_ != nullptr && loop_->IsInLoopThread()) {
+    Interceptor* dst = carrier_->GetLocalInterceptor(dst_id);
+    if (dst != nullptr) {
+      SendLocal(dst, msg);
+      return true;
+    }
+  }
   return carrier_->Send(msg);
 }
 
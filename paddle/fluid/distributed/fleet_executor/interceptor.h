@@ -14,15 +14,19 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <map>
 #include <memory>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
+#include "paddle/fluid/distributed/fleet_executor/spsc_queue.h"
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
@@ -43,6 +47,39 @@ class TaskLoop;
 constexpr int64_t SOURCE_ID = -1;
 constexpr int64_t SINK_ID = -2;
 
+// A message between two interceptors of a carrier, passed through the
+// lock free queues of the interceptors instead of as an InterceptorMessage.
+// It stands for count same messages.
+struct LocalInterceptorMessage {
+  int64_t src_id;
+  int64_t dst_id;
+  MessageType message_type;
+  int64_t scope_idx;
+  int64_t count;
+};
+
+class Interceptor;
+
+// The local messages sent by an interceptor while it handles a batch of
+// messages, enqueued to the receivers after the batch. Consecutive
+// DATA_IS_READY or DATA_IS_USELESS messages to a receiver with the same scope
+// are coalesced into one message with a count.
+class LocalMessageOutbox {
+ public:
+  using Item = std::pair<Interceptor*, LocalInterceptorMessage>;
+
+  void Add(Interceptor* dst, const LocalInterceptorMessage& message);
+
+  // Enqueues the messages to their receivers from the producer loop, and
+  // clears the outbox.
+  void Flush(TaskLoop* producer);
+
+  const std::vector<Item>& items() const { return items_; }
+
+ private:
+  std::vector<Item> items_;
+};
+
 class Interceptor {
  public:
   using MsgHandle = std::function<void(const InterceptorMessage&)>;
@@ -66,6 +103,11 @@ class Interceptor {
   void EnqueueRemoteInterceptorMessage(
       const InterceptorMessage& interceptor_message);
 
+  // Called by the interceptors of the carrier in the loop thread of
+  // producer, enqueue a message to the local mailbox
+  void EnqueueLocalInterceptorMessage(TaskLoop* producer,
+                                      const LocalInterceptorMessage& message);
+
   bool Send(int64_t dst_id, InterceptorMessage& msg);  // NOLINT
 
   void SetPlace(const platform::Place& place) { place_ = place; }
@@ -80,9 +122,17 @@ class Interceptor {
   }
   void RegisterCarrier(Carrier* carrier) { carrier_ = carrier; }
   void RegisterTaskLoop(TaskLoop* loop) { loop_ = loop; }
+  // Create a local mailbox for the interceptors running in every loop.
+  void RegisterLocalQueues(const std::vector<TaskLoop*>& loops);
 
   TaskNode* GetTaskNode() const { return node_; }
 
+  // The number of the messages handled, a coalesced message is counted as
+  // many times as it is handled.
+  int64_t GetHandledMessageCount() const {
+    return handled_message_count_.load(std::memory_order_relaxed);
+  }
+
   DISABLE_COPY_AND_ASSIGN(Interceptor);
 
  protected:
@@ -107,12 +157,26 @@ class Interceptor {
 
  private:
   void LoopOnce();
+  void ScheduleLoopOnce();
+  void SendLocal(Interceptor* dst, const InterceptorMessage& msg);
 
   // interceptor handle which process message
   MsgHandle handle_{nullptr};
 
   std::mutex mutex_;
   std::deque<InterceptorMessage> messages_;
+
+  // producer loop-->local mailbox, filled by the interceptors in the loop
+  std::unordered_map<TaskLoop*,
+                     std::unique_ptr<SpscQueue<LocalInterceptorMessage>>>
+      local_queues_;
+  // whether a LoopOnce is queued and has not started draining
+  std::atomic<bool> loop_scheduled_{false};
+  // The local messages sent while handling messages, which are coalesced
+  // and enqueued after the handling.
+  bool handling_{false};
+  LocalMessageOutbox outbox_;
+  std::atomic<int64_t> handled_message_count_{0};
 };
 
 class InterceptorFactory {
@@ -0,0 +1,122 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace distributed {
+
+// An unbounded lock free queue of one producer thread and one consumer
+// thread. The items are stored in blocks of kBlockSize, a block is
+// allocated when the last one is full, and the consumed blocks are kept
+// for reuse, so a queue of steady traffic does not allocate.
+template <typename T, size_t kBlockSize = 256>
+class SpscQueue {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "The items of SpscQueue must be trivially copyable.");
+
+ public:
+  SpscQueue() {
+    Block* block = new Block();
+    producer_.block = block;
+    consumer_.block = block;
+  }
+
+  ~SpscQueue() {
+    Block* block = consumer_.block;
+    while (block != nullptr) {
+      Block* next = block->next.load(std::memory_order_relaxed);
+      delete block;
+      block = next;
+    }
+    delete spare_.load(std::memory_order_relaxed);
+  }
+
+  // Called by the producer.
+  void Push(const T& item) {
+    if (producer_.index == kBlockSize) {
+      Block* block = spare_.exchange(nullptr, std::memory_order_acquire);
+      if (block == nullptr) {
+        block = new Block();
+      } else {
+        block->next.store(nullptr, std::memory_order_relaxed);
+      }
+      producer_.block->next.store(block, std::memory_order_relaxed);
+      producer_.block = block;
+      producer_.index = 0;
+    }
+    producer_.block->items[producer_.index++] = item;
+    // Publish the item, and the block it is in.
+    producer_.count.store(producer_.count.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_release);
+  }
+
+  // Called by the consumer, returns false if the queue is empty.
+  bool Pop(T* item) {
+    if (consumer_.count == producer_.count.load(std::memory_order_acquire)) {
+      return false;
+    }
+    if (consumer_.index == kBlockSize) {
+      Block* block = consumer_.block;
+      consumer_.block = block->next.load(std::memory_order_relaxed);
+      consumer_.index = 0;
+      // The producer has moved to a later block, so the block can be
+      // reused.
+      delete spare_.exchange(block, std::memory_order_release);
+    }
+    *item = consumer_.block->items[consumer_.index++];
+    ++consumer_.count;
+    return true;
+  }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(SpscQueue);
+
+  struct Block {
+    T items[kBlockSize];
+    std::atomic<Block*> next{nullptr};
+  };
+
+  // The fields of the producer and of the consumer are kept on separate
+  // cache lines, padded rather than aligned so that the queue can be
+  // allocated by new before C++17.
+  struct Producer {
+    char padding[64];
+    // The number of items pushed.
+    std::atomic<size_t> count{0};
+    Block* block;
+    size_t index{0};
+  };
+  struct Consumer {
+    char padding[64];
+    // The number of items popped.
+    size_t count{0};
+    Block* block;
+    size_t index{0};
+    char tail_padding[64];
+  };
+
+  Producer producer_;
+  Consumer consumer_;
+  std::atomic<Block*> spare_{nullptr};
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -45,10 +45,25 @@ void TaskLoop::Loop() {
   looping_ = true;
   quit_ = false;
 
+  std::deque<Functor> tasks;
   while (!quit_) {
-    auto tasks = tasks_.PopAll();
-    for (auto& task : tasks) {
-      task();
+    // Only wait for the tasks of other threads if there is no local task.
+    if (local_tasks_.empty() || tasks_.Size() > 0) {
+      tasks_.PopAll(&tasks);
+      for (auto& task : tasks) {
+        task();
+      }
+      tasks.clear();
+    }
+    while (!local_tasks_.empty() && !quit_) {
+      tasks.swap(local_tasks_);
+      for (auto& task : tasks) {
+        task();
+      }
+      tasks.clear();
+      if (tasks_.Size() > 0) {
+        break;
+      }
     }
   }
   looping_ = false;
@@ -67,7 +82,13 @@ void TaskLoop::RunInLoop(Functor cb) {
   }
 }
 
-void TaskLoop::QueueInLoop(Functor cb) { tasks_.Push(cb); }
+void TaskLoop::QueueInLoop(Functor cb) {
+  if (IsInLoopThread()) {
+    local_tasks_.emplace_back(std::move(cb));
+  } else {
+    tasks_.Push(std::move(cb));
+  }
+}
 
 void TaskLoop::WakeUp() {
   Functor task([] {});
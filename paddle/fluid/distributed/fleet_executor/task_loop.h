@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <deque>
 #include <functional>
 #include <future>
 #include <map>
@@ -78,6 +79,8 @@ class TaskLoop {
   std::thread::id thread_id_;
 
   framework::BlockingQueue<Functor> tasks_;
+  // the tasks queued by the loop thread itself, which need no lock
+  std::deque<Functor> local_tasks_;
 };
 
 }  // namespace distributed
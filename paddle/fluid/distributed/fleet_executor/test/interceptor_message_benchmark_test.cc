@@ -0,0 +1,126 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/fleet_executor/carrier.h"
+#include "paddle/fluid/distributed/fleet_executor/global.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor.h"
+#include "paddle/fluid/distributed/fleet_executor/message_bus.h"
+#include "paddle/fluid/distributed/fleet_executor/task_node.h"
+
+DECLARE_bool(fleet_executor_local_message);
+
+namespace paddle {
+namespace distributed {
+
+// Run micro_steps micro batches through a chain of ComputeInterceptors
+// without ops, and return the messages per second between them.
+double RunComputeChain(const std::string& carrier_id,
+                       int64_t num_computes,
+                       int64_t micro_steps) {
+  std::unordered_map<int64_t, int64_t> interceptor_id_to_rank{{SOURCE_ID, 0},
+                                                               {SINK_ID, 0}};
+  for (int64_t i = 0; i < num_computes; ++i) {
+    interceptor_id_to_rank.emplace(i, 0);
+  }
+  Carrier* carrier =
+      GlobalMap<std::string, Carrier>::Create(carrier_id, carrier_id);
+  carrier->Init(0, interceptor_id_to_rank);
+
+  // NOTE: don't delete, otherwise interceptor will use undefined node
+  std::vector<TaskNode*> nodes;
+  nodes.push_back(new TaskNode(0, SOURCE_ID, micro_steps));
+  for (int64_t i = 0; i < num_computes; ++i) {
+    nodes.push_back(new TaskNode(0, 0, i, micro_steps, 0));
+  }
+  nodes.push_back(new TaskNode(0, SINK_ID, micro_steps));
+  for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+    // Buffer two micro batches between the interceptors.
+    nodes[i]->AddDownstreamTask(nodes[i + 1]->task_id(), 2);
+    nodes[i + 1]->AddUpstreamTask(nodes[i]->task_id(), 2);
+  }
+
+  carrier->SetInterceptor(
+      SOURCE_ID, InterceptorFactory::Create("Source", SOURCE_ID, nodes[0]));
+  for (int64_t i = 0; i < num_computes; ++i) {
+    carrier->SetInterceptor(
+        i, InterceptorFactory::Create("Compute", i, nodes[i + 1]));
+  }
+  carrier->SetInterceptor(
+      SINK_ID, InterceptorFactory::Create("Sink", SINK_ID, nodes.back()));
+
+  auto start = std::chrono::steady_clock::now();
+  InterceptorMessage msg;
+  msg.set_message_type(START);
+  msg.set_dst_id(SOURCE_ID);
+  carrier->EnqueueInterceptorMessage(msg);
+  carrier->Wait();
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+
+  // A DATA_IS_READY and a DATA_IS_USELESS per micro batch of every link.
+  int64_t num_messages = 2 * (num_computes + 1) * micro_steps;
+  // The sink stops the carrier on its last DATA_IS_READY, the last
+  // DATA_IS_USELESS messages may still be on their way.
+  auto handled_messages = [&]() {
+    int64_t handled = 0;
+    for (int64_t id = SINK_ID; id < num_computes; ++id) {
+      handled += carrier->GetInterceptor(id)->GetHandledMessageCount();
+    }
+    return handled;
+  };
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (handled_messages() < num_messages + 1 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // And the START of the source.
+  EXPECT_EQ(handled_messages(), num_messages + 1);
+  for (int64_t i = 0; i < num_computes; ++i) {
+    EXPECT_EQ(carrier->GetInterceptor(i)->GetHandledMessageCount(),
+              2 * micro_steps);
+  }
+  EXPECT_EQ(carrier->GetInterceptor(SINK_ID)->GetHandledMessageCount(),
+            micro_steps);
+  carrier->Release();
+
+  return num_messages / seconds.count();
+}
+
+TEST(ComputeInterceptor, MessageBenchmark) {
+  MessageBus* msg_bus = GlobalVal<MessageBus>::Create();
+  msg_bus->Init(0, {{0, "127.0.0.0:0"}}, "");
+
+  const int64_t num_computes = 8;
+  const int64_t micro_steps = 20000;
+  FLAGS_fleet_executor_local_message = false;
+  double protobuf_rate = RunComputeChain("0", num_computes, micro_steps);
+  FLAGS_fleet_executor_local_message = true;
+  double local_rate = RunComputeChain("1", num_computes, micro_steps);
+  EXPECT_GT(protobuf_rate, 0);
+  EXPECT_GT(local_rate, 0);
+  std::cout << "Messages per second between ComputeInterceptors, by "
+               "protobuf: "
+            << protobuf_rate << ", by local queues: " << local_rate
+            << std::endl;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,111 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor.h"
+
+namespace paddle {
+namespace distributed {
+
+// The outbox does not touch the receivers until it is flushed, so the
+// messages are added without interceptors.
+LocalInterceptorMessage Message(int64_t dst_id,
+                                MessageType message_type,
+                                int64_t scope_idx = 0) {
+  return LocalInterceptorMessage{
+      /*src_id=*/0, dst_id, message_type, scope_idx, /*count=*/1};
+}
+
+TEST(LocalMessageOutbox, MergeCount) {
+  LocalMessageOutbox outbox;
+  for (int i = 0; i < 3; ++i) {
+    outbox.Add(nullptr, Message(1, DATA_IS_READY));
+  }
+  auto useless = Message(2, DATA_IS_USELESS);
+  outbox.Add(nullptr, useless);
+  useless.count = 4;
+  outbox.Add(nullptr, useless);
+
+  const auto& items = outbox.items();
+  ASSERT_EQ(items.size(), 2UL);
+  EXPECT_EQ(items[0].second.dst_id, 1);
+  EXPECT_EQ(items[0].second.message_type, DATA_IS_READY);
+  EXPECT_EQ(items[0].second.count, 3);
+  EXPECT_EQ(items[1].second.dst_id, 2);
+  EXPECT_EQ(items[1].second.message_type, DATA_IS_USELESS);
+  EXPECT_EQ(items[1].second.count, 5);
+}
+
+TEST(LocalMessageOutbox, NoMergeAcrossMessageType) {
+  LocalMessageOutbox outbox;
+  outbox.Add(nullptr, Message(1, DATA_IS_READY));
+  outbox.Add(nullptr, Message(1, DATA_IS_USELESS));
+  outbox.Add(nullptr, Message(1, DATA_IS_READY));
+
+  const auto& items = outbox.items();
+  ASSERT_EQ(items.size(), 3UL);
+  EXPECT_EQ(items[0].second.message_type, DATA_IS_READY);
+  EXPECT_EQ(items[1].second.message_type, DATA_IS_USELESS);
+  EXPECT_EQ(items[2].second.message_type, DATA_IS_READY);
+  for (const auto& item : items) {
+    EXPECT_EQ(item.second.count, 1);
+  }
+}
+
+TEST(LocalMessageOutbox, NoMergeAcrossScope) {
+  LocalMessageOutbox outbox;
+  outbox.Add(nullptr, Message(1, DATA_IS_READY, 0));
+  outbox.Add(nullptr, Message(1, DATA_IS_READY, 1));
+
+  const auto& items = outbox.items();
+  ASSERT_EQ(items.size(), 2UL);
+  EXPECT_EQ(items[0].second.scope_idx, 0);
+  EXPECT_EQ(items[1].second.scope_idx, 1);
+  EXPECT_EQ(items[0].second.count, 1);
+  EXPECT_EQ(items[1].second.count, 1);
+}
+
+TEST(LocalMessageOutbox, NoMergeAcrossReceiver) {
+  LocalMessageOutbox outbox;
+  outbox.Add(nullptr, Message(1, DATA_IS_READY));
+  outbox.Add(nullptr, Message(2, DATA_IS_READY));
+  // Merged with the last message to 1, the messages to other receivers in
+  // between do not change the order seen by 1.
+  outbox.Add(nullptr, Message(1, DATA_IS_READY));
+
+  const auto& items = outbox.items();
+  ASSERT_EQ(items.size(), 2UL);
+  EXPECT_EQ(items[0].second.dst_id, 1);
+  EXPECT_EQ(items[0].second.count, 2);
+  EXPECT_EQ(items[1].second.dst_id, 2);
+  EXPECT_EQ(items[1].second.count, 1);
+}
+
+TEST(LocalMessageOutbox, NoMergeOfOtherMessages) {
+  LocalMessageOutbox outbox;
+  outbox.Add(nullptr, Message(1, STOP));
+  outbox.Add(nullptr, Message(1, STOP));
+  outbox.Add(nullptr, Message(1, DATA_IS_READY));
+  outbox.Add(nullptr, Message(1, START));
+  outbox.Add(nullptr, Message(1, DATA_IS_READY));
+
+  const auto& items = outbox.items();
+  ASSERT_EQ(items.size(), 5UL);
+  for (const auto& item : items) {
+    EXPECT_EQ(item.second.count, 1);
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
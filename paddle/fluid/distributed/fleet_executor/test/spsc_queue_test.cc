@@ -0,0 +1,139 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/fleet_executor/spsc_queue.h"
+
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+constexpr size_t kSmallBlock = 4;
+
+// An item which counts its default constructions, kSmallBlock of which are
+// made by every block allocated. Copying it is still trivial.
+struct CountedItem {
+  static int64_t constructed;
+  CountedItem() { ++constructed; }
+  int64_t value{0};
+};
+int64_t CountedItem::constructed = 0;
+
+TEST(SpscQueue, EmptyPop) {
+  SpscQueue<int64_t, kSmallBlock> queue;
+  int64_t item = -1;
+  EXPECT_FALSE(queue.Pop(&item));
+  queue.Push(7);
+  EXPECT_TRUE(queue.Pop(&item));
+  EXPECT_EQ(item, 7);
+  EXPECT_FALSE(queue.Pop(&item));
+}
+
+TEST(SpscQueue, WrapAroundBlocks) {
+  SpscQueue<int64_t, kSmallBlock> queue;
+  int64_t pushed = 0;
+  int64_t popped = 0;
+  // Batches of every size around the block size, so that both ends cross
+  // the blocks at every index.
+  for (int round = 0; round < 50; ++round) {
+    for (size_t batch = 1; batch <= 3 * kSmallBlock; ++batch) {
+      for (size_t i = 0; i < batch; ++i) {
+        queue.Push(pushed++);
+      }
+      // Leave one item behind every other batch.
+      size_t pop_num = batch % 2 == 0 ? batch : batch - 1;
+      for (size_t i = 0; i < pop_num; ++i) {
+        int64_t item = -1;
+        ASSERT_TRUE(queue.Pop(&item));
+        ASSERT_EQ(item, popped++);
+      }
+    }
+  }
+  int64_t item = -1;
+  while (queue.Pop(&item)) {
+    ASSERT_EQ(item, popped++);
+  }
+  EXPECT_EQ(popped, pushed);
+}
+
+TEST(SpscQueue, ReuseSpareBlock) {
+  SpscQueue<CountedItem, kSmallBlock> queue;
+  CountedItem item;
+  int64_t next = 0;
+  auto push_pop = [&](size_t num) {
+    for (size_t i = 0; i < num; ++i) {
+      item.value = next + i;
+      queue.Push(item);
+    }
+    bool in_order = true;
+    for (size_t i = 0; i < num; ++i) {
+      in_order = queue.Pop(&item) && item.value == next + int64_t(i);
+      if (!in_order) {
+        break;
+      }
+    }
+    next += num;
+    return in_order;
+  };
+  for (size_t num : {size_t(1), kSmallBlock - 1, kSmallBlock}) {
+    // Warm up until both ends have crossed a few blocks, and the consumed
+    // block is kept as the spare one.
+    for (size_t i = 0; i < 3 * kSmallBlock; ++i) {
+      ASSERT_TRUE(push_pop(num));
+    }
+    int64_t constructed = CountedItem::constructed;
+    bool in_order = true;
+    for (int i = 0; i < 1000; ++i) {
+      in_order = in_order && push_pop(num);
+    }
+    EXPECT_TRUE(in_order);
+    // At most a block of items in flight, the producer takes the block
+    // released by the consumer instead of allocating one.
+    EXPECT_EQ(CountedItem::constructed, constructed) << "num " << num;
+  }
+  // More than a block in flight needs more blocks than the spare one.
+  int64_t constructed = CountedItem::constructed;
+  ASSERT_TRUE(push_pop(3 * kSmallBlock));
+  EXPECT_GT(CountedItem::constructed, constructed);
+}
+
+TEST(SpscQueue, TwoThreadsInOrder) {
+  SpscQueue<int64_t, 64> queue;
+  const int64_t num = 1000000;
+  std::thread producer([&] {
+    for (int64_t i = 0; i < num; ++i) {
+      queue.Push(i);
+    }
+  });
+  int64_t expected = 0;
+  bool in_order = true;
+  while (expected < num) {
+    int64_t item = -1;
+    if (!queue.Pop(&item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    in_order = in_order && item == expected;
+    ++expected;
+  }
+  producer.join();
+  EXPECT_TRUE(in_order);
+  int64_t item = -1;
+  EXPECT_FALSE(queue.Pop(&item));
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -62,6 +62,24 @@ DEFINE_int32(pserver_communicate_compress_type,
              0,
              "none:0 snappy:1 gzip:2 zlib:3 lz4:4");
 
+DEFINE_string(pserver_sparse_pull_codec,
+              "fp32",
+              "the codec of the pulled embeddings: fp32, fp16, bf16 or int8");
+
+DEFINE_string(pserver_sparse_push_codec,
+              "fp32",
+              "the codec of the pushed gradients: fp32, fp16, bf16 or int8");
+
+DEFINE_bool(pserver_sparse_push_error_feedback,
+            false,
+            "add the quantization errors of the pushed gradients of a key to "
+            "its next gradients, which keeps a residual per pushed key");
+
+DEFINE_int64(pserver_sparse_push_error_feedback_capacity,
+             1 << 20,
+             "the max number of the keys of a table whose residuals are kept "
+             "by the error feedback, the least recently pushed are evicted");
+
 DEFINE_int32(pserver_max_async_call_num,
              13,
              "max task num in async_call_server");
@@ -342,6 +360,9 @@ int32_t BrpcPsClient::Initialize() {
       _push_sparse_task_queue_map[table_id] =
           paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      if (InitializeSparseValueCoders(table_id) != 0) {
+        return -1;
+      }
     }
   }
 
@@ -717,8 +738,77 @@ void BrpcPsClient::PrintQueueSizeThread() {
   }
 }
 
+int32_t BrpcPsClient::InitializeSparseValueCoders(uint32_t table_id) {
+  SparseValueCodec pull_codec;
+  SparseValueCodec push_codec;
+  if (!ParseSparseValueCodec(FLAGS_pserver_sparse_pull_codec, &pull_codec) ||
+      !ParseSparseValueCodec(FLAGS_pserver_sparse_push_codec, &push_codec)) {
+    LOG(ERROR) << "unknown sparse value codec, pull: "
+               << FLAGS_pserver_sparse_pull_codec
+               << ", push: " << FLAGS_pserver_sparse_push_codec;
+    return -1;
+  }
+  // The codecs apply to the embedding columns the accessor knows, the
+  // tables of the other accessors are sent in float32.
+  auto *accessor = GetTableAccessor(table_id);
+  const auto &info = accessor->GetAccessorInfo();
+  size_t quant_dim = accessor->GetQuantizableDim();
+  _sparse_pull_coders[table_id] =
+      SparseValueCoder(pull_codec, info.select_dim, quant_dim);
+  _sparse_push_coders[table_id] =
+      SparseValueCoder(push_codec, info.update_dim, quant_dim);
+  if (FLAGS_pserver_sparse_push_error_feedback &&
+      _sparse_push_coders[table_id].codec() != SparseValueCodec::kFloat32) {
+    _sparse_push_error_feedbacks[table_id] =
+        std::make_shared<SparseValueErrorFeedback>(
+            _sparse_push_coders[table_id],
+            FLAGS_pserver_sparse_push_error_feedback_capacity);
+  }
+  return 0;
+}
+
+void BrpcPsClient::SerializeSparsePushData(size_t table_id,
+                                           const uint64_t *keys,
+                                           const float *const *values,
+                                           size_t num,
+                                           PsRequestMessage *push_request) {
+  const auto &coder = _sparse_push_coders[table_id];
+  size_t value_size = coder.EncodedBytes();
+  /*
+  Push Content:
+  |---keysData---|---valuesData---|
+  |---8*{num}B---|----------------|
+  */
+  auto *push_data = push_request->mutable_data();
+  push_data->resize(num * (sizeof(uint64_t) + value_size));
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
+  push_data_ptr += num * sizeof(uint64_t);
+  if (coder.codec() == SparseValueCodec::kFloat32) {
+    for (size_t i = 0; i < num; ++i) {
+      memcpy(push_data_ptr, values[i], value_size);
+      push_data_ptr += value_size;
+    }
+    return;
+  }
+
+  uint32_t codec = static_cast<uint32_t>(coder.codec());
+  push_request->add_params(reinterpret_cast<char *>(&codec),
+                           sizeof(uint32_t));
+  auto itr = _sparse_push_error_feedbacks.find(table_id);
+  if (itr != _sparse_push_error_feedbacks.end()) {
+    itr->second->Encode(keys, values, num, push_data_ptr);
+    return;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    coder.Encode(values[i], push_data_ptr);
+    push_data_ptr += value_size;
+  }
+}
+
 void BrpcPsClient::FinalizeWorker() {
   Flush();
+  PrintSparseTableCacheStat();
   VLOG(0) << "BrpcPsClient::FinalizeWorker begin join thread";
   _running = false;
   _async_push_dense_thread.join();
@@ -745,6 +835,7 @@ std::future<int32_t> BrpcPsClient::StopProfiler() {
 
 std::future<int32_t> BrpcPsClient::Barrier(size_t table_id,
                                            uint32_t barrier_type) {
+  ClearSparseTableCaches();
   return SendCmd(table_id, PS_BARRIER, {std::to_string(barrier_type)});
 }
 
@@ -846,6 +937,7 @@ std::future<int32_t> BrpcPsClient::PullDense(Region *regions,
                                              size_t region_num,
                                              size_t table_id) {
   auto timer = std::make_shared<CostTimer>("pserver_client_pull_dense");
+  ClearSparseTableCaches();
   auto *accessor = GetTableAccessor(table_id);
   auto fea_dim = accessor->GetAccessorInfo().fea_dim;
   size_t request_call_num = _server_channels.size();
@@ -1006,7 +1098,10 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     const float **update_values,
     size_t num,
     void *done) {
-  auto *accessor = GetTableAccessor(table_id);
+  auto *cache = GetSparseTableCache(table_id);
+  if (cache != NULL) {
+    cache->Push(keys, update_values, num);
+  }
   // 发送RPC请求
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1040,7 +1135,6 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     auto value_ptr = value_ptrs[shard_idx];
 
     size_t kv_size = kvs.size();
-    uint32_t value_size = accessor->GetAccessorInfo().update_size;
 
     // 发送RPC请求
     auto *push_request = closure->request(shard_idx);
@@ -1048,16 +1142,8 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
-    }
+    SerializeSparsePushData(
+        table_id, kvs.data(), value_ptr.data(), kv_size, push_request);
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1156,7 +1242,16 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
     }
   }
 
-  for (size_t i = 0; i < num; ++i) {
+  // The keys of the fresh values in the cache are not pulled.
+  auto *cache = GetSparseTableCache(table_id);
+  uint64_t cache_step = 0;
+  std::vector<size_t> missed;
+  if (cache != NULL) {
+    cache_step = cache->Lookup(keys, select_values, num, &missed);
+  }
+  size_t pull_num = cache != NULL ? missed.size() : num;
+  for (size_t j = 0; j < pull_num; ++j) {
+    size_t i = cache != NULL ? missed[j] : j;
     size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
     shard_sorted_kvs->at(shard_id).push_back({keys[i], select_values[i]});
   }
@@ -1164,11 +1259,16 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   auto *accessor = GetTableAccessor(table_id);
 
   size_t value_size = accessor->GetAccessorInfo().select_size;
+  const auto &coder = _sparse_pull_coders[table_id];
+  uint32_t codec = static_cast<uint32_t>(coder.codec());
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, coder, cache, cache_step](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        bool is_encoded = coder.codec() != SparseValueCodec::kFloat32;
+        std::vector<char> encoded(is_encoded ? coder.EncodedBytes() : 0);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
           if (closure->check_response(i, PS_PULL_SPARSE_TABLE) != 0) {
             ret = -1;
@@ -1190,15 +1290,36 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
             } else {
               last_key = kv_pair->first;
               last_value_data = kv_pair->second;
-              if (value_size !=
-                  io_buffer_itr.copy_and_forward(
-                      reinterpret_cast<void *>(last_value_data), value_size)) {
+              // The encoded values are decoded from the buffer.
+              void *read_data =
+                  is_encoded ? reinterpret_cast<void *>(encoded.data())
+                             : reinterpret_cast<void *>(last_value_data);
+              size_t read_size = is_encoded ? encoded.size() : value_size;
+              if (read_size !=
+                  io_buffer_itr.copy_and_forward(read_data, read_size)) {
                 LOG(WARNING) << "res data is lack or not in format";
                 ret = -1;
                 break;
               }
+              if (is_encoded) {
+                coder.Decode(encoded.data(), last_value_data);
+              }
+            }
+          }
+        }
+        if (ret == 0 && cache != NULL) {
+          std::vector<uint64_t> pulled_keys;
+          std::vector<const float *> pulled_values;
+          for (auto &request_kvs : *shard_sorted_kvs) {
+            for (auto &kv_pair : request_kvs) {
+              pulled_keys.push_back(kv_pair.first);
+              pulled_values.push_back(kv_pair.second);
             }
           }
+          cache->Insert(pulled_keys.data(),
+                        pulled_values.data(),
+                        pulled_keys.size(),
+                        cache_step);
         }
         closure->set_promise_value(ret);
       });
@@ -1250,6 +1371,10 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       closure->request(i)->set_client_id(_client_id);
       closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
                                       sizeof(uint32_t));
+      if (codec != static_cast<uint32_t>(SparseValueCodec::kFloat32)) {
+        closure->request(i)->add_params(reinterpret_cast<char *>(&codec),
+                                        sizeof(uint32_t));
+      }
       PsService_Stub rpc_stub(GetCmdChannel(i));
       closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
       rpc_stub.service(
@@ -1530,6 +1655,10 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
                                               size_t num) {
   auto push_timer = std::make_shared<CostTimer>("pserver_client_push_sparse");
   CostTimer parse_timer("pserver_client_push_sparse_parse");
+  auto *cache = GetSparseTableCache(table_id);
+  if (cache != NULL) {
+    cache->Push(keys, update_values, num);
+  }
   int push_sparse_async_num = _push_sparse_task_queue_map[table_id]->Size();
   while (push_sparse_async_num > FLAGS_pserver_max_async_call_num) {
     //    LOG(INFO) << "PushSparse Waiting for async_call_num comsume,
@@ -1857,22 +1986,16 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->set_client_id(_client_id);
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
+  std::vector<const float *> merged_values(merged_kv_count);
   for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
+    merged_values[i] =
+        reinterpret_cast<const float *>(merged_value_list[i].data());
   }
+  SerializeSparsePushData(table_id,
+                          merged_key_list.data(),
+                          merged_values.data(),
+                          merged_kv_count,
+                          push_request);
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -26,6 +26,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_value_codec.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -360,6 +361,18 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // the wire codecs of the sparse tables
+  std::unordered_map<uint32_t, SparseValueCoder> _sparse_pull_coders;
+  std::unordered_map<uint32_t, SparseValueCoder> _sparse_push_coders;
+  std::unordered_map<uint32_t, std::shared_ptr<SparseValueErrorFeedback>>
+      _sparse_push_error_feedbacks;
+
+  int32_t InitializeSparseValueCoders(uint32_t table_id);
+  void SerializeSparsePushData(size_t table_id,
+                               const uint64_t *keys,
+                               const float *const *values,
+                               size_t num,
+                               PsRequestMessage *push_request);
 
   std::thread _print_thread;
 
@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/sparse_value_codec.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -239,6 +240,32 @@ int32_t BrpcPsService::Initialize() {
     return -1;                                             \
   }
 
+namespace {
+
+// The coder of the sparse values in the codec of the param_idx-th param of
+// the request, float32 without the param. Returns false for unknown codecs.
+bool GetSparseValueCoder(Table *table,
+                         const PsRequestMessage &request,
+                         int param_idx,
+                         size_t dim,
+                         SparseValueCoder *coder) {
+  if (request.params_size() <= param_idx) {
+    *coder = SparseValueCoder();
+    return true;
+  }
+  uint32_t codec =
+      *(reinterpret_cast<const uint32_t *>(request.params(param_idx).c_str()));
+  if (codec > static_cast<uint32_t>(SparseValueCodec::kInt8)) {
+    return false;
+  }
+  *coder = SparseValueCoder(static_cast<SparseValueCodec>(codec),
+                            dim,
+                            table->ValueAccesor()->GetQuantizableDim());
+  return true;
+}
+
+}  // namespace
+
 int32_t BrpcPsService::InitializeShardInfo() {
   if (!_is_initialize_shard_info) {
     std::lock_guard<std::mutex> guard(_initialize_shard_mutex);
@@ -543,8 +570,26 @@ int32_t BrpcPsService::PullSparse(Table *table,
   table->Pull(table_context);
   // table->PullSparse(res_data->data(), value);
 
-  cntl->response_attachment().append(reinterpret_cast<char *>(res_data->data()),
-                                     res_data->size() * sizeof(float));
+  // The client asks for the values in its codec.
+  SparseValueCoder coder;
+  if (!GetSparseValueCoder(table, request, 1, dim, &coder)) {
+    set_response_code(response, -1, "unknown sparse value codec");
+    butil::return_object(res_data);
+    return 0;
+  }
+  if (coder.codec() == SparseValueCodec::kFloat32) {
+    cntl->response_attachment().append(
+        reinterpret_cast<char *>(res_data->data()),
+        res_data->size() * sizeof(float));
+  } else {
+    thread_local std::vector<char> encoded;
+    encoded.resize(num * coder.EncodedBytes());
+    for (size_t i = 0; i < num; ++i) {
+      coder.Encode(res_data->data() + i * dim,
+                   encoded.data() + i * coder.EncodedBytes());
+    }
+    cntl->response_attachment().append(encoded.data(), encoded.size());
+  }
   butil::return_object(res_data);
   return 0;
 }
@@ -582,6 +627,27 @@ int32_t BrpcPsService::PushSparse(Table *table,
   table_context.push_context.values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
   table_context.num = num;
+  // The encoded gradients are decoded before the updates of the table.
+  SparseValueCoder coder;
+  auto dim = table->ValueAccesor()->GetAccessorInfo().update_dim;
+  if (!GetSparseValueCoder(table, request, 1, dim, &coder)) {
+    set_response_code(response, -1, "unknown sparse value codec");
+    return 0;
+  }
+  thread_local std::vector<float> decoded;
+  if (coder.codec() != SparseValueCodec::kFloat32) {
+    if (push_data.size() != num * (sizeof(uint64_t) + coder.EncodedBytes())) {
+      set_response_code(response, -1, "PushSparse data is not in format");
+      return 0;
+    }
+    const char *encoded = push_data.data() + sizeof(uint64_t) * num;
+    decoded.resize(num * dim);
+    for (size_t i = 0; i < num; ++i) {
+      coder.Decode(encoded + i * coder.EncodedBytes(),
+                   decoded.data() + i * dim);
+    }
+    table_context.push_context.values = decoded.data();
+  }
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
   // num);
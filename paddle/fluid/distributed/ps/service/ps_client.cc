@@ -45,19 +45,41 @@ int32_t PSClient::Configure(  // called in FleetWrapper::InitWorker
                      .downpour_table_param());
 
   const auto &work_param = _config.worker_param().downpour_worker_param();
+  auto cache_options = GetSparseTableCacheOptionsFromFlags();
 
   for (int i = 0; i < work_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = work_param.downpour_table_param(i);
     auto *accessor = CREATE_PSCORE_CLASS(
-        ValueAccessor,
-        work_param.downpour_table_param(i).accessor().accessor_class());
-    accessor->Configure(work_param.downpour_table_param(i).accessor());
+        ValueAccessor, table_param.accessor().accessor_class());
+    accessor->Configure(table_param.accessor());
     accessor->Initialize();
-    _table_accessors[work_param.downpour_table_param(i).table_id()].reset(
-        accessor);
+    _table_accessors[table_param.table_id()].reset(accessor);
+    if (cache_options.max_bytes > 0 &&
+        table_param.type() == PS_SPARSE_TABLE) {
+      const auto &info = accessor->GetAccessorInfo();
+      _sparse_table_caches[table_param.table_id()] =
+          std::make_shared<SparseTableCache>(
+              cache_options, info.select_dim, info.update_dim);
+    }
   }
   return Initialize();
 }
 
+void PSClient::ClearSparseTableCaches() {
+  for (auto &it : _sparse_table_caches) {
+    it.second->Clear();
+  }
+}
+
+void PSClient::PrintSparseTableCacheStat() {
+  for (auto &it : _sparse_table_caches) {
+    VLOG(0) << "sparse table cache of table " << it.first
+            << ", hits: " << it.second->Hits()
+            << ", misses: " << it.second->Misses()
+            << ", hit rate: " << it.second->HitRate();
+  }
+}
+
 PSClient *PSClientFactory::Create(const PSParameter &ps_config) {
   const auto &config = ps_config.server_param();
   if (!config.has_downpour_server_param()) {
@@ -24,6 +24,7 @@
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/ps/service/env.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_table_cache.h"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
@@ -237,6 +238,20 @@ class PSClient {
     return itr->second.get();
   }
 
+  // The worker-side cache of the sparse table, NULL when the cache is off.
+  virtual SparseTableCache *GetSparseTableCache(size_t table_id) {
+    auto itr = _sparse_table_caches.find(table_id);
+    if (itr == _sparse_table_caches.end()) {
+      return NULL;
+    }
+    return itr->second.get();
+  }
+
+  // Invalidates the cached sparse values, on PullDense and Barrier.
+  void ClearSparseTableCaches();
+
+  void PrintSparseTableCacheStat();
+
   virtual size_t GetServerNums() = 0;
 
   virtual std::future<int32_t> PushDenseRawGradient(int table_id,
@@ -336,6 +351,8 @@ class PSClient {
   std::map<uint64_t, std::vector<paddle::distributed::Region>>
       _dense_pull_regions;
   std::unordered_map<uint32_t, std::shared_ptr<ValueAccessor>> _table_accessors;
+  std::unordered_map<uint32_t, std::shared_ptr<SparseTableCache>>
+      _sparse_table_caches;
   std::unordered_map<int32_t, MsgHandlerFunc>
       _msg_handler_map;  // 处理client2client消息
 
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/distributed/ps/service/ps_local_client.h"
 
+#include <numeric>
+
 #include "paddle/fluid/distributed/ps/table/table.h"
 
 // #define pslib_debug_dense_compress
@@ -97,6 +99,7 @@ int32_t PsLocalClient::Initialize() {
 ::std::future<int32_t> PsLocalClient::PullDense(Region* regions,
                                                 size_t region_num,
                                                 size_t table_id) {
+  ClearSparseTableCaches();
   auto* accessor = GetTableAccessor(table_id);
   auto* table_ptr = GetTable(table_id);
 
@@ -264,6 +267,55 @@ int32_t PsLocalClient::Initialize() {
 //  return done();
 //}
 
+::std::future<int32_t> PsLocalClient::PullSparse(float** select_values,
+                                                 size_t table_id,
+                                                 const uint64_t* keys,
+                                                 size_t num,
+                                                 bool is_training) {
+  auto* accessor = GetTableAccessor(table_id);
+  auto* table_ptr = GetTable(table_id);
+  size_t value_dim = accessor->GetAccessorInfo().select_dim;
+
+  // The keys of the fresh values in the cache are not pulled.
+  auto* cache = GetSparseTableCache(table_id);
+  uint64_t cache_step = 0;
+  std::vector<size_t> missed;
+  if (cache != NULL) {
+    cache_step = cache->Lookup(keys, select_values, num, &missed);
+  } else {
+    missed.resize(num);
+    std::iota(missed.begin(), missed.end(), 0);
+  }
+  std::vector<uint64_t> pull_keys(missed.size());
+  std::vector<uint32_t> pull_frequencies(missed.size(), 1);
+  for (size_t i = 0; i < missed.size(); ++i) {
+    pull_keys[i] = keys[missed[i]];
+  }
+  std::vector<float> res_data(missed.size() * value_dim);
+
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.values = res_data.data();
+  table_context.pull_context.pull_value =
+      PullSparseValue(pull_keys, pull_frequencies, value_dim);
+  table_context.pull_context.pull_value.is_training_ = is_training;
+  table_context.num = pull_keys.size();
+  table_ptr->Pull(table_context);
+
+  std::vector<const float*> pulled_values(missed.size());
+  for (size_t i = 0; i < missed.size(); ++i) {
+    memcpy(select_values[missed[i]],
+           res_data.data() + i * value_dim,
+           value_dim * sizeof(float));
+    pulled_values[i] = select_values[missed[i]];
+  }
+  if (cache != NULL) {
+    cache->Insert(
+        pull_keys.data(), pulled_values.data(), pull_keys.size(), cache_step);
+  }
+  return done();
+}
+
 ::std::future<int32_t> PsLocalClient::PullSparsePtr(int shard_id,
                                                     char** select_values,
                                                     size_t table_id,
@@ -323,6 +375,10 @@ int32_t PsLocalClient::Initialize() {
     void* callback) {
   PSClientClosure* closure = reinterpret_cast<PSClientClosure*>(callback);
   auto* table_ptr = GetTable(table_id);
+  auto* cache = GetSparseTableCache(table_id);
+  if (cache != NULL) {
+    cache->Push(keys, update_values, num);
+  }
 
   TableContext table_context;
   table_context.value_type = Sparse;
@@ -342,6 +398,10 @@ int32_t PsLocalClient::Initialize() {
                                                  const float** update_values,
                                                  size_t num) {
   auto* table_ptr = GetTable(table_id);
+  auto* cache = GetSparseTableCache(table_id);
+  if (cache != NULL) {
+    cache->Push(keys, update_values, num);
+  }
 
   TableContext table_context;
   table_context.value_type = Sparse;
@@ -68,13 +68,7 @@ class PsLocalClient : public PSClient {
                                             size_t table_id,
                                             const uint64_t* keys,
                                             size_t num,
-                                            bool is_training) {
-    std::promise<int32_t> prom;
-    std::future<int32_t> fut = prom.get_future();
-    prom.set_value(0);
-
-    return fut;
-  }
+                                            bool is_training);
 
   virtual ::std::future<int32_t> PullSparsePtr(int shard_id,
                                                char** select_values,
@@ -113,6 +107,7 @@ class PsLocalClient : public PSClient {
   }
 
   virtual std::future<int32_t> Barrier(size_t table_id, uint32_t barrier_type) {
+    ClearSparseTableCaches();
     std::promise<int32_t> prom;
     std::future<int32_t> fut = prom.get_future();
     prom.set_value(0);
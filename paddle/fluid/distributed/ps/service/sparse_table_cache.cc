@@ -0,0 +1,213 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_table_cache.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <string>
+
+#include "gflags/gflags.h"
+
+DEFINE_int32(pserver_sparse_cache_max_mb,
+             0,
+             "the budget of the worker-side cache of each sparse table in MB, "
+             "the cache is off when it is 0");
+DEFINE_int32(pserver_sparse_cache_staleness_steps,
+             0,
+             "the pushes of a sparse table a cached value is served after");
+DEFINE_int32(pserver_sparse_cache_staleness_ms,
+             0,
+             "the milliseconds a cached value is served for, unbounded when 0");
+DEFINE_string(pserver_sparse_cache_policy,
+              "lru",
+              "the eviction policy of the sparse table cache, lru or lfu");
+DEFINE_double(pserver_sparse_cache_fold_learning_rate,
+              0,
+              "the learning rate to fold the pushed gradients into the "
+              "cached values with, the pushed keys are evicted when it is 0");
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+// The show and click columns of the pull value are counters.
+constexpr size_t kCounterDim = 2;
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+constexpr size_t SparseTableCache::kEntryOverheadBytes;
+
+SparseTableCacheOptions GetSparseTableCacheOptionsFromFlags() {
+  SparseTableCacheOptions options;
+  options.max_bytes =
+      static_cast<size_t>(FLAGS_pserver_sparse_cache_max_mb) << 20;
+  options.staleness_steps = FLAGS_pserver_sparse_cache_staleness_steps;
+  options.staleness_ms = FLAGS_pserver_sparse_cache_staleness_ms;
+  options.lfu = FLAGS_pserver_sparse_cache_policy == "lfu";
+  options.fold_learning_rate =
+      static_cast<float>(FLAGS_pserver_sparse_cache_fold_learning_rate);
+  return options;
+}
+
+SparseTableCache::SparseTableCache(const SparseTableCacheOptions& options,
+                                   size_t select_dim,
+                                   size_t update_dim)
+    : options_(options),
+      select_dim_(select_dim),
+      entry_bytes_(select_dim * sizeof(float) + kEntryOverheadBytes),
+      can_fold_(options.fold_learning_rate > 0 &&
+                update_dim == select_dim + 1 && select_dim > kCounterDim) {}
+
+bool SparseTableCache::IsFresh(const Entry& entry, int64_t now_ms) const {
+  if (step_ - entry.step > static_cast<uint64_t>(options_.staleness_steps)) {
+    return false;
+  }
+  return options_.staleness_ms <= 0 ||
+         now_ms - entry.time_ms <= options_.staleness_ms;
+}
+
+void SparseTableCache::Erase(
+    std::unordered_map<uint64_t, Entry>::iterator iter) {
+  priorities_.erase(GetPriority(iter->first, iter->second));
+  entries_.erase(iter);
+}
+
+uint64_t SparseTableCache::Lookup(const uint64_t* keys,
+                                  float** select_values,
+                                  size_t num,
+                                  std::vector<size_t>* missed) {
+  int64_t now_ms = options_.staleness_ms > 0 ? NowMs() : 0;
+  size_t missed_num = missed->size();
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (size_t i = 0; i < num; ++i) {
+    auto iter = entries_.find(keys[i]);
+    if (iter != entries_.end() && !IsFresh(iter->second, now_ms)) {
+      Erase(iter);
+      iter = entries_.end();
+    }
+    if (iter == entries_.end()) {
+      missed->push_back(i);
+      continue;
+    }
+    Entry& entry = iter->second;
+    memcpy(select_values[i], entry.value.data(), select_dim_ * sizeof(float));
+    priorities_.erase(GetPriority(keys[i], entry));
+    ++entry.hits;
+    entry.tick = ++tick_;
+    priorities_.insert(GetPriority(keys[i], entry));
+  }
+  missed_num = missed->size() - missed_num;
+  hits_ += num - missed_num;
+  misses_ += missed_num;
+  return step_;
+}
+
+void SparseTableCache::Insert(const uint64_t* keys,
+                              const float* const* values,
+                              size_t num,
+                              uint64_t step) {
+  if (entry_bytes_ > options_.max_bytes) {
+    return;
+  }
+  int64_t now_ms = options_.staleness_ms > 0 ? NowMs() : 0;
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (size_t i = 0; i < num; ++i) {
+    auto iter = entries_.find(keys[i]);
+    if (iter != entries_.end()) {
+      // Keep the value of a later pull.
+      if (iter->second.step > step) {
+        continue;
+      }
+      Erase(iter);
+    }
+    Entry entry;
+    entry.value.assign(values[i], values[i] + select_dim_);
+    entry.step = step;
+    entry.time_ms = now_ms;
+    entry.hits = 0;
+    entry.tick = ++tick_;
+    if (!IsFresh(entry, now_ms)) {
+      continue;
+    }
+    // Evict before the insertion, so the new value is kept.
+    while ((entries_.size() + 1) * entry_bytes_ > options_.max_bytes) {
+      Erase(entries_.find(std::get<2>(*priorities_.begin())));
+    }
+    priorities_.insert(GetPriority(keys[i], entry));
+    entries_.emplace(keys[i], std::move(entry));
+  }
+}
+
+void SparseTableCache::Push(const uint64_t* keys,
+                            const float* const* update_values,
+                            size_t num) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (size_t i = 0; i < num; ++i) {
+    auto iter = entries_.find(keys[i]);
+    if (iter == entries_.end()) {
+      continue;
+    }
+    if (!can_fold_) {
+      Erase(iter);
+      continue;
+    }
+    float* value = iter->second.value.data();
+    const float* update_value = update_values[i] + 1;
+    for (size_t j = 0; j < kCounterDim; ++j) {
+      value[j] += update_value[j];
+    }
+    for (size_t j = kCounterDim; j < select_dim_; ++j) {
+      value[j] -= options_.fold_learning_rate * update_value[j];
+    }
+  }
+  ++step_;
+}
+
+void SparseTableCache::Clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  entries_.clear();
+  priorities_.clear();
+}
+
+size_t SparseTableCache::Size() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return entries_.size();
+}
+
+uint64_t SparseTableCache::Hits() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return hits_;
+}
+
+uint64_t SparseTableCache::Misses() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return misses_;
+}
+
+double SparseTableCache::HitRate() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  uint64_t total = hits_ + misses_;
+  return total == 0 ? 0 : static_cast<double>(hits_) / total;
+}
+
+}  // namespace distributed
+}  // namespace paddle
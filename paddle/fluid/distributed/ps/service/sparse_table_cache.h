@@ -0,0 +1,120 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+struct SparseTableCacheOptions {
+  // The budget of the cached values in bytes, the cache is off when it is 0.
+  size_t max_bytes = 0;
+  // A cached value is served until the table is pushed more than
+  // staleness_steps times after the pull, and for at most staleness_ms
+  // milliseconds when staleness_ms is positive.
+  int64_t staleness_steps = 0;
+  int64_t staleness_ms = 0;
+  // Evicts the least frequently used values instead of the least recently
+  // used ones.
+  bool lfu = false;
+  // The pushed gradients are applied to the cached values with this learning
+  // rate, the pushed keys are evicted when it is 0.
+  float fold_learning_rate = 0;
+};
+
+// The options from the pserver_sparse_cache_* flags.
+SparseTableCacheOptions GetSparseTableCacheOptionsFromFlags();
+
+// The worker-side cache of the values pulled from a sparse table, so the hot
+// keys are not pulled from the servers at every step. The step of the table
+// is the number of its pushes.
+//
+// The pushed gradients are folded into the cached values when the accessor
+// has the layouts of CtrCommonAccessor, where the column i of the pull value
+// (show, click, embed_w, embedx_w...) is updated by the column i + 1 of the
+// push value (slot, show, click, embed_g, embedx_g...).
+class SparseTableCache {
+ public:
+  // The bytes of an entry besides the value, in the hash map and the set.
+  static constexpr size_t kEntryOverheadBytes = 128;
+
+  SparseTableCache(const SparseTableCacheOptions& options,
+                   size_t select_dim,
+                   size_t update_dim);
+
+  // Copies the fresh cached values of the keys to select_values, and appends
+  // the indexes of the other keys to missed. Returns the step to insert the
+  // values of the missed keys at.
+  uint64_t Lookup(const uint64_t* keys,
+                  float** select_values,
+                  size_t num,
+                  std::vector<size_t>* missed);
+
+  // Caches the values pulled at the step.
+  void Insert(const uint64_t* keys,
+              const float* const* values,
+              size_t num,
+              uint64_t step);
+
+  // Folds the pushed values into the cached values or evicts the keys, and
+  // advances the step.
+  void Push(const uint64_t* keys, const float* const* update_values, size_t num);
+
+  void Clear();
+
+  size_t Size() const;
+  uint64_t Hits() const;
+  uint64_t Misses() const;
+  double HitRate() const;
+
+ private:
+  struct Entry {
+    std::vector<float> value;
+    uint64_t step;
+    int64_t time_ms;
+    uint64_t hits;
+    uint64_t tick;
+  };
+  // (hits, tick, key), the front is evicted first.
+  using Priority = std::tuple<uint64_t, uint64_t, uint64_t>;
+
+  Priority GetPriority(uint64_t key, const Entry& entry) const {
+    return Priority(options_.lfu ? entry.hits : 0, entry.tick, key);
+  }
+  bool IsFresh(const Entry& entry, int64_t now_ms) const;
+  void Erase(std::unordered_map<uint64_t, Entry>::iterator iter);
+
+  SparseTableCacheOptions options_;
+  size_t select_dim_;
+  size_t entry_bytes_;
+  bool can_fold_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, Entry> entries_;
+  std::set<Priority> priorities_;
+  uint64_t step_ = 0;
+  uint64_t tick_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace distributed
+}  // namespace paddle
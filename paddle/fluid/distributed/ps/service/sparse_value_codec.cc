@@ -0,0 +1,210 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_value_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+template <typename T>
+void EncodeHalf(const float *value, size_t num, char *out) {
+  for (size_t i = 0; i < num; ++i) {
+    T half(value[i]);
+    memcpy(out + i * sizeof(T), &half, sizeof(T));
+  }
+}
+
+template <typename T>
+void DecodeHalf(const char *in, size_t num, float *value) {
+  for (size_t i = 0; i < num; ++i) {
+    T half;
+    memcpy(&half, in + i * sizeof(T), sizeof(T));
+    value[i] = static_cast<float>(half);
+  }
+}
+
+}  // namespace
+
+bool ParseSparseValueCodec(const std::string &name, SparseValueCodec *codec) {
+  if (name == "fp32") {
+    *codec = SparseValueCodec::kFloat32;
+  } else if (name == "fp16") {
+    *codec = SparseValueCodec::kFloat16;
+  } else if (name == "bf16") {
+    *codec = SparseValueCodec::kBFloat16;
+  } else if (name == "int8") {
+    *codec = SparseValueCodec::kInt8;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+SparseValueCoder::SparseValueCoder(SparseValueCodec codec,
+                                   size_t dim,
+                                   size_t quant_dim)
+    : codec_(codec), dim_(dim) {
+  if (codec == SparseValueCodec::kFloat32 || quant_dim == 0 ||
+      quant_dim > dim) {
+    codec_ = SparseValueCodec::kFloat32;
+    quant_dim = 0;
+  }
+  quant_dim_ = quant_dim;
+  raw_dim_ = dim - quant_dim;
+  encoded_bytes_ = raw_dim_ * sizeof(float);
+  switch (codec_) {
+    case SparseValueCodec::kFloat16:
+    case SparseValueCodec::kBFloat16:
+      encoded_bytes_ += quant_dim_ * sizeof(uint16_t);
+      break;
+    case SparseValueCodec::kInt8:
+      encoded_bytes_ += sizeof(float) + quant_dim_ * sizeof(int8_t);
+      break;
+    default:
+      break;
+  }
+}
+
+void SparseValueCoder::Encode(const float *value, char *out) const {
+  memcpy(out, value, raw_dim_ * sizeof(float));
+  out += raw_dim_ * sizeof(float);
+  value += raw_dim_;
+  switch (codec_) {
+    case SparseValueCodec::kFloat16:
+      EncodeHalf<phi::dtype::float16>(value, quant_dim_, out);
+      break;
+    case SparseValueCodec::kBFloat16:
+      EncodeHalf<phi::dtype::bfloat16>(value, quant_dim_, out);
+      break;
+    case SparseValueCodec::kInt8: {
+      float max_abs = 0;
+      for (size_t i = 0; i < quant_dim_; ++i) {
+        max_abs = std::max(max_abs, std::fabs(value[i]));
+      }
+      float scale = max_abs / 127;
+      memcpy(out, &scale, sizeof(float));
+      int8_t *quant = reinterpret_cast<int8_t *>(out + sizeof(float));
+      for (size_t i = 0; i < quant_dim_; ++i) {
+        float q = scale > 0 ? std::round(value[i] / scale) : 0;
+        quant[i] = static_cast<int8_t>(std::min(std::max(q, -127.f), 127.f));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void SparseValueCoder::Decode(const char *in, float *value) const {
+  memcpy(value, in, raw_dim_ * sizeof(float));
+  in += raw_dim_ * sizeof(float);
+  value += raw_dim_;
+  switch (codec_) {
+    case SparseValueCodec::kFloat16:
+      DecodeHalf<phi::dtype::float16>(in, quant_dim_, value);
+      break;
+    case SparseValueCodec::kBFloat16:
+      DecodeHalf<phi::dtype::bfloat16>(in, quant_dim_, value);
+      break;
+    case SparseValueCodec::kInt8: {
+      float scale;
+      memcpy(&scale, in, sizeof(float));
+      const int8_t *quant =
+          reinterpret_cast<const int8_t *>(in + sizeof(float));
+      for (size_t i = 0; i < quant_dim_; ++i) {
+        value[i] = quant[i] * scale;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+constexpr size_t SparseValueErrorFeedback::kShardNum;
+
+SparseValueErrorFeedback::SparseValueErrorFeedback(
+    const SparseValueCoder &coder, size_t capacity)
+    : coder_(coder),
+      shard_capacity_(std::max<size_t>(1, capacity / kShardNum)) {}
+
+float *SparseValueErrorFeedback::GetResidual(Shard *shard, uint64_t key) {
+  auto &residuals = shard->residuals;
+  auto itr = shard->index.find(key);
+  if (itr != shard->index.end()) {
+    residuals.splice(residuals.begin(), residuals, itr->second);
+    return residuals.front().value.data();
+  }
+  if (residuals.size() < shard_capacity_) {
+    residuals.push_front({key, std::vector<float>(coder_.quant_dim(), 0)});
+  } else {
+    // Reuse the residual of the least recently pushed key.
+    residuals.splice(residuals.begin(), residuals, std::prev(residuals.end()));
+    shard->index.erase(residuals.front().key);
+    residuals.front().key = key;
+    std::fill(residuals.front().value.begin(),
+              residuals.front().value.end(),
+              0.f);
+  }
+  shard->index[key] = residuals.begin();
+  return residuals.front().value.data();
+}
+
+void SparseValueErrorFeedback::Encode(const uint64_t *keys,
+                                      const float *const *values,
+                                      size_t num,
+                                      char *out) {
+  size_t dim = coder_.dim();
+  size_t quant_dim = coder_.quant_dim();
+  size_t raw_dim = dim - quant_dim;
+  std::vector<float> value(dim);
+  std::vector<float> decoded(dim);
+  for (size_t i = 0; i < num; ++i) {
+    auto &shard = shards_[keys[i] % kShardNum];
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    float *residual = GetResidual(&shard, keys[i]);
+    memcpy(value.data(), values[i], raw_dim * sizeof(float));
+    for (size_t j = 0; j < quant_dim; ++j) {
+      value[raw_dim + j] = values[i][raw_dim + j] + residual[j];
+    }
+    coder_.Encode(value.data(), out);
+    coder_.Decode(out, decoded.data());
+    for (size_t j = 0; j < quant_dim; ++j) {
+      residual[j] = value[raw_dim + j] - decoded[raw_dim + j];
+    }
+    out += coder_.EncodedBytes();
+  }
+}
+
+size_t SparseValueErrorFeedback::Size() {
+  size_t size = 0;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    size += shard.residuals.size();
+  }
+  return size;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,110 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// The encodings of the sparse values on the wire. The codec of a request is
+// sent in its params, so the servers decode the requests of any client.
+enum class SparseValueCodec : uint32_t {
+  kFloat32 = 0,
+  kFloat16 = 1,
+  kBFloat16 = 2,
+  // int8 with a float scale per value
+  kInt8 = 3,
+};
+
+// Parses fp32, fp16, bf16 or int8, returns false for the other names.
+bool ParseSparseValueCodec(const std::string &name, SparseValueCodec *codec);
+
+// Encodes the trailing quant_dim columns of the values of dim columns, the
+// embedding or its gradient, with the codec, and keeps the leading columns,
+// such as the slot, show and click, in float32.
+class SparseValueCoder {
+ public:
+  SparseValueCoder() : SparseValueCoder(SparseValueCodec::kFloat32, 0, 0) {}
+  SparseValueCoder(SparseValueCodec codec, size_t dim, size_t quant_dim);
+
+  SparseValueCodec codec() const { return codec_; }
+  size_t dim() const { return dim_; }
+  // The number of the trailing columns encoded with the codec.
+  size_t quant_dim() const { return quant_dim_; }
+  // The bytes of an encoded value.
+  size_t EncodedBytes() const { return encoded_bytes_; }
+
+  void Encode(const float *value, char *out) const;
+  void Decode(const char *in, float *value) const;
+
+ private:
+  SparseValueCodec codec_;
+  size_t dim_;
+  size_t quant_dim_;
+  size_t raw_dim_;
+  size_t encoded_bytes_;
+};
+
+// Encodes the pushed gradients with the error feedback: the quantization
+// error of the gradient of a key is added to its next gradient, so the
+// gradients applied by the servers sum to the pushed ones.
+//
+// The residuals are kept for at most capacity keys, in shards locked by the
+// keys. The least recently pushed key of a full shard is evicted, and its
+// residual, at most half a quantization step per column, is dropped.
+class SparseValueErrorFeedback {
+ public:
+  static constexpr size_t kShardNum = 16;
+
+  SparseValueErrorFeedback(const SparseValueCoder &coder, size_t capacity);
+
+  void Encode(const uint64_t *keys,
+              const float *const *values,
+              size_t num,
+              char *out);
+
+  size_t Size();
+
+ private:
+  struct Residual {
+    uint64_t key;
+    // of the quantized columns, the others are sent exactly
+    std::vector<float> value;
+  };
+
+  // The residuals of a shard, the most recently pushed first.
+  struct Shard {
+    std::mutex mutex;
+    std::list<Residual> residuals;
+    std::unordered_map<uint64_t, std::list<Residual>::iterator> index;
+  };
+
+  // Returns the residual of the key, moved to the front of the shard. The
+  // residual of a new key is zero.
+  float *GetResidual(Shard *shard, uint64_t key);
+
+  SparseValueCoder coder_;
+  size_t shard_capacity_;
+  Shard shards_[kShardNum];
+};
+
+}  // namespace distributed
+}  // namespace paddle
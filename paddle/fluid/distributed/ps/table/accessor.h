@@ -90,6 +90,9 @@ class ValueAccessor {
   virtual int Initialize() = 0;
 
   virtual AccessorInfo GetAccessorInfo() { return _accessor_info; }
+  // The trailing dims of the pull and push values, which are the embedding
+  // and its gradient and can be quantized on the wire.
+  virtual size_t GetQuantizableDim() { return 0; }
 
   virtual bool NeedExtendMF(float* value) { return false; }
   virtual bool HasMF(size_t size) { return false; }
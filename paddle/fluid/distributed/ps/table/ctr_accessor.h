@@ -138,6 +138,9 @@ class CtrCommonAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // embed_w and embedx_w of the pull value, embed_g and embedx_g of the push
+  // value
+  virtual size_t GetQuantizableDim() { return 1 + _config.embedx_dim(); }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   // 判断该value是否保存到ssd
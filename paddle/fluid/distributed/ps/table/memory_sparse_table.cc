@@ -25,6 +25,7 @@
 
 // #include "boost/lexical_cast.hpp"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
 
 DEFINE_bool(pserver_print_missed_key_num_every_push,
             false,
@@ -36,6 +37,10 @@ DEFINE_bool(pserver_enable_create_feasign_randomly,
             false,
             "pserver_enable_create_feasign_randomly");
 DEFINE_int32(pserver_table_save_max_retry, 3, "pserver_table_save_max_retry");
+DEFINE_bool(pserver_numa_bind_shards,
+            false,
+            "Bind the task thread of every shard to a NUMA node in turn, so "
+            "that the values of the shard are allocated on the node");
 
 namespace paddle {
 namespace distributed {
@@ -49,6 +54,24 @@ int32_t MemorySparseTable::Initialize() {
   for (size_t i = 0; i < _shards_task_pool.size(); ++i) {
     _shards_task_pool[i].reset(new ::ThreadPool(1));
   }
+  int numa_node_count = phi::backends::cpu::CpuNumaNodeCount();
+  if (FLAGS_pserver_numa_bind_shards && numa_node_count > 1) {
+    // The values of a shard are created by its task thread, and the pages
+    // are allocated on the node of the thread which touches them first.
+    std::vector<std::future<bool>> tasks(_shards_task_pool.size());
+    for (size_t i = 0; i < _shards_task_pool.size(); ++i) {
+      int node = static_cast<int>(i) % numa_node_count;
+      tasks[i] = _shards_task_pool[i]->enqueue([node]() -> bool {
+        return phi::backends::cpu::BindCurrentThreadToNumaNode(node);
+      });
+    }
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      if (!tasks[i].get()) {
+        LOG(WARNING) << "Failed to bind the task thread of shard " << i
+                     << " to NUMA node " << i % numa_node_count;
+      }
+    }
+  }
   VLOG(0) << "initalize MemorySparseTable succ";
   return 0;
 }
@@ -0,0 +1,419 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// The benchmark of the sparse pulls and pushes of the parameter server on a
+// synthetic CTR workload, with the tables in process (PsLocalClient) or
+// behind a BrpcPsServer on the loopback, e.g.
+//
+//   ps_benchmark --ps_mode=brpc --accessor_class=CtrDymfAccessor
+//       --table_class=SSDSparseTable --thread_num=8 --zipf_alpha=1.2
+//
+// Each thread trains with batches of one feasign per slot per instance,
+// drawn from a Zipf distribution over the feasigns of the slot. It pulls
+// the unique feasigns of a batch and pushes their gradients. The pull and
+// push QPS and latencies, the RSS and the skew of the feasigns over the
+// table shards are reported after the warmup steps.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_client.h"
+#include "paddle/fluid/distributed/ps/service/server.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DEFINE_string(ps_mode,
+              "local",
+              "local: the tables in a PsLocalClient, brpc: a BrpcPsServer and "
+              "a BrpcPsClient on the loopback.");
+DEFINE_string(accessor_class,
+              "CtrCommonAccessor",
+              "CtrCommonAccessor, CtrDymfAccessor or CtrDoubleAccessor.");
+DEFINE_string(table_class,
+              "MemorySparseTable",
+              "MemorySparseTable, or SSDSparseTable in a temporary directory.");
+DEFINE_int32(shard_num, 16, "The shard number of the table.");
+DEFINE_int32(slot_num, 26, "The slot number of an instance.");
+DEFINE_int32(embedx_dim, 8, "The embedding dim.");
+DEFINE_int64(feasign_num_per_slot, 1000000, "The feasign number of a slot.");
+DEFINE_double(zipf_alpha, 1.05, "The exponent of the Zipf distribution.");
+DEFINE_int32(batch_size, 512, "The instance number of a batch.");
+DEFINE_int32(thread_num, 4, "The worker thread number.");
+DEFINE_int32(warmup_steps, 20, "The steps of a thread before the timing.");
+DEFINE_int32(steps, 200, "The timed steps of a thread.");
+DEFINE_double(click_rate, 0.05, "The probability of a click.");
+DEFINE_int32(port, 4219, "The port of the server in the brpc mode.");
+DEFINE_int32(seed, 0, "The seed of the feasigns.");
+DECLARE_string(rocksdb_path);
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+const char *kIp = "127.0.0.1";
+
+// Draws the ranks in [0, n), the rank k with the probability proportional
+// to 1 / (k + 1)^alpha.
+class ZipfGenerator {
+ public:
+  ZipfGenerator(uint64_t n, double alpha) : cdf_(n) {
+    double sum = 0;
+    for (uint64_t k = 0; k < n; ++k) {
+      sum += 1.0 / std::pow(static_cast<double>(k + 1), alpha);
+      cdf_[k] = sum;
+    }
+    for (auto &c : cdf_) {
+      c /= sum;
+    }
+  }
+
+  uint64_t operator()(std::mt19937_64 *engine) const {
+    double u = std::uniform_real_distribution<double>(0, 1)(*engine);
+    auto iter = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+    return std::min<uint64_t>(iter - cdf_.begin(), cdf_.size() - 1);
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+// Scatters the ranks of the slots over the key space, so the hot feasigns
+// are not all in the same shard.
+uint64_t FeasignOf(int slot, uint64_t rank) {
+  uint64_t x = (static_cast<uint64_t>(slot) << 40) + rank;
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+double GetRssMB() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, rss_pages = 0;
+  statm >> pages >> rss_pages;
+  return static_cast<double>(rss_pages) * sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+void GetTableProto(TableParameter *table_proto) {
+  table_proto->set_table_id(0);
+  table_proto->set_table_class(FLAGS_table_class);
+  table_proto->set_shard_num(FLAGS_shard_num);
+  table_proto->set_type(PS_SPARSE_TABLE);
+  TableAccessorParameter *accessor_config = table_proto->mutable_accessor();
+  accessor_config->set_accessor_class(FLAGS_accessor_class);
+  accessor_config->set_fea_dim(FLAGS_embedx_dim + 3);
+  accessor_config->set_embedx_dim(FLAGS_embedx_dim);
+  accessor_config->set_embedx_threshold(0);
+  auto *ctr_accessor_param = accessor_config->mutable_ctr_accessor_param();
+  ctr_accessor_param->set_nonclk_coeff(0.1);
+  ctr_accessor_param->set_click_coeff(1);
+  ctr_accessor_param->set_base_threshold(1.5);
+  ctr_accessor_param->set_delta_threshold(0.25);
+  ctr_accessor_param->set_delta_keep_days(16);
+  ctr_accessor_param->set_show_click_decay_rate(0.98);
+  ctr_accessor_param->set_ssd_unseenday_threshold(1);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseAdaGradSGDRule");
+    auto *adagrad_param = sgd_param->mutable_adagrad();
+    adagrad_param->set_learning_rate(0.05);
+    adagrad_param->set_initial_range(1e-4);
+    adagrad_param->set_initial_g2sum(3);
+    adagrad_param->add_weight_bounds(-10.0);
+    adagrad_param->add_weight_bounds(10.0);
+  }
+}
+
+PSParameter GetPSProto() {
+  PSParameter ps_proto;
+  auto *server_proto =
+      ps_proto.mutable_server_param()->mutable_downpour_server_param();
+  auto *service_proto = server_proto->mutable_service_param();
+  if (FLAGS_ps_mode == "brpc") {
+    service_proto->set_service_class("BrpcPsService");
+    service_proto->set_server_class("BrpcPsServer");
+    service_proto->set_client_class("BrpcPsClient");
+    service_proto->set_start_server_port(0);
+    service_proto->set_server_thread_num(12);
+  } else {
+    service_proto->set_client_class("PsLocalClient");
+  }
+  GetTableProto(server_proto->add_downpour_table_param());
+  GetTableProto(ps_proto.mutable_worker_param()
+                    ->mutable_downpour_worker_param()
+                    ->add_downpour_table_param());
+  return ps_proto;
+}
+
+struct Stat {
+  // The elapsed time of the timed steps.
+  double elapsed_ms = 0;
+  std::vector<double> pull_ms;
+  std::vector<double> push_ms;
+  uint64_t pull_keys = 0;
+  std::vector<uint64_t> shard_keys;
+};
+
+double Percentile(std::vector<double> *ms, double p) {
+  if (ms->empty()) {
+    return 0;
+  }
+  size_t k = std::min(ms->size() - 1, static_cast<size_t>(p * ms->size()));
+  std::nth_element(ms->begin(), ms->begin() + k, ms->end());
+  return (*ms)[k];
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void RunWorker(PSClient *client,
+               const ZipfGenerator &zipf,
+               int thread_id,
+               Stat *stat) {
+  auto *accessor = client->GetTableAccessor(0);
+  size_t select_dim = accessor->GetAccessorInfo().select_dim;
+  size_t update_dim = accessor->GetAccessorInfo().update_dim;
+  // The push values are slot, show, click, [mf_dim,] embed_g and embedx_g.
+  bool has_mf_dim = FLAGS_accessor_class == "CtrDymfAccessor";
+  size_t embed_g_index = has_mf_dim ? 4 : 3;
+
+  std::mt19937_64 engine(FLAGS_seed * 1000003 + thread_id);
+  std::uniform_real_distribution<float> grad_dist(-1e-2, 1e-2);
+  std::bernoulli_distribution click_dist(FLAGS_click_rate);
+  stat->shard_keys.assign(FLAGS_shard_num, 0);
+  std::vector<std::pair<uint64_t, int>> feasigns;
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  std::vector<float *> value_ptrs;
+  std::vector<float> updates;
+  std::vector<const float *> update_ptrs;
+  auto timed_start = std::chrono::steady_clock::now();
+  for (int step = 0; step < FLAGS_warmup_steps + FLAGS_steps; ++step) {
+    feasigns.clear();
+    for (int i = 0; i < FLAGS_batch_size; ++i) {
+      for (int slot = 0; slot < FLAGS_slot_num; ++slot) {
+        feasigns.emplace_back(FeasignOf(slot, zipf(&engine)), slot);
+      }
+    }
+    std::sort(feasigns.begin(), feasigns.end());
+    feasigns.erase(std::unique(feasigns.begin(), feasigns.end()),
+                   feasigns.end());
+    size_t num = feasigns.size();
+    keys.resize(num);
+    for (size_t i = 0; i < num; ++i) {
+      keys[i] = feasigns[i].first;
+    }
+
+    values.resize(num * select_dim);
+    value_ptrs.resize(num);
+    for (size_t i = 0; i < num; ++i) {
+      value_ptrs[i] = values.data() + i * select_dim;
+    }
+    auto start = std::chrono::steady_clock::now();
+    client->PullSparse(value_ptrs.data(), 0, keys.data(), num, true).wait();
+    double pull_ms = ElapsedMs(start);
+
+    updates.assign(num * update_dim, 0);
+    update_ptrs.resize(num);
+    for (size_t i = 0; i < num; ++i) {
+      float *update = updates.data() + i * update_dim;
+      update[0] = feasigns[i].second;
+      update[1] = 1;
+      update[2] = click_dist(engine) ? 1 : 0;
+      if (has_mf_dim) {
+        update[3] = FLAGS_embedx_dim;
+      }
+      for (size_t j = embed_g_index; j < update_dim; ++j) {
+        update[j] = grad_dist(engine);
+      }
+      update_ptrs[i] = update;
+    }
+    start = std::chrono::steady_clock::now();
+    client->PushSparse(0, keys.data(), update_ptrs.data(), num).wait();
+    double push_ms = ElapsedMs(start);
+
+    if (step < FLAGS_warmup_steps) {
+      timed_start = std::chrono::steady_clock::now();
+      continue;
+    }
+    stat->pull_ms.push_back(pull_ms);
+    stat->push_ms.push_back(push_ms);
+    stat->pull_keys += num;
+    for (auto key : keys) {
+      ++stat->shard_keys[key % FLAGS_shard_num];
+    }
+  }
+  stat->elapsed_ms = ElapsedMs(timed_start);
+}
+
+// The requests per second of the threads, each busy with the requests for
+// the sum of their latencies, and the keys per second.
+std::pair<double, double> GetQPS(const std::vector<Stat> &stats,
+                                 std::vector<double> Stat::*ms) {
+  double qps = 0, keys_per_second = 0;
+  for (auto &stat : stats) {
+    double busy_ms = 0;
+    for (double t : stat.*ms) {
+      busy_ms += t;
+    }
+    if (busy_ms > 0) {
+      qps += (stat.*ms).size() * 1000 / busy_ms;
+      keys_per_second += stat.pull_keys * 1000 / busy_ms;
+    }
+  }
+  return std::make_pair(qps, keys_per_second);
+}
+
+void Report(const std::vector<Stat> &stats) {
+  Stat total;
+  total.shard_keys.assign(FLAGS_shard_num, 0);
+  double steps_per_second = 0;
+  for (auto &stat : stats) {
+    if (stat.elapsed_ms > 0) {
+      steps_per_second += stat.pull_ms.size() * 1000 / stat.elapsed_ms;
+    }
+    total.pull_ms.insert(
+        total.pull_ms.end(), stat.pull_ms.begin(), stat.pull_ms.end());
+    total.push_ms.insert(
+        total.push_ms.end(), stat.push_ms.begin(), stat.push_ms.end());
+    total.pull_keys += stat.pull_keys;
+    for (int i = 0; i < FLAGS_shard_num; ++i) {
+      total.shard_keys[i] += stat.shard_keys[i];
+    }
+  }
+  double requests = total.pull_ms.size();
+  LOG(INFO) << "ps_mode: " << FLAGS_ps_mode
+            << ", accessor: " << FLAGS_accessor_class
+            << ", table: " << FLAGS_table_class
+            << ", threads: " << FLAGS_thread_num
+            << ", unique keys per batch: "
+            << (requests > 0 ? total.pull_keys / requests : 0)
+            << ", steps/s: " << steps_per_second;
+  auto pull_qps = GetQPS(stats, &Stat::pull_ms);
+  LOG(INFO) << "pull QPS: " << pull_qps.first
+            << ", keys/s: " << pull_qps.second
+            << ", p50: " << Percentile(&total.pull_ms, 0.5)
+            << " ms, p99: " << Percentile(&total.pull_ms, 0.99) << " ms";
+  auto push_qps = GetQPS(stats, &Stat::push_ms);
+  LOG(INFO) << "push QPS: " << push_qps.first
+            << ", keys/s: " << push_qps.second
+            << ", p50: " << Percentile(&total.push_ms, 0.5)
+            << " ms, p99: " << Percentile(&total.push_ms, 0.99) << " ms";
+
+  auto minmax =
+      std::minmax_element(total.shard_keys.begin(), total.shard_keys.end());
+  double mean = static_cast<double>(total.pull_keys) / FLAGS_shard_num;
+  LOG(INFO) << "shard keys min: " << *minmax.first
+            << ", max: " << *minmax.second << ", max / mean: "
+            << (mean > 0 ? *minmax.second / mean : 0);
+  LOG(INFO) << "RSS: " << GetRssMB() << " MB";
+}
+
+void RunServer(PSServer *server) { server->Start(kIp, FLAGS_port); }
+
+int RunBenchmark() {
+  PSParameter ps_proto = GetPSProto();
+  std::string ssd_path;
+  if (FLAGS_table_class == "SSDSparseTable") {
+    char path[] = "/tmp/ps_benchmark_XXXXXX";
+    if (mkdtemp(path) == nullptr) {
+      LOG(ERROR) << "failed to create the directory of the SSD table";
+      return -1;
+    }
+    ssd_path = path;
+    FLAGS_rocksdb_path = ssd_path;
+  }
+
+  PaddlePSEnvironment env;
+  std::vector<std::string> host_sign_list;
+  std::unique_ptr<PSServer> server;
+  std::thread server_thread;
+  if (FLAGS_ps_mode == "brpc") {
+    setenv("http_proxy", "", 1);
+    setenv("https_proxy", "", 1);
+    host_sign_list.push_back(PSHost(kIp, FLAGS_port, 0).SerializeToString());
+    env.SetPsServers(&host_sign_list, 1);
+    server.reset(PSServerFactory::Create(ps_proto));
+    std::vector<framework::ProgramDesc> server_sub_program(1);
+    server->Configure(ps_proto, env, 0, server_sub_program);
+    server_thread = std::thread(RunServer, server.get());
+    sleep(1);
+  } else if (FLAGS_ps_mode != "local") {
+    LOG(ERROR) << "unknown ps_mode " << FLAGS_ps_mode;
+    return -1;
+  }
+
+  std::unique_ptr<PSClient> client(PSClientFactory::Create(ps_proto));
+  std::map<uint64_t, std::vector<Region>> regions;
+  if (client == nullptr || client->Configure(ps_proto, regions, env, 0) != 0) {
+    LOG(ERROR) << "failed to configure the client";
+    return -1;
+  }
+
+  ZipfGenerator zipf(FLAGS_feasign_num_per_slot, FLAGS_zipf_alpha);
+  std::vector<Stat> stats(FLAGS_thread_num);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < FLAGS_thread_num; ++i) {
+    workers.emplace_back(
+        RunWorker, client.get(), std::cref(zipf), i, &stats[i]);
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  Report(stats);
+
+  if (FLAGS_ps_mode == "brpc") {
+    client->StopServer().wait();
+    client->FinalizeWorker();
+    server_thread.join();
+  }
+  client.reset();
+  server.reset();
+  if (!ssd_path.empty()) {
+    framework::fs_remove(ssd_path);
+  }
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::distributed::RunBenchmark();
+}
@@ -0,0 +1,264 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_table_cache.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_local_client.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+DECLARE_int32(pserver_sparse_cache_max_mb);
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+const int kEmbedxDim = 4;
+// show, click, embed_w and embedx_w
+const int kSelectDim = 3 + kEmbedxDim;
+// slot, show, click, embed_g and embedx_g
+const int kUpdateDim = 4 + kEmbedxDim;
+
+std::vector<float *> RowPointers(std::vector<float> *data, int dim) {
+  std::vector<float *> rows(data->size() / dim);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    rows[i] = data->data() + i * dim;
+  }
+  return rows;
+}
+
+}  // namespace
+
+TEST(SparseTableCache, StalenessSteps) {
+  SparseTableCacheOptions options;
+  options.max_bytes = 1 << 20;
+  options.staleness_steps = 1;
+  SparseTableCache cache(options, kSelectDim, kUpdateDim);
+
+  std::vector<uint64_t> keys = {1, 2};
+  std::vector<float> values(keys.size() * kSelectDim, 1);
+  auto value_ptrs = RowPointers(&values, kSelectDim);
+  std::vector<size_t> missed;
+  uint64_t step = cache.Lookup(keys.data(), value_ptrs.data(), 2, &missed);
+  ASSERT_EQ(missed.size(), 2u);
+  cache.Insert(keys.data(), value_ptrs.data(), 2, step);
+
+  std::vector<float> update(kUpdateDim, 1);
+  std::vector<const float *> update_ptrs = {update.data()};
+  std::vector<float> out(keys.size() * kSelectDim, 0);
+  auto out_ptrs = RowPointers(&out, kSelectDim);
+  for (int i = 0; i < 2; ++i) {
+    // The pushed key 1 is evicted, key 2 is served for one push.
+    missed.clear();
+    cache.Lookup(keys.data(), out_ptrs.data(), 2, &missed);
+    ASSERT_EQ(missed.size(), i == 0 ? 0u : 1u);
+    EXPECT_EQ(out[kSelectDim], 1);
+    cache.Push(keys.data(), update_ptrs.data(), 1);
+  }
+  missed.clear();
+  cache.Lookup(keys.data(), out_ptrs.data(), 2, &missed);
+  EXPECT_EQ(missed.size(), 2u);
+  EXPECT_EQ(cache.Hits(), 3u);
+  EXPECT_EQ(cache.Misses(), 5u);
+  EXPECT_EQ(cache.Size(), 0u);
+}
+
+TEST(SparseTableCache, FoldPush) {
+  SparseTableCacheOptions options;
+  options.max_bytes = 1 << 20;
+  options.staleness_steps = 10;
+  options.fold_learning_rate = 0.5;
+  SparseTableCache cache(options, kSelectDim, kUpdateDim);
+
+  uint64_t key = 7;
+  std::vector<float> value(kSelectDim, 1);
+  const float *value_ptr = value.data();
+  cache.Insert(&key, &value_ptr, 1, 0);
+
+  std::vector<float> update(kUpdateDim, 2);
+  const float *update_ptr = update.data();
+  cache.Push(&key, &update_ptr, 1);
+
+  std::vector<float> out(kSelectDim, 0);
+  float *out_ptr = out.data();
+  std::vector<size_t> missed;
+  cache.Lookup(&key, &out_ptr, 1, &missed);
+  ASSERT_TRUE(missed.empty());
+  // The show and click are added, the weights take a step of SGD.
+  EXPECT_EQ(out[0], 3);
+  EXPECT_EQ(out[1], 3);
+  for (int i = 2; i < kSelectDim; ++i) {
+    EXPECT_EQ(out[i], 0);
+  }
+}
+
+TEST(SparseTableCache, Eviction) {
+  for (bool lfu : {false, true}) {
+    SparseTableCacheOptions options;
+    // The budget of three values.
+    options.max_bytes = 3 * (kSelectDim * sizeof(float) +
+                             SparseTableCache::kEntryOverheadBytes);
+    options.staleness_steps = 1;
+    options.lfu = lfu;
+    SparseTableCache cache(options, kSelectDim, kUpdateDim);
+
+    std::vector<uint64_t> keys = {1, 2, 3};
+    std::vector<float> values(keys.size() * kSelectDim, 0);
+    auto value_ptrs = RowPointers(&values, kSelectDim);
+    cache.Insert(keys.data(), value_ptrs.data(), 3, 0);
+    ASSERT_EQ(cache.Size(), 3u);
+
+    // Key 1 is used twice and key 2 once, after key 3.
+    std::vector<float> value(kSelectDim, 0);
+    float *value_ptr = value.data();
+    std::vector<size_t> missed;
+    std::vector<uint64_t> used = {1, 1, 3, 2};
+    for (uint64_t used_key : used) {
+      cache.Lookup(&used_key, &value_ptr, 1, &missed);
+    }
+    ASSERT_TRUE(missed.empty());
+
+    uint64_t key = 4;
+    cache.Insert(&key, &value_ptr, 1, 0);
+    ASSERT_EQ(cache.Size(), 3u);
+    // LRU evicts key 1, used the earliest, LFU evicts key 3, used the least
+    // and earlier than key 2.
+    uint64_t evicted = lfu ? 3 : 1;
+    for (uint64_t k = 1; k <= 4; ++k) {
+      missed.clear();
+      cache.Lookup(&k, &value_ptr, 1, &missed);
+      EXPECT_EQ(missed.size(), k == evicted ? 1u : 0u) << k;
+    }
+  }
+}
+
+namespace {
+
+void GetSparseTableProto(TableParameter *table_proto) {
+  table_proto->set_table_id(0);
+  table_proto->set_table_class("MemorySparseTable");
+  table_proto->set_shard_num(10);
+  table_proto->set_type(PS_SPARSE_TABLE);
+  TableAccessorParameter *accessor_config = table_proto->mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(kSelectDim);
+  accessor_config->set_embedx_dim(kEmbedxDim);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    // The values are initialized with 0, the same in both tables.
+    naive_param->set_initial_range(0);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+std::unique_ptr<PSClient> CreateLocalClient(PSEnvironment *env) {
+  PSParameter config;
+  auto *server_proto = config.mutable_server_param();
+  auto *downpour_server_proto = server_proto->mutable_downpour_server_param();
+  auto *service_proto = downpour_server_proto->mutable_service_param();
+  service_proto->set_client_class("PsLocalClient");
+  GetSparseTableProto(downpour_server_proto->add_downpour_table_param());
+
+  std::unique_ptr<PSClient> client(new PsLocalClient());
+  std::map<uint64_t, std::vector<Region>> regions;
+  client->Configure(config, regions, *env, 0);
+  return client;
+}
+
+}  // namespace
+
+// With zero staleness, the training with the cache takes the same values as
+// the training without, while the repeated pulls of a step hit the cache.
+TEST(SparseTableCache, ZeroStalenessLocalClient) {
+  PaddlePSEnvironment env;
+  FLAGS_pserver_sparse_cache_max_mb = 0;
+  auto client = CreateLocalClient(&env);
+  FLAGS_pserver_sparse_cache_max_mb = 16;
+  auto cached_client = CreateLocalClient(&env);
+  FLAGS_pserver_sparse_cache_max_mb = 0;
+  ASSERT_EQ(client->GetSparseTableCache(0), nullptr);
+  auto *cache = cached_client->GetSparseTableCache(0);
+  ASSERT_NE(cache, nullptr);
+
+  const int steps = 20;
+  for (int step = 0; step < steps; ++step) {
+    // Two hot keys in every step, and two of ten cold keys.
+    std::vector<uint64_t> keys = {1,
+                                  2,
+                                  100 + static_cast<uint64_t>(step % 10),
+                                  100 + static_cast<uint64_t>(step * 3 % 10)};
+    size_t num = keys.size();
+    std::vector<float> values(num * kSelectDim);
+    std::vector<float> cached_values(num * kSelectDim);
+    auto value_ptrs = RowPointers(&values, kSelectDim);
+    auto cached_value_ptrs = RowPointers(&cached_values, kSelectDim);
+    // Two lookups of the table in a step.
+    for (int pull = 0; pull < 2; ++pull) {
+      client->PullSparse(value_ptrs.data(), 0, keys.data(), num, true).wait();
+      cached_client
+          ->PullSparse(cached_value_ptrs.data(), 0, keys.data(), num, true)
+          .wait();
+      for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], cached_values[i]) << "step " << step;
+      }
+    }
+
+    // Pull the weights towards 1.
+    std::vector<float> updates(num * kUpdateDim);
+    for (size_t i = 0; i < num; ++i) {
+      float *update = updates.data() + i * kUpdateDim;
+      const float *value = values.data() + i * kSelectDim;
+      update[0] = 0;
+      update[1] = 1;
+      update[2] = step % 2;
+      for (int j = 2; j < kSelectDim; ++j) {
+        update[j + 1] = value[j] - 1;
+      }
+    }
+    std::vector<const float *> update_ptrs(num);
+    for (size_t i = 0; i < num; ++i) {
+      update_ptrs[i] = updates.data() + i * kUpdateDim;
+    }
+    client->PushSparse(0, keys.data(), update_ptrs.data(), num).wait();
+    cached_client->PushSparse(0, keys.data(), update_ptrs.data(), num).wait();
+  }
+  EXPECT_EQ(cache->Hits(), static_cast<uint64_t>(steps * 4));
+  EXPECT_EQ(cache->Misses(), static_cast<uint64_t>(steps * 4));
+  EXPECT_DOUBLE_EQ(cache->HitRate(), 0.5);
+
+  cached_client->Barrier(0, 0).wait();
+  EXPECT_EQ(cache->Size(), 0u);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,215 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_value_codec.h"
+
+#include <cmath>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+// slot, show, click, embed_g and embedx_g of 8 dims
+const size_t kDim = 12;
+const size_t kQuantDim = 9;
+
+std::vector<float> RandomValue(std::mt19937 *engine) {
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> value(kDim);
+  value[0] = 1024;
+  value[1] = 3;
+  value[2] = 1;
+  for (size_t i = kDim - kQuantDim; i < kDim; ++i) {
+    value[i] = dist(*engine);
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST(SparseValueCoder, RoundTrip) {
+  std::mt19937 engine(0);
+  struct Case {
+    const char *name;
+    size_t encoded_bytes;
+    float max_error;
+  };
+  std::vector<Case> cases = {
+      {"fp32", kDim * 4, 0},
+      {"fp16", 3 * 4 + kQuantDim * 2, 1e-3},
+      {"bf16", 3 * 4 + kQuantDim * 2, 1e-2},
+      {"int8", 3 * 4 + 4 + kQuantDim, 1.0 / 127},
+  };
+  for (const auto &c : cases) {
+    SparseValueCodec codec;
+    ASSERT_TRUE(ParseSparseValueCodec(c.name, &codec));
+    SparseValueCoder coder(codec, kDim, kQuantDim);
+    EXPECT_EQ(coder.EncodedBytes(), c.encoded_bytes) << c.name;
+    std::vector<char> encoded(coder.EncodedBytes());
+    std::vector<float> decoded(kDim);
+    for (int n = 0; n < 100; ++n) {
+      auto value = RandomValue(&engine);
+      coder.Encode(value.data(), encoded.data());
+      coder.Decode(encoded.data(), decoded.data());
+      // The slot, show and click are exact.
+      for (size_t i = 0; i < kDim - kQuantDim; ++i) {
+        EXPECT_EQ(decoded[i], value[i]) << c.name;
+      }
+      for (size_t i = kDim - kQuantDim; i < kDim; ++i) {
+        EXPECT_NEAR(decoded[i], value[i], c.max_error) << c.name;
+      }
+    }
+  }
+  SparseValueCodec codec;
+  EXPECT_FALSE(ParseSparseValueCodec("int4", &codec));
+}
+
+TEST(SparseValueCoder, NotQuantizable) {
+  // The values of the accessors without quantizable dims are in float32.
+  SparseValueCoder coder(SparseValueCodec::kInt8, kDim, 0);
+  EXPECT_EQ(coder.codec(), SparseValueCodec::kFloat32);
+  EXPECT_EQ(coder.EncodedBytes(), kDim * sizeof(float));
+}
+
+TEST(SparseValueErrorFeedback, SumOfGradients) {
+  std::mt19937 engine(0);
+  SparseValueCoder coder(SparseValueCodec::kInt8, kDim, kQuantDim);
+  SparseValueErrorFeedback error_feedback(coder, 1024);
+  std::vector<uint64_t> keys = {3, 5};
+  std::vector<double> pushed_sum(keys.size() * kDim, 0);
+  std::vector<double> applied_sum(keys.size() * kDim, 0);
+  std::vector<double> plain_sum(keys.size() * kDim, 0);
+  std::vector<char> encoded(keys.size() * coder.EncodedBytes());
+  std::vector<float> decoded(kDim);
+  const int steps = 1000;
+  for (int step = 0; step < steps; ++step) {
+    std::vector<std::vector<float>> values;
+    std::vector<const float *> value_ptrs;
+    for (size_t k = 0; k < keys.size(); ++k) {
+      values.push_back(RandomValue(&engine));
+      // A gradient column much smaller than the others is lost by int8
+      // without the error feedback.
+      values.back()[kDim - 1] = 1e-3;
+    }
+    for (auto &value : values) {
+      value_ptrs.push_back(value.data());
+    }
+    error_feedback.Encode(
+        keys.data(), value_ptrs.data(), keys.size(), encoded.data());
+    for (size_t k = 0; k < keys.size(); ++k) {
+      coder.Decode(encoded.data() + k * coder.EncodedBytes(), decoded.data());
+      for (size_t i = 0; i < kDim; ++i) {
+        pushed_sum[k * kDim + i] += values[k][i];
+        applied_sum[k * kDim + i] += decoded[i];
+      }
+      std::vector<char> plain(coder.EncodedBytes());
+      coder.Encode(values[k].data(), plain.data());
+      coder.Decode(plain.data(), decoded.data());
+      plain_sum[k * kDim + kDim - 1] += decoded[kDim - 1];
+    }
+  }
+  EXPECT_EQ(error_feedback.Size(), keys.size());
+  for (size_t k = 0; k < keys.size(); ++k) {
+    for (size_t i = 0; i < kDim; ++i) {
+      // The sums differ by the last residual, within a quantization step.
+      EXPECT_NEAR(applied_sum[k * kDim + i], pushed_sum[k * kDim + i], 1e-2);
+    }
+    size_t last = k * kDim + kDim - 1;
+    EXPECT_NEAR(pushed_sum[last], steps * 1e-3, 1e-3);
+    EXPECT_LT(std::fabs(plain_sum[last]), 0.5 * steps * 1e-3);
+  }
+}
+
+// Encodes a zero gradient of the key, returns the decoded last column, which
+// is the residual of the key if it is kept.
+float PushZero(const SparseValueCoder &coder,
+               SparseValueErrorFeedback *error_feedback,
+               uint64_t key) {
+  std::vector<float> zero(kDim, 0);
+  const float *value = zero.data();
+  std::vector<char> encoded(coder.EncodedBytes());
+  error_feedback->Encode(&key, &value, 1, encoded.data());
+  std::vector<float> decoded(kDim);
+  coder.Decode(encoded.data(), decoded.data());
+  return decoded[kDim - 1];
+}
+
+TEST(SparseValueErrorFeedback, EvictLeastRecentlyPushed) {
+  std::mt19937 engine(0);
+  SparseValueCoder coder(SparseValueCodec::kInt8, kDim, kQuantDim);
+  // One key per shard, keys 0 and kShardNum are in the same shard.
+  SparseValueErrorFeedback error_feedback(coder,
+                                          SparseValueErrorFeedback::kShardNum);
+  const uint64_t key = 0;
+  const uint64_t other_key = SparseValueErrorFeedback::kShardNum;
+  auto value = RandomValue(&engine);
+  value[kDim - 1] = 1e-3;
+  const float *value_ptr = value.data();
+  std::vector<char> encoded(coder.EncodedBytes());
+
+  error_feedback.Encode(&key, &value_ptr, 1, encoded.data());
+  EXPECT_NE(PushZero(coder, &error_feedback, key), 0.f);
+
+  error_feedback.Encode(&key, &value_ptr, 1, encoded.data());
+  error_feedback.Encode(&other_key, &value_ptr, 1, encoded.data());
+  EXPECT_EQ(error_feedback.Size(), 1UL);
+  // The residual of the key is evicted by the other key.
+  EXPECT_EQ(PushZero(coder, &error_feedback, key), 0.f);
+
+  for (uint64_t k = 0; k < 4 * SparseValueErrorFeedback::kShardNum; ++k) {
+    error_feedback.Encode(&k, &value_ptr, 1, encoded.data());
+  }
+  EXPECT_EQ(error_feedback.Size(), SparseValueErrorFeedback::kShardNum);
+}
+
+TEST(SparseValueErrorFeedback, ConcurrentEncode) {
+  SparseValueCoder coder(SparseValueCodec::kInt8, kDim, kQuantDim);
+  SparseValueErrorFeedback error_feedback(coder, 1 << 16);
+  const int thread_num = 4;
+  const uint64_t keys_per_thread = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 engine(t);
+      std::vector<uint64_t> keys(keys_per_thread);
+      std::vector<std::vector<float>> values;
+      std::vector<const float *> value_ptrs;
+      for (uint64_t k = 0; k < keys_per_thread; ++k) {
+        keys[k] = t * keys_per_thread + k;
+        values.push_back(RandomValue(&engine));
+      }
+      for (auto &value : values) {
+        value_ptrs.push_back(value.data());
+      }
+      std::vector<char> encoded(keys.size() * coder.EncodedBytes());
+      for (int step = 0; step < 10; ++step) {
+        error_feedback.Encode(
+            keys.data(), value_ptrs.data(), keys.size(), encoded.data());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(error_feedback.Size(), thread_num * keys_per_thread);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,37 +14,90 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>  // NOLINT
+#include <string>
+
 #include "paddle/fluid/eager/general_grad.h"
+#include "paddle/phi/core/flags.h"
+#include "paddle/phi/core/threadpool.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
-namespace egr {
-
-std::unordered_map<GradNodeBase*, int> getInDegreeMap(
-    const std::deque<GradNodeBase*>& init_queue) {
-  // Calculate in_degree for each node
-  // We can completely remove this pass, if in_degree were set during forward
-  // pass
-  std::unordered_map<GradNodeBase*, int> node_in_degree_map;
+PADDLE_DEFINE_EXPORTED_int32(
+    eager_backward_num_threads,
+    0,
+    "If greater than 1, the grad nodes of backward whose input grads are "
+    "ready run on a pool of this many threads, so that independent branches "
+    "of the graph run at the same time. Only a backward on CPU runs in "
+    "parallel, and the flag is read once by the first backward. paddle.grad "
+    "and create_graph=True always run serially.");
+PADDLE_DEFINE_EXPORTED_bool(
+    eager_backward_deterministic,
+    false,
+    "If true, the grads of a node are accumulated in a fixed order by the "
+    "parallel backward, so that the results do not depend on the order the "
+    "branches finish in.");
+
+PADDLE_DEFINE_EXPORTED_bool(
+    eager_backward_cache_schedule,
+    false,
+    "If true, the order a serial backward runs the grad nodes in is cached "
+    "by the grad nodes it starts from, and replayed by the later backward "
+    "from the same nodes while no graph has changed, e.g. with "
+    "retain_graph=True. The replay skips the traversal and the queue, and "
+    "reuses the buffers of the input grads. paddle.grad never uses the "
+    "cache.");
 
-  // Copy nodes
-  std::deque<GradNodeBase*> queue = init_queue;
-  std::unordered_set<GradNodeBase*> visited;
+namespace egr {
 
-  // Visit each node exactly once in any order
-  while (!queue.empty()) {
-    GradNodeBase* node = queue.front();
-    queue.pop_front();
+static uint64_t NextBackwardPassId() {
+  static std::atomic<uint64_t> pass_id{0};
+  return ++pass_id;
+}
 
-    if (visited.count(node)) {
-      continue;
-    }
-    visited.insert(node);
+// Reset the run state of node when the backward pass reaches it for the first
+// time, and return whether it is the first time.
+static bool VisitNode(GradNodeBase* node, uint64_t pass_id, size_t* order) {
+  GradNodeRunState* state = node->MutableRunState();
+  if (state->pass_id == pass_id) {
+    return false;
+  }
+  state->pass_id = pass_id;
+  state->order = (*order)++;
+  state->in_degree.store(0, std::memory_order_relaxed);
+  return true;
+}
 
+// Calculate in_degree for each node reachable from init_queue, and store it
+// in the run state of the node. The nodes are collected to nodes in the
+// order they are found in, which is the order of their run state.
+// We can completely remove this pass, if in_degree were set during forward
+// pass
+void PrepareInDegree(const std::deque<GradNodeBase*>& init_queue,
+                     uint64_t pass_id,
+                     std::vector<GradNodeBase*>* nodes) {
+  // The orders of the run states change, which the cached schedules index
+  // their nodes by.
+  BumpGradGraphEpoch();
+  size_t order = 0;
+  nodes->clear();
+  for (GradNodeBase* node : init_queue) {
     PADDLE_ENFORCE_NOT_NULL(
         node,
         paddle::platform::errors::Fatal(
             "We got null node when we traverse the backward graph, and this "
             "should not happened please check your code and contact us."));
+    if (VisitNode(node, pass_id, &order)) {
+      nodes->push_back(node);
+    }
+  }
+
+  // Visit each node exactly once, nodes is the queue
+  for (size_t k = 0; k < nodes->size(); ++k) {
+    GradNodeBase* node = (*nodes)[k];
+
     // Find and append next nodes
     const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
         metas = node->OutputMeta();
@@ -55,20 +108,93 @@ std::unordered_map<GradNodeBase*, int> getInDegreeMap(
         // Next node could be nullptr if it is leaf tensor with no
         // AccumulationNode attached
         // Or it could also originated from dispensable inputs
-        if (!next_node) continue;
+        if (!next_node) {
+          continue;
+        }
 
+        if (VisitNode(next_node, pass_id, &order)) {
+          nodes->push_back(next_node);
+        }
         // Update in_degree
-        if (!node_in_degree_map.count(next_node))
-          node_in_degree_map[next_node] = 0;
-        node_in_degree_map[next_node]++;
-        queue.push_back(next_node);
+        next_node->MutableRunState()->in_degree.fetch_add(
+            1, std::memory_order_relaxed);
       }
     }
   }
-
-  return node_in_degree_map;
 }
 
+// The schedule of a backward graph recorded from a serial pass over it. A
+// later backward from the same grad nodes replays it instead of the
+// traversal and the queue of the serial pass, while the graph epoch is the
+// one it was recorded at, with the GradTensorHolders of the nodes kept
+// between the passes.
+struct BackwardSchedule {
+  // The grad nodes the backward starts from.
+  std::vector<GradNodeBase*> roots;
+  // The graph epoch the schedule is valid at.
+  uint64_t epoch{0};
+  // The nodes reachable from roots, indexed by the order of their run state.
+  std::vector<GradNodeBase*> nodes;
+  // The in_degree of every node, indexed by the order of the node.
+  std::vector<int> in_degree;
+  // The orders of the nodes, in the order the serial pass ran them.
+  std::vector<size_t> run_order;
+  // The GradTensorHolders of the nodes, indexed by the order of the node.
+  std::vector<std::unique_ptr<GradTensorHolder>> holders;
+  // The in_degree left of every node in the running pass.
+  std::vector<int> remaining;
+};
+
+/*
+ * The schedules recorded by the backward passes of a thread, keyed by their
+ * roots. All of them are valid at the same graph epoch, and are dropped when
+ * it changes. A schedule is taken out while it runs, so that a backward
+ * started by a grad node records its own.
+ */
+class BackwardScheduleCache {
+ public:
+  static constexpr size_t kMaxSchedules = 16;
+
+  static BackwardScheduleCache& Instance() {
+    static thread_local BackwardScheduleCache cache;
+    return cache;
+  }
+
+  std::unique_ptr<BackwardSchedule> Take(
+      const std::deque<GradNodeBase*>& roots) {
+    if (epoch_ != GradGraphEpoch()) {
+      schedules_.clear();
+      return nullptr;
+    }
+    for (auto iter = schedules_.begin(); iter != schedules_.end(); ++iter) {
+      const auto& schedule_roots = (*iter)->roots;
+      if (std::equal(schedule_roots.begin(),
+                     schedule_roots.end(),
+                     roots.begin(),
+                     roots.end())) {
+        std::unique_ptr<BackwardSchedule> schedule = std::move(*iter);
+        schedules_.erase(iter);
+        return schedule;
+      }
+    }
+    return nullptr;
+  }
+
+  void Put(std::unique_ptr<BackwardSchedule> schedule) {
+    if (epoch_ != schedule->epoch || schedules_.size() >= kMaxSchedules) {
+      schedules_.clear();
+      epoch_ = schedule->epoch;
+    }
+    if (schedule->epoch == GradGraphEpoch()) {
+      schedules_.push_back(std::move(schedule));
+    }
+  }
+
+ private:
+  uint64_t epoch_{0};
+  std::vector<std::unique_ptr<BackwardSchedule>> schedules_;
+};
+
 // Enforce GradNode has TensorWrappers as Input
 void EnforceGradNodeHasInput(GradNodeBase* node) {
   PADDLE_ENFORCE_NE(
@@ -100,6 +226,385 @@ void DuplicateCheck(const std::vector<paddle::experimental::Tensor>& inputs,
   }
 }
 
+// Run node on the grads of node_input_buffer, and hand each of its output
+// grads with a next node to add_grad(next_node, edge_rank, grad). Shared by
+// the serial pass and the replay of its schedule.
+template <typename AddGrad>
+static void RunGradNode(GradNodeBase* node,
+                        GradTensorHolder* node_input_buffer,
+                        bool retain_graph,
+                        bool create_graph,
+                        bool is_general_grad,
+                        AddGrad&& add_grad) {
+  VLOG(3) << "Preparing GradNode:" << node->name() << " addr:" << node;
+  paddle::platform::RecordEvent node_record_event(
+      std::string((*node).name()),
+      paddle::platform::TracerEventType::Operator,
+      1);
+
+  PADDLE_ENFORCE_NOT_NULL(
+      node_input_buffer,
+      paddle::platform::errors::Fatal(
+          "Unable to find next node in the GradTensorHolder \n"
+          "Trying to run Node without configuring its GradTensorHolder."));
+
+  // Check input
+  EnforceGradNodeHasInput(node);
+
+  VLOG(7) << "Run Backward Kernel with GradTensorHolder.";
+  // Run Pre Backward Node and get outputs
+  paddle::small_vector<std::vector<paddle::experimental::Tensor>,
+                       kSlotSmallVectorSize>
+      grad_output_tensors = (*node)(
+          node_input_buffer->Buffers(), create_graph, is_general_grad);
+
+  if (is_general_grad) {
+    GeneralGrad::Instance().SetResultForEnddingNodes(grad_output_tensors,
+                                                     node);
+  }
+
+  // retain_grad or not
+  if (!retain_graph) {
+    VLOG(3)
+        << "retain_graph is false, need to clear the TensorWrapper of nodes.";
+    node->ClearTensorWrappers();
+  }
+
+  // Prepare GradTensorHolder for next node
+  const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
+      metas = node->OutputMeta();
+  PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
+                 paddle::platform::errors::Fatal(
+                     "Number of edges should be either empty ( for leaf node "
+                     ") or the same as number of output grad tensors, but we "
+                     "got edges size is: %d, grad_output size is: %d",
+                     metas.size(),
+                     grad_output_tensors.size()));
+
+  for (size_t i = 0; i < metas.size(); i++) {
+    for (size_t j = 0; j < metas[i].size(); j++) {
+      const Edge& edge = metas[i][j].GetEdge();
+      if (!edge.IsInitialized()) {
+        continue;
+      }
+      auto edge_rank = edge.GetEdgeRankInfo();
+      // Since we make edge has as same rank as bwd outputs, we indexing them
+      // with the same rank(i, j)
+      // Next node could be nullptr if it is leaf tensor with no
+      // AccumulationNode attached
+      // Or it could also originated from dispensable inputs
+      auto* next_node = edge.GetMutableGradNode().get();
+      if (!next_node || grad_output_tensors[i].empty()) {
+        continue;
+      }
+      VLOG(3) << "Node: " << node->name() << " addr:" << node
+              << ", Found pending node: " << next_node->name()
+              << " addr: " << next_node;
+
+      PADDLE_ENFORCE_LT(
+          j,
+          grad_output_tensors[i].size(),
+          paddle::platform::errors::Fatal(
+              "Rank of grad_output_tensors should be less than "
+              "grad_output_tensors[i].size(), which is: %d. This error may "
+              "indicate autoprune or autograd api error. ",
+              grad_output_tensors.size()));
+      paddle::experimental::Tensor& grad_output_tensor =
+          grad_output_tensors[i][j];
+
+      if ((!grad_output_tensor.defined() ||
+           !grad_output_tensor.initialized())) {
+        VLOG(7) << "We get grad_output_tensor with slot: " << i
+                << ", rank: " << j << " as uninitialized or undefined tensor";
+      }
+
+      VLOG(7) << "Get Edge and grad_output_tensor with slot: " << i
+              << ", rank: " << j
+              << " 's name is: " << grad_output_tensor.name();
+
+      add_grad(next_node, edge_rank, grad_output_tensor);
+    }
+  }
+}
+
+// Whether the calling thread is a worker of ParallelBackwardRunner. A
+// backward started by a grad node, e.g. of PyLayer, runs serially on it.
+static thread_local bool is_parallel_backward_worker = false;
+
+// The grad and amp state of the tracer are thread local, so a worker takes
+// the state of the thread which started the backward while it runs a node,
+// and gets its own back afterwards.
+class TracerStateGuard {
+ public:
+  struct State {
+    bool has_grad;
+    paddle::imperative::AmpLevel amp_level;
+    std::string amp_dtype;
+  };
+
+  static State Current() {
+    const auto& tracer = Controller::Instance().GetCurrentTracer();
+    return State{
+        tracer->HasGrad(), tracer->GetAmpLevel(), tracer->GetAmpDtype()};
+  }
+
+  explicit TracerStateGuard(const State& state) : pre_state_(Current()) {
+    Set(state);
+  }
+
+  ~TracerStateGuard() { Set(pre_state_); }
+
+  TracerStateGuard(const TracerStateGuard&) = delete;
+  TracerStateGuard& operator=(const TracerStateGuard&) = delete;
+
+ private:
+  static void Set(const State& state) {
+    const auto& tracer = Controller::Instance().GetCurrentTracer();
+    tracer->SetHasGrad(state.has_grad);
+    tracer->SetAmpLevel(state.amp_level);
+    tracer->SetAmpDtype(state.amp_dtype);
+  }
+
+  State pre_state_;
+};
+
+/*
+ * Runs the grad nodes of a backward pass on a thread pool. A node is
+ * dispatched as soon as the last of its input grads arrives, so ready nodes
+ * of independent branches run at the same time. Only a backward on CPU runs
+ * here, as the workers do not wait for the streams of each other.
+ *
+ * The input grads of a node are added to its GradTensorHolder under the lock
+ * of the node. In deterministic mode they are kept until the node is ready,
+ * and then added in the order the pass found their producers in. The
+ * GradNodeAccumulation nodes run one at a time, since the hooks of the
+ * reducers of data parallel are not thread safe.
+ */
+class ParallelBackwardRunner {
+ public:
+  ParallelBackwardRunner(
+      std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+          init_buffers,
+      bool retain_graph,
+      bool deterministic)
+      : retain_graph_(retain_graph),
+        deterministic_(deterministic),
+        tracer_state_(TracerStateGuard::Current()) {
+    for (auto& item : *init_buffers) {
+      GetBuffer(item.first)->holder = std::move(item.second);
+    }
+    init_buffers->clear();
+  }
+
+  void Run(const std::deque<GradNodeBase*>& queue) {
+    // Collect the ready nodes before running any, the others are scheduled
+    // when their in_degree drops to zero.
+    std::vector<GradNodeBase*> ready_nodes;
+    for (GradNodeBase* node : queue) {
+      if (node->MutableRunState()->in_degree.load() == 0 &&
+          std::find(ready_nodes.begin(), ready_nodes.end(), node) ==
+              ready_nodes.end()) {
+        ready_nodes.push_back(node);
+      }
+    }
+    for (GradNodeBase* node : ready_nodes) {
+      Schedule(node);
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return num_running_ == 0; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  struct PendingGrad {
+    size_t producer_order;
+    size_t slot;
+    size_t rank;
+    paddle::experimental::Tensor grad;
+  };
+
+  struct NodeBuffer {
+    std::mutex mutex;
+    std::unique_ptr<GradTensorHolder> holder;
+    std::vector<PendingGrad> pending;
+  };
+
+  static phi::ThreadPool* Pool() {
+    static auto* pool = new phi::ThreadPool(FLAGS_eager_backward_num_threads);
+    return pool;
+  }
+
+  NodeBuffer* GetBuffer(GradNodeBase* node) {
+    std::lock_guard<std::mutex> guard(buffers_mutex_);
+    auto& buffer = buffers_[node];
+    if (!buffer) {
+      buffer.reset(new NodeBuffer());
+    }
+    return buffer.get();
+  }
+
+  void Schedule(GradNodeBase* node) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (error_) {
+        return;
+      }
+      ++num_running_;
+    }
+    Pool()->Run([this, node] {
+      is_parallel_backward_worker = true;
+      try {
+        TracerStateGuard tracer_state_guard(tracer_state_);
+        RunNode(node);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (--num_running_ == 0) {
+        cv_.notify_all();
+      }
+    });
+  }
+
+  std::unique_ptr<GradTensorHolder> TakeHolder(NodeBuffer* buffer) {
+    std::lock_guard<std::mutex> guard(buffer->mutex);
+    if (deterministic_ && buffer->holder) {
+      // The grads of a producer are pushed by one thread in the order of its
+      // outputs, which the stable sort keeps.
+      std::stable_sort(buffer->pending.begin(),
+                       buffer->pending.end(),
+                       [](const PendingGrad& a, const PendingGrad& b) {
+                         return a.producer_order < b.producer_order;
+                       });
+      for (const auto& pending : buffer->pending) {
+        buffer->holder->add(pending.slot, pending.rank, pending.grad);
+      }
+      buffer->pending.clear();
+    }
+    return std::move(buffer->holder);
+  }
+
+  void RunNode(GradNodeBase* node) {
+    std::unique_ptr<GradTensorHolder> node_input_buffer =
+        TakeHolder(GetBuffer(node));
+    size_t order = node->MutableRunState()->order;
+    auto add_grad = [&](GradNodeBase* next_node,
+                        const std::pair<size_t, size_t>& edge_rank,
+                        const paddle::experimental::Tensor& grad) {
+      NodeBuffer* buffer = GetBuffer(next_node);
+      {
+        std::lock_guard<std::mutex> guard(buffer->mutex);
+        if (!buffer->holder) {
+          buffer->holder =
+              std::make_unique<GradTensorHolder>(next_node->InputMeta());
+        }
+        if (deterministic_) {
+          buffer->pending.push_back(
+              PendingGrad{order, edge_rank.first, edge_rank.second, grad});
+        } else {
+          buffer->holder->add(edge_rank.first, edge_rank.second, grad);
+        }
+      }
+
+      int in_degree = next_node->MutableRunState()->in_degree.fetch_sub(1) - 1;
+      PADDLE_ENFORCE(
+          in_degree >= 0,
+          paddle::platform::errors::Fatal(
+              "Detected in-degree value smaller than zero. For Node: %s"
+              "Node's in-degree cannot be negative.",
+              next_node->name()));
+      if (in_degree == 0) {
+        Schedule(next_node);
+      }
+    };
+
+    std::unique_lock<std::mutex> accumulation_lock(accumulation_mutex_,
+                                                   std::defer_lock);
+    if (dynamic_cast<egr::GradNodeAccumulation*>(node)) {
+      accumulation_lock.lock();
+    }
+    RunGradNode(node,
+                node_input_buffer.get(),
+                retain_graph_,
+                /*create_graph=*/false,
+                /*is_general_grad=*/false,
+                add_grad);
+  }
+
+  bool retain_graph_;
+  bool deterministic_;
+  TracerStateGuard::State tracer_state_;
+
+  std::mutex buffers_mutex_;
+  std::unordered_map<GradNodeBase*, std::unique_ptr<NodeBuffer>> buffers_;
+
+  std::mutex accumulation_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t num_running_{0};
+  std::exception_ptr error_;
+};
+
+// Run the nodes of a backward pass in the order recorded by schedule. A node
+// whose input grads did not all arrive is skipped, as the serial pass never
+// queues it.
+static void RunBackwardSchedule(
+    BackwardSchedule* schedule,
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+        init_buffers,
+    bool retain_graph,
+    bool create_graph) {
+  const auto& nodes = schedule->nodes;
+  auto& holders = schedule->holders;
+  auto& remaining = schedule->remaining;
+  holders.resize(nodes.size());
+  remaining = schedule->in_degree;
+  for (auto& item : *init_buffers) {
+    holders[item.first->MutableRunState()->order] = std::move(item.second);
+  }
+  init_buffers->clear();
+
+  auto add_grad = [&](GradNodeBase* next_node,
+                      const std::pair<size_t, size_t>& edge_rank,
+                      const paddle::experimental::Tensor& grad) {
+    size_t next_index = next_node->MutableRunState()->order;
+    auto& next_holder = holders[next_index];
+    if (!next_holder) {
+      next_holder = std::make_unique<GradTensorHolder>(next_node->InputMeta());
+    }
+    next_holder->add(edge_rank.first, edge_rank.second, grad, create_graph);
+    --remaining[next_index];
+  };
+
+  for (size_t index : schedule->run_order) {
+    if (remaining[index] != 0) {
+      continue;
+    }
+    GradNodeBase* node = nodes[index];
+    RunGradNode(node,
+                holders[index].get(),
+                retain_graph,
+                create_graph,
+                /*is_general_grad=*/false,
+                add_grad);
+    // Keep the holder for the next replay, a node is never its own next node.
+    holders[index]->Reset(node->InputMeta());
+  }
+
+  // Drop the grads of the nodes skipped.
+  for (size_t index = 0; index < nodes.size(); ++index) {
+    if (remaining[index] != 0 && holders[index]) {
+      holders[index]->Reset(nodes[index]->InputMeta());
+    }
+  }
+}
+
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
 std::vector<paddle::experimental::Tensor> RunBackward(
@@ -125,6 +630,7 @@ std::vector<paddle::experimental::Tensor> RunBackward(
   // 2. Prepare initial input buffers
   std::deque<GradNodeBase*> queue;
   std::deque<GradNodeBase*> orig_queue;
+  bool all_roots_on_cpu = true;
   std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>
       node_input_buffers_dict;
   for (size_t i = 0; i < tensors.size(); i++) {
@@ -202,6 +708,7 @@ std::vector<paddle::experimental::Tensor> RunBackward(
 
     // Prepare queue, potential startup_nodes
     queue.push_back(grad_node);
+    all_roots_on_cpu = all_roots_on_cpu && tensor.is_cpu();
   }
 
   if (is_general_grad) {
@@ -210,12 +717,60 @@ std::vector<paddle::experimental::Tensor> RunBackward(
         inputs, no_grad_vars, orig_queue, &queue, node_input_buffers_dict);
   }
 
-  VLOG(5) << "Update In degree Map for backward";
-  // 3. Compute in_degree for each node
-  std::unordered_map<GradNodeBase*, int> node_in_degree_map =
-      getInDegreeMap(queue);
-
-  VLOG(5) << "Startup_ops's size is " << queue.size();
+  // The kernels of the grad nodes on a device are launched on its streams,
+  // which the workers would not synchronize, so only a backward on CPU runs
+  // in parallel.
+  bool run_parallel =
+      FLAGS_eager_backward_num_threads > 1 && !is_general_grad &&
+      !create_graph && !is_parallel_backward_worker && all_roots_on_cpu &&
+      paddle::platform::is_cpu_place(Controller::Instance().GetExpectedPlace());
+  bool use_schedule = FLAGS_eager_backward_cache_schedule &&
+                      !is_general_grad && !run_parallel;
+
+  // Replay the schedule recorded by a backward from the same nodes, which
+  // needs neither the in_degree nor the queue.
+  std::unique_ptr<BackwardSchedule> schedule;
+  if (use_schedule) {
+    schedule = BackwardScheduleCache::Instance().Take(queue);
+  }
+  std::unique_ptr<BackwardSchedule> recording;
+  if (schedule) {
+    VLOG(5) << "Run the cached schedule of " << schedule->nodes.size()
+            << " nodes";
+    RunBackwardSchedule(schedule.get(),
+                        &node_input_buffers_dict,
+                        retain_graph,
+                        create_graph);
+    BackwardScheduleCache::Instance().Put(std::move(schedule));
+    queue.clear();
+  } else {
+    VLOG(5) << "Update In degree Map for backward";
+    // 3. Compute in_degree for each node
+    std::vector<GradNodeBase*> nodes;
+    PrepareInDegree(queue, NextBackwardPassId(), &nodes);
+
+    VLOG(5) << "Startup_ops's size is " << queue.size();
+
+    if (run_parallel) {
+      ParallelBackwardRunner runner(&node_input_buffers_dict,
+                                    retain_graph,
+                                    FLAGS_eager_backward_deterministic);
+      runner.Run(queue);
+      queue.clear();
+    } else if (use_schedule) {
+      // Record the schedule from the serial pass below.
+      recording = std::make_unique<BackwardSchedule>();
+      recording->roots.assign(queue.begin(), queue.end());
+      recording->epoch = GradGraphEpoch();
+      recording->in_degree.reserve(nodes.size());
+      for (GradNodeBase* node : nodes) {
+        recording->in_degree.push_back(node->MutableRunState()->in_degree.load(
+            std::memory_order_relaxed));
+      }
+      recording->run_order.reserve(nodes.size());
+      recording->nodes = std::move(nodes);
+    }
+  }
 
   /* --- Topological Visit --- */
   // 1. Pop queue
@@ -224,15 +779,50 @@ std::vector<paddle::experimental::Tensor> RunBackward(
   //    |- node(grads)
   //    |- Prepare for next node
   // 3. Update queue
+  // Sum a grad into the buffer of next_node, and queue next_node when all
+  // of its grads arrived.
+  auto add_grad = [&](GradNodeBase* next_node,
+                      const std::pair<size_t, size_t>& edge_rank,
+                      const paddle::experimental::Tensor& grad) {
+    auto& next_buffer = node_input_buffers_dict[next_node];
+    if (!next_buffer) {
+      VLOG(7) << "Construct GradTensorHolder for grad node: "
+              << next_node->name();
+      next_buffer = std::make_unique<GradTensorHolder>(next_node->InputMeta());
+    }
+
+    VLOG(3) << "Sum or Move grad inputs for edge slot: " << edge_rank.first
+            << ", rank: " << edge_rank.second;
+
+    next_buffer->add(edge_rank.first, edge_rank.second, grad, create_graph);
+
+    // Update queue
+    int in_degree = next_node->MutableRunState()->in_degree.fetch_sub(
+                        1, std::memory_order_relaxed) -
+                    1;
+    VLOG(7) << next_node->name() << " ref_cnt is: " << in_degree;
+
+    PADDLE_ENFORCE(
+        in_degree >= 0,
+        paddle::platform::errors::Fatal(
+            "Detected in-degree value smaller than zero. For Node: %s"
+            "Node's in-degree cannot be negative.",
+            next_node->name()));
+
+    if (in_degree == 0) {
+      if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
+        queue.push_front(next_node);
+      } else {
+        queue.push_back(next_node);
+      }
+    }
+  };
+
   while (!queue.empty()) {
     GradNodeBase* node = queue.front();
-    VLOG(3) << "Preparing GradNode:" << node->name() << " addr:" << node;
-    paddle::platform::RecordEvent node_record_event(
-        std::string((*node).name()),
-        paddle::platform::TracerEventType::Operator,
-        1);
-
-    if (queue.size() > 1 && node_in_degree_map[node] != 0) {
+    if (queue.size() > 1 &&
+        node->MutableRunState()->in_degree.load(std::memory_order_relaxed) !=
+            0) {
       queue.pop_front();
       continue;
     }
@@ -249,124 +839,25 @@ std::vector<paddle::experimental::Tensor> RunBackward(
 
     std::unique_ptr<GradTensorHolder> node_input_buffer =
         std::move(node_input_buffer_iter->second);
-
-    // Check input
-    EnforceGradNodeHasInput(node);
-
-    VLOG(7) << "Run Backward Kernel with GradTensorHolder.";
-    // Run Pre Backward Node and get outputs
-    paddle::small_vector<std::vector<paddle::experimental::Tensor>,
-                         kSlotSmallVectorSize>
-        grad_output_tensors = (*node)(
-            node_input_buffer->Buffers(), create_graph, is_general_grad);
-
-    if (!inputs.empty() && is_general_grad) {
-      GeneralGrad::Instance().SetResultForEnddingNodes(grad_output_tensors,
-                                                       node);
-    }
-
-    // retain_grad or not
-    if (!retain_graph) {
-      VLOG(3)
-          << "retain_graph is false, need to clear the TensorWrapper of nodes.";
-      node->ClearTensorWrappers();
-    }
-
     // TODO(jiabin): Should we erase it or find a more efficient way.
     node_input_buffers_dict.erase(node_input_buffer_iter);
 
-    // Prepare GradTensorHolder for next node
-    const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
-        metas = node->OutputMeta();
-    PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
-                   paddle::platform::errors::Fatal(
-                       "Number of edges should be either empty ( for leaf node "
-                       ") or the same as number of output grad tensors, but we "
-                       "got edges size is: %d, grad_output size is: %d",
-                       metas.size(),
-                       grad_output_tensors.size()));
-
-    for (size_t i = 0; i < metas.size(); i++) {
-      for (size_t j = 0; j < metas[i].size(); j++) {
-        const Edge& edge = metas[i][j].GetEdge();
-        if (!edge.IsInitialized()) {
-          continue;
-        }
-        auto edge_rank = edge.GetEdgeRankInfo();
-        // Since we make edge has as same rank as bwd outputs, we indexing them
-        // with the same rank(i, j)
-        auto next_node_shared = edge.GetMutableGradNode();
-        VLOG(3) << "Node: " << node->name() << " addr:" << node
-                << ", Found pending node: " << next_node_shared->name()
-                << " addr: " << next_node_shared.get();
-        // Next node could be nullptr if it is leaf tensor with no
-        // AccumulationNode attached
-        // Or it could also originated from dispensable inputs
-        if (!next_node_shared || !next_node_shared.get() ||
-            grad_output_tensors[i].empty()) {
-          continue;
-        }
-
-        PADDLE_ENFORCE_LT(
-            j,
-            grad_output_tensors[i].size(),
-            paddle::platform::errors::Fatal(
-                "Rank of grad_output_tensors should be less than "
-                "grad_output_tensors[i].size(), which is: %d. This error may "
-                "indicate autoprune or autograd api error. ",
-                grad_output_tensors.size()));
-        paddle::experimental::Tensor& grad_output_tensor =
-            grad_output_tensors[i][j];
-
-        if ((!grad_output_tensor.defined() ||
-             !grad_output_tensor.initialized())) {
-          VLOG(7) << "We get grad_output_tensor with slot: " << i
-                  << ", rank: " << j << " as uninitialized or undefined tensor";
-        }
+    if (recording) {
+      recording->run_order.push_back(node->MutableRunState()->order);
+    }
 
-        VLOG(7) << "Get Edge and grad_output_tensor with slot: " << i
-                << ", rank: " << j
-                << " 's name is: " << grad_output_tensor.name();
-
-        auto* next_node = next_node_shared.get();
-        if (!node_input_buffers_dict.count(next_node)) {
-          const auto& input_meta = next_node->InputMeta();
-          auto grad_tensor_holder =
-              std::make_unique<GradTensorHolder>(input_meta);
-          VLOG(7) << "Construct GradTensorHolder for grad node: "
-                  << next_node->name();
-          node_input_buffers_dict[next_node] = std::move(grad_tensor_holder);
-        }
+    RunGradNode(node,
+                node_input_buffer.get(),
+                retain_graph,
+                create_graph,
+                is_general_grad,
+                add_grad);
+  }
 
-        VLOG(3) << "Sum or Move grad inputs for edge slot: " << edge_rank.first
-                << ", rank: " << edge_rank.second;
-
-        node_input_buffers_dict[next_node]->add(edge_rank.first,
-                                                edge_rank.second,
-                                                grad_output_tensor,
-                                                create_graph);
-
-        // Update queue
-        node_in_degree_map[next_node]--;
-        VLOG(7) << next_node->name()
-                << " ref_cnt is: " << node_in_degree_map[next_node];
-
-        PADDLE_ENFORCE(
-            node_in_degree_map[next_node] >= 0,
-            paddle::platform::errors::Fatal(
-                "Detected in-degree value smaller than zero. For Node: %s"
-                "Node's in-degree cannot be negative.",
-                next_node->name()));
-
-        if (node_in_degree_map[next_node] == 0) {
-          if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
-            queue.push_front(std::move(next_node));
-          } else {
-            queue.push_back(std::move(next_node));
-          }
-        }
-      }
-    }
+  // Nodes skipped by the pass may run in later ones, only a schedule of all
+  // the nodes is valid for them.
+  if (recording && recording->run_order.size() == recording->nodes.size()) {
+    BackwardScheduleCache::Instance().Put(std::move(recording));
   }
 
   VLOG(7) << "Run Backward Final hook size: "
@@ -34,6 +34,16 @@
  **/
 namespace egr {
 
+static std::atomic<uint64_t> grad_graph_epoch{0};
+
+uint64_t GradGraphEpoch() {
+  return grad_graph_epoch.load(std::memory_order_relaxed);
+}
+
+void BumpGradGraphEpoch() {
+  grad_graph_epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
 static void CheckTensor(const paddle::experimental::Tensor& pre,
                         const paddle::experimental::Tensor& post) {
   if (!pre.initialized() && post.initialized()) {
@@ -79,12 +89,15 @@ GradNodeBase::OutputMeta() const {
 
 paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
 GradNodeBase::MutableOutputMeta() {
+  // The edges may be changed through the metas.
+  BumpGradGraphEpoch();
   return bwd_out_meta_;
 }
 
 void GradNodeBase::SetGradInMeta(const paddle::experimental::Tensor& fwd_out,
                                  size_t slot_rank) {
   VLOG(7) << "Set GradSlotMeta for Grad Inputs";
+  BumpGradGraphEpoch();
   auto* fwd_out_meta = egr::EagerUtils::nullable_autograd_meta(fwd_out);
   PADDLE_ENFORCE_LE(
       slot_rank,
@@ -146,6 +159,7 @@ void GradNodeBase::SetGradInMeta(
     const std::vector<paddle::experimental::Tensor>& fwd_out,
     size_t slot_rank) {
   VLOG(7) << "Set GradSlotMeta for Grad Inputs";
+  BumpGradGraphEpoch();
   size_t slot_size = fwd_out.size();
   PADDLE_ENFORCE_LE(
       slot_rank,
@@ -210,6 +224,7 @@ void GradNodeBase::SetGradInMeta(
 
 void GradNodeBase::SetGradOutMeta(const paddle::experimental::Tensor& fwd_in,
                                   size_t slot_rank) {
+  BumpGradGraphEpoch();
   auto* fwd_in_meta = egr::EagerUtils::nullable_autograd_meta(fwd_in);
   PADDLE_ENFORCE_LE(
       (slot_rank + 1),
@@ -267,6 +282,7 @@ void GradNodeBase::SetGradOutMeta(const paddle::experimental::Tensor& fwd_in,
 
 void GradNodeBase::SetGradOutMeta(
     const std::vector<paddle::experimental::Tensor>& fwd_in, size_t slot_rank) {
+  BumpGradGraphEpoch();
   size_t slot_size = fwd_in.size();
   PADDLE_ENFORCE_LE(
       slot_rank,
@@ -332,6 +348,7 @@ void GradNodeBase::SetDefaultGradInOutMeta() {
                      "We can only support 1 input and 1 output in default grad "
                      "meta setter, other size of inputs and outputs should "
                      "create with Setter and Getters"));
+  BumpGradGraphEpoch();
   // Default stop_gradient is false and slot id is 0, slot size is 1;
   bwd_out_meta_[0].resize(1);
   bwd_in_meta_[0].resize(1);
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 
 #include "paddle/fluid/eager/api/utils/global_utils.h"
@@ -165,6 +166,33 @@ class GradSlotMeta {
   Edge adj_edge_;
 };
 
+// The number of changes made to the backward graphs so far. It is bumped
+// when a grad node is created or destroyed and when the metas or edges of a
+// node are set, so what the backward engine caches about a graph is valid
+// while the epoch stays the same.
+uint64_t GradGraphEpoch();
+void BumpGradGraphEpoch();
+
+/**
+ * The bookkeeping of the backward engine on a node in a backward pass. It is
+ * reset by every pass that reaches the node, and not copied with the node.
+ * As every node has one, it also bumps the graph epoch when a node is created
+ * or destroyed.
+ * **/
+struct GradNodeRunState {
+  GradNodeRunState() { BumpGradGraphEpoch(); }
+  GradNodeRunState(const GradNodeRunState&) { BumpGradGraphEpoch(); }
+  GradNodeRunState& operator=(const GradNodeRunState&) { return *this; }
+  ~GradNodeRunState() { BumpGradGraphEpoch(); }
+
+  // The backward pass that the other members belong to
+  uint64_t pass_id{0};
+  // The order in which the pass reached the node
+  size_t order{0};
+  // The number of grad nodes that still have to send grads to the node
+  std::atomic<int> in_degree{0};
+};
+
 class GradNodeBase {
  public:
   GradNodeBase() { VLOG(7) << "Construct GradNodeBase"; }
@@ -291,6 +319,8 @@ class GradNodeBase {
     is_tensor_wrappers_cleared_ = is_tensor_wrappers_cleared;
   }
 
+  GradNodeRunState* MutableRunState() { return &run_state_; }
+
  private:
   // bwd_out_meta_ is used to record Grad output info for backward
   paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>
@@ -316,6 +346,8 @@ class GradNodeBase {
   bool need_complex_to_real_ = false;
 
   bool is_tensor_wrappers_cleared_ = false;
+
+  GradNodeRunState run_state_;
 };
 
 }  // namespace egr
@@ -29,6 +29,36 @@ void GradTensorHolder::SetBufferSlotRankZeros(size_t slot_id, size_t rank) {
       paddle::experimental::zeros_like(buffer_[slot_id][rank]);
 }
 
+void GradTensorHolder::Reset(
+    const paddle::small_vector<std::vector<GradSlotMeta>,
+                               kSlotSmallVectorSize>& metas) {
+  buffer_.resize(metas.size());
+  spare_.resize(metas.size());
+  for (size_t i = 0; i < buffer_.size(); i++) {
+    spare_[i].resize(metas[i].size());
+    for (size_t j = 0; j < buffer_[i].size() && j < spare_[i].size(); j++) {
+      const auto& impl = buffer_[i][j].impl();
+      if (impl && impl.use_count() == 1 &&
+          phi::DenseTensor::classof(impl.get())) {
+        auto dense = std::static_pointer_cast<phi::DenseTensor>(impl);
+        if (dense->Holder() && dense->Holder().use_count() == 1) {
+          spare_[i][j] = std::move(dense);
+        }
+      }
+    }
+    buffer_[i].assign(metas[i].size(), paddle::experimental::Tensor());
+  }
+}
+
+std::shared_ptr<phi::DenseTensor> GradTensorHolder::TakeSpare(size_t slot_id,
+                                                              size_t rank) {
+  if (slot_id < spare_.size() && rank < spare_[slot_id].size() &&
+      spare_[slot_id][rank]) {
+    return std::move(spare_[slot_id][rank]);
+  }
+  return std::make_shared<phi::DenseTensor>();
+}
+
 void GradTensorHolder::CopyValueFromTensor(
     size_t slot_id,
     size_t rank,
@@ -157,8 +187,8 @@ void GradTensorHolder::add(size_t slot_id,
         // TODO(jiabin): Support Other TensorBase later
         // TODO(zhanlve): Replace SelectedRowsAddTensor with
         // add_dygraph_function once it's supported
-        paddle::experimental::Tensor new_buffer(
-            std::make_shared<phi::DenseTensor>(), "tmp_accumulator");
+        paddle::experimental::Tensor new_buffer(TakeSpare(slot_id, rank),
+                                                "tmp_accumulator");
         paddle::imperative::SelectedRowsAddTensor(
             buffer_tensor, t, &new_buffer);
         buffer_tensor.set_impl(new_buffer.impl());
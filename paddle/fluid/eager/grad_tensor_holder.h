@@ -69,10 +69,22 @@ class GradTensorHolder {
 
   void SetBufferSlotRankZeros(size_t slot_id, size_t rank);
 
+  // Drop the buffered grads and reshape the buffer as metas, so that the
+  // holder can be reused by another backward pass. The DenseTensors that only
+  // the holder refers to are kept, and hold the sums of the next pass.
+  void Reset(const paddle::small_vector<std::vector<GradSlotMeta>,
+                                        kSlotSmallVectorSize>& metas);
+
  private:
+  // Take the DenseTensor kept by Reset for the slot, or a new one.
+  std::shared_ptr<phi::DenseTensor> TakeSpare(size_t slot_id, size_t rank);
+
   paddle::small_vector<std::vector<paddle::experimental::Tensor>,
                        kSlotSmallVectorSize>
       buffer_;
+  paddle::small_vector<std::vector<std::shared_ptr<phi::DenseTensor>>,
+                       kSlotSmallVectorSize>
+      spare_;
 };
 
 }  // namespace egr
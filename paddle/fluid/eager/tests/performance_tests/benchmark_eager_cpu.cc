@@ -17,6 +17,7 @@
 #include <paddle/fluid/framework/op_registry.h>
 
 #include <chrono>
+#include <cmath>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/eager/api/all.h"
@@ -41,6 +42,8 @@ PD_DECLARE_KERNEL(add_grad, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum_grad, CPU, ALL_LAYOUT);
 
+DECLARE_bool(eager_backward_cache_schedule);
+
 using namespace egr;            // NOLINT
 using namespace egr_utils_api;  // NOLINT
 
@@ -254,6 +257,56 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
   }
 }
 
+// A chain of scale nodes is built once and every step runs its backward with
+// retain_graph, the steps time the backward with and without
+// FLAGS_eager_backward_cache_schedule.
+TEST(Benchmark, EagerBackwardCachedScheduleCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  const size_t num_steps = 200;
+  const size_t num_scales = 50;
+  for (bool cache_schedule : {false, true}) {
+    FLAGS_eager_backward_cache_schedule = cache_schedule;
+    paddle::framework::DDim ddim = phi::make_ddim({2, 4, 4, 4});
+    paddle::experimental::Tensor tensor =
+        CreateTensorWithValue(ddim,
+                              paddle::platform::CPUPlace(),
+                              phi::DataType::FLOAT32,
+                              phi::DataLayout::NCHW,
+                              5.0,
+                              true);
+    RetainGradForTensor(tensor);
+
+    paddle::experimental::Tensor input_tensor = tensor;
+    for (size_t i = 0; i < num_scales; i++) {
+      input_tensor = egr::scale(input_tensor,
+                                2.0 /*scale*/,
+                                3.0 /*bias*/,
+                                true /*bias_after_scale*/,
+                                true /*trace_backward*/);
+    }
+    std::vector<paddle::experimental::Tensor> target_tensors = {input_tensor};
+
+    double backward_time_ms = 0;
+    for (size_t step = 0; step < num_steps; ++step) {
+      auto t_start = std::chrono::high_resolution_clock::now();
+      Backward(target_tensors, {}, true /*retain_graph*/);
+      auto t_end = std::chrono::high_resolution_clock::now();
+      backward_time_ms +=
+          std::chrono::duration<double, std::milli>(t_end - t_start).count();
+    }
+    // The grads of the steps are summed, powers of two keep the sum exact.
+    eager_test::CompareGradTensorWithValue<float>(
+        tensor, num_steps * std::pow(2.0f, num_scales));
+
+    std::cout << "eager_backward_cache_schedule=" << cache_schedule
+              << ", backward step: " << backward_time_ms / num_steps << " ms"
+              << std::endl;
+  }
+  FLAGS_eager_backward_cache_schedule = false;
+}
+
 USE_OP_ITSELF(scale);
 USE_OP_ITSELF(elementwise_add);
 USE_OP_ITSELF(matmul_v2);
@@ -32,6 +32,10 @@
 PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 
+DECLARE_int32(eager_backward_num_threads);
+DECLARE_bool(eager_backward_deterministic);
+DECLARE_bool(eager_backward_cache_schedule);
+
 namespace egr {
 
 TEST(Backward, SingleNodeEmptyGrad) {
@@ -343,4 +347,107 @@ TEST(Backward, WithAccumulation) {
   eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 2500.0);
 }
 
+// Build num_branches branches of Scale(i + 1) from the targets appended to
+// target_tensors into one Scale(2), which is returned.
+static std::shared_ptr<GradNodeScale> CreateScaleBranches(
+    int num_branches,
+    const paddle::framework::DDim& ddim,
+    std::vector<paddle::experimental::Tensor>* target_tensors) {
+  auto node_ptr = std::make_shared<GradNodeScale>(1, 1);
+  node_ptr->SetAttributes_scale(2.0 /*scale*/);
+  node_ptr->SetDefaultGradInOutMeta();
+
+  for (int i = 0; i < num_branches; ++i) {
+    target_tensors->emplace_back(
+        egr_utils_api::CreateTensorWithValue(ddim,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             1.0 /*value*/,
+                                             false /*is_leaf*/));
+    auto branch_ptr = std::make_shared<GradNodeScale>(1, 1);
+    branch_ptr->SetAttributes_scale(i + 1.0 /*scale*/);
+    branch_ptr->SetDefaultGradInOutMeta();
+    AutogradMeta* auto_grad_meta =
+        EagerUtils::autograd_meta(&(target_tensors->back()));
+    auto_grad_meta->SetGradNode(
+        std::dynamic_pointer_cast<GradNodeBase>(branch_ptr));
+    auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+    auto_grad_meta->SetStopGradient(false);
+
+    // Connect branch -> node via Edge
+    auto tmp_tensor = paddle::experimental::Tensor();
+    auto* meta = EagerUtils::autograd_meta(&tmp_tensor);
+    meta->SetStopGradient(false);
+    meta->SetSingleOutRankWithSlot(0, 0);
+    meta->SetGradNode(node_ptr);
+    branch_ptr->SetGradOutMeta(tmp_tensor, 0);
+  }
+  return node_ptr;
+}
+
+// Connect node -> leaf via Edge
+static void ConnectLeaf(const std::shared_ptr<GradNodeScale>& node_ptr,
+                        paddle::experimental::Tensor* leaf_tensor) {
+  AutogradMeta* auto_grad_meta = EagerUtils::autograd_meta(leaf_tensor);
+  auto acc_node_ptr =
+      std::make_shared<egr::GradNodeAccumulation>(auto_grad_meta);
+  auto_grad_meta->SetGradNode(
+      std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+  auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+  auto_grad_meta->SetStopGradient(false);
+  node_ptr->SetGradOutMeta(*leaf_tensor, 0);
+}
+
+// Eight branches of Scale(i + 1) -> Scale(2) -> leaf, run by the parallel
+// backward engine.
+TEST(Backward, ParallelBranches) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  FLAGS_eager_backward_num_threads = 4;
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16, 16, 32});
+
+  for (bool deterministic : {false, true}) {
+    FLAGS_eager_backward_deterministic = deterministic;
+    std::vector<paddle::experimental::Tensor> target_tensors;
+    paddle::experimental::Tensor leaf_tensor;
+    ConnectLeaf(CreateScaleBranches(8, ddim, &target_tensors), &leaf_tensor);
+
+    Backward(target_tensors, {});
+
+    // (1 + 2 + ... + 8) * 2
+    eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 72.0);
+  }
+  FLAGS_eager_backward_num_threads = 0;
+  FLAGS_eager_backward_deterministic = false;
+}
+
+// A graph of 4 branches of Scale(i + 1) -> Scale(2) -> leaf runs backward
+// with retain_graph every step, the later steps replay the schedule cached by
+// the first one until the edge of Scale(2) is moved to another leaf.
+TEST(Backward, CachedSchedule) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  FLAGS_eager_backward_cache_schedule = true;
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16, 16, 32});
+
+  std::vector<paddle::experimental::Tensor> target_tensors;
+  auto node_ptr = CreateScaleBranches(4, ddim, &target_tensors);
+  paddle::experimental::Tensor leaf_tensor;
+  ConnectLeaf(node_ptr, &leaf_tensor);
+
+  // The grads of the steps are summed, (1 + 2 + 3 + 4) * 2 every step.
+  for (int step = 1; step <= 3; ++step) {
+    Backward(target_tensors, {}, true /*retain_graph*/);
+    eager_test::CompareGradTensorWithValue<float>(leaf_tensor, step * 20.0);
+  }
+
+  // Moving the edge bumps the graph epoch, a stale schedule would still send
+  // the grads to the old leaf.
+  paddle::experimental::Tensor other_leaf_tensor;
+  ConnectLeaf(node_ptr, &other_leaf_tensor);
+  Backward(target_tensors, {}, true /*retain_graph*/);
+  eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 60.0);
+  eager_test::CompareGradTensorWithValue<float>(other_leaf_tensor, 20.0);
+  FLAGS_eager_backward_cache_schedule = false;
+}
+
 }  // namespace egr
@@ -15,10 +15,12 @@ limitations under the License. */
 #include "paddle/fluid/framework/executor.h"
 
 #include <memory>
+#include <sstream>
 
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/trainer_desc.pb.h"
 #include "paddle/fluid/framework/trainer_factory.h"
+#include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/operators/controlflow/conditional_block_op_helper.h"
 #include "paddle/fluid/operators/controlflow/recurrent_op_helper.h"
 #include "paddle/fluid/operators/controlflow/while_op_helper.h"
@@ -65,6 +67,24 @@ void ExecutorPrepareContext::PrepareUnusedVars(
   unused_vars_ = GetUnusedVars(prog_.Block(block_id_), ops_, keep_vars);
 }
 
+// The memory allocated by running block 0 of a program is counted in the
+// scope "executor:<hash of its op types>", which is the same for the clones
+// of a program, so that the programs cloned for every step share one scope.
+// The other blocks are run by the ops of block 0 and count in its scope.
+void ExecutorPrepareContext::PrepareMemoryStatScope() {
+  if (block_id_ != 0) {
+    return;
+  }
+  size_t hash = ops_.size();
+  std::hash<std::string> hasher;
+  for (const auto& op : ops_) {
+    hash = hash * 31 + hasher(op->Type());
+  }
+  std::ostringstream os;
+  os << "executor:" << std::hex << hash;
+  memory_stat_scope_ = os.str();
+}
+
 ExecutorPrepareContext::~ExecutorPrepareContext() {
   VLOG(5) << "destroy ExecutorPrepareContext";
 }
@@ -426,6 +446,7 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
     ctx->ops_.push_back(OpRegistry::CreateOp(*op_desc));
   }
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
+  ctx->PrepareMemoryStatScope();
   return ctx;
 }
 
@@ -460,6 +481,7 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     } else {
       ctx->PrepareUnusedVars(skip_ref_cnt_vars[idx], force_disable_gc);
     }
+    ctx->PrepareMemoryStatScope();
     result.push_back(std::shared_ptr<ExecutorPrepareContext>(ctx));
     ++idx;
   }
@@ -476,6 +498,7 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
   platform::RecordEvent record_run("Executor::RunPartialPreparedContext",
                                    platform::TracerEventType::UserDefined,
                                    1);
+  memory::MemoryStatScope stat_scope(ctx->memory_stat_scope_);
   platform::RecordBlock b(kProgramId);
   PADDLE_ENFORCE_NOT_NULL(
       scope, platform::errors::InvalidArgument("Scope shouldn't be null"));
@@ -44,6 +44,8 @@ struct ExecutorPrepareContext {
   void PrepareUnusedVars(const std::vector<std::string>& keep_vars,
                          bool force_disable_gc = false);
 
+  void PrepareMemoryStatScope();
+
   const framework::ProgramDesc& prog_;
   const size_t block_id_;
 
@@ -52,6 +54,9 @@ struct ExecutorPrepareContext {
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   bool force_disable_gc_{false};
+  // The name of the memory::MemoryStatScope the ops run in, empty to keep
+  // the scope of the caller.
+  std::string memory_stat_scope_;
 };
 
 class Executor {
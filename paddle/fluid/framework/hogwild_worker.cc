@@ -21,6 +21,7 @@ limitations under the License. */
 #include "paddle/fluid/operators/controlflow/conditional_block_op_helper.h"
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/lodtensor_printer.h"
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
 
 #if defined PADDLE_WITH_PSCORE
 #include "paddle/fluid/distributed/ps/service/communicator/communicator.h"
@@ -126,6 +127,7 @@ void HogwildWorker::CreateDeviceResource(const ProgramDesc &main_prog) {
 
 void HogwildWorker::TrainFilesWithProfiler() {
   platform::SetNumThreads(1);
+  phi::backends::cpu::SetIntraOpNumThreads(1);
 #if defined(PADDLE_WITH_HETERPS) && \
     (defined(PADDLE_WITH_NCCL) || defined(PADDLE_WITH_RCCL))
   platform::SetDeviceId(thread_id_);
@@ -250,6 +252,7 @@ void HogwildWorker::TrainFilesWithProfiler() {
 
 void HogwildWorker::TrainFiles() {
   platform::SetNumThreads(1);
+  phi::backends::cpu::SetIntraOpNumThreads(1);
   platform::Timer timeline;
   timeline.Start();
 #if defined(PADDLE_WITH_HETERPS) && \
@@ -392,6 +392,45 @@ std::unique_ptr<Graph> Graph::CloneSubGraph(const size_t idx) {
   return cloned_sub_graph;
 }
 
+const std::unordered_map<std::string, std::unordered_set<ir::Node *>>
+    &Graph::OpNodesByType() const {
+  if (FLAGS_convert_all_blocks) {
+    if (IsMainGraph()) {
+      return GetSubGraph(0)->OpNodesByType();
+    }
+  }
+  std::vector<ir::Node *> retyped_nodes;
+  for (auto &item : op_node_types_) {
+    if (item.first->Op()->Type() != item.second) {
+      retyped_nodes.push_back(item.first);
+    }
+  }
+  for (auto *node : retyped_nodes) {
+    UnindexOpNode(node);
+    IndexOpNode(node);
+  }
+  return op_nodes_by_type_;
+}
+
+void Graph::IndexOpNode(ir::Node *node) const {
+  const std::string &op_type = node->Op()->Type();
+  op_node_types_[node] = op_type;
+  op_nodes_by_type_[op_type].insert(node);
+}
+
+void Graph::UnindexOpNode(ir::Node *node) const {
+  auto iter = op_node_types_.find(node);
+  if (iter == op_node_types_.end()) {
+    return;
+  }
+  auto nodes_iter = op_nodes_by_type_.find(iter->second);
+  nodes_iter->second.erase(node);
+  if (nodes_iter->second.empty()) {
+    op_nodes_by_type_.erase(nodes_iter);
+  }
+  op_node_types_.erase(iter);
+}
+
 bool IsControlDepVar(const ir::Node &var) {
   return var.Name().find(ir::Node::kControlDepVarName) != std::string::npos;
 }
@@ -19,6 +19,7 @@ limitations under the License. */
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -228,6 +229,13 @@ class Graph {
     return node_set_;
   }
 
+  // The op nodes by their op types. The index is updated as the nodes are
+  // added and removed, and the op nodes whose types were changed in place by
+  // the passes are moved to their new types here, so the pattern detectors
+  // only test the nodes of the op types in their patterns.
+  const std::unordered_map<std::string, std::unordered_set<ir::Node *>>
+      &OpNodesByType() const;
+
   // Create a normal variable with non-null VarDesc.
   ir::Node *CreateVarNode(VarDesc *var_desc, int block_id = -1) {
     if (FLAGS_convert_all_blocks) {
@@ -311,6 +319,8 @@ class Graph {
     }
     nodes_.clear();
     node_set_.clear();
+    op_nodes_by_type_.clear();
+    op_node_types_.clear();
     return ret;
   }
 
@@ -328,6 +338,7 @@ class Graph {
     ret.reset(nodes_.at(node).release());
     nodes_.erase(node);
     node_set_.erase(node);
+    UnindexOpNode(node);
     return ret;
   }
 
@@ -372,6 +383,9 @@ class Graph {
                           "The node to be added already exists."));
     nodes_[node].reset(node);
     node_set_.insert(node);
+    if (node->IsOp() && node->Op() != nullptr) {
+      IndexOpNode(node);
+    }
     return node;
   }
 
@@ -448,6 +462,9 @@ class Graph {
 
   std::unique_ptr<Graph> CloneSubGraph(const size_t idx);
 
+  void IndexOpNode(ir::Node *node) const;
+  void UnindexOpNode(ir::Node *node) const;
+
   // NOTE: program_ shouldn't be exposed to user.
   const ProgramDesc program_;
   // NOTE: main_graph_ doesn't hold any node. It's used as a container of
@@ -459,6 +476,10 @@ class Graph {
   std::map<std::string, std::function<void(void)>> attr_dels_;
   std::map<ir::Node *, std::unique_ptr<ir::Node>> nodes_;
   std::unordered_set<ir::Node *> node_set_;
+  // The op nodes by their op types, and the op types they are indexed by.
+  mutable std::unordered_map<std::string, std::unordered_set<ir::Node *>>
+      op_nodes_by_type_;
+  mutable std::unordered_map<ir::Node *, std::string> op_node_types_;
   size_t num_node_created_{0};  // help to generate a unique node id.
   // NOTE(Aurelius84): Whether is constructed with partial ProgramDesc.
   // In case of @to_static, whole trainning program is splited into two
@@ -14,12 +14,23 @@
 
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 
+#include <algorithm>
+#include <array>
+#include <tuple>
+
 #include "paddle/fluid/framework/ir/graph_traits.h"
 #include "paddle/fluid/framework/ir/graph_viz_pass.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/string/pretty_log.h"
 
+PADDLE_DEFINE_EXPORTED_bool(
+    graph_pattern_detector_prune_by_op_type,
+    true,
+    "Only test the nodes of the op types in the patterns, by the op type "
+    "index of the graph, and only extend the matches along the links of "
+    "their nodes. If false, test all the nodes against all the patterns.");
+
 namespace paddle {
 namespace framework {
 namespace ir {
@@ -105,16 +116,78 @@ void GraphPatternDetector::operator()(Graph *graph,
   }
 }
 
+// Collects the nodes that may match the PDNode by the op types of its
+// asserts, returns false if it has no op types to prune the nodes by.
+static bool CollectCandidates(
+    const PDNode &pdnode,
+    const std::unordered_map<std::string, std::unordered_set<Node *>>
+        &op_nodes_by_type,
+    std::unordered_set<Node *> *candidates) {
+  if (pdnode.op_type_link() == PDNode::OpTypeLink::kNone) {
+    return false;
+  }
+  for (const auto &op_type : pdnode.linked_op_types()) {
+    auto iter = op_nodes_by_type.find(op_type);
+    if (iter == op_nodes_by_type.end()) continue;
+    for (auto *op : iter->second) {
+      switch (pdnode.op_type_link()) {
+        case PDNode::OpTypeLink::kOp:
+          candidates->insert(op);
+          break;
+        case PDNode::OpTypeLink::kInputOf:
+          candidates->insert(op->inputs.begin(), op->inputs.end());
+          break;
+        case PDNode::OpTypeLink::kOutputOf:
+          candidates->insert(op->outputs.begin(), op->outputs.end());
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  return true;
+}
+
 bool GraphPatternDetector::MarkPDNodesInGraph(const ir::Graph &graph) {
   VLOG(3) << "mark pdnodes in graph";
   if (graph.Nodes().empty()) return false;
 
-  for (auto &node : GraphTraits::DFS(graph)) {
-    if (node.Name().rfind("__control_var") == 0) continue;
+  // The graph is acyclic, so the DFS from the nodes without inputs reaches
+  // all the nodes, and the candidates of the PDNodes are tested instead.
+  std::vector<PDNode *> unpruned_pdnodes;
+  if (FLAGS_graph_pattern_detector_prune_by_op_type) {
+    const auto &op_nodes_by_type = graph.OpNodesByType();
+    std::unordered_set<Node *> candidates;
     for (const auto &pdnode : pattern_.nodes()) {
-      if (pdnode->Tell(&node)) {
-        VLOG(4) << "Node " << node.Name() << " marked as " << pdnode->name();
-        pdnodes2nodes_[pdnode.get()].insert(&node);
+      candidates.clear();
+      if (!CollectCandidates(*pdnode, op_nodes_by_type, &candidates)) {
+        unpruned_pdnodes.push_back(pdnode.get());
+        continue;
+      }
+      for (auto *node : candidates) {
+        if (node->Name().rfind("__control_var") == 0) continue;
+        if (pdnode->Tell(node)) {
+          VLOG(4) << "Node " << node->Name() << " marked as "
+                  << pdnode->name();
+          pdnodes2nodes_[pdnode.get()].insert(node);
+        }
+      }
+    }
+  } else {
+    for (const auto &pdnode : pattern_.nodes()) {
+      unpruned_pdnodes.push_back(pdnode.get());
+    }
+  }
+
+  if (!unpruned_pdnodes.empty()) {
+    for (auto &node : GraphTraits::DFS(graph)) {
+      if (node.Name().rfind("__control_var") == 0) continue;
+      for (auto *pdnode : unpruned_pdnodes) {
+        if (pdnode->Tell(&node)) {
+          VLOG(4) << "Node " << node.Name() << " marked as "
+                  << pdnode->name();
+          pdnodes2nodes_[pdnode].insert(&node);
+        }
       }
     }
   }
@@ -199,6 +272,64 @@ bool IsNodesLink(Node *a, Node *b) {
   return false;
 }
 
+// Extends the groups by the linked source and target nodes of the edge, in
+// the order of the loops over the sources, the targets and the groups, while
+// only the targets linked to the sources are visited, and only the source or
+// the target a group has matched.
+static void ExtendHitGroups(
+    const std::set<Node *, GraphPatternDetector::NodeIdCompare> &sources,
+    const std::set<Node *, GraphPatternDetector::NodeIdCompare> &targets,
+    const PDPattern::edge_t &edge,
+    const std::vector<HitGroup> &pre_groups,
+    std::vector<HitGroup> *cur_groups) {
+  // (source id, target id, group index, source, target)
+  std::vector<std::tuple<int, int, size_t, Node *, Node *>> hits;
+  auto add_hits = [&](Node *source, size_t group_idx) {
+    for (auto *target : source->outputs) {
+      if (targets.count(target)) {
+        hits.emplace_back(
+            source->id(), target->id(), group_idx, source, target);
+      }
+    }
+  };
+  for (size_t i = 0; i < pre_groups.size(); ++i) {
+    const auto &roles = pre_groups[i].roles;
+    auto source_iter = roles.find(edge.first);
+    auto target_iter = roles.find(edge.second);
+    if (source_iter != roles.end()) {
+      if (sources.count(source_iter->second)) {
+        add_hits(source_iter->second, i);
+      }
+    } else if (target_iter != roles.end()) {
+      Node *target = target_iter->second;
+      if (!targets.count(target)) continue;
+      for (auto *source : target->inputs) {
+        if (sources.count(source) && IsNodesLink(source, target)) {
+          hits.emplace_back(source->id(), target->id(), i, source, target);
+        }
+      }
+    } else {
+      for (auto *source : sources) {
+        add_hits(source, i);
+      }
+    }
+  }
+  std::sort(hits.begin(), hits.end());
+  hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+  for (const auto &hit : hits) {
+    Node *source = std::get<3>(hit);
+    Node *target = std::get<4>(hit);
+    HitGroup new_group = pre_groups[std::get<2>(hit)];
+    if (new_group.Match(source, edge.first) &&
+        new_group.Match(target, edge.second)) {
+      new_group.Register(source, edge.first);
+      new_group.Register(target, edge.second);
+      cur_groups->push_back(std::move(new_group));
+    }
+  }
+}
+
 std::vector<GraphPatternDetector::subgraph_t>
 GraphPatternDetector::DetectPatterns() {
   // Init empty subgraphs.
@@ -228,21 +359,29 @@ GraphPatternDetector::DetectPatterns() {
     auto &cur_groups = bi_records[1 - (step++ % 2)];
     cur_groups.clear();
     if (pre_groups.empty()) break;
-    // source -> target
-    for (Node *source : pdnodes2nodes_[edge.first]) {
-      for (Node *target : pdnodes2nodes_[edge.second]) {
-        VLOG(8) << "check " << source->id() << " -- " << target->id();
-        // TODO(Superjomn) add some prune strategies.
-        for (const auto &group : pre_groups) {
-          if (IsNodesLink(source, target)) {
-            HitGroup new_group = group;
-            bool flag = new_group.Match(source, edge.first) &&
-                        new_group.Match(target, edge.second);
-            if (flag) {
-              new_group.Register(source, edge.first);
-              new_group.Register(target, edge.second);
-              cur_groups.push_back(new_group);
-              // TODO(Superjomn) need to unique
+    if (FLAGS_graph_pattern_detector_prune_by_op_type) {
+      ExtendHitGroups(pdnodes2nodes_[edge.first],
+                      pdnodes2nodes_[edge.second],
+                      edge,
+                      pre_groups,
+                      &cur_groups);
+    } else {
+      // source -> target
+      for (Node *source : pdnodes2nodes_[edge.first]) {
+        for (Node *target : pdnodes2nodes_[edge.second]) {
+          VLOG(8) << "check " << source->id() << " -- " << target->id();
+          // TODO(Superjomn) add some prune strategies.
+          for (const auto &group : pre_groups) {
+            if (IsNodesLink(source, target)) {
+              HitGroup new_group = group;
+              bool flag = new_group.Match(source, edge.first) &&
+                          new_group.Match(target, edge.second);
+              if (flag) {
+                new_group.Register(source, edge.first);
+                new_group.Register(target, edge.second);
+                cur_groups.push_back(new_group);
+                // TODO(Superjomn) need to unique
+              }
             }
           }
         }
@@ -407,12 +546,29 @@ PDNode &PDNode::LinksFrom(const std::vector<PDNode *> &others) {
   return *this;
 }
 
+void PDNode::LinkOpTypes(OpTypeLink link,
+                         const std::unordered_set<std::string> &op_types) {
+  if (link == OpTypeLink::kOp && op_type_link_ == OpTypeLink::kOp) {
+    // An op matches all the asserts of its op types.
+    for (auto it = linked_op_types_.begin(); it != linked_op_types_.end();) {
+      it = op_types.count(*it) ? std::next(it) : linked_op_types_.erase(it);
+    }
+  } else if (link == OpTypeLink::kOp ||
+             op_type_link_ == OpTypeLink::kNone) {
+    // A var may be linked to different ops by the asserts, so only the op
+    // types of one assert are kept.
+    op_type_link_ = link;
+    linked_op_types_ = op_types;
+  }
+}
+
 PDNode *PDNode::assert_is_op() {
   asserts_.emplace_back([](Node *x) { return x && x->IsOp(); });
   return this;
 }
 
 PDNode *PDNode::assert_is_op(const std::string &op_type) {
+  LinkOpTypes(OpTypeLink::kOp, {op_type});
   asserts_.emplace_back([op_type](Node *x) {
     return x && x->IsOp() && x->Op()->Type() == op_type;
   });
@@ -476,6 +632,7 @@ PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
                                         const std::string &argument,
                                         int nth) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kOutputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op->IsOp() && op->Op()->Type() == op_type &&
@@ -489,6 +646,7 @@ PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
 
 PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kInputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type &&
@@ -503,6 +661,7 @@ PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
 
 PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kOutputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type &&
@@ -517,6 +676,7 @@ PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
 
 PDNode *PDNode::assert_is_op_output(const std::string &op_type) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kOutputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type) {
@@ -537,6 +697,7 @@ PDNode *PDNode::assert_is_op_output(const std::string &op_type,
 
 PDNode *PDNode::assert_is_op_input(const std::string &op_type) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kInputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type) {
@@ -593,6 +754,7 @@ PDNode *PDNode::assert_more(PDNode::teller_t &&teller) {
 }
 
 PDNode *PDNode::assert_is_ops(const std::unordered_set<std::string> &op_types) {
+  LinkOpTypes(OpTypeLink::kOp, op_types);
   asserts_.emplace_back([op_types](Node *x) {
     return x && x->IsOp() && op_types.count(x->Op()->Type());
   });
@@ -621,6 +783,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
     const std::string &argument,
     int nth) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op->IsOp() && op_types.count(op->Op()->Type()) &&
@@ -634,6 +797,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
 PDNode *PDNode::assert_is_ops_output(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type())) {
@@ -656,6 +820,7 @@ PDNode *PDNode::assert_is_ops_output(
 PDNode *PDNode::assert_is_ops_input(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kInputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type())) {
@@ -678,6 +843,7 @@ PDNode *PDNode::assert_is_ops_input(
 PDNode *PDNode::assert_is_only_input_of_ops(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kInputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type()) &&
@@ -693,6 +859,7 @@ PDNode *PDNode::assert_is_only_input_of_ops(
 PDNode *PDNode::assert_is_only_output_of_ops(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  LinkOpTypes(OpTypeLink::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type()) &&
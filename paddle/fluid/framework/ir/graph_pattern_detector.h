@@ -63,6 +63,13 @@ struct PDNode {
     kOutput,       // an output and will be retained,
     kIntermediate  // will be removed after handler.
   };
+  // How the matched nodes relate to the op types required by the asserts.
+  enum class OpTypeLink {
+    kNone,      // No op type is required,
+    kOp,        // an op of the op types,
+    kInputOf,   // a var that is an input of an op of the op types,
+    kOutputOf,  // a var that is an output of an op of the op types.
+  };
 
   // this link to others
   PDNode& LinksTo(const std::vector<PDNode*>& others);
@@ -80,6 +87,15 @@ struct PDNode {
   bool IsOp() const { return type_ == Type::kOp; }
   bool IsVar() const { return type_ == Type::kVar; }
 
+  // The op types required by the asserts, the detector only tests the nodes
+  // of these op types or linked to them.
+  OpTypeLink op_type_link() const {
+    return teller_ ? OpTypeLink::kNone : op_type_link_;
+  }
+  const std::unordered_set<std::string>& linked_op_types() const {
+    return linked_op_types_;
+  }
+
   const std::string& name() const { return name_; }
   const PDPattern* pdpattern() const { return pattern_; }
 
@@ -188,6 +204,9 @@ struct PDNode {
 
   PDNode(PDNode&& other) = default;
 
+  void LinkOpTypes(OpTypeLink link,
+                   const std::unordered_set<std::string>& op_types);
+
   friend class PDPattern;
 
   // Will removed latter.
@@ -197,6 +216,8 @@ struct PDNode {
   std::string name_;
   Type type_;
   Role role_{Role::kUnknown};
+  OpTypeLink op_type_link_{OpTypeLink::kNone};
+  std::unordered_set<std::string> linked_op_types_;
 };
 
 /*
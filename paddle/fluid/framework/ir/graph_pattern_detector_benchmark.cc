@@ -0,0 +1,219 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The benchmark of the pattern detection on the graphs of transformer
+// encoders, with and without the pruning by the op types. It runs the
+// detectors of a set of fuse patterns over the graph, and reports the total
+// analysis time of each mode and the number of the matched subgraphs, which
+// should be the same for both.
+
+#include <chrono>  // NOLINT
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+DEFINE_int32(layers, 128, "The number of the transformer encoder layers.");
+DEFINE_int32(repeat, 3, "Repeat times of the detectors.");
+DECLARE_bool(graph_pattern_detector_prune_by_op_type);
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+// Appends the layers of multi-head attention and feed forward network, as
+// in the programs the fused_multi_transformer passes work on.
+void BuildTransformerEncoder(Layers* layers, int num_layers) {
+  auto* x = layers->data("x", {1, 128, 1024});
+  for (int i = 0; i < num_layers; ++i) {
+    auto param = [&](const std::string& name, std::vector<int64_t> shape) {
+      return layers->data(name + "_" + std::to_string(i), shape, true);
+    };
+    auto* ln_out = layers->layer_norm(
+        x, param("ln_scale", {1024}), param("ln_bias", {1024}))[0];
+
+    std::vector<VarDesc*> qkv;
+    for (int j = 0; j < 3; ++j) {
+      std::string suffix = std::to_string(j);
+      auto* out = layers->matmul_v2(
+          ln_out, param("weights" + suffix, {1024, 1024}), nullptr);
+      out = layers->elementwise_add(
+          out, param("bias" + suffix, {1024}), nullptr, 2);
+      out = layers->reshape2(out, {1, 128, 16, 64}, true);
+      qkv.push_back(layers->transpose2(out, {0, 2, 1, 3}, true));
+    }
+    auto* q = layers->scale(qkv[0], 0.125, 0, false);
+    auto* qk = layers->matmul_v2(q, qkv[1], nullptr, false, true);
+    qk = layers->elementwise_add(
+        qk, param("biasqk", {1, 1, 1, 128}), nullptr, -1);
+    qk = layers->softmax(qk, -1);
+    qk = layers->dropout(qk, 0.1, "upscale_in_train");
+    auto* qkv_out = layers->matmul_v2(qk, qkv[2]);
+    qkv_out = layers->transpose2(qkv_out, {0, 2, 1, 3}, true);
+    qkv_out = layers->reshape2(qkv_out, {1, 128, 1024}, true);
+    auto* attention_out = layers->matmul_v2(
+        qkv_out, param("weights_l", {1024, 1024}), nullptr);
+    attention_out = layers->elementwise_add(
+        attention_out, param("bias_l", {1024}), nullptr, 2);
+    attention_out = layers->elementwise_add(x, attention_out);
+
+    auto* ffn_ln_out = layers->layer_norm(attention_out,
+                                          param("ffn_ln_scale", {1024}),
+                                          param("ffn_ln_bias", {1024}))[0];
+    auto* ffn_out = layers->matmul_v2(
+        ffn_ln_out, param("ffn_weights0", {1024, 4096}), nullptr);
+    ffn_out = layers->elementwise_add(
+        ffn_out, param("ffn_bias0", {4096}), nullptr, 2);
+    ffn_out = layers->gelu(ffn_out);
+    ffn_out = layers->matmul_v2(
+        ffn_out, param("ffn_weights1", {4096, 1024}), nullptr);
+    ffn_out = layers->elementwise_add(
+        ffn_out, param("ffn_bias1", {1024}), nullptr, 2);
+    x = layers->elementwise_add(attention_out, ffn_out);
+  }
+}
+
+// The patterns of the fuse passes in the CPU and GPU pass strategies, most
+// of which do not match the transformer graphs, as in the analysis.
+std::vector<std::function<void(PDPattern*)>> GetPatterns() {
+  std::vector<std::function<void(PDPattern*)>> patterns;
+  for (bool with_relu : {false, true}) {
+    patterns.emplace_back([with_relu](PDPattern* pattern) {
+      auto* x = pattern->NewNode("fc_fuse/x")
+                    ->AsInput()
+                    ->assert_is_op_input("mul", "X");
+      patterns::FC fc_pattern(pattern, "fc_fuse");
+      fc_pattern(x, true, with_relu);
+    });
+  }
+  std::vector<std::pair<std::string, std::string>> op_acts = {
+      {"elementwise_add", "gelu"},
+      {"elementwise_add", "relu"},
+      {"matmul_v2", "gelu"},
+      {"fc", "gelu"},
+      {"fc", "relu"},
+      {"conv2d", "relu"},
+      {"conv2d", "swish"},
+      {"concat", "relu"}};
+  for (auto& op_act : op_acts) {
+    patterns.emplace_back([op_act](PDPattern* pattern) {
+      patterns::OperatorActivation op_act_pattern(pattern, "op_act");
+      op_act_pattern(op_act.first, op_act.second);
+    });
+  }
+  for (std::string op_type :
+       {"elementwise_add", "elementwise_sub", "elementwise_mul"}) {
+    patterns.emplace_back([op_type](PDPattern* pattern) {
+      patterns::ElementwiseOp elementwise_pattern(pattern, "elementwise");
+      elementwise_pattern(op_type);
+    });
+  }
+  for (std::string op_type : {"matmul", "matmul_v2"}) {
+    patterns.emplace_back([op_type](PDPattern* pattern) {
+      patterns::ReshapeTransposeMatmulPattern reshape_transpose_matmul(
+          pattern, "reshape_transpose_matmul");
+      reshape_transpose_matmul(op_type, true, true);
+    });
+    patterns.emplace_back([op_type](PDPattern* pattern) {
+      patterns::MatmulTransposeReshapePattern matmul_transpose_reshape(
+          pattern, "matmul_transpose_reshape");
+      matmul_transpose_reshape(op_type);
+    });
+  }
+  patterns.emplace_back([](PDPattern* pattern) {
+    patterns::Matmul matmul_pattern(pattern, "matmul");
+    matmul_pattern();
+  });
+  patterns.emplace_back([](PDPattern* pattern) {
+    patterns::MatmulScale matmul_scale_pattern(pattern, "matmul_scale");
+    matmul_scale_pattern();
+  });
+  patterns.emplace_back([](PDPattern* pattern) {
+    patterns::LayerNormShiftScale layer_norm_pattern(pattern, "layer_norm");
+    layer_norm_pattern();
+  });
+  patterns.emplace_back([](PDPattern* pattern) {
+    patterns::DeleteDropoutOpPattern dropout_pattern(pattern, "dropout");
+    dropout_pattern();
+  });
+  patterns.emplace_back([](PDPattern* pattern) {
+    auto* x = pattern->NewNode("x")
+                  ->assert_is_ops_input({"matmul", "matmul_v2"}, "X")
+                  ->AsInput();
+    patterns::VitAttention vit_attention_pattern(pattern, "vit_attention");
+    vit_attention_pattern(x);
+  });
+  return patterns;
+}
+
+// Returns the total number of the subgraphs matched by the detectors.
+int RunDetectors(Graph* graph,
+                 const std::vector<std::function<void(PDPattern*)>>& patterns,
+                 double* ms) {
+  int found_count = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& build_pattern : patterns) {
+    GraphPatternDetector detector;
+    build_pattern(detector.mutable_pattern());
+    detector(graph,
+             [&](const GraphPatternDetector::subgraph_t& subgraph, Graph* g) {
+               ++found_count;
+             });
+  }
+  *ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+  return found_count;
+}
+
+int RunBenchmark() {
+  Layers layers;
+  BuildTransformerEncoder(&layers, FLAGS_layers);
+  Graph graph(layers.main_program());
+  LOG(INFO) << "Graph of " << FLAGS_layers << " layers has "
+            << graph.Nodes().size() << " nodes";
+
+  auto patterns = GetPatterns();
+  int found_counts[2] = {0, 0};
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    for (bool prune : {false, true}) {
+      FLAGS_graph_pattern_detector_prune_by_op_type = prune;
+      double ms = 0;
+      found_counts[prune] = RunDetectors(&graph, patterns, &ms);
+      LOG(INFO) << patterns.size() << " detectors "
+                << (prune ? "with" : "without")
+                << " pruning by op type: " << ms
+                << " ms, found subgraphs: " << found_counts[prune];
+    }
+  }
+  if (found_counts[0] != found_counts[1]) {
+    LOG(ERROR) << "The pruning by op type changes the found subgraphs";
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::framework::ir::RunBenchmark();
+}
@@ -15,6 +15,9 @@
 #include <gtest/gtest.h>
 
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+DECLARE_bool(graph_pattern_detector_prune_by_op_type);
 
 namespace paddle {
 namespace framework {
@@ -207,6 +210,75 @@ TEST(GraphPatternDetector, IntermediateCheck) {
   ASSERT_EQ(count, 1);
 }
 
+TEST(GraphPatternDetecter, OpNodesByType) {
+  Layers layers;
+  auto* mul_out = layers.mul(layers.data("x"), layers.data("w", {}, true));
+  auto* add_out = layers.elementwise_add(mul_out, layers.data("b", {}, true));
+  layers.relu(add_out);
+  Graph graph(layers.main_program());
+
+  const auto& op_nodes_by_type = graph.OpNodesByType();
+  ASSERT_EQ(op_nodes_by_type.size(), 3UL);
+  ASSERT_EQ(op_nodes_by_type.at("mul").size(), 1UL);
+  ASSERT_EQ(op_nodes_by_type.at("relu").size(), 1UL);
+
+  // The op whose type is changed in place is moved to its new type.
+  Node* relu = *op_nodes_by_type.at("relu").begin();
+  relu->Op()->SetType("gelu");
+  EXPECT_EQ(graph.OpNodesByType().count("relu"), 0UL);
+  EXPECT_EQ(graph.OpNodesByType().at("gelu").count(relu), 1UL);
+
+  Node* mul = *op_nodes_by_type.at("mul").begin();
+  graph.RemoveNode(mul);
+  EXPECT_EQ(graph.OpNodesByType().count("mul"), 0UL);
+  OpDesc desc;
+  desc.SetType("mul");
+  mul = graph.CreateOpNode(&desc);
+  EXPECT_EQ(graph.OpNodesByType().at("mul").count(mul), 1UL);
+}
+
+TEST(GraphPatternDetecter, PruneByOpType) {
+  // x -> mul -> elementwise_add -> relu -> mul -> elementwise_add
+  Layers layers;
+  auto* x = layers.data("x");
+  for (int i = 0; i < 2; ++i) {
+    std::string suffix = std::to_string(i);
+    x = layers.mul(x, layers.data("w" + suffix, {}, true));
+    x = layers.elementwise_add(x, layers.data("b" + suffix, {}, true));
+    if (i == 0) {
+      x = layers.relu(x);
+    }
+  }
+  Graph graph(layers.main_program());
+
+  // The ids of the nodes of the found subgraphs by the PDNode names.
+  auto detect = [&](bool prune, bool with_relu) {
+    FLAGS_graph_pattern_detector_prune_by_op_type = prune;
+    GraphPatternDetector detector;
+    auto* x = detector.mutable_pattern()
+                  ->NewNode("fc/x")
+                  ->AsInput()
+                  ->assert_is_op_input("mul", "X");
+    patterns::FC fc_pattern(detector.mutable_pattern(), "fc");
+    fc_pattern(x, true, with_relu);
+    std::vector<std::map<std::string, int>> found;
+    detector(&graph,
+             [&](const GraphPatternDetector::subgraph_t& subgraph, Graph* g) {
+               found.emplace_back();
+               for (auto& item : subgraph) {
+                 found.back()[item.first->name()] = item.second->id();
+               }
+             });
+    FLAGS_graph_pattern_detector_prune_by_op_type = true;
+    return found;
+  };
+  for (bool with_relu : {false, true}) {
+    auto found = detect(true, with_relu);
+    EXPECT_EQ(found.size(), with_relu ? 1UL : 2UL);
+    EXPECT_EQ(found, detect(false, with_relu));
+  }
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,202 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/weight_only_quant_pass.h"
+
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/phi/kernels/funcs/weight_only_quant.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+static Node* FindInputNode(Node* op, const std::string& name) {
+  for (auto* node : op->inputs) {
+    if (node->IsVar() && node->Name() == name) {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+static Node* FindOutputNode(Node* op, const std::string& name) {
+  for (auto* node : op->outputs) {
+    if (node->IsVar() && node->Name() == name) {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+bool WeightOnlyQuantPass::QuantizeOp(ir::Graph* graph,
+                                     Node* op,
+                                     int weight_bits) const {
+  auto* op_desc = op->Op();
+  const bool is_fc = op_desc->Type() == "fc";
+  const std::string x_arg = is_fc ? "Input" : "X";
+  const std::string w_arg = is_fc ? "W" : "Y";
+  if (op_desc->Input(x_arg).size() != 1 || op_desc->Input(w_arg).size() != 1 ||
+      op_desc->Output("Out").size() != 1) {
+    return false;
+  }
+  Node* x = FindInputNode(op, op_desc->Input(x_arg)[0]);
+  Node* w = FindInputNode(op, op_desc->Input(w_arg)[0]);
+  Node* out = FindOutputNode(op, op_desc->Output("Out")[0]);
+  // A weight shared with other ops keeps its float32 copy.
+  if (x == nullptr || w == nullptr || out == nullptr || w->Var() == nullptr ||
+      !w->Var()->Persistable() || w->outputs.size() != 1) {
+    return false;
+  }
+  auto* scope = param_scope();
+  auto* w_var = scope->FindVar(w->Name());
+  if (w_var == nullptr) {
+    return false;
+  }
+  const auto& w_tensor = w_var->Get<phi::DenseTensor>();
+  if (w_tensor.dims().size() != 2 ||
+      w_tensor.dtype() != phi::DataType::FLOAT32) {
+    return false;
+  }
+
+  int in_num_col_dims = 1;
+  bool trans_w = false;
+  std::string activation_type;
+  if (is_fc) {
+    if ((op_desc->HasAttr("padding_weights") &&
+         PADDLE_GET_CONST(bool, op_desc->GetAttr("padding_weights"))) ||
+        (op_desc->HasAttr("use_mkldnn") &&
+         PADDLE_GET_CONST(bool, op_desc->GetAttr("use_mkldnn")))) {
+      return false;
+    }
+    in_num_col_dims =
+        PADDLE_GET_CONST(int, op_desc->GetAttr("in_num_col_dims"));
+    activation_type =
+        PADDLE_GET_CONST(std::string, op_desc->GetAttr("activation_type"));
+  } else {
+    if (PADDLE_GET_CONST(bool, op_desc->GetAttr("trans_x"))) {
+      return false;
+    }
+    trans_w = PADDLE_GET_CONST(bool, op_desc->GetAttr("trans_y"));
+    // A matmul_v2 by a 2-D weight is an fc over the last axis of x.
+    const auto x_shape = x->Var()->GetShape();
+    if (x_shape.size() < 2) {
+      return false;
+    }
+    in_num_col_dims = static_cast<int>(x_shape.size()) - 1;
+  }
+  Node* bias = nullptr;
+  if (is_fc && op_desc->Inputs().count("Bias") &&
+      op_desc->Input("Bias").size() == 1) {
+    bias = FindInputNode(op, op_desc->Input("Bias")[0]);
+  }
+
+  const int64_t k = trans_w ? w_tensor.dims()[1] : w_tensor.dims()[0];
+  const int64_t n = trans_w ? w_tensor.dims()[0] : w_tensor.dims()[1];
+  const int64_t row_bytes = phi::funcs::WeightOnlyRowBytes(k, weight_bits);
+
+  VarDesc qweight_desc(w->Name() + "@weight_only_int" +
+                       std::to_string(weight_bits));
+  qweight_desc.SetShape({n, row_bytes});
+  qweight_desc.SetDataType(proto::VarType::INT8);
+  qweight_desc.SetPersistable(true);
+  auto* qweight = graph->CreateVarNode(&qweight_desc);
+  auto* qweight_tensor =
+      scope->Var(qweight->Name())->GetMutable<phi::DenseTensor>();
+  qweight_tensor->Resize({n, row_bytes});
+
+  VarDesc scale_desc(w->Name() + "@weight_only_scale");
+  scale_desc.SetShape({n});
+  scale_desc.SetDataType(proto::VarType::FP32);
+  scale_desc.SetPersistable(true);
+  auto* scale = graph->CreateVarNode(&scale_desc);
+  auto* scale_tensor =
+      scope->Var(scale->Name())->GetMutable<phi::DenseTensor>();
+  scale_tensor->Resize({n});
+
+  phi::funcs::WeightOnlyQuantize<float>(
+      w_tensor.data<float>(),
+      k,
+      n,
+      trans_w,
+      weight_bits,
+      qweight_tensor->mutable_data<int8_t>(platform::CPUPlace()),
+      scale_tensor->mutable_data<float>(platform::CPUPlace()));
+
+  OpDesc desc(op_desc->Block());
+  desc.SetType("fused_weight_only_fc");
+  desc.SetInput("Input", {x->Name()});
+  desc.SetInput("QWeight", {qweight->Name()});
+  desc.SetInput("Scale", {scale->Name()});
+  if (bias != nullptr) {
+    desc.SetInput("Bias", {bias->Name()});
+  }
+  desc.SetOutput("Out", {out->Name()});
+  desc.SetAttr("in_num_col_dims", in_num_col_dims);
+  desc.SetAttr("activation_type", activation_type);
+  desc.SetAttr("weight_bits", weight_bits);
+  desc.Flush();
+  auto* weight_only_fc = graph->CreateOpNode(&desc);
+
+  IR_NODE_LINK_TO(x, weight_only_fc);
+  IR_NODE_LINK_TO(qweight, weight_only_fc);
+  IR_NODE_LINK_TO(scale, weight_only_fc);
+  if (bias != nullptr) {
+    IR_NODE_LINK_TO(bias, weight_only_fc);
+  }
+  IR_NODE_LINK_TO(weight_only_fc, out);
+
+  const std::string w_name = w->Name();
+  GraphSafeRemoveNodes(graph, {op, w});
+  scope->EraseVars({w_name});
+  return true;
+}
+
+void WeightOnlyQuantPass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init(name_scope_, graph);
+  const int weight_bits = Has("weight_bits") ? Get<int>("weight_bits") : 8;
+  phi::funcs::CheckWeightOnlyBits(weight_bits);
+
+  std::vector<Node*> ops;
+  for (auto* node : graph->Nodes()) {
+    if (node->IsOp() && node->Op() != nullptr &&
+        (node->Op()->Type() == "fc" || node->Op()->Type() == "matmul_v2")) {
+      ops.push_back(node);
+    }
+  }
+  int found_count = 0;
+  for (auto* op : ops) {
+    if (QuantizeOp(graph, op, weight_bits)) {
+      ++found_count;
+    }
+  }
+  AddStatis(found_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(weight_only_quant_pass,
+              paddle::framework::ir::WeightOnlyQuantPass);
+REGISTER_PASS_CAPABILITY(weight_only_quant_pass)
+    .AddCombination(
+        paddle::framework::compatible::OpVersionComparatorCombination()
+            .EQ("fc", 0)
+            .EQ("matmul_v2", 0));
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+class Graph;
+class Node;
+
+/*
+ * Replace fc and matmul_v2 ops whose weight is a 2-D float32 parameter with
+ * fused_weight_only_fc. The weight is quantized per output channel to the
+ * number of bits given by the pass attribute "weight_bits", 8 by default,
+ * and the float32 weight is dropped from the scope.
+ */
+class WeightOnlyQuantPass : public FusePassBase {
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+
+ private:
+  // Quantize the weight of op into the scope and replace op with
+  // fused_weight_only_fc. Returns false if op is left as it is.
+  bool QuantizeOp(ir::Graph* graph, Node* op, int weight_bits) const;
+
+  const std::string name_scope_{"weight_only_quant_pass"};
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
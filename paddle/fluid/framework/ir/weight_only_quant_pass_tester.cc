@@ -0,0 +1,153 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/framework/ir/weight_only_quant_pass.h"
+#include "paddle/phi/kernels/funcs/weight_only_quant.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+static void AddVarToScope(Scope* param_scope,
+                          const std::string& name,
+                          const DDim& dims) {
+  std::mt19937 rng(static_cast<unsigned int>(name.size()));
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  auto* tensor = param_scope->Var(name)->GetMutable<phi::DenseTensor>();
+  tensor->Resize(dims);
+  float* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+// Returns the largest error of the dequantized weight in units of the
+// scale of its output channel.
+static float MaxQuantError(const phi::DenseTensor& weight,
+                           const phi::DenseTensor& qweight,
+                           const phi::DenseTensor& scale,
+                           bool trans_weight,
+                           int bits) {
+  const int64_t k = trans_weight ? weight.dims()[1] : weight.dims()[0];
+  const int64_t n = trans_weight ? weight.dims()[0] : weight.dims()[1];
+  const int64_t row_bytes = phi::funcs::WeightOnlyRowBytes(k, bits);
+  std::vector<float> row(k);
+  float max_error = 0.f;
+  for (int64_t j = 0; j < n; ++j) {
+    phi::funcs::WeightOnlyDecodeRow(
+        qweight.data<int8_t>() + j * row_bytes, k, bits, row.data());
+    const float s = scale.data<float>()[j];
+    for (int64_t i = 0; i < k; ++i) {
+      const float w = trans_weight ? weight.data<float>()[j * k + i]
+                                   : weight.data<float>()[i * n + j];
+      max_error = std::max(max_error, std::abs(row[i] * s - w) / s);
+    }
+  }
+  return max_error;
+}
+
+static void TestWeightOnlyQuantPass(int bits) {
+  // inputs                     operator                 output
+  // ----------------------------------------------------------------
+  // (x, fc_w, fc_bias)         fc                    -> fc_out
+  // (fc_out, matmul_w)         matmul_v2(trans_y)    -> matmul_out
+  // (fc_out, shared_w)         matmul_v2             -> shared_out0
+  // (fc_out, shared_w)         matmul_v2             -> shared_out1
+  Layers layers;
+  auto* x = layers.data("x", {4, 64});
+  auto* fc_w = layers.data("fc_w", {64, 33}, true);
+  auto* fc_bias = layers.data("fc_bias", {33}, true);
+  auto* fc_out = layers.fc(x, fc_w, fc_bias, 1, "relu");
+  fc_out->SetShape({4, 33});
+  auto* matmul_w = layers.data("matmul_w", {16, 33}, true);
+  layers.matmul_v2(fc_out, matmul_w, nullptr, false, true);
+  auto* shared_w = layers.data("shared_w", {33, 8}, true);
+  layers.matmul_v2(fc_out, shared_w);
+  layers.matmul_v2(fc_out, shared_w);
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(layers.main_program()));
+  auto* scope = new Scope();
+  AddVarToScope(scope, "fc_w", {64, 33});
+  AddVarToScope(scope, "fc_bias", {33});
+  AddVarToScope(scope, "matmul_w", {16, 33});
+  AddVarToScope(scope, "shared_w", {33, 8});
+  phi::DenseTensor fc_w_ref, matmul_w_ref;
+  fc_w_ref.ShareDataWith(scope->FindVar("fc_w")->Get<phi::DenseTensor>());
+  matmul_w_ref.ShareDataWith(
+      scope->FindVar("matmul_w")->Get<phi::DenseTensor>());
+  graph->Set("__param_scope__", scope);
+
+  auto pass = PassRegistry::Instance().Get("weight_only_quant_pass");
+  pass->Set("weight_bits", new int(bits));
+  graph.reset(pass->Apply(graph.release()));
+
+  EXPECT_EQ(GetNumOpNodes(graph, "fc"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "matmul_v2"), 2);
+  EXPECT_EQ(GetNumOpNodes(graph, "fused_weight_only_fc"), 2);
+  EXPECT_EQ(scope->FindVar("fc_w"), nullptr);
+  EXPECT_EQ(scope->FindVar("matmul_w"), nullptr);
+  EXPECT_NE(scope->FindVar("shared_w"), nullptr);
+
+  const std::string suffix = "@weight_only_int" + std::to_string(bits);
+  const auto& fc_qweight =
+      scope->FindVar("fc_w" + suffix)->Get<phi::DenseTensor>();
+  const auto& fc_scale =
+      scope->FindVar("fc_w@weight_only_scale")->Get<phi::DenseTensor>();
+  EXPECT_EQ(fc_qweight.dims(),
+            phi::make_ddim({33, phi::funcs::WeightOnlyRowBytes(64, bits)}));
+  EXPECT_LE(MaxQuantError(fc_w_ref, fc_qweight, fc_scale, false, bits),
+            0.5f + 1e-4f);
+
+  const auto& matmul_qweight =
+      scope->FindVar("matmul_w" + suffix)->Get<phi::DenseTensor>();
+  const auto& matmul_scale =
+      scope->FindVar("matmul_w@weight_only_scale")->Get<phi::DenseTensor>();
+  EXPECT_EQ(matmul_qweight.dims(),
+            phi::make_ddim({16, phi::funcs::WeightOnlyRowBytes(33, bits)}));
+  EXPECT_LE(
+      MaxQuantError(matmul_w_ref, matmul_qweight, matmul_scale, true, bits),
+      0.5f + 1e-4f);
+
+  for (auto* node : graph->Nodes()) {
+    if (node->IsOp() && node->Op()->Type() == "fused_weight_only_fc") {
+      auto* op = node->Op();
+      EXPECT_EQ(PADDLE_GET_CONST(int, op->GetAttr("weight_bits")), bits);
+      if (op->Input("QWeight")[0] == "fc_w" + suffix) {
+        EXPECT_EQ(op->Input("Bias")[0], "fc_bias");
+        EXPECT_EQ(PADDLE_GET_CONST(std::string,
+                                   op->GetAttr("activation_type")),
+                  "relu");
+      } else {
+        EXPECT_EQ(op->Inputs().count("Bias"), 0UL);
+        EXPECT_EQ(PADDLE_GET_CONST(int, op->GetAttr("in_num_col_dims")), 1);
+      }
+    }
+  }
+}
+
+TEST(WeightOnlyQuantPass, int8) { TestWeightOnlyQuantPass(8); }
+
+TEST(WeightOnlyQuantPass, int4) { TestWeightOnlyQuantPass(4); }
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(weight_only_quant_pass);
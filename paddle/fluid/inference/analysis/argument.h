@@ -204,6 +204,7 @@ struct Argument {
   DECL_ARGUMENT_FIELD(use_gpu, UseGPU, bool);
   DECL_ARGUMENT_FIELD(use_cutlass, UseCutlass, bool);
   DECL_ARGUMENT_FIELD(use_fc_padding, UseFcPadding, bool);
+  DECL_ARGUMENT_FIELD(weight_only_quant_bits, WeightOnlyQuantBits, int);
   DECL_ARGUMENT_FIELD(gpu_device_id, GPUDeviceId, int);
 
   // Usually use for trt dynamic shape.
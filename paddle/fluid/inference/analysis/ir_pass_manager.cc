@@ -304,6 +304,8 @@ void IRPassManager::CreatePasses(Argument *argument,
       }
       bool use_fc_padding = !fc_mkldnn_pass && argument->use_fc_padding();
       pass->Set("use_fc_padding", new bool(use_fc_padding));
+    } else if (pass_name == "weight_only_quant_pass") {
+      pass->Set("weight_bits", new int(argument->weight_only_quant_bits()));
     }
     pre_pass = pass_name;
 
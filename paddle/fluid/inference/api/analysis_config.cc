@@ -158,6 +158,19 @@ void AnalysisConfig::DisableFCPadding() {
   Update();
 }
 
+void AnalysisConfig::EnableWeightOnlyQuant(int weight_bits) {
+  if (weight_bits != 8 && weight_bits != 4) {
+    LOG(ERROR) << "EnableWeightOnlyQuant() only supports 8 or 4 bits, but "
+                  "received "
+               << weight_bits;
+    weight_only_quant_bits_ = 0;
+  } else {
+    weight_only_quant_bits_ = weight_bits;
+  }
+
+  Update();
+}
+
 void AnalysisConfig::EnableXpu(int l3_workspace_size,
                                bool locked,
                                bool autotune,
@@ -398,6 +411,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(params_file_);
 
   CP_MEMBER(use_fc_padding_);
+  CP_MEMBER(weight_only_quant_bits_);
   // GPU related.
   CP_MEMBER(use_gpu_);
   CP_MEMBER(use_cutlass_);
@@ -963,6 +977,23 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  // The fc and matmul_v2 left by the fuse passes get quantized weights.
+  if (weight_only_quant_bits_ > 0) {
+    if (!enable_ir_optim_) {
+      LOG(ERROR) << "EnableWeightOnlyQuant() only works when IR optimization "
+                    "is enabled.";
+    } else if (use_gpu() || use_xpu() || use_mkldnn_) {
+      LOG(ERROR) << "EnableWeightOnlyQuant() only works on CPU without "
+                    "MKLDNN.";
+    } else {
+      const auto &passes = pass_builder()->AllPasses();
+      if (std::find(passes.begin(), passes.end(), "weight_only_quant_pass") ==
+          passes.end()) {
+        pass_builder()->AppendPass("weight_only_quant_pass");
+      }
+    }
+  }
+
   // TODO(inference): When we enable memory_optimize and mkldnn, PaddleSeg model
   // fail.
   if (enable_memory_optim_) {
@@ -1050,6 +1081,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << use_external_stream_;
   ss << exec_stream_;
   ss << use_fc_padding_;
+  ss << weight_only_quant_bits_;
   ss << gpu_device_id_;
   ss << xpu_device_id_;
   ss << memory_pool_init_size_mb_;
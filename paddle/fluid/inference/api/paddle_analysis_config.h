@@ -239,6 +239,20 @@ struct PD_INFER_DECL AnalysisConfig {
   /// \return bool Whether fc padding is used.
   ///
   bool use_fc_padding() const { return use_fc_padding_; }
+  ///
+  /// \brief Quantize the weights of fc and matmul_v2 per output channel and
+  /// dequantize them on the fly in the CPU kernel. It cuts the weight memory
+  /// traffic of small-batch inference without MKLDNN.
+  ///
+  /// \param weight_bits The number of bits of the quantized weights, 8 or 4.
+  ///
+  void EnableWeightOnlyQuant(int weight_bits = 8);
+  ///
+  /// \brief The number of bits of the weight-only quantization.
+  ///
+  /// \return int The number of bits, or 0 if it is disabled.
+  ///
+  int weight_only_quant_bits() const { return weight_only_quant_bits_; }
 
   // GPU related.
 
@@ -1078,6 +1092,7 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // Padding related
   bool use_fc_padding_{true};
+  int weight_only_quant_bits_{0};
 
   // TensorRT related.
   bool use_tensorrt_{false};
@@ -0,0 +1,323 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/allocation_trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>  // NOLINT
+#include <tuple>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_string(
+    allocation_trace_path,
+    "",
+    "If not empty, every allocation and free of AllocatorFacade is recorded "
+    "to this file, which can be replayed on other allocator strategies by "
+    "the allocation_trace_replay tool.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+constexpr char kAllocationTraceMagic[8] = {
+    'P', 'D', 'A', 'L', 'L', 'O', 'C', 'T'};
+constexpr size_t kBufferedEvents = 1 << 16;
+
+uint32_t CurrentThreadIndex() {
+  static std::atomic<uint32_t> next_index{0};
+  static thread_local uint32_t index = next_index.fetch_add(1);
+  return index;
+}
+
+}  // namespace
+
+std::atomic<bool> AllocationTraceRecorder::recording_{false};
+
+AllocationTraceRecorder& AllocationTraceRecorder::Instance() {
+  // Never destroyed, allocations may be freed during static destruction.
+  static auto* recorder = new AllocationTraceRecorder();
+  return *recorder;
+}
+
+void AllocationTraceRecorder::Start(const std::string& path) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (file_.is_open()) {
+    FlushLocked();
+    file_.close();
+  }
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  PADDLE_ENFORCE_EQ(file_.is_open(),
+                    true,
+                    platform::errors::Unavailable(
+                        "Failed to open allocation trace file %s.", path));
+  uint32_t header[2] = {kAllocationTraceVersion,
+                        static_cast<uint32_t>(sizeof(AllocationTraceEvent))};
+  file_.write(kAllocationTraceMagic, sizeof(kAllocationTraceMagic));
+  file_.write(reinterpret_cast<const char*>(header), sizeof(header));
+  buffer_.reserve(kBufferedEvents);
+  start_ = std::chrono::steady_clock::now();
+  recording_ = true;
+  VLOG(1) << "Record allocation trace to " << path;
+
+  static std::once_flag stop_at_exit;
+  std::call_once(stop_at_exit,
+                 [] { std::atexit([] { Instance().Stop(); }); });
+}
+
+void AllocationTraceRecorder::Stop() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  recording_ = false;
+  if (file_.is_open()) {
+    FlushLocked();
+    file_.close();
+  }
+}
+
+void AllocationTraceRecorder::Record(const phi::Allocation& allocation,
+                                     size_t size,
+                                     bool is_free) {
+  AllocationTraceEvent event;
+  event.ptr = reinterpret_cast<uintptr_t>(allocation.ptr());
+  event.size = size;
+  event.thread_id = CurrentThreadIndex();
+  event.device_id = allocation.place().GetDeviceId();
+  event.place_type = static_cast<uint8_t>(allocation.place().GetType());
+  event.is_free = is_free;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!file_.is_open()) {
+    return;
+  }
+  // Taken under the lock, so that the events are in timestamp order.
+  event.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+  buffer_.push_back(event);
+  if (buffer_.size() >= kBufferedEvents) {
+    FlushLocked();
+  }
+}
+
+void AllocationTraceRecorder::FlushLocked() {
+  file_.write(reinterpret_cast<const char*>(buffer_.data()),
+              buffer_.size() * sizeof(AllocationTraceEvent));
+  file_.flush();
+  buffer_.clear();
+}
+
+std::vector<AllocationTraceEvent> LoadAllocationTrace(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(file.is_open(),
+                    true,
+                    platform::errors::NotFound(
+                        "Failed to open allocation trace file %s.", path));
+  char magic[sizeof(kAllocationTraceMagic)];
+  uint32_t header[2] = {0, 0};
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(header), sizeof(header));
+  PADDLE_ENFORCE_EQ(
+      file.good() &&
+          std::memcmp(magic, kAllocationTraceMagic, sizeof(magic)) == 0,
+      true,
+      platform::errors::InvalidArgument(
+          "%s is not an allocation trace file.", path));
+  PADDLE_ENFORCE_EQ(header[0] == kAllocationTraceVersion &&
+                        header[1] == sizeof(AllocationTraceEvent),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "The allocation trace %s has version %d, but only "
+                        "version %d is supported.",
+                        path,
+                        header[0],
+                        kAllocationTraceVersion));
+
+  std::vector<AllocationTraceEvent> events;
+  AllocationTraceEvent event;
+  while (file.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+    events.push_back(event);
+  }
+  return events;
+}
+
+phi::Allocation* ReservedMemoryCounter::AllocateImpl(size_t size) {
+  auto allocation = underlying_allocator_->Allocate(size);
+  size_t allocated = allocation->size();
+  size_t reserved = reserved_.fetch_add(allocated) + allocated;
+  size_t peak = peak_reserved_.load();
+  while (reserved > peak &&
+         !peak_reserved_.compare_exchange_weak(peak, reserved)) {
+  }
+  return allocation.release();
+}
+
+void ReservedMemoryCounter::FreeImpl(phi::Allocation* allocation) {
+  reserved_.fetch_sub(allocation->size());
+  underlying_allocator_->Free(allocation);
+}
+
+namespace {
+
+struct ReplayOp {
+  size_t slot;
+  size_t size;
+  bool is_free;
+};
+
+struct ReplayTimer {
+  void Add(std::chrono::steady_clock::duration duration) {
+    double us = std::chrono::duration<double, std::micro>(duration).count();
+    total_us += us;
+    max_us = std::max(max_us, us);
+  }
+
+  double total_us{0};
+  double max_us{0};
+};
+
+}  // namespace
+
+AllocationReplayResult ReplayAllocationTrace(
+    const std::vector<AllocationTraceEvent>& events,
+    const std::shared_ptr<Allocator>& allocator,
+    const ReservedMemoryCounter* counter,
+    bool multi_thread) {
+  AllocationReplayResult result;
+
+  // Give every allocation a slot, and turn the trace into the operations
+  // of every thread on the slots.
+  std::vector<const AllocationTraceEvent*> sorted(events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    sorted[i] = &events[i];
+  }
+  std::stable_sort(sorted.begin(),
+                   sorted.end(),
+                   [](const AllocationTraceEvent* a,
+                      const AllocationTraceEvent* b) {
+                     return a->timestamp_ns < b->timestamp_ns;
+                   });
+
+  using Key = std::tuple<uint8_t, int16_t, uint64_t>;
+  std::map<Key, size_t> live_slots;
+  std::vector<ReplayOp> ops;
+  std::map<uint32_t, std::vector<ReplayOp>> thread_ops;
+  std::vector<size_t> slot_sizes;
+  size_t allocated = 0;
+  for (const auto* event : sorted) {
+    Key key(event->place_type, event->device_id, event->ptr);
+    ReplayOp op;
+    if (event->is_free) {
+      auto it = live_slots.find(key);
+      if (it == live_slots.end()) {
+        continue;
+      }
+      op = ReplayOp{it->second, slot_sizes[it->second], true};
+      live_slots.erase(it);
+      allocated -= op.size;
+      ++result.num_frees;
+    } else {
+      // Allocations of 0 bytes never reach the allocators of a place.
+      if (event->size == 0) {
+        continue;
+      }
+      op = ReplayOp{slot_sizes.size(), event->size, false};
+      slot_sizes.push_back(event->size);
+      live_slots[key] = op.slot;
+      allocated += op.size;
+      result.peak_allocated = std::max(result.peak_allocated, allocated);
+      ++result.num_allocs;
+    }
+    ops.push_back(op);
+    thread_ops[event->thread_id].push_back(op);
+  }
+
+  std::vector<AllocationPtr> slots(slot_sizes.size());
+  std::vector<ReplayTimer> timers;
+  auto start = std::chrono::steady_clock::now();
+  if (!multi_thread) {
+    timers.resize(1);
+    for (const auto& op : ops) {
+      auto op_start = std::chrono::steady_clock::now();
+      if (op.is_free) {
+        slots[op.slot].reset();
+      } else {
+        slots[op.slot] = allocator->Allocate(op.size);
+      }
+      timers[0].Add(std::chrono::steady_clock::now() - op_start);
+    }
+  } else {
+    std::unique_ptr<std::atomic<bool>[]> ready(
+        new std::atomic<bool>[slots.size()]);
+    for (size_t i = 0; i < slots.size(); ++i) {
+      ready[i] = false;
+    }
+    timers.resize(thread_ops.size());
+    std::vector<std::thread> threads;
+    size_t thread_index = 0;
+    for (const auto& item : thread_ops) {
+      const auto* ops_of_thread = &item.second;
+      auto* timer = &timers[thread_index++];
+      threads.emplace_back([&, ops_of_thread, timer] {
+        for (const auto& op : *ops_of_thread) {
+          if (op.is_free) {
+            // The slot may be allocated by another thread. That allocation
+            // is earlier in the trace, so waiting for it can not deadlock.
+            while (!ready[op.slot].load(std::memory_order_acquire)) {
+              std::this_thread::yield();
+            }
+            auto op_start = std::chrono::steady_clock::now();
+            slots[op.slot].reset();
+            timer->Add(std::chrono::steady_clock::now() - op_start);
+          } else {
+            auto op_start = std::chrono::steady_clock::now();
+            slots[op.slot] = allocator->Allocate(op.size);
+            timer->Add(std::chrono::steady_clock::now() - op_start);
+            ready[op.slot].store(true, std::memory_order_release);
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  for (const auto& timer : timers) {
+    result.allocator_seconds += timer.total_us / 1e6;
+    result.max_op_us = std::max(result.max_op_us, timer.max_us);
+  }
+  if (counter != nullptr) {
+    result.peak_reserved = counter->PeakReserved();
+    if (result.peak_reserved > 0) {
+      result.fragmentation =
+          1.0 - static_cast<double>(result.peak_allocated) /
+                    static_cast<double>(result.peak_reserved);
+    }
+  }
+  slots.clear();
+  return result;
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,162 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+/*
+ * One allocation or free seen by the allocators of AllocatorFacade. The
+ * events are written to the trace file as they are, so the layout is part
+ * of the file format (see kAllocationTraceVersion).
+ *
+ * A free is matched to its allocation by place and ptr, which can not be
+ * reused while the allocation is alive; the lifetime of an allocation is the
+ * difference of the two timestamps.
+ */
+struct AllocationTraceEvent {
+  uint64_t timestamp_ns;  // since the recording started
+  uint64_t ptr;
+  uint64_t size;  // requested size for allocations, allocated size for frees
+  uint32_t thread_id;  // small sequential id of the calling thread
+  int16_t device_id;
+  uint8_t place_type;  // phi::AllocationType
+  uint8_t is_free;
+};
+
+static_assert(sizeof(AllocationTraceEvent) == 32,
+              "AllocationTraceEvent is written to file as is.");
+
+constexpr uint32_t kAllocationTraceVersion = 1;
+
+/*
+ * Records the allocations of StatAllocator to a binary trace file. It is
+ * started by FLAGS_allocation_trace_path when AllocatorFacade is created, or
+ * explicitly by Start. Events are buffered and written in batches, so the
+ * overhead is one lock and one copy per allocation while recording, and a
+ * relaxed atomic load otherwise.
+ */
+class AllocationTraceRecorder {
+ public:
+  static AllocationTraceRecorder& Instance();
+
+  static bool IsRecording() {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  // Truncate path and record to it until Stop is called.
+  void Start(const std::string& path);
+  // Flush the buffered events and close the trace file.
+  void Stop();
+
+  void Record(const phi::Allocation& allocation, size_t size, bool is_free);
+
+ private:
+  AllocationTraceRecorder() = default;
+
+  void FlushLocked();
+
+  static std::atomic<bool> recording_;
+
+  std::mutex mutex_;
+  std::ofstream file_;
+  std::vector<AllocationTraceEvent> buffer_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Read all events of a trace written by AllocationTraceRecorder.
+std::vector<AllocationTraceEvent> LoadAllocationTrace(const std::string& path);
+
+/*
+ * Forwards to an underlying allocator and counts the bytes it holds, to
+ * measure how much memory an allocator under replay reserves.
+ */
+class ReservedMemoryCounter : public Allocator {
+ public:
+  explicit ReservedMemoryCounter(
+      std::shared_ptr<Allocator> underlying_allocator)
+      : underlying_allocator_(std::move(underlying_allocator)) {}
+
+  bool IsAllocThreadSafe() const override {
+    return underlying_allocator_->IsAllocThreadSafe();
+  }
+
+  size_t Reserved() const { return reserved_.load(); }
+  size_t PeakReserved() const { return peak_reserved_.load(); }
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+  uint64_t ReleaseImpl(const platform::Place& place) override {
+    return underlying_allocator_->Release(place);
+  }
+
+ private:
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::atomic<size_t> reserved_{0};
+  std::atomic<size_t> peak_reserved_{0};
+};
+
+struct AllocationReplayResult {
+  size_t num_allocs{0};
+  size_t num_frees{0};
+  double seconds{0};  // wall time of the replay
+  // Time spent inside Allocate and Free, summed over the replay threads.
+  // With several threads, its growth over a single thread replay is the
+  // time spent waiting for the locks of the allocator.
+  double allocator_seconds{0};
+  double max_op_us{0};
+  size_t peak_allocated{0};  // peak of the bytes requested by live allocations
+  size_t peak_reserved{0};   // peak of the bytes held by the allocator
+  // 1 - peak_allocated / peak_reserved
+  double fragmentation{0};
+
+  double OpsPerSecond() const {
+    return seconds > 0 ? (num_allocs + num_frees) / seconds : 0;
+  }
+};
+
+/*
+ * Drive allocator with the events of a trace, ignoring their place. If
+ * multi_thread is true, the events of every recorded thread are replayed
+ * by a thread of their own, and a free of an allocation made by another
+ * thread waits for it. Otherwise the events are replayed in timestamp
+ * order by the calling thread. counter, if not null, is the underlying
+ * allocator of allocator and gives the peak reserved bytes.
+ *
+ * Frees of allocations made before the recording started are skipped, and
+ * allocations alive at the end of the trace are freed after it.
+ */
+AllocationReplayResult ReplayAllocationTrace(
+    const std::vector<AllocationTraceEvent>& events,
+    const std::shared_ptr<Allocator>& allocator,
+    const ReservedMemoryCounter* counter,
+    bool multi_thread);
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
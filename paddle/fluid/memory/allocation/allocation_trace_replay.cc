@@ -0,0 +1,161 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replay an allocation trace recorded with FLAGS_allocation_trace_path on
+// a host allocator, e.g.
+//
+//   allocation_trace_replay --trace=train.trace --place=cpu
+//       --strategy=size_class --chunk_size_mb=32 --multi_thread
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/allocation_trace.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/memory/allocation/size_class_allocator.h"
+#include "paddle/fluid/platform/enforce.h"
+
+DEFINE_string(trace, "", "The trace recorded by FLAGS_allocation_trace_path.");
+DEFINE_string(strategy,
+              "auto_growth",
+              "The allocator to replay the trace on: auto_growth, size_class "
+              "or system, which allocates every block by CPUAllocator.");
+DEFINE_string(place,
+              "",
+              "Replay only the events of this place: cpu, gpu or gpu_pinned. "
+              "All events are replayed if empty.");
+DEFINE_int32(device_id, -1, "Replay only the events of this device if >= 0.");
+DEFINE_uint64(chunk_size_mb,
+              0,
+              "The chunk size of auto_growth and size_class in MB. Blocks "
+              "are allocated with their own size by auto_growth if 0.");
+DEFINE_uint64(alignment,
+              64,
+              "The alignment of auto_growth and size_class. Set it to 256 "
+              "to model the GPU auto_growth allocator.");
+DEFINE_bool(multi_thread,
+            false,
+            "Also replay every recorded thread by a thread of its own, and "
+            "report the time spent waiting for the allocator.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static std::vector<AllocationTraceEvent> FilterEvents(
+    const std::vector<AllocationTraceEvent>& events) {
+  int place_type = -1;
+  if (FLAGS_place == "cpu") {
+    place_type = static_cast<int>(phi::AllocationType::CPU);
+  } else if (FLAGS_place == "gpu") {
+    place_type = static_cast<int>(phi::AllocationType::GPU);
+  } else if (FLAGS_place == "gpu_pinned") {
+    place_type = static_cast<int>(phi::AllocationType::GPUPINNED);
+  } else {
+    PADDLE_ENFORCE_EQ(FLAGS_place.empty(),
+                      true,
+                      platform::errors::InvalidArgument(
+                          "Unsupported place %s, candidates are cpu, gpu or "
+                          "gpu_pinned.",
+                          FLAGS_place));
+  }
+  std::vector<AllocationTraceEvent> filtered;
+  for (const auto& event : events) {
+    if ((place_type < 0 || event.place_type == place_type) &&
+        (FLAGS_device_id < 0 || event.device_id == FLAGS_device_id)) {
+      filtered.push_back(event);
+    }
+  }
+  return filtered;
+}
+
+static std::shared_ptr<Allocator> CreateAllocator(
+    const std::shared_ptr<Allocator>& underlying_allocator) {
+  size_t chunk_size = FLAGS_chunk_size_mb << 20;
+  if (FLAGS_strategy == "auto_growth") {
+    return std::make_shared<AutoGrowthBestFitAllocator>(
+        underlying_allocator, FLAGS_alignment, chunk_size);
+  }
+  if (FLAGS_strategy == "size_class") {
+    return std::make_shared<SizeClassAllocator>(
+        underlying_allocator, FLAGS_alignment, chunk_size);
+  }
+  PADDLE_ENFORCE_EQ(FLAGS_strategy,
+                    "system",
+                    platform::errors::InvalidArgument(
+                        "Unsupported strategy %s, candidates are auto_growth, "
+                        "size_class or system.",
+                        FLAGS_strategy));
+  return underlying_allocator;
+}
+
+static AllocationReplayResult Replay(
+    const std::vector<AllocationTraceEvent>& events, bool multi_thread) {
+  auto counter =
+      std::make_shared<ReservedMemoryCounter>(std::make_shared<CPUAllocator>());
+  auto allocator = CreateAllocator(counter);
+  return ReplayAllocationTrace(events, allocator, counter.get(), multi_thread);
+}
+
+static void Print(const std::string& name,
+                  const AllocationReplayResult& result) {
+  std::cout << name << ": " << result.num_allocs << " allocs, "
+            << result.num_frees << " frees in " << result.seconds * 1e3
+            << " ms, " << result.OpsPerSecond() / 1e6 << " M ops/s"
+            << "\n  allocator time: " << result.allocator_seconds * 1e3
+            << " ms, slowest op: " << result.max_op_us << " us"
+            << "\n  peak allocated: " << (result.peak_allocated >> 20)
+            << " MB, peak reserved: " << (result.peak_reserved >> 20)
+            << " MB, fragmentation: " << result.fragmentation * 100 << "%"
+            << std::endl;
+}
+
+static void Run() {
+  PADDLE_ENFORCE_EQ(
+      FLAGS_trace.empty(),
+      false,
+      platform::errors::InvalidArgument("Please set the trace by --trace."));
+  auto events = FilterEvents(LoadAllocationTrace(FLAGS_trace));
+  std::cout << "Replay " << events.size() << " events of " << FLAGS_trace
+            << " on " << FLAGS_strategy << std::endl;
+
+  auto single = Replay(events, false);
+  Print("single thread", single);
+  if (FLAGS_multi_thread) {
+    auto multi = Replay(events, true);
+    Print("multi thread", multi);
+    std::cout << "  lock wait: "
+              << std::max(0.0,
+                          multi.allocator_seconds - single.allocator_seconds) *
+                     1e3
+              << " ms" << std::endl;
+  }
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::memory::allocation::Run();
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/allocation_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/stat_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+class MallocAllocator : public Allocator {
+ public:
+  bool IsAllocThreadSafe() const override { return true; }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    return new Allocation(malloc(size), size, platform::CPUPlace());
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    free(allocation->ptr());
+    delete allocation;
+  }
+};
+
+// Each thread allocates 100 blocks of 1KB to 100KB, and frees them after
+// the next one is allocated except for the last one.
+static void RunWorkload(const std::shared_ptr<Allocator> &allocator) {
+  AllocationPtr last;
+  for (size_t i = 1; i <= 100; ++i) {
+    auto allocation = allocator->Allocate(i << 10);
+    last = std::move(allocation);
+  }
+  // Freed by another thread.
+  std::thread([&last] { last.reset(); }).join();
+}
+
+TEST(AllocationTrace, record_and_replay) {
+  std::string path = "allocation_trace_test.trace";
+  auto allocator =
+      std::make_shared<StatAllocator>(std::make_shared<MallocAllocator>());
+
+  AllocationTraceRecorder::Instance().Start(path);
+  ASSERT_TRUE(AllocationTraceRecorder::IsRecording());
+  std::thread t0(RunWorkload, allocator);
+  std::thread t1(RunWorkload, allocator);
+  t0.join();
+  t1.join();
+  AllocationTraceRecorder::Instance().Stop();
+  ASSERT_FALSE(AllocationTraceRecorder::IsRecording());
+  // Not recorded.
+  allocator->Allocate(1 << 10);
+
+  auto events = LoadAllocationTrace(path);
+  ASSERT_EQ(events.size(), 400UL);
+  std::set<uint32_t> threads;
+  size_t num_frees = 0;
+  for (size_t i = 0; i < events.size(); ++i) {
+    if (i > 0) {
+      ASSERT_GE(events[i].timestamp_ns, events[i - 1].timestamp_ns);
+    }
+    ASSERT_EQ(events[i].place_type,
+              static_cast<uint8_t>(phi::AllocationType::CPU));
+    threads.insert(events[i].thread_id);
+    num_frees += events[i].is_free;
+  }
+  ASSERT_EQ(threads.size(), 4UL);
+  ASSERT_EQ(num_frees, 200UL);
+
+  for (bool multi_thread : {false, true}) {
+    auto counter = std::make_shared<ReservedMemoryCounter>(
+        std::make_shared<MallocAllocator>());
+    auto replay_allocator =
+        std::make_shared<AutoGrowthBestFitAllocator>(counter, 64);
+    auto result = ReplayAllocationTrace(
+        events, replay_allocator, counter.get(), multi_thread);
+    EXPECT_EQ(result.num_allocs, 200UL);
+    EXPECT_EQ(result.num_frees, 200UL);
+    // At most two blocks of each thread are alive.
+    EXPECT_LE(result.peak_allocated, 4 * (100UL << 10));
+    EXPECT_GE(result.peak_allocated, 199UL << 10);
+    EXPECT_GE(result.peak_reserved, result.peak_allocated);
+    EXPECT_GE(result.fragmentation, 0.0);
+    EXPECT_GT(result.OpsPerSecond(), 0.0);
+    replay_allocator->Release(platform::CPUPlace());
+    EXPECT_EQ(counter->Reserved(), 0UL);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(AllocationTrace, skip_frees_before_recording) {
+  std::string path = "allocation_trace_skip_test.trace";
+  auto allocator =
+      std::make_shared<StatAllocator>(std::make_shared<MallocAllocator>());
+  auto early = allocator->Allocate(256);
+  AllocationTraceRecorder::Instance().Start(path);
+  early.reset();
+  auto late = allocator->Allocate(512);
+  AllocationTraceRecorder::Instance().Stop();
+
+  auto events = LoadAllocationTrace(path);
+  ASSERT_EQ(events.size(), 2UL);
+  auto counter = std::make_shared<ReservedMemoryCounter>(
+      std::make_shared<MallocAllocator>());
+  auto result = ReplayAllocationTrace(events, counter, counter.get(), false);
+  // The free of early is skipped, and late is freed after the replay.
+  EXPECT_EQ(result.num_allocs, 1UL);
+  EXPECT_EQ(result.num_frees, 0UL);
+  EXPECT_EQ(result.peak_allocated, 512UL);
+  EXPECT_EQ(result.peak_reserved, 512UL);
+  EXPECT_EQ(counter->Reserved(), 0UL);
+  std::remove(path.c_str());
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -97,6 +97,10 @@ class Allocation : public phi::Allocation {
 
   void* base_ptr() const { return base_ptr_; }
 
+  // The MemoryStatScope the allocation is counted in, set by StatAllocator.
+  int stat_scope_id() const { return stat_scope_id_; }
+  void set_stat_scope_id(int id) { stat_scope_id_ = id; }
+
  private:
   inline void RegisterDecoratedAllocator(Allocator* allocator) {
     decorated_allocators_.emplace_back(allocator);
@@ -110,6 +114,7 @@ class Allocation : public phi::Allocation {
 
  private:
   void* base_ptr_;  // the point that directly requested from system
+  int stat_scope_id_{0};
 
   /**
    * NOTE(zjl): Since decorated_allocators_ is usually a small vector.
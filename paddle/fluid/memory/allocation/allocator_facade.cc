@@ -16,12 +16,15 @@
 
 #include "gflags/gflags.h"
 #include "paddle/fluid/memory/allocation/aligned_allocator.h"
+#include "paddle/fluid/memory/allocation/allocation_trace.h"
 #include "paddle/fluid/memory/allocation/allocator.h"
 #include "paddle/fluid/memory/allocation/allocator_strategy.h"
 #include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/memory/allocation/huge_page_cpu_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
+#include "paddle/fluid/memory/allocation/size_class_allocator.h"
 #include "paddle/fluid/memory/allocation/stat_allocator.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -101,6 +104,9 @@ PADDLE_DEFINE_EXPORTED_bool(use_cuda_managed_memory,
                             "strategy");
 
 DECLARE_string(allocator_strategy);
+DECLARE_string(allocation_trace_path);
+DECLARE_string(cpu_huge_page);
+DECLARE_string(cpu_numa_node);
 
 namespace paddle {
 namespace memory {
@@ -164,6 +170,34 @@ static bool IsCUDAGraphCapturing() {
 #endif
 }
 
+// The size_class strategy, and the auto_growth strategy with huge pages,
+// pool host memory in chunks, with blocks aligned to the cache line so that
+// vectorized kernels never split a load.
+static constexpr size_t kSizeClassAlignment = 64;
+static constexpr size_t kSizeClassChunkSize = 32 << 20;
+
+// FLAGS_cpu_huge_page or FLAGS_cpu_numa_node is set, so the host chunks are
+// mapped by HugePageCPUAllocator.
+static bool UseHugePageCPUAllocator() {
+  return !FLAGS_cpu_huge_page.empty() || !FLAGS_cpu_numa_node.empty();
+}
+
+static std::shared_ptr<Allocator> CreateCPUChunkAllocator() {
+  if (!UseHugePageCPUAllocator()) {
+    return std::make_shared<CPUAllocator>();
+  }
+  int numa_node = kNoNumaNode;
+  if (FLAGS_cpu_numa_node == "local") {
+    numa_node = kNumaNodeOfCurrentThread;
+  } else if (!FLAGS_cpu_numa_node.empty()) {
+    numa_node = std::stoi(FLAGS_cpu_numa_node);
+  }
+  VLOG(1) << "Map host chunks with huge page mode \"" << FLAGS_cpu_huge_page
+          << "\" on NUMA node \"" << FLAGS_cpu_numa_node << "\"";
+  return std::make_shared<HugePageCPUAllocator>(
+      HugePageModeFromString(FLAGS_cpu_huge_page), numa_node);
+}
+
 class AllocatorFacadePrivate {
  public:
   using AllocatorMap = std::map<platform::Place, std::shared_ptr<Allocator>>;
@@ -222,8 +256,16 @@ class AllocatorFacadePrivate {
         break;
       }
 
-      case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+      case AllocatorStrategy::kAutoGrowth:
+      case AllocatorStrategy::kSizeClass: {
+        if (strategy_ == AllocatorStrategy::kSizeClass) {
+          InitSizeClassCPUAllocator();
+        } else if (UseHugePageCPUAllocator()) {
+          // Mapping every tensor by pages is too costly, pool them in chunks.
+          InitAutoGrowthCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
         allow_free_idle_chunk_ = allow_free_idle_chunk;
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
@@ -251,7 +293,11 @@ class AllocatorFacadePrivate {
           is_stream_safe_cuda_allocator_used_ = true;
         }
 
-        InitNaiveBestFitCUDAPinnedAllocator();
+        if (strategy_ == AllocatorStrategy::kSizeClass) {
+          InitSizeClassCUDAPinnedAllocator();
+        } else {
+          InitNaiveBestFitCUDAPinnedAllocator();
+        }
 #endif
 #ifdef PADDLE_WITH_ASCEND_CL
         for (int dev_id = 0; dev_id < platform::GetNPUDeviceCount(); ++dev_id) {
@@ -327,6 +373,10 @@ class AllocatorFacadePrivate {
     }
 
     WrapStatAllocator();
+    if (!FLAGS_allocation_trace_path.empty() &&
+        !AllocationTraceRecorder::IsRecording()) {
+      AllocationTraceRecorder::Instance().Start(FLAGS_allocation_trace_path);
+    }
 
     CheckAllocThreadSafe();
 
@@ -498,12 +548,33 @@ class AllocatorFacadePrivate {
     allocators_[platform::CPUPlace()] = std::make_shared<CPUAllocator>();
   }
 
+  void InitSizeClassCPUAllocator() {
+    allocators_[platform::CPUPlace()] = std::make_shared<SizeClassAllocator>(
+        CreateCPUChunkAllocator(), kSizeClassAlignment, kSizeClassChunkSize);
+  }
+
+  void InitAutoGrowthCPUAllocator() {
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<AutoGrowthBestFitAllocator>(
+            CreateCPUChunkAllocator(),
+            kSizeClassAlignment,
+            kSizeClassChunkSize);
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
         std::make_shared<NaiveBestFitAllocator>(platform::CUDAPinnedPlace());
   }
 
+  void InitSizeClassCUDAPinnedAllocator() {
+    allocators_[platform::CUDAPinnedPlace()] =
+        std::make_shared<SizeClassAllocator>(
+            std::make_shared<CPUPinnedAllocator>(),
+            kSizeClassAlignment,
+            kSizeClassChunkSize);
+  }
+
   void InitNaiveBestFitCUDAAllocator(platform::CUDAPlace p) {
     allocators_[p] = std::make_shared<NaiveBestFitAllocator>(p);
   }
@@ -512,8 +583,8 @@ class AllocatorFacadePrivate {
   std::shared_ptr<Allocator> CreateCUDAAllocator(platform::CUDAPlace p) {
     if (FLAGS_use_cuda_managed_memory) {
       PADDLE_ENFORCE_EQ(
-          strategy_,
-          AllocatorStrategy::kAutoGrowth,
+          IsAutoGrowthStrategy(strategy_),
+          true,
           platform::errors::InvalidArgument(
               "CUDA managed memory is only implemented for auto_growth "
               "strategy, not support %s strategy.\n"
@@ -539,8 +610,8 @@ class AllocatorFacadePrivate {
 
   void InitStreamSafeCUDAAllocator(platform::CUDAPlace p, gpuStream_t stream) {
     PADDLE_ENFORCE_EQ(
-        strategy_,
-        AllocatorStrategy::kAutoGrowth,
+        IsAutoGrowthStrategy(strategy_),
+        true,
         platform::errors::Unimplemented(
             "Only support auto-growth strategey for StreamSafeCUDAAllocator, "
             "the allocator strategy %d is unsupported for multi-stream",
@@ -1030,8 +1101,8 @@ const std::shared_ptr<Allocator>& AllocatorFacade::GetAllocator(
 
 void* AllocatorFacade::GetBasePtr(
     const std::shared_ptr<phi::Allocation>& allocation) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(IsAutoGrowthStrategy(GetAllocatorStrategy()),
+                    true,
                     paddle::platform::errors::Unimplemented(
                         "GetBasePtr() is only implemented for auto_growth "
                         "strategy, not support allocator strategy: %d",
@@ -1160,8 +1231,8 @@ void AllocatorFacade::SetDefaultStream(const platform::CUDAPlace& place,
 
 #ifdef PADDLE_WITH_CUDA
 void AllocatorFacade::PrepareMemoryPoolForCUDAGraph(int64_t id) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(IsAutoGrowthStrategy(GetAllocatorStrategy()),
+                    true,
                     platform::errors::InvalidArgument(
                         "CUDA Graph is only supported when the "
                         "FLAGS_allocator_strategy=\"auto_growth\", but got "
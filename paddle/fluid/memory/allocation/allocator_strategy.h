@@ -18,10 +18,22 @@ namespace paddle {
 namespace memory {
 namespace allocation {
 
-enum class AllocatorStrategy { kNaiveBestFit, kAutoGrowth, kThreadLocal };
+enum class AllocatorStrategy {
+  kNaiveBestFit,
+  kAutoGrowth,
+  kThreadLocal,
+  kSizeClass
+};
 
 extern AllocatorStrategy GetAllocatorStrategy();
 
+// Whether device memory is managed by AutoGrowthBestFitAllocator. The
+// size_class strategy differs from auto_growth only on CPU and pinned memory.
+inline bool IsAutoGrowthStrategy(AllocatorStrategy strategy) {
+  return strategy == AllocatorStrategy::kAutoGrowth ||
+         strategy == AllocatorStrategy::kSizeClass;
+}
+
 // Do nothing, just make sure linker do not prune this file.
 extern void UseAllocatorStrategyGFlag();
 
@@ -0,0 +1,227 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/huge_page_cpu_allocator.h"
+
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_string(
+    cpu_huge_page,
+    "",
+    "Back the chunks of the auto_growth and size_class CPU allocators with "
+    "2MB huge pages: transparent (madvise) or explicit (MAP_HUGETLB, which "
+    "needs pages reserved by /proc/sys/vm/nr_hugepages). Disabled if empty.");
+PADDLE_DEFINE_EXPORTED_string(
+    cpu_numa_node,
+    "",
+    "Bind the chunks of the auto_growth and size_class CPU allocators to a "
+    "NUMA node: local for the node of the allocating thread, or the id of "
+    "a node. Not bound if empty.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+constexpr int kMaxNumaNodes = 64;
+constexpr int kMpolPreferred = 1;  // MPOL_PREFERRED of numaif.h
+
+std::atomic<int64_t> numa_node_usage[kMaxNumaNodes];
+
+class HugePageAllocation : public Allocation {
+ public:
+  HugePageAllocation(void* ptr, size_t size, size_t mapped_size, int node)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        mapped_size_(mapped_size),
+        node_(node) {}
+
+  size_t mapped_size() const { return mapped_size_; }
+  int node() const { return node_; }
+
+ private:
+  size_t mapped_size_;
+  int node_;
+};
+
+void UpdateNumaNodeUsage(int node, int64_t increment) {
+  if (node >= 0 && node < kMaxNumaNodes) {
+    numa_node_usage[node].fetch_add(increment, std::memory_order_relaxed);
+  }
+}
+
+#ifdef __linux__
+// Map size bytes aligned to alignment, by mapping more and trimming.
+void* MapAligned(size_t size, size_t alignment, int flags) {
+  size_t mapped_size = size + alignment;
+  void* p = mmap(nullptr,
+                 mapped_size,
+                 PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | flags,
+                 -1,
+                 0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+  uintptr_t aligned = (begin + alignment - 1) & ~(alignment - 1);
+  if (aligned > begin) {
+    munmap(p, aligned - begin);
+  }
+  size_t tail = begin + mapped_size - (aligned + size);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(aligned + size), tail);
+  }
+  return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+}  // namespace
+
+HugePageMode HugePageModeFromString(const std::string& mode) {
+  if (mode.empty()) {
+    return HugePageMode::kNone;
+  } else if (mode == "transparent") {
+    return HugePageMode::kTransparent;
+  } else if (mode == "explicit") {
+    return HugePageMode::kExplicit;
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "Unsupported huge page mode %s, candidates are transparent or explicit.",
+      mode));
+}
+
+HugePageCPUAllocator::HugePageCPUAllocator(HugePageMode mode, int numa_node)
+    : mode_(mode), numa_node_(numa_node) {
+  PADDLE_ENFORCE_LT(numa_node,
+                    phi::backends::cpu::CpuNumaNodeCount(),
+                    platform::errors::InvalidArgument(
+                        "The NUMA node %d does not exist, there are %d nodes.",
+                        numa_node,
+                        phi::backends::cpu::CpuNumaNodeCount()));
+}
+
+std::vector<int64_t> HugePageCPUAllocator::NumaNodeUsage() {
+  int num_nodes =
+      std::min(phi::backends::cpu::CpuNumaNodeCount(), kMaxNumaNodes);
+  std::vector<int64_t> usage(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    usage[i] = numa_node_usage[i].load(std::memory_order_relaxed);
+  }
+  return usage;
+}
+
+phi::Allocation* HugePageCPUAllocator::AllocateImpl(size_t size) {
+  int node = numa_node_ >= 0
+                 ? numa_node_
+                 : phi::backends::cpu::CpuNumaNodeOfCurrentThread();
+#ifdef __linux__
+  size_t page_size = mode_ == HugePageMode::kNone
+                         ? static_cast<size_t>(sysconf(_SC_PAGESIZE))
+                         : kHugePageSize;
+  size_t mapped_size = AlignedSize(std::max<size_t>(size, 1), page_size);
+  void* p = nullptr;
+  if (mode_ == HugePageMode::kExplicit) {
+    p = mmap(nullptr,
+             mapped_size,
+             PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+             -1,
+             0);
+    if (p == MAP_FAILED) {
+      p = nullptr;
+      LOG_FIRST_N(WARNING, 1)
+          << "Failed to map explicit huge pages, fall back to transparent "
+             "huge pages. Please reserve the pages by "
+             "/proc/sys/vm/nr_hugepages.";
+    }
+  }
+  if (p == nullptr) {
+    // Transparent huge pages are only used for 2MB aligned ranges.
+    p = MapAligned(mapped_size, page_size, 0);
+    PADDLE_ENFORCE_NOT_NULL(
+        p,
+        platform::errors::ResourceExhausted(
+            "Fail to map memory of %ld size, error code is %d.", size, errno));
+    if (mode_ != HugePageMode::kNone) {
+      madvise(p, mapped_size, MADV_HUGEPAGE);
+    }
+  }
+  if (numa_node_ != kNoNumaNode && node < kMaxNumaNodes &&
+      phi::backends::cpu::CpuNumaNodeCount() > 1) {
+    // Set before the pages are touched, so they are allocated on the node.
+    uint64_t node_mask = 1ULL << node;
+    if (syscall(SYS_mbind,
+                p,
+                mapped_size,
+                kMpolPreferred,
+                &node_mask,
+                sizeof(node_mask) * 8 + 1,
+                0) != 0) {
+      LOG_FIRST_N(WARNING, 1) << "Failed to bind memory to NUMA node " << node
+                              << ", error code is " << errno << ".";
+    }
+  }
+#elif defined(_WIN32)
+  size_t mapped_size = size;
+  void* p = _aligned_malloc(size, kHugePageSize);
+  PADDLE_ENFORCE_NOT_NULL(p,
+                          platform::errors::ResourceExhausted(
+                              "Fail to alloc memory of %ld size.", size));
+#else
+  size_t mapped_size = size;
+  void* p = nullptr;
+  int error = posix_memalign(&p, kHugePageSize, size);
+  PADDLE_ENFORCE_EQ(
+      error,
+      0,
+      platform::errors::ResourceExhausted(
+          "Fail to alloc memory of %ld size, error code is %d.", size, error));
+#endif
+  UpdateNumaNodeUsage(node, mapped_size);
+  return new HugePageAllocation(p, size, mapped_size, node);
+}
+
+void HugePageCPUAllocator::FreeImpl(phi::Allocation* allocation) {
+  auto* huge_page_allocation = static_cast<HugePageAllocation*>(allocation);
+  size_t mapped_size = huge_page_allocation->mapped_size();
+  UpdateNumaNodeUsage(huge_page_allocation->node(),
+                      -static_cast<int64_t>(mapped_size));
+#ifdef __linux__
+  munmap(allocation->ptr(), mapped_size);
+#elif defined(_WIN32)
+  _aligned_free(allocation->ptr());
+#else
+  free(allocation->ptr());
+#endif
+  delete allocation;
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,76 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+enum class HugePageMode {
+  kNone,         // 4KB pages
+  kTransparent,  // madvise(MADV_HUGEPAGE)
+  kExplicit,     // MAP_HUGETLB, falls back to kTransparent if unavailable
+};
+
+// Parse FLAGS_cpu_huge_page: "", "transparent" or "explicit".
+HugePageMode HugePageModeFromString(const std::string& mode);
+
+// The numa_node of HugePageCPUAllocator to use the node of the thread
+// calling Allocate.
+constexpr int kNumaNodeOfCurrentThread = -1;
+// The numa_node of HugePageCPUAllocator to not bind the memory.
+constexpr int kNoNumaNode = -2;
+
+/*
+ * A system allocator of host memory that maps every allocation by mmap, and
+ * can back it with 2MB huge pages and bind it to a NUMA node (the
+ * MPOL_PREFERRED policy of mbind, so that the allocation still succeeds when
+ * the node is full). The sizes are rounded up to whole pages, so it is meant
+ * to be the underlying allocator of the chunks of AutoGrowthBestFitAllocator
+ * or SizeClassAllocator.
+ *
+ * On platforms other than Linux, it falls back to posix_memalign.
+ */
+class HugePageCPUAllocator : public Allocator {
+ public:
+  static constexpr size_t kHugePageSize = 2UL << 20;
+
+  HugePageCPUAllocator(HugePageMode mode, int numa_node);
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // The bytes mapped by all HugePageCPUAllocators on every NUMA node.
+  // Memory that is not bound is counted on the node of the allocating
+  // thread.
+  static std::vector<int64_t> NumaNodeUsage();
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+
+ private:
+  HugePageMode mode_;
+  int numa_node_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
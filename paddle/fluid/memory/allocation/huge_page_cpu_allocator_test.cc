@@ -0,0 +1,89 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/huge_page_cpu_allocator.h"
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static int64_t TotalNumaNodeUsage() {
+  auto usage = HugePageCPUAllocator::NumaNodeUsage();
+  return std::accumulate(usage.begin(), usage.end(), int64_t(0));
+}
+
+TEST(HugePageCPUAllocator, allocate_and_free) {
+  ASSERT_GE(phi::backends::cpu::CpuNumaNodeCount(), 1);
+  for (auto mode : {HugePageMode::kNone,
+                    HugePageMode::kTransparent,
+                    HugePageMode::kExplicit}) {
+    for (int numa_node : {kNoNumaNode, kNumaNodeOfCurrentThread, 0}) {
+      auto allocator = std::make_shared<HugePageCPUAllocator>(mode, numa_node);
+      int64_t usage = TotalNumaNodeUsage();
+      {
+        auto small = allocator->Allocate(100);
+        auto large = allocator->Allocate(5 << 20);
+        ASSERT_EQ(small->size(), 100UL);
+        ASSERT_EQ(large->size(), 5UL << 20);
+        memset(small->ptr(), 1, small->size());
+        memset(large->ptr(), 2, large->size());
+        if (mode != HugePageMode::kNone) {
+          EXPECT_EQ(reinterpret_cast<uintptr_t>(large->ptr()) %
+                        HugePageCPUAllocator::kHugePageSize,
+                    0UL);
+        }
+        EXPECT_GE(TotalNumaNodeUsage() - usage, (5 << 20) + 100);
+      }
+      EXPECT_EQ(TotalNumaNodeUsage(), usage);
+    }
+  }
+}
+
+TEST(HugePageCPUAllocator, chunks_of_auto_growth) {
+  auto huge_page_allocator = std::make_shared<HugePageCPUAllocator>(
+      HugePageMode::kTransparent, kNumaNodeOfCurrentThread);
+  auto allocator = std::make_shared<AutoGrowthBestFitAllocator>(
+      huge_page_allocator, 64, 4 * HugePageCPUAllocator::kHugePageSize);
+  int64_t usage = TotalNumaNodeUsage();
+  std::vector<AllocationPtr> allocations;
+  for (size_t i = 1; i <= 64; ++i) {
+    allocations.emplace_back(allocator->Allocate(i << 10));
+    memset(allocations.back()->ptr(), 0, i << 10);
+  }
+  // All blocks fit in one chunk.
+  EXPECT_EQ(TotalNumaNodeUsage() - usage,
+            static_cast<int64_t>(4 * HugePageCPUAllocator::kHugePageSize));
+  allocations.clear();
+  allocator->Release(platform::CPUPlace());
+  EXPECT_EQ(TotalNumaNodeUsage(), usage);
+}
+
+TEST(HugePageCPUAllocator, huge_page_mode_from_string) {
+  EXPECT_EQ(HugePageModeFromString(""), HugePageMode::kNone);
+  EXPECT_EQ(HugePageModeFromString("transparent"), HugePageMode::kTransparent);
+  EXPECT_EQ(HugePageModeFromString("explicit"), HugePageMode::kExplicit);
+  EXPECT_ANY_THROW(HugePageModeFromString("1GB"));
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
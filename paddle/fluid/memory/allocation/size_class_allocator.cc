@@ -0,0 +1,495 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/size_class_allocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+constexpr size_t kBlocksPerSlab = 256;
+
+inline int FindLastSet(uint64_t x) {
+#if defined(_MSC_VER)
+  unsigned long index;  // NOLINT
+  _BitScanReverse64(&index, x);
+  return static_cast<int>(index);
+#else
+  return 63 - __builtin_clzll(x);
+#endif
+}
+
+inline int FindFirstSet(uint64_t x) {
+#if defined(_MSC_VER)
+  unsigned long index;  // NOLINT
+  _BitScanForward64(&index, x);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
+}  // namespace
+
+// Tracks the live allocators, so that a thread which exits returns its
+// caches only to the allocators which are not destroyed yet.
+class SizeClassAllocator::ThreadCacheRegistry {
+ public:
+  struct LocalCaches {
+    ~LocalCaches() {
+      Destroyed() = true;
+      auto &registry = Instance();
+      std::lock_guard<std::mutex> guard(registry.mutex_);
+      for (auto &item : caches_) {
+        auto it = registry.allocators_.find(item.first);
+        if (it != registry.allocators_.end()) {
+          it->second->ReturnThreadCache(item.second);
+        }
+      }
+    }
+
+    std::vector<std::pair<uint64_t, ThreadCache *>> caches_;
+  };
+
+  // Never destroyed, as threads may exit after static destruction.
+  static ThreadCacheRegistry &Instance() {
+    static auto *registry = new ThreadCacheRegistry();
+    return *registry;
+  }
+
+  // Nullptr once the caches of the calling thread are destroyed, e.g. when
+  // an allocation is freed by another thread_local destructor.
+  static LocalCaches *Local() {
+    if (Destroyed()) {
+      return nullptr;
+    }
+    static thread_local LocalCaches caches;
+    return &caches;
+  }
+
+  static uint64_t Register(SizeClassAllocator *allocator) {
+    static std::atomic<uint64_t> next_id{0};
+    uint64_t id = next_id.fetch_add(1);
+    auto &registry = Instance();
+    std::lock_guard<std::mutex> guard(registry.mutex_);
+    registry.allocators_[id] = allocator;
+    return id;
+  }
+
+  static void Unregister(uint64_t id) {
+    auto &registry = Instance();
+    std::lock_guard<std::mutex> guard(registry.mutex_);
+    registry.allocators_.erase(id);
+  }
+
+ private:
+  static bool &Destroyed() {
+    static thread_local bool destroyed = false;
+    return destroyed;
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, SizeClassAllocator *> allocators_;
+};
+
+SizeClassAllocator::SizeClassAllocator(
+    const std::shared_ptr<Allocator> &underlying_allocator,
+    size_t alignment,
+    size_t chunk_size,
+    bool allow_free_idle_chunk,
+    bool use_thread_cache)
+    : underlying_allocator_(underlying_allocator),
+      alignment_(alignment),
+      chunk_size_(std::max(AlignedSize(chunk_size, alignment), alignment)),
+      allow_free_idle_chunk_(allow_free_idle_chunk),
+      use_thread_cache_(use_thread_cache && alignment <= kThreadCacheMaxSize),
+      num_cache_classes_(0) {
+  PADDLE_ENFORCE_GT(alignment,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The alignment of SizeClassAllocator must be "
+                        "positive, but got %d.",
+                        alignment));
+  std::memset(sl_bitmap_, 0, sizeof(sl_bitmap_));
+  std::memset(free_lists_, 0, sizeof(free_lists_));
+  if (use_thread_cache_) {
+    size_t max_units = RoundUpToClass(kThreadCacheMaxSize / alignment_);
+    num_cache_classes_ = CacheClass(max_units * alignment_) + 1;
+  }
+  id_ = ThreadCacheRegistry::Register(this);
+}
+
+SizeClassAllocator::~SizeClassAllocator() {
+  // The blocks still in thread caches belong to chunks_, which are freed
+  // with this allocator.
+  ThreadCacheRegistry::Unregister(id_);
+}
+
+void SizeClassAllocator::Mapping(size_t units, int *fl, int *sl) {
+  if (units < kSecondLevelCount) {
+    *fl = 0;
+    *sl = static_cast<int>(units);
+  } else {
+    int log2 = FindLastSet(units);
+    *fl = log2 - kSecondLevelLog2 + 1;
+    *sl = static_cast<int>(units >> (log2 - kSecondLevelLog2)) -
+          kSecondLevelCount;
+  }
+}
+
+size_t SizeClassAllocator::RoundUpToClass(size_t units) {
+  if (units < kSecondLevelCount) {
+    return units;
+  }
+  size_t step = static_cast<size_t>(1)
+                << (FindLastSet(units) - kSecondLevelLog2);
+  return (units + step - 1) & ~(step - 1);
+}
+
+size_t SizeClassAllocator::CacheClass(size_t size) const {
+  int fl, sl;
+  Mapping(size / alignment_, &fl, &sl);
+  return static_cast<size_t>(fl) * kSecondLevelCount + sl;
+}
+
+SizeClassAllocator::Block *SizeClassAllocator::NewBlock() {
+  if (spare_blocks_ == nullptr) {
+    std::unique_ptr<Block[]> slab(new Block[kBlocksPerSlab]);
+    for (size_t i = 0; i + 1 < kBlocksPerSlab; ++i) {
+      slab[i].next_free_ = &slab[i + 1];
+    }
+    slab[kBlocksPerSlab - 1].next_free_ = nullptr;
+    spare_blocks_ = slab.get();
+    block_slabs_.emplace_back(std::move(slab));
+  }
+  Block *block = spare_blocks_;
+  spare_blocks_ = block->next_free_;
+  *block = Block();
+  return block;
+}
+
+void SizeClassAllocator::DeleteBlock(Block *block) {
+  block->next_free_ = spare_blocks_;
+  spare_blocks_ = block;
+}
+
+void SizeClassAllocator::InsertFreeBlock(Block *block) {
+  int fl, sl;
+  Mapping(block->size_ / alignment_, &fl, &sl);
+  Block *head = free_lists_[fl][sl];
+  block->is_free_ = true;
+  block->prev_free_ = nullptr;
+  block->next_free_ = head;
+  if (head != nullptr) {
+    head->prev_free_ = block;
+  }
+  free_lists_[fl][sl] = block;
+  fl_bitmap_ |= static_cast<uint64_t>(1) << fl;
+  sl_bitmap_[fl] |= static_cast<uint32_t>(1) << sl;
+}
+
+void SizeClassAllocator::RemoveFreeBlock(Block *block) {
+  int fl, sl;
+  Mapping(block->size_ / alignment_, &fl, &sl);
+  if (block->prev_free_ != nullptr) {
+    block->prev_free_->next_free_ = block->next_free_;
+  } else {
+    free_lists_[fl][sl] = block->next_free_;
+  }
+  if (block->next_free_ != nullptr) {
+    block->next_free_->prev_free_ = block->prev_free_;
+  }
+  if (free_lists_[fl][sl] == nullptr) {
+    sl_bitmap_[fl] &= ~(static_cast<uint32_t>(1) << sl);
+    if (sl_bitmap_[fl] == 0) {
+      fl_bitmap_ &= ~(static_cast<uint64_t>(1) << fl);
+    }
+  }
+  block->is_free_ = false;
+  block->prev_free_ = nullptr;
+  block->next_free_ = nullptr;
+}
+
+SizeClassAllocator::Block *SizeClassAllocator::FindFreeBlock(size_t size) {
+  // Searching from the rounded up class, rather than the class of size,
+  // makes the first block of any non-empty list a fit.
+  int fl, sl;
+  Mapping(RoundUpToClass(size / alignment_), &fl, &sl);
+  uint32_t sl_map = sl_bitmap_[fl] & (~static_cast<uint32_t>(0) << sl);
+  if (sl_map == 0) {
+    uint64_t fl_map =
+        fl + 1 < 64 ? fl_bitmap_ & (~static_cast<uint64_t>(0) << (fl + 1)) : 0;
+    if (fl_map == 0) {
+      return nullptr;
+    }
+    fl = FindFirstSet(fl_map);
+    sl_map = sl_bitmap_[fl];
+  }
+  return free_lists_[fl][FindFirstSet(sl_map)];
+}
+
+SizeClassAllocator::Block *SizeClassAllocator::AllocateChunk(size_t size) {
+  size_t realloc_size = std::max(size, chunk_size_);
+  try {
+    chunks_.emplace_back(static_unique_ptr_cast<Allocation>(
+        underlying_allocator_->Allocate(realloc_size)));
+  } catch (BadAlloc &ex) {
+    if (FreeIdleChunks() == 0) throw ex;
+    chunks_.emplace_back(static_unique_ptr_cast<Allocation>(
+        underlying_allocator_->Allocate(realloc_size)));
+  }
+
+  auto *chunk = &(*chunks_.rbegin());
+  uint8_t *p = reinterpret_cast<uint8_t *>(chunk->allocation_->ptr());
+  PADDLE_ENFORCE_EQ(reinterpret_cast<uintptr_t>(p) % alignment_,
+                    0,
+                    platform::errors::PreconditionNotMet(
+                        "The chunk allocated by the underlying allocator is "
+                        "not aligned to %d bytes.",
+                        alignment_));
+  Block *block = NewBlock();
+  block->ptr_ = p;
+  block->size_ = chunk->allocation_->size() / alignment_ * alignment_;
+  block->chunk_ = chunk;
+  chunk->head_ = block;
+  VLOG(2) << "Not found and reallocate " << block->size_ << "("
+          << static_cast<void *>(p) << ")";
+  return block;
+}
+
+SizeClassAllocator::Block *SizeClassAllocator::AllocateBlock(size_t size) {
+  Block *block = FindFreeBlock(size);
+  if (block != nullptr) {
+    RemoveFreeBlock(block);
+  } else {
+    block = AllocateChunk(size);
+  }
+
+  if (block->size_ > size) {
+    Block *remaining = NewBlock();
+    remaining->ptr_ = block->ptr_ + size;
+    remaining->size_ = block->size_ - size;
+    remaining->chunk_ = block->chunk_;
+    remaining->prev_phys_ = block;
+    remaining->next_phys_ = block->next_phys_;
+    if (remaining->next_phys_ != nullptr) {
+      remaining->next_phys_->prev_phys_ = remaining;
+    }
+    block->next_phys_ = remaining;
+    block->size_ = size;
+    InsertFreeBlock(remaining);
+  }
+  block->is_free_ = false;
+  return block;
+}
+
+void SizeClassAllocator::FreeBlock(Block *block) {
+  Block *prev = block->prev_phys_;
+  if (prev != nullptr && prev->is_free_) {
+    RemoveFreeBlock(prev);
+    prev->size_ += block->size_;
+    prev->next_phys_ = block->next_phys_;
+    if (prev->next_phys_ != nullptr) {
+      prev->next_phys_->prev_phys_ = prev;
+    }
+    DeleteBlock(block);
+    block = prev;
+  }
+
+  Block *next = block->next_phys_;
+  if (next != nullptr && next->is_free_) {
+    RemoveFreeBlock(next);
+    block->size_ += next->size_;
+    block->next_phys_ = next->next_phys_;
+    if (block->next_phys_ != nullptr) {
+      block->next_phys_->prev_phys_ = block;
+    }
+    DeleteBlock(next);
+  }
+
+  InsertFreeBlock(block);
+}
+
+uint64_t SizeClassAllocator::FreeIdleChunks() {
+  if (!allow_free_idle_chunk_) {
+    return 0;
+  }
+  uint64_t bytes = 0;
+  for (auto chunk_it = chunks_.begin(); chunk_it != chunks_.end();) {
+    Block *head = chunk_it->head_;
+    if (head->is_free_ && head->next_phys_ == nullptr) {
+      VLOG(2) << "Free chunk with size " << head->size_;
+      bytes += head->size_;
+      RemoveFreeBlock(head);
+      DeleteBlock(head);
+      chunk_it = chunks_.erase(chunk_it);
+    } else {
+      ++chunk_it;
+    }
+  }
+  return bytes;
+}
+
+SizeClassAllocator::ThreadCache *SizeClassAllocator::GetThreadCache() {
+  auto *local = ThreadCacheRegistry::Local();
+  if (local == nullptr) {
+    return nullptr;
+  }
+  for (auto &item : local->caches_) {
+    if (item.first == id_) {
+      return item.second;
+    }
+  }
+  ThreadCache *cache = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(thread_caches_mutex_);
+    thread_caches_.emplace_back(new ThreadCache(num_cache_classes_));
+    cache = thread_caches_.back().get();
+  }
+  local->caches_.emplace_back(id_, cache);
+  return cache;
+}
+
+bool SizeClassAllocator::PushToThreadCache(Block *block) {
+  ThreadCache *cache = GetThreadCache();
+  if (cache == nullptr) {
+    return false;
+  }
+  size_t index = CacheClass(block->size_);
+  if (cache->counts_[index] >= kThreadCacheMaxBlocksPerClass ||
+      cache->bytes_ + block->size_ > kThreadCacheMaxBytes) {
+    return false;
+  }
+  block->next_free_ = cache->heads_[index];
+  cache->heads_[index] = block;
+  ++cache->counts_[index];
+  cache->bytes_ += block->size_;
+  return true;
+}
+
+SizeClassAllocator::Block *SizeClassAllocator::PopFromThreadCache(
+    size_t size) {
+  ThreadCache *cache = GetThreadCache();
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  size_t index = CacheClass(size);
+  Block *block = cache->heads_[index];
+  if (block != nullptr) {
+    cache->heads_[index] = block->next_free_;
+    block->next_free_ = nullptr;
+    --cache->counts_[index];
+    cache->bytes_ -= block->size_;
+  }
+  return block;
+}
+
+void SizeClassAllocator::FlushThreadCache(ThreadCache *cache) {
+  std::lock_guard<SpinLock> guard(spinlock_);
+  for (size_t i = 0; i < cache->heads_.size(); ++i) {
+    Block *block = cache->heads_[i];
+    while (block != nullptr) {
+      Block *next = block->next_free_;
+      FreeBlock(block);
+      block = next;
+    }
+    cache->heads_[i] = nullptr;
+    cache->counts_[i] = 0;
+  }
+  cache->bytes_ = 0;
+}
+
+void SizeClassAllocator::ReturnThreadCache(ThreadCache *cache) {
+  FlushThreadCache(cache);
+  std::lock_guard<std::mutex> guard(thread_caches_mutex_);
+  for (auto it = thread_caches_.begin(); it != thread_caches_.end(); ++it) {
+    if (it->get() == cache) {
+      thread_caches_.erase(it);
+      break;
+    }
+  }
+}
+
+phi::Allocation *SizeClassAllocator::AllocateImpl(size_t unaligned_size) {
+  platform::RecordEvent record("SizeClassAllocator::Allocate",
+                               platform::TracerEventType::UserDefined,
+                               9 /*level*/);
+  size_t size = std::max(AlignedSize(unaligned_size, alignment_), alignment_);
+  if (use_thread_cache_ && size <= kThreadCacheMaxSize) {
+    // Small blocks are cut to the size of their class, so that any cached
+    // block of the class can serve the request.
+    size = RoundUpToClass(size / alignment_) * alignment_;
+    Block *block = PopFromThreadCache(size);
+    if (block != nullptr) {
+      return new BlockAllocation(block);
+    }
+  }
+
+  Block *block = nullptr;
+  {
+    std::lock_guard<SpinLock> guard(spinlock_);
+    block = AllocateBlock(size);
+  }
+  VLOG(10) << "Alloc " << block->size_
+           << " bytes, ptr = " << static_cast<void *>(block->ptr_);
+  return new BlockAllocation(block);
+}
+
+void SizeClassAllocator::FreeImpl(phi::Allocation *allocation) {
+  platform::RecordEvent record("SizeClassAllocator::Free",
+                               platform::TracerEventType::UserDefined,
+                               9 /*level*/);
+  Block *block = static_cast<BlockAllocation *>(allocation)->block_;
+  delete allocation;
+  if (use_thread_cache_ && block->size_ <= kThreadCacheMaxSize &&
+      PushToThreadCache(block)) {
+    return;
+  }
+  std::lock_guard<SpinLock> guard(spinlock_);
+  FreeBlock(block);
+}
+
+uint64_t SizeClassAllocator::ReleaseImpl(const platform::Place &place) {
+  if (use_thread_cache_) {
+    auto *local = ThreadCacheRegistry::Local();
+    if (local != nullptr) {
+      for (auto &item : local->caches_) {
+        if (item.first == id_) {
+          FlushThreadCache(item.second);
+        }
+      }
+    }
+  }
+  std::lock_guard<SpinLock> guard(spinlock_);
+  return FreeIdleChunks();
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
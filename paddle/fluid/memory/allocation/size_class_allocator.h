@@ -0,0 +1,175 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/allocation/spin_lock.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+/*
+ * A two-level segregated fit (TLSF) allocator that grows by chunks like
+ * AutoGrowthBestFitAllocator, but finds, splits and coalesces blocks in
+ * constant time.
+ *
+ * Free blocks are kept in size-class lists indexed by a first level (the
+ * power of two of the size) and a second level (kSecondLevelCount linear
+ * subdivisions of it). Two bitmaps record which lists are non-empty, so
+ * that a fitting list is found with two bit scans instead of a search in
+ * an ordered map. Block headers live in slabs owned by the allocator and
+ * link their physical neighbours and free-list siblings directly, so no
+ * container node is allocated per block.
+ *
+ * Small blocks freed by a thread are kept in a per-thread cache, bounded
+ * by kThreadCacheMaxBytes, and handed back to the same thread without
+ * taking the lock. The cache of a thread is returned to the pool when the
+ * thread exits or calls Release.
+ */
+class SizeClassAllocator : public Allocator {
+ public:
+  static constexpr int kSecondLevelLog2 = 4;
+  static constexpr int kSecondLevelCount = 1 << kSecondLevelLog2;
+  static constexpr int kFirstLevelCount = 64 - kSecondLevelLog2 + 1;
+
+  // Blocks up to this size go through the per-thread cache.
+  static constexpr size_t kThreadCacheMaxSize = 32 << 10;
+  static constexpr size_t kThreadCacheMaxBytes = 4 << 20;
+  static constexpr size_t kThreadCacheMaxBlocksPerClass = 64;
+
+  SizeClassAllocator(const std::shared_ptr<Allocator> &underlying_allocator,
+                     size_t alignment,
+                     size_t chunk_size,
+                     bool allow_free_idle_chunk = true,
+                     bool use_thread_cache = true);
+
+  ~SizeClassAllocator() override;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override;
+
+  void FreeImpl(phi::Allocation *allocation) override;
+
+  // Return the cache of the calling thread to the pool and release the
+  // chunks which are not used.
+  uint64_t ReleaseImpl(const platform::Place &place) override;
+
+ private:
+  struct Chunk;
+
+  struct Block {
+    uint8_t *ptr_;
+    size_t size_;
+    Chunk *chunk_;
+    // Blocks next to this one in the chunk, nullptr at the ends.
+    Block *prev_phys_;
+    Block *next_phys_;
+    // Siblings in a free list, a thread cache or the spare block list.
+    Block *prev_free_;
+    Block *next_free_;
+    bool is_free_;
+  };
+
+  struct Chunk {
+    explicit Chunk(DecoratedAllocationPtr allocation)
+        : allocation_(std::move(allocation)) {}
+
+    DecoratedAllocationPtr allocation_;
+    // The first block of the chunk, which is never merged into another.
+    Block *head_{nullptr};
+  };
+
+  struct BlockAllocation : public Allocation {
+    explicit BlockAllocation(Block *block)
+        : Allocation(block->ptr_,
+                     block->chunk_->allocation_->base_ptr(),
+                     block->size_,
+                     block->chunk_->allocation_->place()),
+          block_(block) {}
+
+    Block *block_;
+  };
+
+  struct ThreadCache {
+    explicit ThreadCache(size_t num_classes)
+        : heads_(num_classes, nullptr), counts_(num_classes, 0) {}
+
+    std::vector<Block *> heads_;
+    std::vector<size_t> counts_;
+    size_t bytes_{0};
+  };
+
+  class ThreadCacheRegistry;
+
+  // Map a size in units of alignment_ to its first and second level.
+  static void Mapping(size_t units, int *fl, int *sl);
+  // Round a size in units of alignment_ up to the lower bound of the next
+  // class, so that every block of that class is large enough.
+  static size_t RoundUpToClass(size_t units);
+  // Index of the thread cache list of a block of the given size.
+  size_t CacheClass(size_t size) const;
+
+  Block *NewBlock();
+  void DeleteBlock(Block *block);
+
+  void InsertFreeBlock(Block *block);
+  void RemoveFreeBlock(Block *block);
+  Block *FindFreeBlock(size_t size);
+  Block *AllocateChunk(size_t size);
+  Block *AllocateBlock(size_t size);
+  void FreeBlock(Block *block);
+  uint64_t FreeIdleChunks();
+
+  ThreadCache *GetThreadCache();
+  bool PushToThreadCache(Block *block);
+  Block *PopFromThreadCache(size_t size);
+  // Called with the registry lock held when the owning thread exits.
+  void ReturnThreadCache(ThreadCache *cache);
+  void FlushThreadCache(ThreadCache *cache);
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  size_t alignment_;
+  size_t chunk_size_;
+  bool allow_free_idle_chunk_;
+  bool use_thread_cache_;
+  size_t num_cache_classes_;
+  uint64_t id_;
+
+  std::list<Chunk> chunks_;
+  std::vector<std::unique_ptr<Block[]>> block_slabs_;
+  Block *spare_blocks_{nullptr};
+
+  uint64_t fl_bitmap_{0};
+  uint32_t sl_bitmap_[kFirstLevelCount];
+  Block *free_lists_[kFirstLevelCount][kSecondLevelCount];
+
+  std::mutex thread_caches_mutex_;
+  std::vector<std::unique_ptr<ThreadCache>> thread_caches_;
+
+  SpinLock spinlock_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,202 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/size_class_allocator.h"
+
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/aligned_allocator.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+class RecordedAllocator : public Allocator {
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    allocated_size_ += size;
+    return new Allocation(malloc(size), size, platform::CPUPlace());
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    allocated_size_ -= allocation->size();
+    free(allocation->ptr());
+    delete allocation;
+  }
+
+ public:
+  size_t AllocatedSize() const { return allocated_size_; }
+
+ private:
+  size_t allocated_size_{0};
+};
+
+static constexpr size_t kAlignment = 64;
+static constexpr size_t kChunkSize = 1 << 20;
+
+static void FillAndCheck(const std::vector<AllocationPtr> &allocations) {
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    memset(allocations[i]->ptr(),
+           static_cast<int>(i & 0xFF),
+           allocations[i]->size());
+  }
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    auto *p = reinterpret_cast<uint8_t *>(allocations[i]->ptr());
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p) % kAlignment, 0UL);
+    for (size_t j = 0; j < allocations[i]->size(); ++j) {
+      ASSERT_EQ(p[j], static_cast<uint8_t>(i & 0xFF));
+    }
+  }
+}
+
+TEST(SizeClassAllocator, allocate_and_coalesce) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto underlying_allocator =
+      std::make_shared<AlignedAllocator>(recorded_allocator, kAlignment);
+  auto allocator = std::make_shared<SizeClassAllocator>(
+      underlying_allocator, kAlignment, kChunkSize, true, false);
+
+  std::vector<AllocationPtr> allocations;
+  for (size_t size : {1, 63, 64, 65, 1000, 4096, 12345, 100000}) {
+    allocations.emplace_back(allocator->Allocate(size));
+    ASSERT_GE(allocations.back()->size(), size);
+  }
+  FillAndCheck(allocations);
+  // All requests fit into the first chunk.
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), kChunkSize + kAlignment);
+
+  // A request larger than the chunk size gets a chunk of its own.
+  allocations.emplace_back(allocator->Allocate(3 * kChunkSize));
+  ASSERT_EQ(recorded_allocator->AllocatedSize(),
+            4 * kChunkSize + 2 * kAlignment);
+  FillAndCheck(allocations);
+
+  // Freeing every other block and then the rest coalesces the chunk back
+  // into a single free block, so that it can be released.
+  for (size_t i = 0; i < allocations.size(); i += 2) {
+    allocations[i].reset();
+  }
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), kChunkSize + kAlignment);
+  allocations.clear();
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0UL);
+}
+
+TEST(SizeClassAllocator, reuse_freed_block) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto underlying_allocator =
+      std::make_shared<AlignedAllocator>(recorded_allocator, kAlignment);
+  for (bool use_thread_cache : {false, true}) {
+    auto allocator = std::make_shared<SizeClassAllocator>(
+        underlying_allocator, kAlignment, kChunkSize, true, use_thread_cache);
+    for (size_t size : {256, 5000, 300000}) {
+      auto allocation = allocator->Allocate(size);
+      void *ptr = allocation->ptr();
+      allocation.reset();
+      allocation = allocator->Allocate(size);
+      ASSERT_EQ(allocation->ptr(), ptr);
+    }
+    ASSERT_EQ(recorded_allocator->AllocatedSize(), kChunkSize + kAlignment);
+    allocator->Release(platform::CPUPlace());
+    ASSERT_EQ(recorded_allocator->AllocatedSize(), 0UL);
+  }
+}
+
+TEST(SizeClassAllocator, multi_thread) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto underlying_allocator =
+      std::make_shared<AlignedAllocator>(recorded_allocator, kAlignment);
+  auto allocator = std::make_shared<SizeClassAllocator>(
+      underlying_allocator, kAlignment, kChunkSize);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&allocator, t] {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<size_t> size_dist(1, 64 << 10);
+      std::vector<AllocationPtr> allocations(32);
+      for (int i = 0; i < 4000; ++i) {
+        auto &allocation = allocations[rng() % allocations.size()];
+        if (allocation) {
+          auto *p = reinterpret_cast<uint8_t *>(allocation->ptr());
+          ASSERT_EQ(p[0], static_cast<uint8_t>(t));
+          ASSERT_EQ(p[allocation->size() - 1], static_cast<uint8_t>(t));
+          allocation.reset();
+        } else {
+          allocation = allocator->Allocate(size_dist(rng));
+          memset(allocation->ptr(), t, allocation->size());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // The caches of the exited threads are returned to the pool.
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0UL);
+}
+
+// Replay the same synthetic trace of a mix of small activations and large
+// buffers on both allocators.
+static double ReplayTrace(const std::shared_ptr<Allocator> &allocator) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<size_t> small_dist(1, 16 << 10);
+  std::uniform_int_distribution<size_t> large_dist(64 << 10, 4 << 20);
+  std::vector<AllocationPtr> allocations(256);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 200000; ++i) {
+    auto &allocation = allocations[rng() % allocations.size()];
+    if (allocation) {
+      allocation.reset();
+    } else {
+      size_t size = rng() % 8 == 0 ? large_dist(rng) : small_dist(rng);
+      allocation = allocator->Allocate(size);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+TEST(SizeClassAllocator, compare_with_auto_growth) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto underlying_allocator =
+      std::make_shared<AlignedAllocator>(recorded_allocator, kAlignment);
+  size_t chunk_size = 64 << 20;
+  auto auto_growth = std::make_shared<AutoGrowthBestFitAllocator>(
+      underlying_allocator, kAlignment, chunk_size);
+  auto size_class = std::make_shared<SizeClassAllocator>(
+      underlying_allocator, kAlignment, chunk_size);
+
+  double auto_growth_ms = ReplayTrace(auto_growth);
+  double size_class_ms = ReplayTrace(size_class);
+  LOG(INFO) << "Replay trace: auto_growth takes " << auto_growth_ms
+            << " ms, size_class takes " << size_class_ms << " ms.";
+
+  auto_growth->Release(platform::CPUPlace());
+  size_class->Release(platform::CPUPlace());
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0UL);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "paddle/fluid/memory/allocation/allocation_trace.h"
 #include "paddle/fluid/memory/allocation/allocator.h"
 #include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/platform/profiler/mem_tracing.h"
@@ -31,18 +32,27 @@ class StatAllocator : public Allocator {
 
  protected:
   void FreeImpl(phi::Allocation* allocation) override {
-    if (platform::is_cpu_place(allocation->place()) ||
-        platform::is_cuda_pinned_place(allocation->place())) {
+    bool is_host = platform::is_cpu_place(allocation->place()) ||
+                   platform::is_cuda_pinned_place(allocation->place());
+    if (is_host) {
       HOST_MEMORY_STAT_UPDATE(
           Allocated, allocation->place().GetDeviceId(), -allocation->size());
     } else {
       DEVICE_MEMORY_STAT_UPDATE(
           Allocated, allocation->place().GetDeviceId(), -allocation->size());
     }
+    int scope_id = static_cast<Allocation*>(allocation)->stat_scope_id();
+    if (scope_id != 0) {
+      MemoryStatScopeUpdate(scope_id, is_host, -allocation->size());
+    }
     platform::RecordMemEvent(allocation->ptr(),
                              allocation->place(),
                              allocation->size(),
                              platform::TracerMemEventType::Free);
+    if (UNLIKELY(AllocationTraceRecorder::IsRecording())) {
+      AllocationTraceRecorder::Instance().Record(
+          *allocation, allocation->size(), /*is_free=*/true);
+    }
     underlying_allocator_->Free(allocation);
   }
 
@@ -51,18 +61,28 @@ class StatAllocator : public Allocator {
         underlying_allocator_->Allocate(size);
 
     const platform::Place& place = allocation->place();
-    if (platform::is_cpu_place(place) ||
-        platform::is_cuda_pinned_place(place)) {
+    bool is_host = platform::is_cpu_place(place) ||
+                   platform::is_cuda_pinned_place(place);
+    if (is_host) {
       HOST_MEMORY_STAT_UPDATE(
           Allocated, place.GetDeviceId(), allocation->size());
     } else {
       DEVICE_MEMORY_STAT_UPDATE(
           Allocated, place.GetDeviceId(), allocation->size());
     }
+    int scope_id = CurrentMemoryStatScopeId();
+    static_cast<Allocation*>(allocation.get())->set_stat_scope_id(scope_id);
+    if (scope_id != 0) {
+      MemoryStatScopeUpdate(scope_id, is_host, allocation->size());
+    }
     platform::RecordMemEvent(allocation->ptr(),
                              allocation->place(),
                              allocation->size(),
                              platform::TracerMemEventType::Allocate);
+    if (UNLIKELY(AllocationTraceRecorder::IsRecording())) {
+      AllocationTraceRecorder::Instance().Record(
+          *allocation, size, /*is_free=*/false);
+    }
     return allocation.release();
   }
 
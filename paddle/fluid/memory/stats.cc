@@ -14,12 +14,65 @@ limitations under the License. */
 
 #include "paddle/fluid/memory/stats.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <unordered_map>
+
 #include "paddle/fluid/memory/allocation/spin_lock.h"
 #include "paddle/phi/core/macros.h"
 
 namespace paddle {
 namespace memory {
 
+StatSlot* StatSlotList::Acquire() {
+  for (StatSlot* slot = head_.load(std::memory_order_acquire);
+       slot != nullptr;
+       slot = slot->next) {
+    bool in_use = false;
+    if (!slot->in_use.load(std::memory_order_relaxed) &&
+        slot->in_use.compare_exchange_strong(in_use, true)) {
+      return slot;
+    }
+  }
+  StatSlot* slot = new StatSlot();
+  slot->in_use = true;
+  slot->next = head_.load(std::memory_order_relaxed);
+  while (!head_.compare_exchange_weak(slot->next, slot)) {
+  }
+  return slot;
+}
+
+void StatSlotList::Release(StatSlot* slot) {
+  slot->current.store(0, std::memory_order_relaxed);
+  slot->peak.store(0, std::memory_order_relaxed);
+  slot->in_use.store(false, std::memory_order_release);
+}
+
+int64_t StatSlotList::Sum() const {
+  int64_t sum = 0;
+  for (StatSlot* slot = head_.load(std::memory_order_acquire);
+       slot != nullptr;
+       slot = slot->next) {
+    sum += slot->current.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+int64_t StatSlotList::TakePeaks() {
+  int64_t sum = 0;
+  for (StatSlot* slot = head_.load(std::memory_order_acquire);
+       slot != nullptr;
+       slot = slot->next) {
+    int64_t current = slot->current.load(std::memory_order_relaxed);
+    // current is larger if the owner stored it after the peak was taken.
+    sum += std::max(slot->peak.exchange(current, std::memory_order_relaxed),
+                    current);
+  }
+  return sum;
+}
+
 class StatRegistry {
  public:
   static StatRegistry* GetInstance() {
@@ -104,6 +157,131 @@ void HostMemoryStatUpdate(const std::string& stat_type,
   StatRegistry::GetInstance()->Update("Host" + stat_type, dev_id, increment);
 }
 
+namespace {
+
+struct MemoryStatScopeCounter {
+  std::atomic<int64_t> current{0};
+  std::atomic<int64_t> peak{0};
+
+  void Update(int64_t increment) {
+    int64_t value = current.fetch_add(increment) + increment;
+    int64_t prev_peak = peak.load(std::memory_order_relaxed);
+    while (prev_peak < value && !peak.compare_exchange_weak(prev_peak, value)) {
+    }
+  }
+};
+
+// Scope 0 is the unnamed scope of threads without MemoryStatScope, and is
+// not counted.
+class MemoryStatScopeRegistry {
+ public:
+  static MemoryStatScopeRegistry& Instance() {
+    // Never destroyed, allocations may be freed during static destruction.
+    static auto* registry = new MemoryStatScopeRegistry();
+    return *registry;
+  }
+
+  int GetId(const std::string& name) {
+    std::lock_guard<SpinLock> guard(lock_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+    if (names_.size() == kMaxMemoryStatScopes - 1) {
+      LOG_FIRST_N(WARNING, 1)
+          << "Too many memory stat scopes, the memory of scope " << name
+          << " and the later ones is counted in scope others.";
+      names_.emplace_back("others");
+    }
+    if (names_.size() == kMaxMemoryStatScopes) {
+      return kMaxMemoryStatScopes - 1;
+    }
+    int id = static_cast<int>(names_.size());
+    names_.push_back(name);
+    ids_[name] = id;
+    return id;
+  }
+
+  void Update(int id, bool is_host, int64_t increment) {
+    auto& counters = is_host ? host_ : device_;
+    counters[id].Update(increment);
+  }
+
+  std::vector<MemoryStatScopeSnapshot> Snapshot() {
+    size_t num_scopes = 0;
+    {
+      std::lock_guard<SpinLock> guard(lock_);
+      num_scopes = names_.size();
+    }
+    std::vector<MemoryStatScopeSnapshot> snapshot;
+    for (size_t id = 1; id < num_scopes; ++id) {
+      MemoryStatScopeSnapshot item;
+      item.host_current = host_[id].current;
+      item.host_peak = host_[id].peak;
+      item.device_current = device_[id].current;
+      item.device_peak = device_[id].peak;
+      if (item.host_peak == 0 && item.device_peak == 0) {
+        continue;
+      }
+      {
+        std::lock_guard<SpinLock> guard(lock_);
+        item.name = names_[id];
+      }
+      snapshot.push_back(std::move(item));
+    }
+    return snapshot;
+  }
+
+ private:
+  MemoryStatScopeRegistry() : names_{""} {}
+
+  SpinLock lock_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int> ids_;
+  MemoryStatScopeCounter host_[kMaxMemoryStatScopes];
+  MemoryStatScopeCounter device_[kMaxMemoryStatScopes];
+};
+
+thread_local int current_memory_stat_scope_id = 0;
+
+}  // namespace
+
+MemoryStatScope::MemoryStatScope(const std::string& name)
+    : prev_id_(current_memory_stat_scope_id) {
+  if (!name.empty()) {
+    current_memory_stat_scope_id =
+        MemoryStatScopeRegistry::Instance().GetId(name);
+  }
+}
+
+MemoryStatScope::~MemoryStatScope() {
+  current_memory_stat_scope_id = prev_id_;
+}
+
+int CurrentMemoryStatScopeId() { return current_memory_stat_scope_id; }
+
+void MemoryStatScopeUpdate(int scope_id, bool is_host, int64_t increment) {
+  MemoryStatScopeRegistry::Instance().Update(scope_id, is_host, increment);
+}
+
+std::vector<MemoryStatScopeSnapshot> GetMemoryStatScopeSnapshot() {
+  return MemoryStatScopeRegistry::Instance().Snapshot();
+}
+
+std::string MemoryStatScopeTable() {
+  std::ostringstream os;
+  os << std::left << std::setw(32) << "scope" << std::right << std::setw(16)
+     << "host_current" << std::setw(16) << "host_peak" << std::setw(16)
+     << "device_current" << std::setw(16) << "device_peak" << "\n";
+  for (const auto& item : GetMemoryStatScopeSnapshot()) {
+    os << std::left << std::setw(32) << item.name << std::right
+       << std::setw(16) << item.host_current << std::setw(16)
+       << item.host_peak << std::setw(16) << item.device_current
+       << std::setw(16) << item.device_peak << "\n";
+  }
+  return os.str();
+}
+
 #define DEVICE_MEMORY_STAT_REGISTER_WITH_ID(item, id) \
   StatRegistry::GetInstance()->Register(              \
       "Device" #item, id, Stat<DeviceMemoryStat##item##id>::GetInstance());
@@ -17,8 +17,8 @@ limitations under the License. */
 #include <atomic>
 #include <map>
 #include <string>
+#include <vector>
 
-#include "paddle/fluid/framework/new_executor/workqueue/thread_data_registry.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
 #include "paddle/fluid/platform/macros.h"
@@ -26,13 +26,38 @@ limitations under the License. */
 namespace paddle {
 namespace memory {
 
-using framework::ThreadDataRegistry;
-
 struct ThreadLocalStatBase {
   int64_t current{0};
   int64_t peak{0};
 };
 
+// The value of a Stat owned by one thread. It is only written by the owner,
+// and read by any thread when the value of the Stat is computed. peak is the
+// largest value of the slot since the peaks were last taken. Padded to
+// a cache line, so that the slots of two threads rarely share one.
+struct StatSlot {
+  std::atomic<int64_t> current{0};
+  std::atomic<int64_t> peak{0};
+  std::atomic<bool> in_use{false};
+  StatSlot* next{nullptr};
+  char padding[32];
+};
+
+// A lock-free list of StatSlot. Slots are never freed, the slot of an exited
+// thread is reset and reused by the next thread.
+class StatSlotList {
+ public:
+  StatSlot* Acquire();
+  void Release(StatSlot* slot);
+  int64_t Sum() const;
+  // The sum of the peaks of the slots, which restart from their current
+  // values.
+  int64_t TakePeaks();
+
+ private:
+  std::atomic<StatSlot*> head_{nullptr};
+};
+
 class StatBase {
  public:
   StatBase() = default;
@@ -46,6 +71,13 @@ class StatBase {
   DISABLE_COPY_AND_ASSIGN(StatBase);
 };
 
+/*
+ * Update only touches the slot of the calling thread, which keeps its own
+ * peak. The peaks of the threads are summed when the peak value is read, and
+ * when a thread exits. The sum bounds the peak of the Stat from above, and
+ * is exact when a single thread updates the Stat between two reads.
+ * Like before, the value of a thread is dropped when it exits.
+ */
 template <typename ThreadLocalStatType>
 class Stat : public StatBase {
  public:
@@ -54,41 +86,57 @@ class Stat : public StatBase {
     return &instance;
   }
 
-  int64_t GetCurrentValue() override {
-    std::unordered_map<uint64_t, ThreadLocalStatType> thread_local_stats =
-        ThreadDataRegistry<ThreadLocalStatType>::GetInstance()
-            .GetAllThreadDataByValue();
-    int64_t current_value = 0;
-    for (auto pair : thread_local_stats) {
-      current_value += pair.second.current;
-    }
-    return current_value;
-  }
+  int64_t GetCurrentValue() override { return slots_.Sum(); }
 
-  int64_t GetPeakValue() override { return peak_value_; }
+  int64_t GetPeakValue() override {
+    UpdatePeak(slots_.TakePeaks());
+    return peak_value_;
+  }
 
   void Update(int64_t increment) override {
-    auto& thread_data_registry =
-        ThreadDataRegistry<ThreadLocalStatType>::GetInstance();
-    ThreadLocalStatType* thread_local_stat =
-        thread_data_registry.GetMutableCurrentThreadData();
-    thread_local_stat->current += increment;
-
-    if (thread_local_stat->current > thread_local_stat->peak) {
-      thread_local_stat->peak = thread_local_stat->current;
-      int64_t current_value = GetCurrentValue();
-      int64_t prev_value = peak_value_;
-      while (prev_value < current_value &&
-             !peak_value_.compare_exchange_weak(prev_value, current_value)) {
-      }
-      VLOG(8) << "Update peak_value, after update, peak_value = "
-              << peak_value_.load() << " , current value = " << current_value;
+    StatSlot* slot = ThreadSlot();
+    int64_t current =
+        slot->current.load(std::memory_order_relaxed) + increment;
+    slot->current.store(current, std::memory_order_relaxed);
+    if (current > slot->peak.load(std::memory_order_relaxed)) {
+      slot->peak.store(current, std::memory_order_relaxed);
     }
   }
 
  private:
+  class SlotHolder {
+   public:
+    explicit SlotHolder(Stat* stat)
+        : stat_(stat), slot_(stat->slots_.Acquire()) {}
+    ~SlotHolder() {
+      stat_->UpdatePeak(stat_->slots_.TakePeaks());
+      stat_->slots_.Release(slot_);
+    }
+    StatSlot* slot() const { return slot_; }
+
+   private:
+    Stat* stat_;
+    StatSlot* slot_;
+  };
+
   Stat() {}
   ~Stat() {}
+
+  StatSlot* ThreadSlot() {
+    static thread_local SlotHolder holder(this);
+    return holder.slot();
+  }
+
+  void UpdatePeak(int64_t peak_value) {
+    int64_t prev_value = peak_value_;
+    while (prev_value < peak_value &&
+           !peak_value_.compare_exchange_weak(prev_value, peak_value)) {
+    }
+    VLOG(8) << "Update peak_value, after update, peak_value = "
+            << peak_value_.load() << " , peaks of threads = " << peak_value;
+  }
+
+  StatSlotList slots_;
   std::atomic<int64_t> peak_value_{0};
 };
 
@@ -109,6 +157,56 @@ void HostMemoryStatUpdate(const std::string& stat_type,
                           int dev_id,
                           int64_t increment);
 
+/*
+ * Attribute the memory allocated by the current thread to a component, e.g.
+ * "dataset", "executor:<program>" or "predictor:<id>":
+ *
+ *   {
+ *     MemoryStatScope stat_scope("predictor:" + std::to_string(id));
+ *     ...  // allocations of AllocatorFacade are counted in the scope
+ *   }
+ *
+ * Scopes nest, an allocation is counted in the innermost one, and its free
+ * is counted in the same scope wherever it happens. A scope with an empty
+ * name keeps the scope of the caller. The scope is not inherited by the
+ * threads started inside it.
+ */
+class MemoryStatScope {
+ public:
+  explicit MemoryStatScope(const std::string& name);
+  ~MemoryStatScope();
+
+ private:
+  int prev_id_;
+
+  DISABLE_COPY_AND_ASSIGN(MemoryStatScope);
+};
+
+// At most kMaxMemoryStatScopes scopes can be created, the memory of the
+// later ones is counted in the last scope, named "others".
+constexpr int kMaxMemoryStatScopes = 256;
+
+// The id of the innermost MemoryStatScope of the calling thread, 0 if none.
+int CurrentMemoryStatScopeId();
+
+// Called by StatAllocator, scope_id must be non-zero.
+void MemoryStatScopeUpdate(int scope_id, bool is_host, int64_t increment);
+
+struct MemoryStatScopeSnapshot {
+  std::string name;
+  int64_t host_current{0};
+  int64_t host_peak{0};
+  int64_t device_current{0};
+  int64_t device_peak{0};
+};
+
+// The allocated bytes of every scope that has allocated memory, summed over
+// the places of host and device.
+std::vector<MemoryStatScopeSnapshot> GetMemoryStatScopeSnapshot();
+
+// The snapshot formatted as a table, for logging.
+std::string MemoryStatScopeTable();
+
 #define DEVICE_MEMORY_STAT_FUNC_SWITHCH_CASE(item, id)              \
   case id:                                                          \
     stat = paddle::memory::Stat<                                    \
@@ -173,5 +173,81 @@ TEST_F(StatsTest, HostReservedTest) {
   RunTests();
 }
 
+TEST(StatsPeakTest, PeakOfThreads) {
+  const std::string stat_type = "Allocated";
+  const int dev_id = 1;
+  // The peak of an exited thread is kept.
+  std::thread([&] {
+    DeviceMemoryStatUpdate(stat_type, dev_id, 100);
+    DeviceMemoryStatUpdate(stat_type, dev_id, -100);
+  }).join();
+  EXPECT_EQ(DeviceMemoryStatPeakValue(stat_type, dev_id), 100);
+  EXPECT_EQ(DeviceMemoryStatCurrentValue(stat_type, dev_id), 0);
+
+  // The peaks of the threads are summed on read.
+  DeviceMemoryStatUpdate(stat_type, dev_id, 30);
+  std::thread([&] {
+    DeviceMemoryStatUpdate(stat_type, dev_id, 50);
+    DeviceMemoryStatUpdate(stat_type, dev_id, -50);
+  }).join();
+  EXPECT_EQ(DeviceMemoryStatPeakValue(stat_type, dev_id), 100);
+  DeviceMemoryStatUpdate(stat_type, dev_id, 80);
+  EXPECT_EQ(DeviceMemoryStatPeakValue(stat_type, dev_id), 110);
+  DeviceMemoryStatUpdate(stat_type, dev_id, -110);
+  EXPECT_EQ(DeviceMemoryStatPeakValue(stat_type, dev_id), 110);
+  EXPECT_EQ(DeviceMemoryStatCurrentValue(stat_type, dev_id), 0);
+}
+
+TEST(MemoryStatScopeTest, NestedScopes) {
+  EXPECT_EQ(CurrentMemoryStatScopeId(), 0);
+  int outer_id = 0;
+  {
+    MemoryStatScope outer("stats_test_outer");
+    outer_id = CurrentMemoryStatScopeId();
+    EXPECT_NE(outer_id, 0);
+    MemoryStatScopeUpdate(outer_id, /*is_host=*/true, 100);
+    {
+      MemoryStatScope inner("stats_test_inner");
+      int inner_id = CurrentMemoryStatScopeId();
+      EXPECT_NE(inner_id, outer_id);
+      MemoryStatScopeUpdate(inner_id, /*is_host=*/false, 300);
+      MemoryStatScopeUpdate(inner_id, /*is_host=*/false, -200);
+    }
+    EXPECT_EQ(CurrentMemoryStatScopeId(), outer_id);
+    {
+      // An empty name keeps the scope of the caller.
+      MemoryStatScope unnamed("");
+      EXPECT_EQ(CurrentMemoryStatScopeId(), outer_id);
+    }
+    EXPECT_EQ(CurrentMemoryStatScopeId(), outer_id);
+    // Another thread is not in the scope.
+    std::thread([] { EXPECT_EQ(CurrentMemoryStatScopeId(), 0); }).join();
+  }
+  EXPECT_EQ(CurrentMemoryStatScopeId(), 0);
+  {
+    MemoryStatScope outer("stats_test_outer");
+    EXPECT_EQ(CurrentMemoryStatScopeId(), outer_id);
+  }
+  MemoryStatScopeUpdate(outer_id, /*is_host=*/true, -40);
+
+  int found = 0;
+  for (const auto& item : GetMemoryStatScopeSnapshot()) {
+    if (item.name == "stats_test_outer") {
+      ++found;
+      EXPECT_EQ(item.host_current, 60);
+      EXPECT_EQ(item.host_peak, 100);
+      EXPECT_EQ(item.device_peak, 0);
+    } else if (item.name == "stats_test_inner") {
+      ++found;
+      EXPECT_EQ(item.host_peak, 0);
+      EXPECT_EQ(item.device_current, 100);
+      EXPECT_EQ(item.device_peak, 300);
+    }
+  }
+  EXPECT_EQ(found, 2);
+  EXPECT_NE(MemoryStatScopeTable().find("stats_test_inner"),
+            std::string::npos);
+}
+
 }  // namespace memory
 }  // namespace paddle
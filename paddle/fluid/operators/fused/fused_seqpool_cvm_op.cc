@@ -14,7 +14,15 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/fused/fused_seqpool_cvm_op.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
+
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
+
 namespace paddle {
 namespace operators {
 
@@ -239,6 +247,209 @@ class FusedSeqpoolCVMGradOpMaker : public framework::SingleGradOpMaker<T> {
   }
 };
 
+// The offsets of the sequences of every slot. An input without lod is a
+// sequence per row.
+template <typename TensorT>
+static std::vector<const size_t*> GetSlotLods(
+    const std::vector<TensorT*>& tensors,
+    std::vector<std::vector<size_t>>* default_lods,
+    int* batch_size) {
+  const size_t slot_size = tensors.size();
+  std::vector<const size_t*> lods(slot_size);
+  default_lods->resize(slot_size);
+  *batch_size = -1;
+  for (size_t i = 0; i < slot_size; ++i) {
+    const auto* tensor = tensors[i];
+    int cur_batch_size = 0;
+    if (tensor->lod().size() != 0) {
+      lods[i] = tensor->lod()[0].data();
+      cur_batch_size = tensor->lod()[0].size() - 1;
+    } else {
+      auto& default_lod = (*default_lods)[i];
+      default_lod.resize(tensor->dims()[0] + 1);
+      for (size_t j = 0; j < default_lod.size(); ++j) {
+        default_lod[j] = j;
+      }
+      lods[i] = default_lod.data();
+      cur_batch_size = tensor->dims()[0];
+    }
+    if (*batch_size == -1) {
+      *batch_size = cur_batch_size;
+    } else {
+      PADDLE_ENFORCE_EQ(*batch_size,
+                        cur_batch_size,
+                        platform::errors::PreconditionNotMet(
+                            "The batch size of all input should be same, "
+                            "please cheack, last batchsize is %d, current "
+                            "batchsize is %d",
+                            *batch_size,
+                            cur_batch_size));
+    }
+  }
+  return lods;
+}
+
+// Pools the sequences of all slots in one parallel pass over the lod
+// offsets, with the jit seqpool kernel, and applies CVM on the pooled rows.
+template <typename T>
+class FusedSeqpoolCVMOpCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto inputs = ctx.MultiInput<phi::DenseTensor>("X");
+    auto outputs = ctx.MultiOutput<phi::DenseTensor>("Out");
+    const auto slot_size = inputs.size();
+    auto padding_value = static_cast<T>(ctx.Attr<float>("pad_value"));
+    auto use_cvm = ctx.Attr<bool>("use_cvm");
+    const int cvm_offset = ctx.Attr<int>("cvm_offset");
+
+    const int embedding_size = inputs[0]->numel() / inputs[0]->dims()[0];
+    for (size_t i = 0; i < slot_size; ++i) {
+      PADDLE_ENFORCE_EQ(
+          static_cast<int>(inputs[i]->numel() / inputs[i]->dims()[0]),
+          embedding_size,
+          platform::errors::InvalidArgument(
+              "The embedding size of all inputs should be equal."));
+    }
+    int batch_size = -1;
+    std::vector<std::vector<size_t>> default_lods;
+    auto lods = GetSlotLods(inputs, &default_lods, &batch_size);
+
+    const int out_size = use_cvm ? embedding_size : embedding_size - cvm_offset;
+    std::vector<const T*> input_data(slot_size);
+    std::vector<T*> output_data(slot_size);
+    for (size_t i = 0; i < slot_size; ++i) {
+      input_data[i] = inputs[i]->data<T>();
+      outputs[i]->Resize({batch_size, out_size});
+      output_data[i] = outputs[i]->mutable_data<T>(ctx.GetPlace());
+    }
+    // Without cvm, the sequences are pooled into a buffer, whose columns
+    // after cvm_offset are the outputs.
+    phi::DenseTensor seqpool_output;
+    T* seqpool_output_data = nullptr;
+    if (!use_cvm) {
+      seqpool_output.Resize({static_cast<int64_t>(slot_size * batch_size),
+                             static_cast<int64_t>(embedding_size)});
+      seqpool_output_data = seqpool_output.mutable_data<T>(ctx.GetPlace());
+    }
+
+    jit::seq_pool_attr_t attr(embedding_size, jit::SeqPoolType::kSum);
+    auto seqpool =
+        jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
+            attr);
+    const int64_t num_rows = static_cast<int64_t>(slot_size) * batch_size;
+    auto pool_row = [&](int64_t row) {
+      const int64_t slot = row / batch_size;
+      const int64_t ins = row % batch_size;
+      const size_t start = lods[slot][ins];
+      const size_t end = lods[slot][ins + 1];
+      T* dst = use_cvm ? output_data[slot] + ins * embedding_size
+                       : seqpool_output_data + row * embedding_size;
+      if (end > start) {
+        jit::seq_pool_attr_t row_attr(
+            embedding_size,
+            jit::SeqPoolType::kSum,
+            static_cast<int>(end - start));
+        seqpool(input_data[slot] + start * embedding_size, dst, &row_attr);
+      } else {
+        std::fill(dst, dst + embedding_size, static_cast<T>(0));
+      }
+      // The same as the cuda kernel, the sum starts from pad_value.
+      if (padding_value != static_cast<T>(0)) {
+        for (int k = 0; k < embedding_size; ++k) {
+          dst[k] += padding_value;
+        }
+      }
+      if (use_cvm) {
+        // show and click
+        dst[0] = std::log(dst[0] + 1);
+        dst[1] = std::log(dst[1] + 1) - dst[0];
+      } else {
+        std::memcpy(output_data[slot] + ins * out_size,
+                    dst + cvm_offset,
+                    out_size * sizeof(T));
+      }
+    };
+    // The rows of a slot are as long as their sequences, so the grain is
+    // taken from the average length.
+    const int64_t row_numel = std::max<int64_t>(
+        1, inputs[0]->numel() / std::max<int64_t>(batch_size, 1));
+    const int64_t grain_size = std::max<int64_t>(
+        1, phi::backends::cpu::kIntraOpGrainSize / row_numel);
+    auto& dev_ctx = ctx.template device_context<phi::CPUContext>();
+    dev_ctx.ParallelFor(
+        0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            pool_row(row);
+          }
+        });
+  }
+};
+
+// The grad of every row of a sequence is the cvm of the instance in the
+// first cvm_offset columns, and the out grad of the instance in the rest.
+template <typename T>
+class FusedSeqpoolCVMGradOpCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto out_grads =
+        ctx.MultiInput<phi::DenseTensor>(framework::GradVarName("Out"));
+    auto in_grads =
+        ctx.MultiOutput<phi::DenseTensor>(framework::GradVarName("X"));
+    auto* cvm = ctx.Input<phi::DenseTensor>("CVM");
+    auto use_cvm = ctx.Attr<bool>("use_cvm");
+    const int cvm_offset = ctx.Attr<int>("cvm_offset");
+    const auto slot_size = in_grads.size();
+
+    const int embedding_size = in_grads[0]->numel() / in_grads[0]->dims()[0];
+    int batch_size = -1;
+    std::vector<std::vector<size_t>> default_lods;
+    auto lods = GetSlotLods(in_grads, &default_lods, &batch_size);
+
+    const int out_size = use_cvm ? embedding_size : embedding_size - cvm_offset;
+    std::vector<const T*> out_grads_data(slot_size);
+    std::vector<T*> in_grads_data(slot_size);
+    for (size_t i = 0; i < slot_size; ++i) {
+      out_grads_data[i] = out_grads[i]->data<T>();
+      in_grads_data[i] = in_grads[i]->mutable_data<T>(ctx.GetPlace());
+    }
+    const T* cvm_data = cvm->data<T>();
+
+    const int64_t num_rows = static_cast<int64_t>(slot_size) * batch_size;
+    auto grad_row = [&](int64_t row) {
+      const int64_t slot = row / batch_size;
+      const int64_t ins = row % batch_size;
+      const size_t start = lods[slot][ins];
+      const size_t end = lods[slot][ins + 1];
+      if (end == start) {
+        return;
+      }
+      T* first = in_grads_data[slot] + start * embedding_size;
+      std::memcpy(
+          first, cvm_data + ins * cvm_offset, cvm_offset * sizeof(T));
+      std::memcpy(first + cvm_offset,
+                  out_grads_data[slot] + ins * out_size +
+                      (use_cvm ? cvm_offset : 0),
+                  (embedding_size - cvm_offset) * sizeof(T));
+      for (size_t k = start + 1; k < end; ++k) {
+        std::memcpy(in_grads_data[slot] + k * embedding_size,
+                    first,
+                    embedding_size * sizeof(T));
+      }
+    };
+    const int64_t row_numel = std::max<int64_t>(
+        1, in_grads[0]->numel() / std::max<int64_t>(batch_size, 1));
+    const int64_t grain_size = std::max<int64_t>(
+        1, phi::backends::cpu::kIntraOpGrainSize / row_numel);
+    auto& dev_ctx = ctx.template device_context<phi::CPUContext>();
+    dev_ctx.ParallelFor(
+        0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            grad_row(row);
+          }
+        });
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
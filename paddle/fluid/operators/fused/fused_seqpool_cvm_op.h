@@ -19,29 +19,3 @@ limitations under the License. */
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/tensor.h"
-
-namespace paddle {
-namespace operators {
-
-template <typename T>
-class FusedSeqpoolCVMOpCPUKernel : public framework::OpKernel<T> {
- public:
-  void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW(platform::errors::Unimplemented(
-        "Unimplemented CPU kernel for FusedSeqpoolCVMOp, only support GPU "
-        "now."));
-  }
-};
-
-template <typename T>
-class FusedSeqpoolCVMGradOpCPUKernel : public framework::OpKernel<T> {
- public:
-  void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW(platform::errors::Unimplemented(
-        "Unimplemented CPU kernel for FusedSeqpoolCVMGradOp, only support GPU "
-        "now."));
-  }
-};
-
-}  // namespace operators
-}  // namespace paddle
@@ -0,0 +1,86 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/infershape_utils.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/phi/core/infermeta_utils.h"
+#include "paddle/phi/infermeta/multiary.h"
+
+namespace paddle {
+namespace operators {
+
+class FusedWeightOnlyFCOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  phi::KernelKey GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override {
+    auto input_data_type =
+        OperatorWithKernel::IndicateVarDataType(ctx, "Input");
+    return phi::KernelKey(input_data_type, ctx.GetPlace());
+  }
+};
+
+class FusedWeightOnlyFCOpMaker : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("Input", "(Tensor) The input tensor of the fc.");
+    AddInput("QWeight",
+             "(Tensor) The int8 weight with one row per output channel, of "
+             "shape (O, I), or (O, (I + 1) / 2) with two 4-bit values in "
+             "each byte.");
+    AddInput("Scale",
+             "(Tensor) The float dequantization scale of each output "
+             "channel, of shape (O).");
+    AddInput("Bias", "(Tensor, optional) Bias vector with shape (1 x O).")
+        .AsDispensable();
+    AddOutput("Out", "(Tensor) The output tensor of the fc.");
+    AddAttr<int>("in_num_col_dims",
+                 "(int, default 1), The fc op can take tensors with more than "
+                 "two dimensions as its inputs.")
+        .SetDefault(1)
+        .EqualGreaterThan(1);
+    AddAttr<std::string>("activation_type",
+                         "Activation type used in fully connected operator.")
+        .SetDefault("");
+    AddAttr<int>("weight_bits",
+                 "(int, default 8) The number of bits of the quantized "
+                 "weight, 8 or 4.")
+        .SetDefault(8);
+    AddComment(R"DOC(
+Weight-only Quantized Fully Connected Operator.
+
+Out = Input * (QWeight * Scale)^T + Bias. The weight of an fc or matmul_v2 is
+quantized per output channel by weight_only_quant_pass, and dequantized on the
+fly by the kernel, so small-batch inference reads 4 or 8 times less weight
+memory than with a float32 weight.
+)DOC");
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+DECLARE_INFER_SHAPE_FUNCTOR(fused_weight_only_fc,
+                            FusedWeightOnlyFCInferShapeFunctor,
+                            PD_INFER_META(phi::FusedWeightOnlyFCInferMeta));
+REGISTER_OPERATOR(
+    fused_weight_only_fc,
+    ops::FusedWeightOnlyFCOp,
+    ops::FusedWeightOnlyFCOpMaker,
+    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
+    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>,
+    FusedWeightOnlyFCInferShapeFunctor);
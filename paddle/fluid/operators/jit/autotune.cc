@@ -0,0 +1,204 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/jit/autotune.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+
+#include "glog/logging.h"
+#include "paddle/fluid/operators/jit/helper.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_bool(
+    jit_autotune,
+    false,
+    "Whether to time all the candidate implementations of a jit kernel on "
+    "the first use of each attribute, and use the fastest one instead of "
+    "the default best one.");
+
+PADDLE_DEFINE_EXPORTED_string(
+    jit_autotune_cache_file,
+    "",
+    "The file to persist the choices of the jit kernel autotune to, which "
+    "are loaded by the later runs. Empty means not to persist them.");
+
+namespace paddle {
+namespace operators {
+namespace jit {
+
+static const char* CurrentISA() {
+  using phi::backends::cpu::MayIUse;
+  if (MayIUse(phi::backends::cpu::avx512_core)) {
+    return "avx512_core";
+  } else if (MayIUse(phi::backends::cpu::avx512f)) {
+    return "avx512f";
+  } else if (MayIUse(phi::backends::cpu::avx2)) {
+    return "avx2";
+  } else if (MayIUse(phi::backends::cpu::avx)) {
+    return "avx";
+  }
+  return "isa_any";
+}
+
+static std::string CacheKey(const std::string& kernel_type,
+                            const std::string& isa,
+                            int64_t key) {
+  return kernel_type + " " + isa + " " + std::to_string(key);
+}
+
+// Parses a line of the cache file: kernel_type isa key impl_type cost_us.
+static bool ParseCacheLine(const std::string& line,
+                           std::string* cache_key,
+                           std::string* impl_type) {
+  std::istringstream sin(line);
+  std::string kernel_type, isa;
+  int64_t key;
+  if (!(sin >> kernel_type >> isa >> key >> *impl_type)) {
+    return false;
+  }
+  *cache_key = CacheKey(kernel_type, isa, key);
+  return true;
+}
+
+static bool CacheFileHas(const std::string& path,
+                         const std::string& cache_key) {
+  std::ifstream fin(path);
+  std::string line, line_key, impl_type;
+  while (std::getline(fin, line)) {
+    if (ParseCacheLine(line, &line_key, &impl_type) && line_key == cache_key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Appends the line of cache_key to the cache file, unless another process
+// has written the key. The processes sharing the file serialize the check
+// and the write by an advisory lock of the file.
+static void AppendToCacheFile(const std::string& path,
+                              const std::string& cache_key,
+                              const std::string& line) {
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0) {
+    LOG(WARNING) << "Can not open the jit autotune cache file " << path;
+    return;
+  }
+  if (flock(fd, LOCK_EX) != 0) {
+    LOG(WARNING) << "Can not lock the jit autotune cache file " << path;
+    close(fd);
+    return;
+  }
+  if (!CacheFileHas(path, cache_key) &&
+      write(fd, line.data(), line.size()) !=
+          static_cast<ssize_t>(line.size())) {
+    LOG(WARNING) << "Can not write the jit autotune cache file " << path;
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+#else
+  if (CacheFileHas(path, cache_key)) {
+    return;
+  }
+  std::ofstream fout(path, std::ios::app);
+  if (!fout) {
+    LOG(WARNING) << "Can not open the jit autotune cache file " << path;
+    return;
+  }
+  fout << line;
+#endif
+}
+
+AutoTuneCache& AutoTuneCache::Instance() {
+  static AutoTuneCache cache;
+  return cache;
+}
+
+void AutoTuneCache::LoadIfNeeded() {
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+  if (FLAGS_jit_autotune_cache_file.empty()) {
+    return;
+  }
+  std::ifstream fin(FLAGS_jit_autotune_cache_file);
+  std::string line;
+  size_t num = 0;
+  std::string cache_key, impl_type;
+  while (std::getline(fin, line)) {
+    if (!ParseCacheLine(line, &cache_key, &impl_type)) {
+      continue;
+    }
+    impl_types_[cache_key] = impl_type;
+    ++num;
+  }
+  VLOG(3) << "Load " << num << " jit autotune choices from "
+          << FLAGS_jit_autotune_cache_file;
+}
+
+bool AutoTuneCache::Find(KernelType kt, int64_t key, std::string* impl_type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LoadIfNeeded();
+  auto iter = impl_types_.find(CacheKey(to_string(kt), CurrentISA(), key));
+  if (iter == impl_types_.end()) {
+    return false;
+  }
+  *impl_type = iter->second;
+  return true;
+}
+
+void AutoTuneCache::Insert(KernelType kt,
+                           int64_t key,
+                           const std::string& impl_type,
+                           double cost_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LoadIfNeeded();
+  std::string cache_key = CacheKey(to_string(kt), CurrentISA(), key);
+  // Keep the first choice if several threads tuned the same key.
+  if (!impl_types_.emplace(cache_key, impl_type).second) {
+    return;
+  }
+  VLOG(3) << "Autotune " << to_string(kt) << " with key " << key << ": "
+          << impl_type << ", " << cost_us << " us";
+  if (FLAGS_jit_autotune_cache_file.empty()) {
+    return;
+  }
+  std::ostringstream line;
+  line << cache_key << " " << impl_type << " " << cost_us << "\n";
+  AppendToCacheFile(FLAGS_jit_autotune_cache_file, cache_key, line.str());
+}
+
+size_t AutoTuneCache::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return impl_types_.size();
+}
+
+void AutoTuneCache::Clean() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  impl_types_.clear();
+  loaded_ = false;
+}
+
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,137 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/operators/jit/kernel_base.h"
+
+DECLARE_bool(jit_autotune);
+DECLARE_string(jit_autotune_cache_file);
+
+namespace paddle {
+namespace operators {
+namespace jit {
+
+constexpr int kAutoTuneBurning = 10;
+constexpr int kAutoTuneRepeat = 100;
+
+// The implementation types of the jit kernels chosen by the autotune, by the
+// kernel type, the ISA of the CPU and the key of the attribute. The choices
+// are appended to FLAGS_jit_autotune_cache_file if it is set, and loaded from
+// it on the first lookup, so that the later runs on the same hosts skip the
+// timing.
+class AutoTuneCache {
+ public:
+  static AutoTuneCache& Instance();
+
+  bool Find(KernelType kt, int64_t key, std::string* impl_type);
+
+  // Keeps the first choice of a key, and appends it to the cache file unless
+  // another process has written the key.
+  void Insert(KernelType kt,
+              int64_t key,
+              const std::string& impl_type,
+              double cost_us);
+
+  size_t Size();
+
+  // Drops the choices in memory, which are loaded again from the file.
+  void Clean();
+
+ private:
+  AutoTuneCache() = default;
+
+  void LoadIfNeeded();
+
+  std::mutex mutex_;
+  bool loaded_{false};
+  std::unordered_map<std::string, std::string> impl_types_;
+};
+
+// Returns the average time in microseconds of the function on the arguments.
+template <typename Func, typename... Args>
+double TimeFunc(Func func, Args... args) {
+  for (int i = 0; i < kAutoTuneBurning; ++i) {
+    func(args...);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kAutoTuneRepeat; ++i) {
+    func(args...);
+  }
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         kAutoTuneRepeat;
+}
+
+// Times the function of the kernel on the inputs made from the attribute.
+// Returns false for the kernels whose inputs can not be made from their
+// attributes, which are not tuned.
+template <typename Func, typename Attr>
+bool TimeKernelFunc(const void*, Func, const Attr&, double*) {
+  return false;
+}
+
+template <typename T>
+bool TimeKernelFunc(const XYZNTuple<T>*,
+                    typename XYZNTuple<T>::func_type func,
+                    const int& d,
+                    double* cost_us) {
+  std::vector<T> x(d, static_cast<T>(0.5)), y(d, static_cast<T>(0.5)), z(d);
+  *cost_us = TimeFunc(func, x.data(), y.data(), z.data(), d);
+  return true;
+}
+
+template <typename T>
+bool TimeKernelFunc(const XYNTuple<T>*,
+                    typename XYNTuple<T>::func_type func,
+                    const int& d,
+                    double* cost_us) {
+  std::vector<T> x(d, static_cast<T>(0.5)), y(d);
+  *cost_us = TimeFunc(func, x.data(), y.data(), d);
+  return true;
+}
+
+template <typename T>
+bool TimeKernelFunc(const SeqPoolTuple<T>*,
+                    typename SeqPoolTuple<T>::func_type func,
+                    const seq_pool_attr_t& attr,
+                    double* cost_us) {
+  std::vector<T> x(attr.h * attr.w, static_cast<T>(0.5)), y(attr.w);
+  *cost_us = TimeFunc(func, x.data(), y.data(), &attr);
+  return true;
+}
+
+template <typename T>
+bool TimeKernelFunc(const MatMulTuple<T>*,
+                    typename MatMulTuple<T>::func_type func,
+                    const matmul_attr_t& attr,
+                    double* cost_us) {
+  std::vector<T> a(attr.m * attr.k, static_cast<T>(0.5));
+  std::vector<T> b(attr.k * attr.n, static_cast<T>(0.5));
+  std::vector<T> c(attr.m * attr.n);
+  *cost_us = TimeFunc(func, a.data(), b.data(), c.data(), &attr);
+  return true;
+}
+
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
@@ -45,6 +45,10 @@ const int ALIGN32_BEG exp_int_0x7f[] ALIGN32_END = {REPEAT_8TIMES(0x7f)};
 int ALIGN32_BEG g_tmp_mem[16] ALIGN32_END = {0};
 
 void VActJitCode::genCode() {
+  if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core)) {
+    genAVX512Code();
+    return;
+  }
   int offset = 0;
   for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
     vmovups(ymm_src, ptr[param1 + offset]);
@@ -79,6 +83,27 @@ void VActJitCode::genCode() {
   ret();
 }
 
+void VActJitCode::genAVX512Code() {
+  int rest = num_ % ZMM_FLOAT_BLOCK;
+  if (rest > 0) {
+    mov(eax, (1 << rest) - 1);
+    kmovw(k1, eax);
+  }
+  int blocks = (num_ + ZMM_FLOAT_BLOCK - 1) / ZMM_FLOAT_BLOCK;
+  for (int i = 0; i < blocks; ++i) {
+    int offset = sizeof(float) * ZMM_FLOAT_BLOCK * i;
+    bool tail = rest > 0 && i == blocks - 1;
+    vmovups(tail ? zmm_src | k1 | T_z : zmm_src, ptr[param1 + offset]);
+    act<zmm_t>(zmm_dst, zmm_src, type_);
+    if (tail) {
+      vmovups(ptr[param2 + offset] | k1, zmm_dst);
+    } else {
+      vmovups(ptr[param2 + offset], zmm_dst);
+    }
+  }
+  ret();
+}
+
 #define DECLARE_ACT_CREATOR(name)                                            \
   class name##Creator : public JitCodeCreator<int> {                         \
    public:                                                                   \
@@ -68,7 +68,18 @@ class VActFunc : public JitCode {
   virtual void genCode() = 0;
 
  protected:
-  // compute RELU with ymm, xmm
+  // load the constant of exp_float_consts at offset, which holds only
+  // YMM_FLOAT_BLOCK floats, so it is broadcast to zmm
+  template <typename JMM>
+  void load_const_jmm(JMM& dst, reg64_t& base, size_t offset) {  // NOLINT
+    if (std::is_same<JMM, zmm_t>::value) {
+      vbroadcastss(dst, ptr[base + offset]);
+    } else {
+      vmovaps(dst, ptr[base + offset]);
+    }
+  }
+
+  // compute RELU with zmm, ymm, xmm
   template <typename JMM>
   void relu_jmm(JMM& dst, JMM& src, int zero_idx = 15) {  // NOLINT
     JMM zero = JMM(zero_idx);
@@ -76,13 +87,13 @@ class VActFunc : public JitCode {
     vmaxps(dst, src, zero);
   }
 
-  // compute SQUARE with ymm, xmm
+  // compute SQUARE with zmm, ymm, xmm
   template <typename JMM>
   void square_jmm(JMM& dst, JMM& src) {  // NOLINT
     vmulps(dst, src, src);
   }
 
-  // compute EXP with ymm, xmm
+  // compute EXP with zmm, ymm, xmm
   template <typename JMM>
   void exp_jmm(JMM& dst,  // NOLINT
                JMM& src,  // NOLINT
@@ -102,50 +113,59 @@ class VActFunc : public JitCode {
     push(reg_ptr_global);
     vmovaps(jmm_src, src);
     mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_HIG]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_HIG);
     vminps(jmm_src, jmm_src, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_LOW]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_LOW);
     vmaxps(jmm_src, jmm_src, jmm_tmp);
     // express exp(x) as exp(g + n*log(2))
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_LOG2EF]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_LOG2EF);
     vmulps(jmm_fx, jmm_src, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_0P5);
     vaddps(jmm_fx, jmm_fx, jmm_tmp);
-    vroundps(jmm_fy, jmm_fx, 0x01);
-    // if greater, substract 1
-    vcmpgtps(jmm_mask, jmm_fy, jmm_fx);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global]);
-    vandps(jmm_mask, jmm_mask, jmm_tmp);
-    vsubps(jmm_fx, jmm_fy, jmm_mask);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_C1]);
+    if (std::is_same<JMM, zmm_t>::value) {
+      // floor, which needs no correction
+      vrndscaleps(jmm_fx, jmm_fx, 0x01);
+    } else {
+      vroundps(jmm_fy, jmm_fx, 0x01);
+      // if greater, substract 1
+      vcmpgtps(jmm_mask, jmm_fy, jmm_fx);
+      vmovaps(jmm_tmp, ptr[reg_ptr_global]);
+      vandps(jmm_mask, jmm_mask, jmm_tmp);
+      vsubps(jmm_fx, jmm_fy, jmm_mask);
+    }
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_C1);
     vmulps(jmm_fy, jmm_fx, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_C2]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_C2);
     JMM ymm_z = JMM(jmm_mask.getIdx());
     vmulps(ymm_z, jmm_fx, jmm_tmp);
     vsubps(jmm_src, jmm_src, jmm_fy);
     vsubps(jmm_src, jmm_src, ymm_z);
     vmulps(ymm_z, jmm_src, jmm_src);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_P0]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_P0);
     vmulps(dst, jmm_src, jmm_tmp);
     for (size_t i = OFFSET_EXP_P1; i < OFFSET_EXP_P5;
          i += (YMM_FLOAT_BLOCK * sizeof(float))) {
-      vmovaps(jmm_tmp, ptr[reg_ptr_global + i]);  // P1~P4
+      load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, i);  // P1~P4
       vaddps(dst, dst, jmm_tmp);
       vmulps(dst, dst, jmm_src);
     }
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_P5]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_P5);
     vaddps(dst, dst, jmm_tmp);
     vmulps(dst, dst, ymm_z);
     vaddps(dst, dst, jmm_src);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_ONE);
     vaddps(dst, dst, jmm_tmp);
     // build 2^n
     JMM ymm_int = jmm_fx;
     vcvttps2dq(ymm_int, jmm_fx);
     mov(reg_ptr_global, reinterpret_cast<size_t>(exp_int_0x7f));
-    vmovdqa(jmm_tmp, ptr[reg_ptr_global]);
+    if (std::is_same<JMM, zmm_t>::value) {
+      vpbroadcastd(jmm_tmp, ptr[reg_ptr_global]);
+    } else {
+      vmovdqa(jmm_tmp, ptr[reg_ptr_global]);
+    }
     if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx2) ||
-        std::is_same<JMM, xmm_t>::value) {
+        !std::is_same<JMM, ymm_t>::value) {
       vpaddd(ymm_int, ymm_int, jmm_tmp);
       vpslld(ymm_int, ymm_int, 23);
     } else if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
@@ -173,7 +193,7 @@ class VActFunc : public JitCode {
     pop(reg_ptr_global);
   }
 
-  // compute SIGMOID with ymm, xmm
+  // compute SIGMOID with zmm, ymm, xmm
   template <typename JMM>
   void sigmoid_jmm(JMM& dst,          // NOLINT
                    JMM& src,          // NOLINT
@@ -189,20 +209,20 @@ class VActFunc : public JitCode {
     push(reg_ptr_global);
     vmovaps(jmm_src, src);
     mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_SIGMOID_MAX]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_SIGMOID_MAX);
     vminps(jmm_src, jmm_src, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_SIGMOID_MIN]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_SIGMOID_MIN);
     vmaxps(jmm_src, jmm_src, jmm_tmp);
     vxorps(jmm_tmp, jmm_tmp, jmm_tmp);
     vsubps(jmm_src, jmm_tmp, jmm_src);
     exp_jmm<JMM>(dst, jmm_src, src_idx, fx_idx, fy_idx, mask_idx, tmp_idx);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_ONE);
     vaddps(dst, dst, jmm_tmp);
     vdivps(dst, jmm_tmp, dst);
     pop(reg_ptr_global);
   }
 
-  // compute TANH with ymm, xmm
+  // compute TANH with zmm, ymm, xmm
   template <typename JMM>
   void tanh_jmm(JMM& dst,          // NOLINT
                 JMM& src,          // NOLINT
@@ -219,21 +239,21 @@ class VActFunc : public JitCode {
     push(reg_ptr_global);
     vmovaps(jmm_src, src);
     mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_TWO);
     vxorps(jmm_zero, jmm_zero, jmm_zero);
     vsubps(jmm_tmp, jmm_zero, jmm_tmp);
     vmulps(jmm_src, jmm_src, jmm_tmp);
     exp_jmm<JMM>(dst, jmm_src, src_idx, fx_idx, fy_idx, mask_idx, tmp_idx);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_ONE);
     vaddps(dst, dst, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_TWO);
     vdivps(dst, jmm_tmp, dst);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    load_const_jmm<JMM>(jmm_tmp, reg_ptr_global, OFFSET_EXP_ONE);
     vsubps(dst, dst, jmm_tmp);
     pop(reg_ptr_global);
   }
 
-  // compute IDENTITY with ymm, xmm
+  // compute IDENTITY with zmm, ymm, xmm
   template <typename JMM>
   void identity_jmm(JMM& dst, JMM& src, int zero_idx) {  // NOLINT
     JMM zero = JMM(zero_idx);
@@ -318,6 +338,9 @@ class VActJitCode : public VActFunc {
   void genCode() override;
 
  protected:
+  // The code with zmm, whose tail is loaded and stored with a mask.
+  void genAVX512Code();
+
   int num_;
   operand_type type_;
   reg64_t param1{abi_param1};
@@ -325,9 +348,11 @@ class VActJitCode : public VActFunc {
 
   xmm_t xmm_src = xmm_t(0);
   ymm_t ymm_src = ymm_t(0);
+  zmm_t zmm_src = zmm_t(0);
 
   xmm_t xmm_dst = xmm_t(1);
   ymm_t ymm_dst = ymm_t(1);
+  zmm_t zmm_dst = zmm_t(1);
 };
 
 #define DECLARE_ACT_JITCODE(name, op_type)                                    \
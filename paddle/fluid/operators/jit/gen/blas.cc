@@ -24,6 +24,10 @@ namespace jit {
 namespace gen {
 
 void VXXJitCode::genCode() {
+  if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core)) {
+    genAVX512Code();
+    return;
+  }
   // do not need push stack, and do not need save avx512reg if do not use avx512
   int offset = 0;
   if (with_relu_) {
@@ -111,6 +115,49 @@ void VXXJitCode::genCode() {
   ret();
 }
 
+void VXXJitCode::genAVX512Code() {
+  int rest = num_ % ZMM_FLOAT_BLOCK;
+  if (rest > 0) {
+    mov(eax, (1 << rest) - 1);
+    kmovw(k1, eax);
+  }
+  if (with_relu_) {
+    vxorps(zmm_zero, zmm_zero, zmm_zero);
+  }
+  if (scalar_index_ == 1) {
+    vbroadcastss(zmm_src1, ptr[param1]);
+  } else if (scalar_index_ == 2) {
+    vbroadcastss(zmm_src2, ptr[param2]);
+  }
+  int blocks = (num_ + ZMM_FLOAT_BLOCK - 1) / ZMM_FLOAT_BLOCK;
+  for (int i = 0; i < blocks; ++i) {
+    int offset = sizeof(float) * ZMM_FLOAT_BLOCK * i;
+    bool tail = rest > 0 && i == blocks - 1;
+    if (scalar_index_ != 1) {
+      vmovups(tail ? zmm_src1 | k1 | T_z : zmm_src1, ptr[param1 + offset]);
+    }
+    if (scalar_index_ != 2) {
+      vmovups(tail ? zmm_src2 | k1 | T_z : zmm_src2, ptr[param2 + offset]);
+    }
+    if (type_ == operand_type::MUL) {
+      vmulps(zmm_dst, zmm_src1, zmm_src2);
+    } else if (type_ == operand_type::ADD) {
+      vaddps(zmm_dst, zmm_src1, zmm_src2);
+    } else if (type_ == operand_type::SUB) {
+      vsubps(zmm_dst, zmm_src1, zmm_src2);
+    }
+    if (with_relu_) {
+      vmaxps(zmm_dst, zmm_zero, zmm_dst);
+    }
+    if (tail) {
+      vmovups(ptr[param3 + offset] | k1, zmm_dst);
+    } else {
+      vmovups(ptr[param3 + offset], zmm_dst);
+    }
+  }
+  ret();
+}
+
 void NCHW16CMulNCJitCode::genCode() {
   // RDI is ptr x_input
   // RSI is ptr y_input
@@ -26,10 +26,24 @@ namespace jit {
 namespace gen {
 
 void EmbSeqPoolJitCode::genCode() {
+  if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core)) {
+    genPoolCode<zmm_t>(ZMM_FLOAT_BLOCK);
+  } else {
+    genPoolCode<ymm_t>(YMM_FLOAT_BLOCK);
+  }
+}
+
+template <typename JMM>
+void EmbSeqPoolJitCode::genPoolCode(int block) {
   preCode();
-  constexpr int block = YMM_FLOAT_BLOCK;
   constexpr int max_num_regs = 8;
-  const int num_block = tbl_w_ / block;
+  // the rest width is only left with zmm, and is loaded and saved with the
+  // opmask k1 in the last block
+  const int rest = tbl_w_ % block;
+  const int num_block = (tbl_w_ + block - 1) / block;
+  auto is_tail = [&](int block_i) {
+    return rest > 0 && block_i == num_block - 1;
+  };
   const int num_groups = num_block / max_num_regs;
   const size_t block_size = sizeof(float) * block;
   std::vector<int> groups(num_groups, max_num_regs);
@@ -38,6 +52,11 @@ void EmbSeqPoolJitCode::genCode() {
     groups.push_back(rest_num_regs);
   }
 
+  if (rest > 0) {
+    mov(eax, (1 << rest) - 1);
+    kmovw(k1, eax);
+  }
+
   // protect param_dst
   mov(reg_ptr_param_dst, param_dst);
   mov(reg_idx_width_in_byte,
@@ -67,7 +86,12 @@ void EmbSeqPoolJitCode::genCode() {
       add(reg_ptr_tbl_i, param_tbl);  // reg is ptr_i now
       size_t w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ymm_t(reg_i + num_regs), ptr[reg_ptr_tbl_i + w_offset]);
+        if (is_tail(acc_num_regs + reg_i)) {
+          vmovups(JMM(reg_i + num_regs) | k1 | T_z,
+                  ptr[reg_ptr_tbl_i + w_offset]);
+        } else {
+          vmovups(JMM(reg_i + num_regs), ptr[reg_ptr_tbl_i + w_offset]);
+        }
         w_offset += block_size;
       }
       add(reg_ptr_idx_i, reg_idx_width_in_byte);
@@ -92,9 +116,12 @@ void EmbSeqPoolJitCode::genCode() {
         add(reg_ptr_tbl_i, param_tbl);
         size_t w_offset = 0;
         for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-          vmovups(ymm_t(reg_i), ptr[reg_ptr_tbl_i + w_offset]);
-          vaddps(
-              ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs), ymm_t(reg_i));
+          if (is_tail(acc_num_regs + reg_i)) {
+            vmovups(JMM(reg_i) | k1 | T_z, ptr[reg_ptr_tbl_i + w_offset]);
+          } else {
+            vmovups(JMM(reg_i), ptr[reg_ptr_tbl_i + w_offset]);
+          }
+          vaddps(JMM(reg_i + num_regs), JMM(reg_i + num_regs), JMM(reg_i));
           w_offset += block_size;
         }
         add(reg_ptr_idx_i, reg_idx_width_in_byte);
@@ -105,7 +132,11 @@ void EmbSeqPoolJitCode::genCode() {
       // avg or sqrt here, if needed
       w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i + num_regs));
+        if (is_tail(acc_num_regs + reg_i)) {
+          vmovups(ptr[reg_ptr_dst_i + w_offset] | k1, JMM(reg_i + num_regs));
+        } else {
+          vmovups(ptr[reg_ptr_dst_i + w_offset], JMM(reg_i + num_regs));
+        }
         w_offset += block_size;
       }
       add(reg_ptr_dst_i, tbl_width_in_byte);
@@ -123,11 +154,14 @@ void EmbSeqPoolJitCode::genCode() {
 class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
  public:
   bool CanBeUsed(const emb_seq_pool_attr_t& attr) const override {
-    return phi::backends::cpu::MayIUse(phi::backends::cpu::avx) &&
-           attr.table_width % YMM_FLOAT_BLOCK == 0;
+    return phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core) ||
+           (phi::backends::cpu::MayIUse(phi::backends::cpu::avx) &&
+            attr.table_width % YMM_FLOAT_BLOCK == 0);
   }
   size_t CodeSize(const emb_seq_pool_attr_t& attr) const override {
-    return 96 + (attr.table_width / YMM_FLOAT_BLOCK) * 96 * 8;
+    return 96 +
+           ((attr.table_width + YMM_FLOAT_BLOCK - 1) / YMM_FLOAT_BLOCK) * 96 *
+               8;
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const emb_seq_pool_attr_t& attr) const override {
@@ -55,6 +55,9 @@ class EmbSeqPoolJitCode : public JitCode {
   void genCode() override;
 
  private:
+  template <typename JMM>
+  void genPoolCode(int block);
+
   int tbl_w_;
   SeqPoolType type_;
   reg64_t param_tbl{abi_param1};
@@ -26,63 +26,94 @@ namespace jit {
 namespace gen {
 
 void GRUJitCode::genCode() {
-  reg64_t reg_ptr_gates = rax;
-  reg64_t reg_ptr_ht_1 = r9;
-  reg64_t reg_ptr_ht = r10;
+  bool use_zmm = phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core);
+  int rest = num_ % ZMM_FLOAT_BLOCK;
+  if (use_zmm && rest > 0) {
+    mov(eax, (1 << rest) - 1);
+    kmovw(k1, eax);
+  }
   mov(reg_ptr_gates, ptr[param1 + offsetof(gru_t, gates)]);
   mov(reg_ptr_ht_1, ptr[param1 + offsetof(gru_t, ht_1)]);
   mov(reg_ptr_ht, ptr[param1 + offsetof(gru_t, ht)]);
-  ymm_t ymm_one = ymm_t(0);
 
   if (id_ == 2) {
     reg64_t reg_ptr_tmp = r11;
     mov(reg_ptr_tmp, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(ymm_one, ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
-  }
-  int offset = 0;
-  int d = num_ * sizeof(float);
-  for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
-    ymm_t ymm_u = ymm_t(1);
-    ymm_t ymm_r = ymm_t(2);
-    ymm_t ymm_s = ymm_t(3);
-    ymm_t ymm_ht_1 = ymm_t(4);
-    // W: {W_update, W_reset; W_state}
-    if (id_ == 0 || id_ == 2) {
-      vmovups(ymm_u, ptr[reg_ptr_gates + offset]);
-      vmovups(ymm_s, ptr[reg_ptr_gates + offset + 2 * d]);
+    if (use_zmm) {
+      vbroadcastss(zmm_t(0), ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    } else {
+      vmovaps(ymm_t(0), ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
     }
-    if (id_ == 1) {
-      vmovups(ymm_r, ptr[reg_ptr_gates + offset + d]);
+  }
+  if (use_zmm) {
+    int blocks = (num_ + ZMM_FLOAT_BLOCK - 1) / ZMM_FLOAT_BLOCK;
+    for (int i = 0; i < blocks; ++i) {
+      genBlock<zmm_t>(sizeof(float) * ZMM_FLOAT_BLOCK * i,
+                      rest > 0 && i == blocks - 1);
     }
-    if (id_ == 1 || id_ == 2) {
-      vmovups(ymm_ht_1, ptr[reg_ptr_ht_1 + offset]);
+  } else {
+    for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
+      genBlock<ymm_t>(sizeof(float) * YMM_FLOAT_BLOCK * i, false);
     }
+  }
+  ret();
+}
 
-    if (id_ == 0) {
-      // ht = act_gate(u) * act_cand(s)
-      act<ymm_t>(ymm_u, ymm_u, act_gate_);
-      act<ymm_t>(ymm_s, ymm_s, act_cand_);
-      vmulps(ymm_s, ymm_s, ymm_u);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_s);
-    } else if (id_ == 1) {
-      // ht = act_gate(r) * ht_1
-      act<ymm_t>(ymm_r, ymm_r, act_gate_);
-      vmulps(ymm_r, ymm_r, ymm_ht_1);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_r);
-    } else if (id_ == 2) {
-      // ht = act_gate(u) * act_cand(s) + (1-act_gate(u)) * ht_1
-      ymm_t ymm_one_inner = ymm_t(ymm_one.getIdx());
-      act<ymm_t>(ymm_u, ymm_u, act_gate_);
-      act<ymm_t>(ymm_s, ymm_s, act_cand_);
-      vmulps(ymm_s, ymm_s, ymm_u);
-      vsubps(ymm_u, ymm_one_inner, ymm_u);
-      vmulps(ymm_u, ymm_ht_1, ymm_u);
-      vaddps(ymm_u, ymm_s, ymm_u);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_u);
+template <typename JMM>
+void GRUJitCode::genBlock(int offset, bool tail) {
+  auto load = [&](const JMM& dst, const Xbyak::Address& src) {
+    if (tail) {
+      vmovups(dst | k1 | T_z, src);
+    } else {
+      vmovups(dst, src);
     }
-    offset += sizeof(float) * YMM_FLOAT_BLOCK;
+  };
+  auto store = [&](const Xbyak::Address& dst, const JMM& src) {
+    if (tail) {
+      vmovups(dst | k1, src);
+    } else {
+      vmovups(dst, src);
+    }
+  };
+  int d = num_ * sizeof(float);
+  JMM jmm_one = JMM(0);
+  JMM jmm_u = JMM(1);
+  JMM jmm_r = JMM(2);
+  JMM jmm_s = JMM(3);
+  JMM jmm_ht_1 = JMM(4);
+  // W: {W_update, W_reset; W_state}
+  if (id_ == 0 || id_ == 2) {
+    load(jmm_u, ptr[reg_ptr_gates + offset]);
+    load(jmm_s, ptr[reg_ptr_gates + offset + 2 * d]);
+  }
+  if (id_ == 1) {
+    load(jmm_r, ptr[reg_ptr_gates + offset + d]);
+  }
+  if (id_ == 1 || id_ == 2) {
+    load(jmm_ht_1, ptr[reg_ptr_ht_1 + offset]);
+  }
+
+  if (id_ == 0) {
+    // ht = act_gate(u) * act_cand(s)
+    act<JMM>(jmm_u, jmm_u, act_gate_);
+    act<JMM>(jmm_s, jmm_s, act_cand_);
+    vmulps(jmm_s, jmm_s, jmm_u);
+    store(ptr[reg_ptr_ht + offset], jmm_s);
+  } else if (id_ == 1) {
+    // ht = act_gate(r) * ht_1
+    act<JMM>(jmm_r, jmm_r, act_gate_);
+    vmulps(jmm_r, jmm_r, jmm_ht_1);
+    store(ptr[reg_ptr_ht + offset], jmm_r);
+  } else if (id_ == 2) {
+    // ht = act_gate(u) * act_cand(s) + (1-act_gate(u)) * ht_1
+    act<JMM>(jmm_u, jmm_u, act_gate_);
+    act<JMM>(jmm_s, jmm_s, act_cand_);
+    vmulps(jmm_s, jmm_s, jmm_u);
+    vsubps(jmm_u, jmm_one, jmm_u);
+    vmulps(jmm_u, jmm_ht_1, jmm_u);
+    vaddps(jmm_u, jmm_s, jmm_u);
+    store(ptr[reg_ptr_ht + offset], jmm_u);
   }
-  ret();
 }
 
 #define DECLARE_GRU_CREATOR(name)                                    \
@@ -90,11 +121,13 @@ void GRUJitCode::genCode() {
    public:                                                           \
     /* TODO(TJ): enable more */                                      \
     bool CanBeUsed(const gru_attr_t& attr) const override {          \
-      return phi::backends::cpu::MayIUse(phi::backends::cpu::avx) && \
-             attr.d % 8 == 0;                                        \
+      return phi::backends::cpu::MayIUse(                            \
+                 phi::backends::cpu::avx512_core) ||                 \
+             (attr.d % 8 == 0 &&                                     \
+              phi::backends::cpu::MayIUse(phi::backends::cpu::avx)); \
     }                                                                \
     size_t CodeSize(const gru_attr_t& attr) const override {         \
-      return 96 + attr.d / YMM_FLOAT_BLOCK * 96 * 2 * 8;             \
+      return 96 + (attr.d / YMM_FLOAT_BLOCK + 1) * 96 * 2 * 8;       \
     }                                                                \
     std::unique_ptr<GenBase> CreateJitCode(                          \
         const gru_attr_t& attr) const override {                     \
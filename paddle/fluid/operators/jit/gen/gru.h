@@ -90,11 +90,19 @@ class GRUJitCode : public VActFunc {
   void genCode() override;
 
  protected:
+  // Computes ht of the block at offset, where the tail block is loaded and
+  // stored with the mask k1.
+  template <typename JMM>
+  void genBlock(int offset, bool tail);
+
   int id_;
   int num_;
   operand_type act_gate_;
   operand_type act_cand_;
   reg64_t param1{abi_param1};
+  reg64_t reg_ptr_gates{rax};
+  reg64_t reg_ptr_ht_1{r9};
+  reg64_t reg_ptr_ht{r10};
 };
 
 #define DECLARE_GRU_JITCODE(name, id)                  \
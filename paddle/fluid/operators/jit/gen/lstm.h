@@ -94,6 +94,11 @@ class LSTMJitCode : public VActFunc {
   void genCode() override;
 
  protected:
+  // Computes ct and ht of the block at offset, where the tail block is loaded
+  // and stored with the mask k1.
+  template <typename JMM>
+  void genBlock(int offset, bool tail);
+
   int num_;
   bool compute_c1h1_;
   bool use_peephole_;
@@ -101,6 +106,11 @@ class LSTMJitCode : public VActFunc {
   operand_type act_cand_;
   operand_type act_cell_;
   reg64_t param1{abi_param1};
+  reg64_t reg_ptr_gates{rax};
+  reg64_t reg_ptr_ct_1{r9};
+  reg64_t reg_ptr_ct{r10};
+  reg64_t reg_ptr_ht{r11};
+  reg64_t reg_ptr_wp{r12};
 };
 
 #define DECLARE_LSTM_JITCODE(name, compute_c1h1)                  \
@@ -16,6 +16,8 @@
 
 #include <stddef.h>  // offsetof
 
+#include <algorithm>
+
 #include "paddle/fluid/operators/jit/registry.h"
 #include "paddle/phi/backends/cpu/cpu_info.h"
 
@@ -107,14 +109,425 @@ void MatMulJitCode::genCode() {
   postCode();
 }
 
+// The vpermw index of MatMulBF16JitCodeBase::convertPairs
+alignas(64) static const uint16_t bf16_pair_index[32] = {
+    0, 16, 1, 17, 2,  18, 3,  19, 4,  20, 5,  21, 6,  22, 7,  23,
+    8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31};
+
+// The palette 1 with 16 rows of 64 bytes in each of tmm0-tmm7
+alignas(64) static const uint8_t amx_tile_config[64] = {
+    1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    64, 0,  64, 0,  64, 0,  64, 0,  64, 0,  64, 0,  64, 0,  64, 0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    16, 16, 16, 16, 16, 16, 16, 16, 0,  0,  0,  0,  0,  0,  0,  0};
+
+void MatMulBF16JitCodeBase::allocBuffer(int size) {
+  mov(rbx, rsp);
+  sub(rsp, size);
+  and_(rsp, -64);
+  for (int offset = 4096; offset < size; offset += 4096) {
+    mov(dword[rbx - offset], eax);
+  }
+  mov(dword[rsp], eax);
+}
+
+void MatMulBF16JitCodeBase::setTailMasks() {
+  int n_rest = n_ % ZMM_FLOAT_BLOCK;
+  if (n_rest > 0) {
+    mov(eax, (1 << n_rest) - 1);
+    kmovw(k1, eax);
+  }
+  int k_rest = k_ % 32;
+  int lo = std::min(k_rest, ZMM_FLOAT_BLOCK);
+  int hi = k_rest - lo;
+  if (lo > 0 && lo < ZMM_FLOAT_BLOCK) {
+    mov(eax, (1 << lo) - 1);
+    kmovw(k2, eax);
+  }
+  if (hi > 0 && hi < ZMM_FLOAT_BLOCK) {
+    mov(eax, (1 << hi) - 1);
+    kmovw(k3, eax);
+  }
+}
+
+void MatMulBF16JitCodeBase::convertRows(reg64_t& reg_src,
+                                        reg64_t& reg_dst,
+                                        reg64_t& reg_cnt,
+                                        int rows,
+                                        int dst_stride) {
+  auto load = [&](const zmm_t& dst, int valid, int offset, opmask_t& mask) {
+    if (valid == ZMM_FLOAT_BLOCK) {
+      vmovups(dst, ptr[reg_src + offset]);
+    } else if (valid > 0) {
+      vmovups(dst | mask | T_z, ptr[reg_src + offset]);
+    } else {
+      vxorps(dst, dst, dst);
+    }
+  };
+  Label l_next_row;
+  mov(reg_cnt, rows);
+  L(l_next_row);
+  for (int c = 0; c < kpad_ / 32; ++c) {
+    int valid = std::min(32, k_ - 32 * c);
+    int lo = std::min(valid, ZMM_FLOAT_BLOCK);
+    load(zmm_tmp0, lo, c * 32 * sizeof(float), k2);
+    load(zmm_tmp1, valid - lo, (c * 32 + 16) * sizeof(float), k3);
+    vcvtne2ps2bf16(zmm_tmp0, zmm_tmp1, zmm_tmp0);
+    vmovups(ptr[reg_dst + c * 64], zmm_tmp0);
+  }
+  add(reg_src, k_ * sizeof(float));
+  add(reg_dst, dst_stride);
+  dec(reg_cnt);
+  jnz(l_next_row, T_NEAR);
+}
+
+void MatMulBF16JitCodeBase::convertPairs(const zmm_t& dst,
+                                         const Xbyak::Address& row0,
+                                         const Xbyak::Address& row1,
+                                         bool has_row1,
+                                         bool tail) {
+  if (tail) {
+    vmovups(zmm_tmp0 | k1 | T_z, row0);
+  } else {
+    vmovups(zmm_tmp0, row0);
+  }
+  if (!has_row1) {
+    vxorps(zmm_tmp1, zmm_tmp1, zmm_tmp1);
+  } else if (tail) {
+    vmovups(zmm_tmp1 | k1 | T_z, row1);
+  } else {
+    vmovups(zmm_tmp1, row1);
+  }
+  // row0 in the low 16 words, row1 in the high ones
+  vcvtne2ps2bf16(dst, zmm_tmp1, zmm_tmp0);
+  vpermw(dst, zmm_idx, dst);
+}
+
+void MatMulBF16JitCode::genCode() {
+  preCode();
+  setTailMasks();
+  mov(reg_tmp, reinterpret_cast<size_t>(bf16_pair_index));
+  vmovups(zmm_idx, ptr[reg_tmp]);
+  allocBuffer(kRows * kpad_ * 2);
+  int blocks = m_ / kRows;
+  if (blocks > 0) {
+    Label l_next_rows;
+    mov(reg_iter_m, blocks);
+    L(l_next_rows);
+    genRows(kRows);
+    add(param_x, kRows * k_ * sizeof(float));
+    add(param_z, kRows * n_ * sizeof(float));
+    dec(reg_iter_m);
+    jnz(l_next_rows, T_NEAR);
+  }
+  if (m_ % kRows > 0) {
+    genRows(m_ % kRows);
+  }
+  freeBuffer();
+  postCode();
+}
+
+void MatMulBF16JitCode::genRows(int rows) {
+  mov(reg_cvt_src, param_x);
+  mov(reg_cvt_dst, rsp);
+  convertRows(reg_cvt_src, reg_cvt_dst, reg_cvt_cnt, rows, kpad_ * 2);
+  const int group = kBlocks * ZMM_FLOAT_BLOCK;
+  int col = 0;
+  for (; col + group <= n_; col += group) {
+    genColumns(rows, col, kBlocks, false);
+  }
+  int rest = n_ - col;
+  if (rest > 0) {
+    genColumns(rows,
+               col,
+               (rest + ZMM_FLOAT_BLOCK - 1) / ZMM_FLOAT_BLOCK,
+               rest % ZMM_FLOAT_BLOCK != 0);
+  }
+}
+
+void MatMulBF16JitCode::genColumns(int rows, int col, int blocks, bool tail) {
+  // z of row r and block b in zmm(r * kBlocks + b), y in zmm(24 + b)
+  auto acc = [](int r, int b) { return zmm_t(r * kBlocks + b); };
+  const int y_idx = kRows * kBlocks;
+  const int row_bytes = n_ * sizeof(float);
+  for (int r = 0; r < rows; ++r) {
+    for (int b = 0; b < blocks; ++b) {
+      vxorps(acc(r, b), acc(r, b), acc(r, b));
+    }
+  }
+  auto pairs = [&](bool has_row1) {
+    for (int b = 0; b < blocks; ++b) {
+      int offset = b * ZMM_FLOAT_BLOCK * sizeof(float);
+      convertPairs(zmm_t(y_idx + b),
+                   ptr[reg_b + offset],
+                   ptr[reg_b + row_bytes + offset],
+                   has_row1,
+                   tail && b == blocks - 1);
+    }
+    for (int r = 0; r < rows; ++r) {
+      for (int b = 0; b < blocks; ++b) {
+        vdpbf16ps(
+            acc(r, b), zmm_t(y_idx + b), zword_b[reg_a + r * kpad_ * 2]);
+      }
+    }
+  };
+  mov(reg_a, rsp);
+  lea(reg_b, ptr[param_y + col * sizeof(float)]);
+  if (k_ / 2 > 0) {
+    Label l_next_pair;
+    mov(reg_iter_k, k_ / 2);
+    L(l_next_pair);
+    pairs(true);
+    add(reg_a, 2 * sizeof(int16_t));
+    add(reg_b, 2 * row_bytes);
+    dec(reg_iter_k);
+    jnz(l_next_pair, T_NEAR);
+  }
+  if (k_ % 2 != 0) {
+    pairs(false);
+  }
+  for (int r = 0; r < rows; ++r) {
+    for (int b = 0; b < blocks; ++b) {
+      int offset = r * row_bytes + (col + b * ZMM_FLOAT_BLOCK) * sizeof(float);
+      if (tail && b == blocks - 1) {
+        vmovups(ptr[param_z + offset] | k1, acc(r, b));
+      } else {
+        vmovups(ptr[param_z + offset], acc(r, b));
+      }
+    }
+  }
+}
+
+void MatMulAMXJitCode::vex0F38(int pp, int reg, int base, int index, int vvvv) {
+  db(0xC4);
+  db((((~reg >> 3) & 1) << 7) | (((~index >> 3) & 1) << 6) |
+     (((~base >> 3) & 1) << 5) | 0x02);
+  db(((~vvvv & 0xF) << 3) | pp);
+}
+
+void MatMulAMXJitCode::amxMem(int pp,
+                              int opcode,
+                              int tmm,
+                              const Xbyak::Reg64& base,
+                              const Xbyak::Reg64* index,
+                              int disp) {
+  int b = base.getIdx();
+  int x = index ? index->getIdx() : 0;
+  vex0F38(pp, tmm, b, x, 0);
+  db(opcode);
+  int mod = 2;
+  if (disp == 0 && (b & 7) != 5) {
+    mod = 0;
+  } else if (disp >= -128 && disp <= 127) {
+    mod = 1;
+  }
+  // always with a SIB byte, whose index 100 means none
+  db((mod << 6) | ((tmm & 7) << 3) | 4);
+  db(((index ? (x & 7) : 4) << 3) | (b & 7));
+  if (mod == 1) {
+    db(disp & 0xFF);
+  } else if (mod == 2) {
+    for (int i = 0; i < 4; ++i) {
+      db((disp >> (8 * i)) & 0xFF);
+    }
+  }
+}
+
+void MatMulAMXJitCode::ldtilecfg(const Xbyak::Reg64& base) {
+  amxMem(0, 0x49, 0, base, nullptr, 0);
+}
+
+void MatMulAMXJitCode::tilerelease() {
+  vex0F38(0, 0, 0, 0, 0);
+  db(0x49);
+  db(0xC0);
+}
+
+void MatMulAMXJitCode::tilezero(int tmm) {
+  vex0F38(3, tmm, 0, 0, 0);
+  db(0x49);
+  db(0xC0 | (tmm << 3));
+}
+
+void MatMulAMXJitCode::tileloadd(int tmm,
+                                 const Xbyak::Reg64& base,
+                                 const Xbyak::Reg64& stride,
+                                 int disp) {
+  amxMem(3, 0x4B, tmm, base, &stride, disp);
+}
+
+void MatMulAMXJitCode::tilestored(const Xbyak::Reg64& base,
+                                  const Xbyak::Reg64& stride,
+                                  int disp,
+                                  int tmm) {
+  amxMem(2, 0x4B, tmm, base, &stride, disp);
+}
+
+void MatMulAMXJitCode::tdpbf16ps(int dst, int a, int b) {
+  vex0F38(2, dst, a, 0, b);
+  db(0x5C);
+  db(0xC0 | (dst << 3) | a);
+}
+
+void MatMulAMXJitCode::genCode() {
+  preCode();
+  setTailMasks();
+  mov(reg_tmp, reinterpret_cast<size_t>(bf16_pair_index));
+  vmovups(zmm_idx, ptr[reg_tmp]);
+  // x, then 2 tiles of y and a tile of z
+  allocBuffer(a_size() + 3 * 1024);
+  mov(reg_tmp, reinterpret_cast<size_t>(amx_tile_config));
+  ldtilecfg(reg_tmp);
+  mov(reg_stride_a, a_stride());
+  mov(reg_stride_b, 64);
+  mov(reg_stride_z, n_ * sizeof(float));
+  int blocks = m_ / 32;
+  if (blocks > 0) {
+    Label l_next_rows;
+    mov(reg_iter_m, blocks);
+    L(l_next_rows);
+    genRows(32);
+    add(param_x, 32 * k_ * sizeof(float));
+    add(param_z, 32 * n_ * sizeof(float));
+    dec(reg_iter_m);
+    jnz(l_next_rows, T_NEAR);
+  }
+  if (m_ % 32 > 0) {
+    genRows(m_ % 32);
+  }
+  tilerelease();
+  freeBuffer();
+  postCode();
+}
+
+void MatMulAMXJitCode::genRows(int rows) {
+  mov(reg_b, param_x);
+  mov(reg_a, rsp);
+  convertRows(reg_b, reg_a, reg_iter_k, rows, a_stride());
+  mov(reg_col_y, param_y);
+  mov(reg_col_z, param_z);
+  int groups = n_ / 32;
+  if (groups > 0) {
+    Label l_next_cols;
+    mov(reg_iter_n, groups);
+    L(l_next_cols);
+    genColumns(rows, 2, false);
+    add(reg_col_y, 32 * sizeof(float));
+    add(reg_col_z, 32 * sizeof(float));
+    dec(reg_iter_n);
+    jnz(l_next_cols, T_NEAR);
+  }
+  int rest = n_ % 32;
+  if (rest > 0) {
+    genColumns(rows,
+               (rest + ZMM_FLOAT_BLOCK - 1) / ZMM_FLOAT_BLOCK,
+               rest % ZMM_FLOAT_BLOCK != 0);
+  }
+}
+
+void MatMulAMXJitCode::genColumns(int rows, int tiles, bool tail) {
+  int row_tiles = (rows + 15) / 16;
+  for (int i = 0; i < row_tiles; ++i) {
+    for (int j = 0; j < tiles; ++j) {
+      tilezero(2 * i + j);
+    }
+  }
+  mov(reg_a, rsp);
+  mov(reg_b, reg_col_y);
+  if (k_ / 32 > 0) {
+    Label l_next_chunk;
+    mov(reg_iter_k, k_ / 32);
+    L(l_next_chunk);
+    genChunk(rows, tiles, tail, 32);
+    dec(reg_iter_k);
+    jnz(l_next_chunk, T_NEAR);
+  }
+  if (k_ % 32 > 0) {
+    genChunk(rows, tiles, tail, k_ % 32);
+  }
+  const int row_bytes = n_ * sizeof(float);
+  for (int i = 0; i < row_tiles; ++i) {
+    for (int j = 0; j < tiles; ++j) {
+      int valid_rows = std::min(16, rows - 16 * i);
+      bool tail_cols = tail && j == tiles - 1;
+      int offset = 16 * i * row_bytes + j * 64;
+      if (valid_rows == 16 && !tail_cols) {
+        tilestored(reg_col_z, reg_stride_z, offset, 2 * i + j);
+        continue;
+      }
+      // through the buffer of z, for the rows and columns out of z
+      lea(reg_tmp, ptr[rsp + a_size() + 2 * 1024]);
+      tilestored(reg_tmp, reg_stride_b, 0, 2 * i + j);
+      for (int r = 0; r < valid_rows; ++r) {
+        vmovups(zmm_tmp0, ptr[reg_tmp + r * 64]);
+        if (tail_cols) {
+          vmovups(ptr[reg_col_z + offset + r * row_bytes] | k1, zmm_tmp0);
+        } else {
+          vmovups(ptr[reg_col_z + offset + r * row_bytes], zmm_tmp0);
+        }
+      }
+    }
+  }
+}
+
+void MatMulAMXJitCode::genChunk(int rows, int tiles, bool tail, int valid_k) {
+  const int row_bytes = n_ * sizeof(float);
+  // convert the 32 rows of y into the VNNI layout of tmm6 and tmm7
+  lea(reg_tmp, ptr[rsp + a_size()]);
+  for (int j = 0; j < tiles; ++j) {
+    for (int p = 0; p < 16; ++p) {
+      zmm_t dst = zmm_t(p % 8);
+      int k0 = 2 * p;
+      if (k0 >= valid_k) {
+        vxorps(dst, dst, dst);
+      } else {
+        convertPairs(dst,
+                     ptr[reg_b + k0 * row_bytes + j * 64],
+                     ptr[reg_b + (k0 + 1) * row_bytes + j * 64],
+                     k0 + 1 < valid_k,
+                     tail && j == tiles - 1);
+      }
+      vmovups(ptr[reg_tmp + j * 1024 + p * 64], dst);
+    }
+  }
+  int row_tiles = (rows + 15) / 16;
+  for (int i = 0; i < row_tiles; ++i) {
+    tileloadd(4 + i, reg_a, reg_stride_a, 16 * i * a_stride());
+  }
+  for (int j = 0; j < tiles; ++j) {
+    tileloadd(6 + j, reg_tmp, reg_stride_b, j * 1024);
+  }
+  for (int i = 0; i < row_tiles; ++i) {
+    for (int j = 0; j < tiles; ++j) {
+      tdpbf16ps(2 * i + j, 4 + i, 6 + j);
+    }
+  }
+  add(reg_a, 64);
+  add(reg_b, 32 * row_bytes);
+}
+
 class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
  public:
   bool CanBeUsed(const matmul_attr_t& attr) const override {
+    if (attr.bf16) {
+      return phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core) &&
+             phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_bf16) &&
+             attr.k <= 2048;
+    }
     return attr.m == 1 &&
            phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f) &&
            attr.n % ZMM_FLOAT_BLOCK == 0 && attr.k < 512;
   }
   size_t CodeSize(const matmul_attr_t& attr) const override {
+    if (attr.bf16) {
+      // up to 12 bytes for each instruction, and the rows and the columns
+      // are generated twice, for the loop and the tail
+      size_t rows = (attr.k + 31) / 32 * 4;
+      size_t cols = UseAMX(attr) ? 2 * (2 * 16 * 6 + 4 * 16 * 2 + 32)
+                                 : (attr.n / 64 + 1) *
+                                       (3 * 6 * 4 + 2 * 4 * 5 + 32);
+      return 1024 + 2 * 12 * (rows + 2 * cols);
+    }
     int block = YMM_FLOAT_BLOCK;
     if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f)) {
       block = ZMM_FLOAT_BLOCK;
@@ -144,8 +557,21 @@ class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
             "The attribute k (second matrix's col) of MatMul should "
             "be larger than 0. But it is %d.",
             attr.k));
+    if (attr.bf16) {
+      if (UseAMX(attr)) {
+        return make_unique<MatMulAMXJitCode>(attr, CodeSize(attr));
+      }
+      return make_unique<MatMulBF16JitCode>(attr, CodeSize(attr));
+    }
     return make_unique<MatMulJitCode>(attr, CodeSize(attr));
   }
+
+ private:
+  // The tiles have 16 rows, which are mostly wasted with less rows of x.
+  static bool UseAMX(const matmul_attr_t& attr) {
+    return attr.m >= 16 &&
+           phi::backends::cpu::MayIUse(phi::backends::cpu::amx_bf16);
+  }
 };
 
 }  // namespace gen
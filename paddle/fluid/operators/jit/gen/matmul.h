@@ -63,6 +63,162 @@ class MatMulJitCode : public JitCode {
   reg64_t reg_ptr_wgt{r10};
 };
 
+// The common part of the matmul jitcode of the matmul_attr_t with bf16 set,
+// which rounds x and y to bf16 when it reads them. The rows of x go to a
+// buffer on the stack first, each padded with zero to kpad_ bf16.
+class MatMulBF16JitCodeBase : public JitCode {
+ public:
+  explicit MatMulBF16JitCodeBase(const matmul_attr_t& attr,
+                                 size_t code_size,
+                                 void* code_ptr = nullptr)
+      : JitCode(code_size, code_ptr),
+        m_(attr.m),
+        n_(attr.n),
+        k_(attr.k),
+        kpad_((attr.k + 31) / 32 * 32) {}
+
+ protected:
+  // Moves rsp below a buffer of size bytes aligned to 64, keeping the old rsp
+  // in rbx. The pages are touched from the top, so none is skipped.
+  void allocBuffer(int size);
+  void freeBuffer() { mov(rsp, rbx); }
+  // Sets k1 to the tail of n, and k2, k3 to the tails of the two halves of
+  // the last 32 floats of a row of x.
+  void setTailMasks();
+  // Converts rows of x from reg_src on into bf16 rows of kpad_ at reg_dst,
+  // which are dst_stride bytes apart. reg_cnt is a scratch.
+  void convertRows(reg64_t& reg_src,  // NOLINT
+                   reg64_t& reg_dst,  // NOLINT
+                   reg64_t& reg_cnt,  // NOLINT
+                   int rows,
+                   int dst_stride);
+  // Converts 16 columns of two rows of y into dst, whose word 2j is row0[j]
+  // and word 2j+1 is row1[j], the order vdpbf16ps and the AMX tiles take.
+  // The second row is zero if has_row1 is false, and the columns out of the
+  // mask k1 are zero if tail is true.
+  void convertPairs(const zmm_t& dst,
+                    const Xbyak::Address& row0,
+                    const Xbyak::Address& row1,
+                    bool has_row1,
+                    bool tail);
+
+  int m_, n_, k_, kpad_;
+  // zmm_idx has the index of vpermw for convertPairs
+  zmm_t zmm_idx = zmm_t(28);
+  zmm_t zmm_tmp0 = zmm_t(29);
+  zmm_t zmm_tmp1 = zmm_t(30);
+  reg64_t param_x{abi_param1};
+  reg64_t param_y{abi_param2};
+  reg64_t param_z{abi_param3};
+};
+
+// Accumulates the bf16 products with vdpbf16ps for blocks of kRows rows of x
+// and kBlocks zmm of columns of y, converting the pairs of rows of y in
+// registers.
+class MatMulBF16JitCode : public MatMulBF16JitCodeBase {
+ public:
+  explicit MatMulBF16JitCode(const matmul_attr_t& attr,
+                             size_t code_size = 256 * 1024,
+                             void* code_ptr = nullptr)
+      : MatMulBF16JitCodeBase(attr, code_size, code_ptr) {
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = "MatMulBF16JitCode";
+    base = base + "_M" + std::to_string(m_) + "_N" + std::to_string(n_) + "_K" +
+           std::to_string(k_);
+    return base;
+  }
+  void genCode() override;
+
+  static constexpr int kRows = 6;
+  static constexpr int kBlocks = 4;
+
+ private:
+  // Computes rows of z, whose rows of x are already in the buffer.
+  void genRows(int rows);
+  // Computes rows of z of blocks zmm of columns at col.
+  void genColumns(int rows, int col, int blocks, bool tail);
+
+  reg64_t reg_a{r10};
+  reg64_t reg_b{r11};
+  reg64_t reg_iter_k{rax};
+  reg64_t reg_iter_m{r12};
+  reg64_t reg_cvt_src{r8};
+  reg64_t reg_cvt_dst{r9};
+  reg64_t reg_cvt_cnt{r13};
+  reg64_t reg_tmp{r14};
+};
+
+// Accumulates the bf16 products with the AMX tiles. A block of 32 rows and 32
+// columns of z stays in the tiles tmm0-tmm3 (tmm(2 * row + col)), the 32 rows
+// of x are loaded from the buffer into tmm4 and tmm5, and the 32 columns of y
+// are converted into the buffer and loaded into tmm6 and tmm7 for every 32 of
+// k. Xbyak of the version in use does not know the AMX instructions, so they
+// are encoded here.
+class MatMulAMXJitCode : public MatMulBF16JitCodeBase {
+ public:
+  explicit MatMulAMXJitCode(const matmul_attr_t& attr,
+                            size_t code_size = 256 * 1024,
+                            void* code_ptr = nullptr)
+      : MatMulBF16JitCodeBase(attr, code_size, code_ptr) {
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = "MatMulAMXJitCode";
+    base = base + "_M" + std::to_string(m_) + "_N" + std::to_string(n_) + "_K" +
+           std::to_string(k_);
+    return base;
+  }
+  void genCode() override;
+
+ private:
+  // Computes rows of z of the 32 rows of x in the buffer.
+  void genRows(int rows);
+  // Computes the rows of z of tiles tiles of columns from reg_col_y on.
+  void genColumns(int rows, int tiles, bool tail);
+  // Adds the products of 32 of k, of which valid_k are in x and y.
+  void genChunk(int rows, int tiles, bool tail, int valid_k);
+
+  // VEX.128.0F38.W0 with the prefix pp (0: none, 1: 66, 2: F3, 3: F2)
+  void vex0F38(int pp, int reg, int base, int index, int vvvv);
+  void amxMem(int pp,
+              int opcode,
+              int tmm,
+              const Xbyak::Reg64& base,
+              const Xbyak::Reg64* index,
+              int disp);
+  void ldtilecfg(const Xbyak::Reg64& base);
+  void tilerelease();
+  void tilezero(int tmm);
+  void tileloadd(int tmm,
+                 const Xbyak::Reg64& base,
+                 const Xbyak::Reg64& stride,
+                 int disp = 0);
+  void tilestored(const Xbyak::Reg64& base,
+                  const Xbyak::Reg64& stride,
+                  int disp,
+                  int tmm);
+  void tdpbf16ps(int dst, int a, int b);
+
+  int a_stride() const { return kpad_ * 2; }
+  int a_size() const { return 32 * a_stride(); }
+
+  reg64_t reg_a{r10};
+  reg64_t reg_b{r11};
+  reg64_t reg_iter_k{rax};
+  reg64_t reg_iter_n{r12};
+  reg64_t reg_iter_m{r13};
+  reg64_t reg_col_y{r14};
+  reg64_t reg_col_z{r15};
+  reg64_t reg_stride_a{r8};
+  reg64_t reg_stride_b{r9};
+  reg64_t reg_stride_z{rcx};
+  reg64_t reg_tmp{rbp};
+};
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
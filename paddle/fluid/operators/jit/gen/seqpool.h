@@ -156,6 +156,35 @@ class SeqPoolJitCode : public JitCode {
     save_rest(rest, w_offset);
   }
 
+  // the rest width is less than a zmm, which is loaded and saved with the
+  // opmask k1 of the rest
+  void pool_height_of_rest_width_masked(int w_offset) {
+    vmovups(zmm_t(0) | k1 | T_z, ptr[param_src + w_offset]);
+    cmp(reg32_int_h, 1);
+    Label l_next_h, l_h_done;
+    jle(l_h_done, T_NEAR);
+    mov(reg_h_i, 1);
+    mov(reg_tmp, param_src);
+    add(reg_tmp, w_ * sizeof(float) + w_offset);
+    L(l_next_h);
+    {
+      vmovups(zmm_t(1) | k1 | T_z, ptr[reg_tmp]);
+      vaddps(zmm_t(0), zmm_t(0), zmm_t(1));
+      inc(reg_h_i);
+      add(reg_tmp, w_ * sizeof(float));
+      cmp(reg_h_i, reg32_int_h);
+      jl(l_next_h, T_NEAR);
+    }
+    L(l_h_done);
+    // save right now
+    if (type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt) {
+      mov(reg_tmp, reinterpret_cast<size_t>(fp_h_));
+      vbroadcastss(zmm_t(1), ptr[reg_tmp]);
+      vmulps(zmm_t(0), zmm_t(0), zmm_t(1));
+    }
+    vmovups(ptr[param_dst + w_offset] | k1, zmm_t(0));
+  }
+
   // return the number of used regs, use start from reg 0
   int load_rest(int rest,
                 int w_offset,
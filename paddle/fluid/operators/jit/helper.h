@@ -22,6 +22,7 @@
 #include <utility>  // for std::move
 #include <vector>
 
+#include "paddle/fluid/operators/jit/autotune.h"
 #include "paddle/fluid/operators/jit/gen_base.h"
 #include "paddle/fluid/operators/jit/kernel_base.h"
 #include "paddle/fluid/operators/jit/kernel_key.h"
@@ -196,6 +197,49 @@ typename KernelTuple::func_type GetDefaultBestFunc(
   return funcs[0];
 }
 
+// Times all the candidates of this attr and returns the fastest one, whose
+// implementation type is kept in AutoTuneCache for the later calls.
+template <typename KernelTuple, typename PlaceType = platform::CPUPlace>
+typename KernelTuple::func_type GetAutoTunedFunc(
+    const typename KernelTuple::attr_type& attr) {
+  auto funcs = GetAllCandidateFuncsWithTypes<KernelTuple, PlaceType>(attr);
+  PADDLE_ENFORCE_GE(funcs.size(),
+                    1UL,
+                    platform::errors::InvalidArgument(
+                        "The candicate jit kernel is at least one in CPU."));
+  if (funcs.size() == 1) {
+    return funcs[0].second;
+  }
+  auto& cache = AutoTuneCache::Instance();
+  int64_t key = JitCodeKey<typename KernelTuple::attr_type>(attr);
+  std::string impl_type;
+  if (cache.Find(KernelTuple::kernel_type, key, &impl_type)) {
+    for (auto& f : funcs) {
+      if (f.first == impl_type) {
+        return f.second;
+      }
+    }
+  }
+  size_t best = 0;
+  double best_cost_us = 0;
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    double cost_us;
+    if (!TimeKernelFunc(static_cast<const KernelTuple*>(nullptr),
+                        funcs[i].second,
+                        attr,
+                        &cost_us)) {
+      return funcs[0].second;
+    }
+    if (i == 0 || cost_us < best_cost_us) {
+      best = i;
+      best_cost_us = cost_us;
+    }
+  }
+  cache.Insert(
+      KernelTuple::kernel_type, key, funcs[best].first, best_cost_us);
+  return funcs[best].second;
+}
+
 extern std::map<size_t, std::shared_ptr<void>>& GetFuncCacheMap();
 
 template <typename KernelTuple, typename PlaceType>
@@ -224,8 +268,11 @@ class KernelFuncs {
     if (Has(key)) {
       return funcs_.at(key);
     }
-    // If do not have this attr in cache then get the default best
-    auto func = GetDefaultBestFunc<KernelTuple, PlaceType>(attr);
+    // If do not have this attr in cache then get the default best, or the
+    // fastest one with FLAGS_jit_autotune
+    auto func = FLAGS_jit_autotune
+                    ? GetAutoTunedFunc<KernelTuple, PlaceType>(attr)
+                    : GetDefaultBestFunc<KernelTuple, PlaceType>(attr);
     Insert(key, func);
     return func;
   }
@@ -295,6 +342,9 @@ inline std::ostream& operator<<(std::ostream& os, const sgd_attr_t& attr) {
 
 inline std::ostream& operator<<(std::ostream& os, const matmul_attr_t& attr) {
   os << "M[" << attr.m << "],N[" << attr.n << "],K[" << attr.k << "]";
+  if (attr.bf16) {
+    os << ",BF16";
+  }
   return os;
 }
 
@@ -322,6 +322,9 @@ struct AdamWTuple {
 typedef struct matmul_attr_s {
   int m, n, k;
   void* packed_weight{nullptr};
+  // Allow the kernel to round the inputs to bf16 and accumulate in fp32, as
+  // the jitcode does with AMX or vdpbf16ps. The others ignore it.
+  bool bf16{false};
   matmul_attr_s() = default;
   explicit matmul_attr_s(int m_, int n_, int k_, void* packed_weight_ = nullptr)
       : m(m_), n(n_), k(k_), packed_weight(packed_weight_) {}
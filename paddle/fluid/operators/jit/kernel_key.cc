@@ -53,7 +53,8 @@ int64_t JitCodeKey<seq_pool_attr_t>(const seq_pool_attr_t& attr) {
 
 template <>
 int64_t JitCodeKey<matmul_attr_t>(const matmul_attr_t& attr) {
-  return XXH64(&attr, sizeof(int) * 3, 0);  // m, n, k
+  int keys[4] = {attr.m, attr.n, attr.k, static_cast<int>(attr.bf16)};
+  return XXH64(keys, sizeof(int) * 4, 0);
 }
 
 template <>
@@ -12,6 +12,10 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <random>
 
@@ -766,6 +770,45 @@ void TestKernelMatMul() {
       }
     }
   }
+  // The jitcode of bf16 rounds a and b to bf16, so all are compared on the
+  // rounded a and b.
+  auto to_bf16 = [](T* data, int n) {
+    for (int i = 0; i < n; ++i) {
+      float v = static_cast<float>(data[i]);
+      uint32_t u;
+      memcpy(&u, &v, sizeof(u));
+      u = (u + 0x7FFF + ((u >> 16) & 1)) & 0xFFFF0000;
+      memcpy(&v, &u, sizeof(v));
+      data[i] = static_cast<T>(v);
+    }
+  };
+  for (int m : {1, 5, 16, 33, 64}) {
+    for (int n : {1, 16, 33, 64, 100}) {
+      for (int k : {1, 2, 31, 32, 33, 100, 512}) {
+        auto ref = jit::GetReferFunc<KernelTuple>();
+        EXPECT_TRUE(ref != nullptr);
+        std::vector<T> a(m * k), b(k * n), c(m * n);
+        RandomVec<T>(m * k, a.data());
+        RandomVec<T>(k * n, b.data());
+        to_bf16(a.data(), m * k);
+        to_bf16(b.data(), k * n);
+        jit::matmul_attr_t attr{m, n, k};
+        attr.bf16 = true;
+        ref(a.data(), b.data(), c.data(), &attr);
+        auto verifier = [](const typename KernelTuple::func_type tgt,
+                           const std::vector<T>& a,
+                           const std::vector<T>& b,
+                           const std::vector<T>& cref,
+                           const typename KernelTuple::attr_type& attr) {
+          EXPECT_TRUE(tgt != nullptr);
+          std::vector<T> c(cref.size());
+          tgt(a.data(), b.data(), c.data(), &attr);
+          ExpectEQ<T>(c.data(), cref.data(), attr.m * attr.n);
+        };
+        TestAllImpls<KernelTuple, PlaceType>(attr, verifier, a, b, c, attr);
+      }
+    }
+  }
   FLAGS_acc = last_acc;
 }
 
@@ -1383,6 +1426,49 @@ TEST(JITKernel_helper, GetAllCandidateFuncs) {
   }
 }
 
+TEST(JITKernel_helper, autotune) {
+  const int d = 1023;
+  std::string cache_file = "jit_autotune_cache_test.txt";
+  std::remove(cache_file.c_str());
+  FLAGS_jit_autotune_cache_file = cache_file;
+  auto& cache = jit::AutoTuneCache::Instance();
+  cache.Clean();
+
+  auto funcs = jit::GetAllCandidateFuncs<jit::VMulTuple<float>, CPUPlace>(d);
+  auto tuned = jit::GetAutoTunedFunc<jit::VMulTuple<float>, CPUPlace>(d);
+  EXPECT_TRUE(std::find(funcs.begin(), funcs.end(), tuned) != funcs.end());
+  if (funcs.size() > 1) {
+    EXPECT_EQ(cache.Size(), 1UL);
+    // the choice is loaded from the file after the cache in memory is gone
+    cache.Clean();
+    std::string impl_type;
+    EXPECT_TRUE(cache.Find(jit::kVMul, d, &impl_type));
+    EXPECT_TRUE(tuned ==
+                (jit::GetAutoTunedFunc<jit::VMulTuple<float>, CPUPlace>(d)));
+  }
+
+  // the first choice of a key is kept, and written to the file only once
+  cache.Insert(jit::kVMul, d + 1, "first", 1.0);
+  cache.Insert(jit::kVMul, d + 1, "second", 1.0);
+  cache.Clean();
+  cache.Insert(jit::kVMul, d + 1, "third", 1.0);
+  std::string impl_type;
+  EXPECT_TRUE(cache.Find(jit::kVMul, d + 1, &impl_type));
+  EXPECT_EQ(impl_type, "first");
+  std::ifstream fin(cache_file);
+  std::string line;
+  int num_lines = 0;
+  while (std::getline(fin, line)) {
+    num_lines += line.find(" " + std::to_string(d + 1) + " ") !=
+                 std::string::npos;
+  }
+  EXPECT_EQ(num_lines, 1);
+
+  FLAGS_jit_autotune_cache_file = "";
+  cache.Clean();
+  std::remove(cache_file.c_str());
+}
+
 TEST(JITKernel_helper, pack_weights) {
   const int N = 8 * 60, K = 2;
   float src[K][N], yref[K][N], y[K * N];
@@ -1474,6 +1560,12 @@ TEST(JITKernel_helper, attr) {
   out.str("");
   out << jit::matmul_attr_t(1, 2, 3);
   EXPECT_EQ(out.str().size(), 14UL);
+
+  out.str("");
+  jit::matmul_attr_t bf16_attr(1, 2, 3);
+  bf16_attr.bf16 = true;
+  out << bf16_attr;
+  EXPECT_EQ(out.str().size(), 19UL);
 }
 
 // test keys
@@ -1557,11 +1649,15 @@ TEST(JITKernel_key, matmul) {
   auto key2 = jit::JitCodeKey<jit::matmul_attr_t>(attr2);
   auto key3 = jit::JitCodeKey<jit::matmul_attr_t>(attr3);
   auto key4 = jit::JitCodeKey<jit::matmul_attr_t>(attr4);
+  jit::matmul_attr_t attr5(1, 2, 3);
+  attr5.bf16 = true;
+  auto key5 = jit::JitCodeKey<jit::matmul_attr_t>(attr5);
 
   EXPECT_TRUE(key1 == key2);
   EXPECT_TRUE(key2 != key3);
   EXPECT_TRUE(key2 != key4);
   EXPECT_TRUE(key3 != key4);
+  EXPECT_TRUE(key2 != key5);
 }
 
 TEST(JITKernel_key, emb_seq_pool) {
@@ -14,17 +14,47 @@
 
 #include "paddle/fluid/operators/reader/buffered_reader.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/platform/device/device_wrapper.h"
+#include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 
 #include "paddle/phi/backends/device_guard.h"
 #include "paddle/phi/backends/device_manager.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_int32(
+    reader_num_workers,
+    1,
+    "The number of the threads with which BufferedReader copies the batches "
+    "to a device. The underlying reader is still read by one thread at a "
+    "time, so a BufferedReader on CPUPlace, which copies nothing, always "
+    "uses one thread. The buffer of the reader holds at least one more "
+    "batch than the workers.");
+
+USE_INT_STAT(STAT_buffered_reader_read_batches);
+USE_INT_STAT(STAT_buffered_reader_stall_batches);
+USE_INT_STAT(STAT_buffered_reader_wait_us);
+USE_INT_STAT(STAT_buffered_reader_ready_batches);
+USE_INT_STAT(STAT_buffered_reader_reused_tensors);
 
 namespace paddle {
 namespace operators {
 namespace reader {
+
+// Only the copies to the device run in parallel, so more workers would only
+// wait for each other on CPUPlace.
+static size_t NumWorkers(const platform::Place &place) {
+  if (platform::is_cpu_place(place)) {
+    return 1;
+  }
+  return static_cast<size_t>(std::max(FLAGS_reader_num_workers, 1));
+}
+
 BufferedReader::~BufferedReader() {
   VLOG(1) << "~BufferedReader";
   reader_->Shutdown();
@@ -33,7 +63,7 @@ BufferedReader::~BufferedReader() {
     if (front.valid()) {
       front.wait();
     }
-    position_.pop();
+    position_.pop_front();
   }
 }
 
@@ -43,11 +73,11 @@ BufferedReader::BufferedReader(
     size_t buffer_size,
     bool pin_memory)
     : framework::DecoratedReader(reader),
-      thread_pool_(1),
+      thread_pool_(NumWorkers(place)),
       place_(place),
-      buffer_size_(buffer_size),
+      buffer_size_(std::max(buffer_size, NumWorkers(place) + 1)),
       pin_memory_(pin_memory) {
-  VLOG(1) << "BufferedReader";
+  VLOG(1) << "BufferedReader with " << NumWorkers(place) << " workers";
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   if (platform::is_gpu_place(place_) && !pin_memory) {
     int dev_idx = place_.device;
@@ -55,7 +85,7 @@ BufferedReader::BufferedReader(
         ((phi::GPUContext *)(platform::DeviceContextPool::Instance().Get(
              place_)))
             ->stream();
-    events_.resize(buffer_size);
+    events_.resize(buffer_size_);
     for (auto &event : events_) {
       event = platform::CudaEventResourcePool::Instance().New(dev_idx);
     }
@@ -70,7 +100,7 @@ BufferedReader::BufferedReader(
         ((platform::NPUDeviceContext *)(platform::DeviceContextPool::Instance()
                                             .Get(place_)))
             ->stream();
-    events_.resize(buffer_size);
+    events_.resize(buffer_size_);
     for (auto &event : events_) {
       event = platform::NpuEventResourcePool::Instance().New(dev_idx);
     }
@@ -85,7 +115,7 @@ BufferedReader::BufferedReader(
         ((platform::MLUDeviceContext *)(platform::DeviceContextPool::Instance()
                                             .Get(place_)))
             ->stream();
-    events_.resize(buffer_size);
+    events_.resize(buffer_size_);
     for (auto &event : events_) {
       event = platform::MluEventResourcePool::Instance().New(dev_idx);
     }
@@ -100,7 +130,7 @@ BufferedReader::BufferedReader(
         ((platform::XPUDeviceContext *)(platform::DeviceContextPool::Instance()
                                             .Get(place_)))
             ->stream();
-    events_.resize(buffer_size);
+    events_.resize(buffer_size_);
     for (auto &event : events_) {
       event = platform::XpuEventResourcePool::Instance().New(dev_idx);
     }
@@ -116,7 +146,7 @@ BufferedReader::BufferedReader(
     custom_device_compute_stream_ =
         std::make_shared<phi::stream::Stream>(place_, stream);
 
-    custom_device_events_.resize(buffer_size);
+    custom_device_events_.resize(buffer_size_);
     for (auto &event : custom_device_events_) {
       event = std::make_shared<phi::event::Event>();
       event->Init(place_);
@@ -126,12 +156,12 @@ BufferedReader::BufferedReader(
   }
 #endif
 
-  cpu_buffer_.resize(buffer_size);
-  cuda_buffer_.resize(buffer_size);
-  npu_buffer_.resize(buffer_size);
-  mlu_buffer_.resize(buffer_size);
-  xpu_buffer_.resize(buffer_size);
-  custom_device_buffer_.resize(buffer_size);
+  cpu_buffer_.resize(buffer_size_);
+  cuda_buffer_.resize(buffer_size_);
+  npu_buffer_.resize(buffer_size_);
+  mlu_buffer_.resize(buffer_size_);
+  xpu_buffer_.resize(buffer_size_);
+  custom_device_buffer_.resize(buffer_size_);
   ReadTillBufferFullAsync();
 }
 
@@ -141,10 +171,46 @@ void BufferedReader::ReadTillBufferFullAsync() {
   }
 }
 
+void BufferedReader::RecycleBuffer(TensorVec *buffer, size_t num) {
+  if (buffer->size() != num) {
+    buffer->clear();
+    return;
+  }
+  int64_t reused = 0;
+  for (auto &tensor : *buffer) {
+    if (!tensor.IsInitialized()) {
+      continue;
+    }
+    if (tensor.Holder().use_count() > 1) {
+      tensor = phi::DenseTensor();
+    } else {
+      ++reused;
+    }
+  }
+  STAT_ADD(STAT_buffered_reader_reused_tensors, reused);
+}
+
 void BufferedReader::ReadAsync(size_t i) {
-  position_.emplace(thread_pool_.enqueue([this, i]() -> size_t {
+  size_t ticket = read_ticket_++;
+  position_.emplace_back(thread_pool_.enqueue([this, i, ticket]() -> size_t {
     TensorVec &cpu = cpu_buffer_[i];
-    reader_->ReadNext(&cpu);
+    {
+      std::unique_lock<std::mutex> lock(read_mutex_);
+      read_cond_.wait(lock, [this, ticket] {
+        return next_read_ticket_ == ticket;
+      });
+      std::exception_ptr exception;
+      try {
+        reader_->ReadNext(&cpu);
+      } catch (...) {
+        exception = std::current_exception();
+      }
+      ++next_read_ticket_;
+      read_cond_.notify_all();
+      if (exception) {
+        std::rethrow_exception(exception);
+      }
+    }
 
     if (cpu.empty()) {
       return -1UL;
@@ -153,6 +219,7 @@ void BufferedReader::ReadAsync(size_t i) {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)  // @{ Group GPU Place
     if (platform::is_gpu_place(place_)) {
       TensorVec &cuda = cuda_buffer_[i];
+      RecycleBuffer(&cuda, cpu.size());
       if (cuda.empty()) {
         cuda.resize(cpu.size());
       } else {
@@ -278,6 +345,7 @@ void BufferedReader::ReadAsync(size_t i) {
 #ifdef PADDLE_WITH_ASCEND_CL
     if (platform::is_npu_place(place_)) {
       TensorVec &npu = npu_buffer_[i];
+      RecycleBuffer(&npu, cpu.size());
       if (npu.empty()) {
         npu.resize(cpu.size());
       } else {
@@ -328,6 +396,7 @@ void BufferedReader::ReadAsync(size_t i) {
 #ifdef PADDLE_WITH_MLU
     if (platform::is_mlu_place(place_)) {
       TensorVec &mlu = mlu_buffer_[i];
+      RecycleBuffer(&mlu, cpu.size());
       if (mlu.empty()) {
         mlu.resize(cpu.size());
       } else {
@@ -379,6 +448,7 @@ void BufferedReader::ReadAsync(size_t i) {
 #ifdef PADDLE_WITH_XPU
     if (platform::is_xpu_place(place_)) {
       TensorVec &xpu = xpu_buffer_[i];
+      RecycleBuffer(&xpu, cpu.size());
       if (xpu.empty()) {
         xpu.resize(cpu.size());
       } else {
@@ -436,6 +506,7 @@ void BufferedReader::ReadAsync(size_t i) {
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
     if (platform::is_custom_place(place_)) {
       TensorVec &custom_device = custom_device_buffer_[i];
+      RecycleBuffer(&custom_device, cpu.size());
       if (custom_device.empty()) {
         custom_device.resize(cpu.size());
       } else {
@@ -490,9 +561,13 @@ void BufferedReader::ReadAsync(size_t i) {
 void BufferedReader::ShutdownImpl() {
   VLOG(1) << "ShutdownImpl";
   reader_->Shutdown();
-  while (!position_.empty()) {
-    position_.pop();
+  // Waits for the workers, which may still use the buffers.
+  for (auto &position : position_) {
+    if (position.valid()) {
+      position.wait();
+    }
   }
+  position_.clear();
   prev_pos_ = -1UL;
 }
 
@@ -506,26 +581,63 @@ void BufferedReader::ReadNextImpl(paddle::framework::LoDTensorArray *out) {
     out->clear();
     return;
   }
-  size_t i = position_.front().get();
-  position_.pop();
+  int64_t ready_batches = 0;
+  for (auto &position : position_) {
+    if (position.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      ++ready_batches;
+    }
+  }
+  // The executor stalls on the reader if the next batch is not ready.
+  bool stall = position_.front().wait_for(std::chrono::seconds(0)) !=
+               std::future_status::ready;
+  auto start = std::chrono::steady_clock::now();
+  size_t i;
+  {
+    platform::RecordEvent record_event(
+        "BufferedReader:Wait", platform::TracerEventType::UserDefined, 1);
+    i = position_.front().get();
+  }
+  position_.pop_front();
 
   if (i == -1UL) {
     ReadNextImpl(out);
     return;
   }
 
+  STAT_ADD(STAT_buffered_reader_read_batches, 1);
+  STAT_ADD(STAT_buffered_reader_ready_batches, ready_batches);
+  if (stall) {
+    STAT_ADD(STAT_buffered_reader_stall_batches, 1);
+    STAT_ADD(STAT_buffered_reader_wait_us,
+             std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now() - start)
+                 .count());
+  }
+
+  // The tensors on the devices stay in the buffers, and are reused by the
+  // next batch of the position once the consumer releases them.
+  TensorVec *buffer = &cpu_buffer_[i];
   if (platform::is_gpu_place(place_)) {
-    *out = std::move(cuda_buffer_[i]);
+    buffer = &cuda_buffer_[i];
   } else if (platform::is_npu_place(place_)) {
-    *out = std::move(npu_buffer_[i]);
+    buffer = &npu_buffer_[i];
   } else if (platform::is_mlu_place(place_)) {
-    *out = std::move(mlu_buffer_[i]);
+    buffer = &mlu_buffer_[i];
   } else if (platform::is_xpu_place(place_)) {
-    *out = std::move(xpu_buffer_[i]);
+    buffer = &xpu_buffer_[i];
   } else if (platform::is_custom_place(place_)) {
-    *out = std::move(custom_device_buffer_[i]);
+    buffer = &custom_device_buffer_[i];
+  }
+  // The batch on CPUPlace is the output of the underlying reader, which is
+  // handed out as it is.
+  if (buffer == &cpu_buffer_[i]) {
+    *out = std::move(*buffer);
   } else {
-    *out = std::move(cpu_buffer_[i]);
+    out->resize(buffer->size());
+    for (size_t j = 0; j < buffer->size(); ++j) {
+      (*out)[j].ShareDataWith((*buffer)[j]);
+    }
   }
 
   // Do not push current position into ReadAsync. Push the previous position
@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <memory>
-#include <queue>
+#include <mutex>  // NOLINT
 #include <vector>
 
 #include "ThreadPool.h"
@@ -45,6 +47,13 @@ namespace paddle {
 namespace operators {
 namespace reader {
 
+// NOTE: The reader reads the underlying reader and copies the data to place
+// with FLAGS_reader_num_workers threads, or one thread on CPUPlace. The
+// workers take turns to read the underlying reader in the order of the buffer
+// positions, so the batches keep their order, and only the copies to place
+// overlap. The time ReadNext waits for the workers and the number of the
+// ready batches are added to the int stats STAT_buffered_reader_*, which are
+// got by core.get_int_stats() in Python.
 class BufferedReader : public framework::DecoratedReader {
   using TensorVec = paddle::framework::LoDTensorArray;
   using VecFuture = std::future<TensorVec>;
@@ -62,6 +71,10 @@ class BufferedReader : public framework::DecoratedReader {
 
   void ReadAsync(size_t i);
 
+  // Drops the tensors of the buffer still held by the consumer of the previous
+  // batch of it, so that only the free allocations are reused.
+  void RecycleBuffer(TensorVec* buffer, size_t num);
+
  protected:
   void ShutdownImpl() override;
   void StartImpl() override;
@@ -73,7 +86,13 @@ class BufferedReader : public framework::DecoratedReader {
   const size_t buffer_size_;
   bool pin_memory_;
 
-  std::queue<std::future<size_t>> position_;
+  std::deque<std::future<size_t>> position_;
+
+  // The tickets order the reading of the underlying reader by the workers.
+  std::mutex read_mutex_;
+  std::condition_variable read_cond_;
+  size_t read_ticket_{0};
+  size_t next_read_ticket_{0};
 
   // The buffer for reading data.
   // NOTE: the simplest way to implement buffered reader is do not use any
@@ -0,0 +1,93 @@
+//   Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/buffered_reader.h"
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/monitor.h"
+
+DECLARE_int32(reader_num_workers);
+USE_INT_STAT(STAT_buffered_reader_read_batches);
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+// Reads the batches of 0, 1, ..., batch_num - 1, each after a random delay.
+class CountingReader : public framework::ReaderBase {
+ public:
+  explicit CountingReader(int64_t batch_num)
+      : framework::ReaderBase({phi::make_ddim({1})},
+                              {framework::proto::VarType::INT64},
+                              {false}),
+        batch_num_(batch_num),
+        engine_(0) {}
+
+ protected:
+  void ReadNextImpl(framework::LoDTensorArray* out) override {
+    out->clear();
+    if (next_ >= batch_num_) {
+      return;
+    }
+    std::uniform_int_distribution<int> delay_us(0, 200);
+    std::this_thread::sleep_for(std::chrono::microseconds(delay_us(engine_)));
+    out->resize(1);
+    auto* data = (*out)[0].mutable_data<int64_t>(phi::make_ddim({1}),
+                                                 platform::CPUPlace());
+    data[0] = next_++;
+  }
+
+  void StartImpl() override { next_ = 0; }
+
+ private:
+  int64_t batch_num_;
+  int64_t next_{0};
+  std::mt19937 engine_;
+};
+
+// The reader on CPUPlace runs one worker whatever FLAGS_reader_num_workers is,
+// and keeps the order and the restarts of the underlying reader.
+TEST(BufferedReader, KeepOrderWithWorkers) {
+  const int64_t batch_num = 200;
+  for (int num_workers : {1, 4}) {
+    FLAGS_reader_num_workers = num_workers;
+    int64_t read_batches = STAT_GET(STAT_buffered_reader_read_batches);
+    auto reader = framework::MakeDecoratedReader<BufferedReader>(
+        std::make_shared<CountingReader>(batch_num), platform::CPUPlace(), 2);
+    for (int epoch = 0; epoch < 2; ++epoch) {
+      framework::LoDTensorArray out;
+      for (int64_t i = 0; i < batch_num; ++i) {
+        reader->ReadNext(&out);
+        ASSERT_EQ(out.size(), 1UL);
+        EXPECT_EQ(out[0].data<int64_t>()[0], i);
+      }
+      reader->ReadNext(&out);
+      EXPECT_TRUE(out.empty());
+      reader->Shutdown();
+      reader->Start();
+    }
+    reader->Shutdown();
+    EXPECT_EQ(STAT_GET(STAT_buffered_reader_read_batches) - read_batches,
+              2 * batch_num);
+  }
+  FLAGS_reader_num_workers = 1;
+}
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
@@ -20,6 +20,15 @@ namespace platform {}  // namespace platform
 
 DEFINE_INT_STATUS(STAT_total_feasign_num_in_mem)
 DEFINE_INT_STATUS(STAT_epoch_finish)
+
+// For BufferedReader
+DEFINE_INT_STATUS(STAT_buffered_reader_read_batches)
+DEFINE_INT_STATUS(STAT_buffered_reader_stall_batches)
+DEFINE_INT_STATUS(STAT_buffered_reader_wait_us)
+DEFINE_INT_STATUS(STAT_buffered_reader_ready_batches)
+DEFINE_INT_STATUS(STAT_buffered_reader_reused_tensors)
+
+// For GPU
 DEFINE_INT_STATUS(STAT_gpu0_mem_size)
 DEFINE_INT_STATUS(STAT_gpu1_mem_size)
 DEFINE_INT_STATUS(STAT_gpu2_mem_size)
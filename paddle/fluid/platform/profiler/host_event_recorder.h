@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -67,12 +69,22 @@ class EventContainer {
   // Get all events and clear the container
   std::vector<EventType> Reduce();
 
+  // Call fn on the events of the full blocks and release the blocks.
+  // It can be called by another thread while the owner thread is recording,
+  // but not together with Reduce. fn must not keep the strings of the
+  // events, which are released with the blocks. Returns the number of
+  // events.
+  template <typename Fn>
+  size_t DrainFullBlocks(Fn &&fn);
+
   // Return a buffer to store the string attribute of Event.
   // HostEventRecorder locates in the static data section.
   // So it's safe to use arena to avoid fragmented allocations.
   char *GetStrBufFromArena(size_t size) { return GetStringStorage(size); }
 
  private:
+  struct StringBlock;
+
   struct EventBlock {
     union InitDeferedEvent {
       InitDeferedEvent() {}
@@ -83,7 +95,7 @@ class EventContainer {
 
     static constexpr size_t kBlockSize = 1 << 24;  // 16 MB
     static constexpr size_t kAvailSize =
-        kBlockSize - sizeof(size_t) - sizeof(nullptr);
+        kBlockSize - sizeof(size_t) - 2 * sizeof(nullptr);
     static constexpr size_t kNumEvents = kAvailSize / sizeof(InitDeferedEvent);
     static constexpr size_t kPadSize =
         kAvailSize - kNumEvents * sizeof(InitDeferedEvent);
@@ -94,6 +106,9 @@ class EventContainer {
 
     size_t offset = 0;
     EventBlock *next = nullptr;
+    // The current string block when the block became full, the strings of
+    // the events recorded later are in it or in the later string blocks.
+    StringBlock *str_block = nullptr;
     InitDeferedEvent events[kNumEvents];
     char padding[kPadSize];
   };
@@ -137,6 +152,10 @@ class EventContainer {
   EventBlock *cur_event_block_ = nullptr;
   StringBlock *str_blocks_ = nullptr;
   StringBlock *cur_str_block_ = nullptr;
+  // The number of full blocks, published by the owner thread to
+  // DrainFullBlocks.
+  std::atomic<size_t> num_full_blocks_{0};
+  size_t num_drained_blocks_ = 0;
 };
 
 template <typename EventType>
@@ -156,15 +175,43 @@ std::vector<EventType> EventContainer<EventType>::Reduce() {
     cur = next;
   }
   event_blocks_ = cur_event_block_ = new EventBlock;
+  num_full_blocks_.store(0, std::memory_order_relaxed);
+  num_drained_blocks_ = 0;
   return all_events;
 }
 
+template <typename EventType>
+template <typename Fn>
+size_t EventContainer<EventType>::DrainFullBlocks(Fn &&fn) {
+  size_t num_full_blocks = num_full_blocks_.load(std::memory_order_acquire);
+  size_t event_cnt = 0;
+  for (; num_drained_blocks_ < num_full_blocks; ++num_drained_blocks_) {
+    // The owner thread records to the later blocks only.
+    EventBlock *cur = event_blocks_;
+    for (size_t i = 0; i < cur->offset; ++i) {
+      fn(cur->events[i].event);
+    }
+    event_cnt += cur->offset;
+    for (auto str = str_blocks_; str != cur->str_block;) {
+      auto next = str->next;
+      delete str;
+      str = next;
+    }
+    str_blocks_ = cur->str_block;
+    event_blocks_ = cur->next;
+    delete cur;
+  }
+  return event_cnt;
+}
+
 template <typename EventType>
 EventType *EventContainer<EventType>::GetEventStorage() {
   if (UNLIKELY(cur_event_block_->offset >=
                EventBlock::kNumEvents)) {  // another block
+    cur_event_block_->str_block = cur_str_block_;
     cur_event_block_->next = new EventBlock;
     cur_event_block_ = cur_event_block_->next;
+    num_full_blocks_.fetch_add(1, std::memory_order_release);
   }
   auto &obj = cur_event_block_->events[cur_event_block_->offset].event;
   ++cur_event_block_->offset;
@@ -215,6 +262,14 @@ class ThreadEventRecorder {
     return thr_sec;
   }
 
+  // Forward call to EventContainer::DrainFullBlocks
+  template <typename Fn>
+  size_t DrainEvents(Fn &&fn) {
+    return base_evt_cntr_.DrainFullBlocks(std::forward<Fn>(fn));
+  }
+
+  uint64_t ThreadId() const { return thread_id_; }
+
  private:
   uint64_t thread_id_;
   std::string thread_name_;
@@ -255,6 +310,7 @@ class HostEventRecorder {
           thread_event_recorder_ptr =
               std::make_shared<ThreadEventRecorder<EventType>>();
       *(GetThreadLocalRecorder()) = thread_event_recorder_ptr;
+      std::lock_guard<std::mutex> guard(thr_recorders_mutex_);
       thr_recorders_.push_back(thread_event_recorder_ptr);
     }
     (*GetThreadLocalRecorder())->RecordEvent(std::forward<Args>(args)...);
@@ -265,6 +321,7 @@ class HostEventRecorder {
   HostEventSection<EventType> GatherEvents() {
     HostEventSection<EventType> host_sec;
     host_sec.process_id = GetProcessId();
+    std::lock_guard<std::mutex> guard(thr_recorders_mutex_);
     host_sec.thr_sections.reserve(thr_recorders_.size());
     for (auto &v : thr_recorders_) {
       host_sec.thr_sections.emplace_back(std::move(v->GatherEvents()));
@@ -272,6 +329,22 @@ class HostEventRecorder {
     return host_sec;
   }
 
+  // thread-safe with RecordEvent, but not with GatherEvents.
+  // Call fn(thread_id, event) on the events of the full blocks of every
+  // thread, and release the blocks. Used to stream the events while
+  // tracing. Returns the number of events.
+  template <typename Fn>
+  size_t DrainEvents(Fn &&fn) {
+    size_t event_cnt = 0;
+    std::lock_guard<std::mutex> guard(thr_recorders_mutex_);
+    for (auto &v : thr_recorders_) {
+      uint64_t thread_id = v->ThreadId();
+      event_cnt += v->DrainEvents(
+          [&](const EventType &event) { fn(thread_id, event); });
+    }
+    return event_cnt;
+  }
+
  private:
   using ThreadEventRecorderRegistry = framework::ThreadDataRegistry<
       std::shared_ptr<ThreadEventRecorder<EventType>>>;
@@ -288,6 +361,7 @@ class HostEventRecorder {
   // shared pointer. We add this to prevent ThreadEventRecorder being destroyed
   // by thread-local variable in ThreadEventRecorderRegistry and lose data.
   std::vector<std::shared_ptr<ThreadEventRecorder<EventType>>> thr_recorders_;
+  std::mutex thr_recorders_mutex_;
 };
 
 }  // namespace platform
@@ -0,0 +1,302 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/host_event_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/os_info.h"
+#include "paddle/fluid/platform/profiler/host_event_recorder.h"
+
+namespace paddle {
+namespace platform {
+
+namespace {
+
+// The buffered events are written to the file in writes of about this size.
+constexpr size_t kBufferBytes = 1 << 20;
+
+int HighestBit(uint64_t value) {
+  int bit = 0;
+  while (value >>= 1) {
+    ++bit;
+  }
+  return bit;
+}
+
+}  // namespace
+
+int DurationHistogram::BucketIndex(uint64_t duration_ns) {
+  if (duration_ns < kSubBuckets) {
+    return static_cast<int>(duration_ns);
+  }
+  int exponent = std::min(HighestBit(duration_ns), kMaxExponent);
+  if (exponent == kMaxExponent) {
+    return kNumBuckets - 1;
+  }
+  int sub_bucket = static_cast<int>(
+      (duration_ns >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+  return (exponent - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+}
+
+uint64_t DurationHistogram::BucketLowerBound(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int exponent = index / kSubBuckets + kSubBucketBits - 1;
+  uint64_t sub_bucket = index % kSubBuckets;
+  return (kSubBuckets + sub_bucket) << (exponent - kSubBucketBits);
+}
+
+void DurationHistogram::Add(uint64_t duration_ns) {
+  ++buckets_[BucketIndex(duration_ns)];
+  ++count_;
+  total_ns_ += duration_ns;
+  min_ns_ = std::min(min_ns_, duration_ns);
+  max_ns_ = std::max(max_ns_, duration_ns);
+}
+
+uint64_t DurationHistogram::Percentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  // The rank of the duration, from 1.
+  uint64_t rank = static_cast<uint64_t>(p / 100 * count_ + 0.5);
+  rank = std::min(std::max<uint64_t>(rank, 1), count_);
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      // The middle of the bucket.
+      uint64_t lower = BucketLowerBound(i);
+      uint64_t upper = i + 1 < kNumBuckets ? BucketLowerBound(i + 1) : lower;
+      uint64_t duration_ns = lower + (upper - lower) / 2;
+      return std::min(std::max(duration_ns, min_ns_), max_ns_);
+    }
+  }
+  return max_ns_;
+}
+
+constexpr const char* HostEventStreamer::kOtherEventsName;
+
+HostEventStreamer::~HostEventStreamer() {
+  // The recorders may have been destroyed at exit, so only stop the thread.
+  if (running_) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+}
+
+void HostEventStreamer::Start(const HostEventStreamerOptions& options) {
+  PADDLE_ENFORCE_EQ(
+      running_,
+      false,
+      platform::errors::PreconditionNotMet("HostEventStreamer is running."));
+  PADDLE_ENFORCE_EQ(options.path.empty(),
+                    false,
+                    platform::errors::InvalidArgument(
+                        "The path of HostEventStreamer is empty."));
+  options_ = options;
+  process_id_ = GetProcessId();
+  histograms_.clear();
+  buffer_.reserve(kBufferBytes);
+  OpenFile();
+  stop_ = false;
+  running_ = true;
+  thread_ = std::thread([this]() { Loop(); });
+}
+
+void HostEventStreamer::Stop() {
+  if (!running_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  DrainEvents();
+  // The blocks being recorded can't be drained until the tracing stops.
+  HostEventSection<CommonEvent> host_events =
+      HostEventRecorder<CommonEvent>::GetInstance().GatherEvents();
+  for (const auto& thr_sec : host_events.thr_sections) {
+    for (const auto& evt : thr_sec.events) {
+      StreamEvent(thr_sec.thread_id, evt);
+    }
+  }
+  FlushBuffer();
+  output_file_stream_.close();
+  running_ = false;
+}
+
+std::vector<HostEventSummary> HostEventStreamer::GetSummaries() {
+  std::vector<HostEventSummary> summaries;
+  std::lock_guard<std::mutex> guard(mutex_);
+  summaries.reserve(histograms_.size());
+  for (const auto& pair : histograms_) {
+    const DurationHistogram& histogram = pair.second;
+    HostEventSummary summary;
+    summary.name = pair.first;
+    summary.count = histogram.Count();
+    summary.total_ns = histogram.TotalNs();
+    summary.min_ns = histogram.MinNs();
+    summary.max_ns = histogram.MaxNs();
+    summary.p50_ns = histogram.Percentile(50);
+    summary.p90_ns = histogram.Percentile(90);
+    summary.p99_ns = histogram.Percentile(99);
+    summaries.push_back(std::move(summary));
+  }
+  std::sort(summaries.begin(),
+            summaries.end(),
+            [](const HostEventSummary& a, const HostEventSummary& b) {
+              return a.total_ns > b.total_ns;
+            });
+  return summaries;
+}
+
+void HostEventStreamer::Loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!cv_.wait_for(lock,
+                       std::chrono::milliseconds(options_.interval_ms),
+                       [this]() { return stop_; })) {
+    DrainEvents();
+    FlushBuffer();
+  }
+}
+
+void HostEventStreamer::DrainEvents() {
+  size_t event_cnt = HostEventRecorder<CommonEvent>::GetInstance().DrainEvents(
+      [this](uint64_t thread_id, const CommonEvent& event) {
+        StreamEvent(thread_id, event);
+      });
+  VLOG(4) << "HostEventStreamer drained " << event_cnt << " events";
+}
+
+void HostEventStreamer::StreamEvent(uint64_t thread_id,
+                                    const CommonEvent& event) {
+  // Look up by a std::string, which is not allocated for short names.
+  std::string name(event.name);
+  auto iter = histograms_.find(name);
+  if (iter == histograms_.end()) {
+    if (histograms_.size() < options_.max_names) {
+      iter = histograms_.emplace(name, DurationHistogram()).first;
+    } else {
+      iter = histograms_.emplace(kOtherEventsName, DurationHistogram()).first;
+    }
+  }
+  iter->second.Add(event.end_ns >= event.start_ns
+                       ? event.end_ns - event.start_ns
+                       : 0);
+
+  event_proto_.set_name(std::move(name));
+  event_proto_.set_type(static_cast<TracerEventTypeProto>(event.type));
+  event_proto_.set_start_ns(event.start_ns);
+  event_proto_.set_end_ns(event.end_ns);
+  event_proto_.set_process_id(process_id_);
+  event_proto_.set_thread_id(thread_id);
+  using google::protobuf::io::CodedOutputStream;
+  uint32_t size = static_cast<uint32_t>(event_proto_.ByteSizeLong());
+  size_t offset = buffer_.size();
+  buffer_.resize(offset + CodedOutputStream::VarintSize32(size) + size);
+  uint8_t* target = reinterpret_cast<uint8_t*>(&buffer_[offset]);
+  target = CodedOutputStream::WriteVarint32ToArray(size, target);
+  event_proto_.SerializeWithCachedSizesToArray(target);
+  if (buffer_.size() >= kBufferBytes) {
+    FlushBuffer();
+  }
+}
+
+void HostEventStreamer::OpenFile() {
+  output_file_stream_.open(
+      options_.path,
+      std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+  if (!output_file_stream_) {
+    LOG(WARNING) << "Unable to open file for writing profiling data.";
+  } else {
+    LOG(INFO) << "streaming profiling data to " << options_.path;
+  }
+  file_bytes_ = 0;
+}
+
+void HostEventStreamer::FlushBuffer() {
+  if (buffer_.empty()) {
+    return;
+  }
+  if (file_bytes_ > 0 &&
+      file_bytes_ + static_cast<int64_t>(buffer_.size()) >
+          options_.max_file_bytes) {
+    output_file_stream_.close();
+    std::string older_path = options_.path + ".1";
+    if (std::rename(options_.path.c_str(), older_path.c_str()) != 0) {
+      LOG(WARNING) << "Unable to rename " << options_.path << " to "
+                   << older_path;
+    }
+    OpenFile();
+  }
+  output_file_stream_.write(buffer_.data(), buffer_.size());
+  file_bytes_ += buffer_.size();
+  buffer_.clear();
+}
+
+std::vector<HostTraceEventProto> LoadHostTraceEventStream(
+    const std::string& path) {
+  std::ifstream input_file_stream(path,
+                                  std::ifstream::in | std::ifstream::binary);
+  PADDLE_ENFORCE_EQ(input_file_stream.is_open(),
+                    true,
+                    platform::errors::NotFound(
+                        "Unable to open the host event stream %s.", path));
+  std::string data((std::istreambuf_iterator<char>(input_file_stream)),
+                   std::istreambuf_iterator<char>());
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(data.data());
+  size_t offset = 0;
+  std::vector<HostTraceEventProto> events;
+  while (offset < data.size()) {
+    google::protobuf::io::CodedInputStream input(
+        begin + offset, static_cast<int>(data.size() - offset));
+    uint32_t size = 0;
+    PADDLE_ENFORCE_EQ(
+        input.ReadVarint32(&size),
+        true,
+        platform::errors::InvalidArgument(
+            "The host event stream %s is broken at %d.", path, offset));
+    offset += input.CurrentPosition();
+    HostTraceEventProto event;
+    PADDLE_ENFORCE_EQ(
+        offset + size <= data.size() &&
+            event.ParseFromArray(begin + offset, static_cast<int>(size)),
+        true,
+        platform::errors::InvalidArgument(
+            "The host event stream %s is broken at %d.", path, offset));
+    offset += size;
+    events.push_back(std::move(event));
+  }
+  return events;
+}
+
+}  // namespace platform
+}  // namespace paddle
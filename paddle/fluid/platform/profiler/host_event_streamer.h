@@ -0,0 +1,154 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/profiler/common_event.h"
+#include "paddle/fluid/platform/profiler/dump/nodetree.pb.h"
+
+namespace paddle {
+namespace platform {
+
+// Counts durations in buckets of 1/16 of a power of two, so a percentile is
+// within about 3% of the exact one, with a fixed memory of about 5 KB.
+class DurationHistogram {
+ public:
+  void Add(uint64_t duration_ns);
+
+  // p is in [0, 100]. Returns 0 if there is no duration.
+  uint64_t Percentile(double p) const;
+
+  uint64_t Count() const { return count_; }
+  uint64_t TotalNs() const { return total_ns_; }
+  uint64_t MinNs() const { return count_ == 0 ? 0 : min_ns_; }
+  uint64_t MaxNs() const { return max_ns_; }
+
+ private:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // Durations from 2^kMaxExponent ns (about 36 minutes) share the last
+  // bucket.
+  static constexpr int kMaxExponent = 41;
+  static constexpr int kNumBuckets =
+      (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+  static int BucketIndex(uint64_t duration_ns);
+  static uint64_t BucketLowerBound(int index);
+
+  std::array<uint64_t, kNumBuckets> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t total_ns_ = 0;
+  uint64_t min_ns_ = UINT64_MAX;
+  uint64_t max_ns_ = 0;
+};
+
+struct HostEventSummary {
+  std::string name;
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t min_ns = 0;
+  uint64_t max_ns = 0;
+  uint64_t p50_ns = 0;
+  uint64_t p90_ns = 0;
+  uint64_t p99_ns = 0;
+};
+
+struct HostEventStreamerOptions {
+  // The events are appended to path, as HostTraceEventProto messages which
+  // are prefixed by their varint size.
+  std::string path;
+  // How often the full event blocks are drained.
+  int64_t interval_ms = 1000;
+  // When the file reaches max_file_bytes, it is renamed to path + ".1",
+  // which replaces the older one, so at most twice of it is kept on disk.
+  int64_t max_file_bytes = 1LL << 30;
+  // The events of the names beyond max_names are summarized together as
+  // kOtherEventsName.
+  size_t max_names = 1024;
+};
+
+/*
+ * Streams the host events out while tracing, instead of keeping all of them
+ * in memory until the tracing stops. A background thread drains the full
+ * event blocks of the threads from HostEventRecorder<CommonEvent>, writes
+ * the events to a file, and summarizes the durations of every event name
+ * with bounded memory.
+ */
+class HostEventStreamer {
+ public:
+  static constexpr const char* kOtherEventsName = "<others>";
+
+  static HostEventStreamer& GetInstance() {
+    static HostEventStreamer instance;
+    return instance;
+  }
+
+  ~HostEventStreamer();
+
+  // Clear the summaries and start streaming. The events recorded before
+  // should have been gathered.
+  void Start(const HostEventStreamerOptions& options);
+
+  // Stream the rest events and close the file. Call it after the tracing
+  // stops, it gathers the events of HostEventRecorder<CommonEvent>.
+  void Stop();
+
+  bool IsRunning() const { return running_; }
+
+  // thread-safe. The summaries of the events streamed so far, by the total
+  // duration in descending order.
+  std::vector<HostEventSummary> GetSummaries();
+
+ private:
+  HostEventStreamer() = default;
+  DISABLE_COPY_AND_ASSIGN(HostEventStreamer);
+
+  void Loop();
+  void DrainEvents();
+  void StreamEvent(uint64_t thread_id, const CommonEvent& event);
+  void OpenFile();
+  void FlushBuffer();
+
+  HostEventStreamerOptions options_;
+  bool running_ = false;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+
+  uint64_t process_id_ = 0;
+  std::ofstream output_file_stream_;
+  int64_t file_bytes_ = 0;
+  std::string buffer_;
+  HostTraceEventProto event_proto_;
+  std::unordered_map<std::string, DurationHistogram> histograms_;
+};
+
+// Read the events written by HostEventStreamer from path.
+std::vector<HostTraceEventProto> LoadHostTraceEventStream(
+    const std::string& path);
+
+}  // namespace platform
+}  // namespace paddle
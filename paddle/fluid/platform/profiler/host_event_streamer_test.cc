@@ -0,0 +1,146 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/host_event_streamer.h"
+
+#include <cstdio>
+#include <map>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/profiler/host_event_recorder.h"
+
+namespace paddle {
+namespace platform {
+
+TEST(DurationHistogram, Percentile) {
+  DurationHistogram histogram;
+  EXPECT_EQ(histogram.Percentile(50), 0u);
+  for (uint64_t duration = 1; duration <= 100000; ++duration) {
+    histogram.Add(duration);
+  }
+  EXPECT_EQ(histogram.Count(), 100000u);
+  EXPECT_EQ(histogram.MinNs(), 1u);
+  EXPECT_EQ(histogram.MaxNs(), 100000u);
+  EXPECT_NEAR(histogram.Percentile(50), 50000, 50000 * 0.04);
+  EXPECT_NEAR(histogram.Percentile(90), 90000, 90000 * 0.04);
+  EXPECT_NEAR(histogram.Percentile(99), 99000, 99000 * 0.04);
+  EXPECT_EQ(histogram.Percentile(100), 100000u);
+  EXPECT_EQ(histogram.Percentile(0), 1u);
+}
+
+// Events of two threads, more than an event block of each, so the events
+// are drained while recording.
+TEST(HostEventStreamer, StreamEvents) {
+  const std::string path = "host_event_streamer_test.pb";
+  const uint64_t num_events = 500000;
+  HostEventStreamerOptions options;
+  options.path = path;
+  options.interval_ms = 1;
+  HostEventStreamer::GetInstance().Start(options);
+
+  auto record = [&](const char* name, uint64_t duration) {
+    for (uint64_t i = 0; i < num_events; ++i) {
+      HostEventRecorder<CommonEvent>::GetInstance().RecordEvent(
+          name,
+          i * 1000,
+          i * 1000 + duration,
+          EventRole::kOrdinary,
+          TracerEventType::Operator);
+    }
+    // An event with a std::string name.
+    HostEventRecorder<CommonEvent>::GetInstance().RecordEvent(
+        std::string(name) + "_last",
+        num_events * 1000,
+        num_events * 1000 + duration,
+        EventRole::kOrdinary,
+        TracerEventType::UserDefined);
+  };
+  std::thread thread_a(record, "op_a", 100);
+  std::thread thread_b(record, "op_b", 300);
+  thread_a.join();
+  thread_b.join();
+  HostEventStreamer::GetInstance().Stop();
+  EXPECT_FALSE(HostEventStreamer::GetInstance().IsRunning());
+
+  std::map<std::string, HostEventSummary> summaries;
+  for (const auto& summary : HostEventStreamer::GetInstance().GetSummaries()) {
+    summaries[summary.name] = summary;
+  }
+  ASSERT_EQ(summaries.size(), 4u);
+  EXPECT_EQ(summaries["op_a"].count, num_events);
+  EXPECT_EQ(summaries["op_a"].total_ns, num_events * 100);
+  EXPECT_EQ(summaries["op_b"].p99_ns, 300u);
+  EXPECT_EQ(summaries["op_b_last"].count, 1u);
+
+  std::map<std::string, uint64_t> counts;
+  uint64_t last_start_ns = 0;
+  for (const auto& event : LoadHostTraceEventStream(path)) {
+    ++counts[event.name()];
+    if (event.name() == "op_a") {
+      // The events of a thread are streamed in order.
+      EXPECT_GE(event.start_ns(), last_start_ns);
+      last_start_ns = event.start_ns();
+      EXPECT_EQ(event.end_ns() - event.start_ns(), 100u);
+      EXPECT_EQ(event.type(), TracerEventTypeProto::Operator);
+    }
+  }
+  EXPECT_EQ(counts["op_a"], num_events);
+  EXPECT_EQ(counts["op_b"], num_events);
+  EXPECT_EQ(counts["op_a_last"], 1u);
+  EXPECT_EQ(counts["op_b_last"], 1u);
+  std::remove(path.c_str());
+}
+
+TEST(HostEventStreamer, RotateFile) {
+  const std::string path = "host_event_streamer_rotate_test.pb";
+  HostEventStreamerOptions options;
+  options.path = path;
+  options.max_file_bytes = 1 << 20;
+  options.max_names = 2;
+  HostEventStreamer::GetInstance().Start(options);
+  const uint64_t num_events = 200000;
+  const char* names[] = {"op_a", "op_b", "op_c"};
+  for (uint64_t i = 0; i < num_events; ++i) {
+    HostEventRecorder<CommonEvent>::GetInstance().RecordEvent(
+        names[i % 3],
+        i * 1000,
+        i * 1000 + 10,
+        EventRole::kOrdinary,
+        TracerEventType::Operator);
+  }
+  HostEventStreamer::GetInstance().Stop();
+
+  auto newer_events = LoadHostTraceEventStream(path);
+  auto older_events = LoadHostTraceEventStream(path + ".1");
+  EXPECT_GT(newer_events.size(), 0u);
+  EXPECT_GT(older_events.size(), 0u);
+  EXPECT_LT(newer_events.size() + older_events.size(), num_events);
+  // The newest event is kept.
+  EXPECT_EQ(newer_events.back().start_ns(), (num_events - 1) * 1000);
+
+  auto summaries = HostEventStreamer::GetInstance().GetSummaries();
+  ASSERT_EQ(summaries.size(), 3u);
+  uint64_t total_count = 0;
+  for (const auto& summary : summaries) {
+    EXPECT_NE(summary.name, "op_c");
+    total_count += summary.count;
+  }
+  EXPECT_EQ(total_count, num_events);
+  std::remove(path.c_str());
+  std::remove((path + ".1").c_str());
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -19,6 +19,7 @@
 #include "paddle/fluid/framework/op_proto_maker.h"
 #include "paddle/fluid/platform/profiler/common_event.h"
 #include "paddle/fluid/platform/profiler/host_event_recorder.h"
+#include "paddle/fluid/platform/profiler/host_event_streamer.h"
 #include "paddle/phi/core/flags.h"
 
 // Used to filter events, works like glog VLOG(level).
@@ -28,6 +29,22 @@ PADDLE_DEFINE_EXPORTED_int64(host_trace_level,
                              "RecordEvent will works "
                              "if host_trace_level >= level.");
 
+// If not empty, the host events are streamed to the file while tracing,
+// rather than kept in memory and returned in the profiler result.
+PADDLE_DEFINE_EXPORTED_string(host_trace_stream_path,
+                              "",
+                              "The file to stream the host events to while "
+                              "tracing, the host events are not returned in "
+                              "the profiler result if it is set.");
+PADDLE_DEFINE_EXPORTED_int64(host_trace_stream_interval_ms,
+                             1000,
+                             "How often the host events are streamed.");
+PADDLE_DEFINE_EXPORTED_int64(host_trace_stream_max_mb,
+                             1024,
+                             "The file of host_trace_stream_path is rotated "
+                             "to a file with the suffix .1 when it reaches "
+                             "host_trace_stream_max_mb MB.");
+
 namespace paddle {
 namespace platform {
 
@@ -156,6 +173,13 @@ void HostTracer::StartTracing() {
   HostEventRecorder<CommonMemEvent>::GetInstance().GatherEvents();
   HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
       .GatherEvents();
+  if (!FLAGS_host_trace_stream_path.empty()) {
+    HostEventStreamerOptions streamer_options;
+    streamer_options.path = FLAGS_host_trace_stream_path;
+    streamer_options.interval_ms = FLAGS_host_trace_stream_interval_ms;
+    streamer_options.max_file_bytes = FLAGS_host_trace_stream_max_mb << 20;
+    HostEventStreamer::GetInstance().Start(streamer_options);
+  }
   HostTraceLevel::GetInstance().SetLevel(options_.trace_level);
   state_ = TracerState::STARTED;
 }
@@ -166,6 +190,7 @@ void HostTracer::StopTracing() {
       TracerState::STARTED,
       platform::errors::PreconditionNotMet("TracerState must be STARTED"));
   HostTraceLevel::GetInstance().SetLevel(HostTraceLevel::kDisabled);
+  HostEventStreamer::GetInstance().Stop();
   state_ = TracerState::STOPED;
 }
 
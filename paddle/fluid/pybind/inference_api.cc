@@ -837,6 +837,10 @@ void BindAnalysisConfig(py::module *m) {
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
       .def("enable_mkldnn_bfloat16", &AnalysisConfig::EnableMkldnnBfloat16)
+      .def("enable_weight_only_quant",
+           &AnalysisConfig::EnableWeightOnlyQuant,
+           py::arg("weight_bits") = 8)
+      .def("weight_only_quant_bits", &AnalysisConfig::weight_only_quant_bits)
 #ifdef PADDLE_WITH_MKLDNN
       .def("quantizer_config",
            &AnalysisConfig::mkldnn_quantizer_config,
@@ -66,11 +66,13 @@ limitations under the License. */
 #include "paddle/fluid/imperative/amp_auto_cast.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/memory/allocation/allocator_strategy.h"
+#include "paddle/fluid/memory/allocation/huge_page_cpu_allocator.h"
 #include "paddle/fluid/prim/utils/utils.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/memory/allocation/cuda_ipc_allocator.h"
 #endif
 #include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/operators/activation_op.h"
 #include "paddle/fluid/operators/common_infer_shape_functions.h"
 #include "paddle/fluid/operators/ops_extra_info.h"
@@ -1881,6 +1883,20 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("device_memory_stat_current_value",
         memory::DeviceMemoryStatCurrentValue);
   m.def("device_memory_stat_peak_value", memory::DeviceMemoryStatPeakValue);
+  m.def("memory_stat_scope_snapshot", []() {
+    std::unordered_map<std::string, std::unordered_map<std::string, int64_t>>
+        snapshot;
+    for (const auto &item : memory::GetMemoryStatScopeSnapshot()) {
+      snapshot[item.name] = {{"host_current", item.host_current},
+                             {"host_peak", item.host_peak},
+                             {"device_current", item.device_current},
+                             {"device_peak", item.device_peak}};
+    }
+    return snapshot;
+  });
+  m.def("memory_stat_scope_table", memory::MemoryStatScopeTable);
+  m.def("cpu_numa_node_usage",
+        memory::allocation::HugePageCPUAllocator::NumaNodeUsage);
   m.def(
       "run_cmd",
       [](const std::string &cmd,
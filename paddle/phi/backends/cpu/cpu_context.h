@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <memory>
 
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
 #include "paddle/phi/backends/cpu/forwards.h"
 #include "paddle/phi/core/device_context.h"
 
@@ -37,6 +38,23 @@ class PADDLE_API CPUContext : public DeviceContext,
 
   static const char* name() { return "CPUContext"; }
 
+  // Run fn(chunk_begin, chunk_end) over [begin, end), which is split into
+  // chunks of at least grain_size items and computed by the intra-op thread
+  // pool. See backends/cpu/cpu_parallel.h for the thread budget.
+  template <typename Function>
+  void ParallelFor(int64_t begin,
+                   int64_t end,
+                   int64_t grain_size,
+                   const Function& fn) const {
+    if (backends::cpu::GetIntraOpChunkNum(begin, end, grain_size) <= 1) {
+      if (begin < end) {
+        fn(begin, end);
+      }
+      return;
+    }
+    backends::cpu::IntraOpParallelFor(begin, end, grain_size, fn);
+  }
+
  protected:
   // NOTE: External users manage resources. Used in inference scenarios.
   // The Set interface is for inference only, DeviceContext will mark the
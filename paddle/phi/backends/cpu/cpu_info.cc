@@ -26,6 +26,14 @@ limitations under the License. */
 #include <unistd.h>
 #endif  // _WIN32
 
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#include <fstream>
+#include <string>
+
 #ifdef PADDLE_WITH_XBYAK
 #include "xbyak/xbyak_util.h"
 #endif
@@ -127,6 +135,28 @@ size_t NPUPinnedMaxChunkSize() {
   return NPUPinnedMaxAllocSize() / 256;
 }
 
+#if !defined(WITH_NV_JETSON) && !defined(PADDLE_WITH_ARM) && \
+    !defined(PADDLE_WITH_SW) && !defined(PADDLE_WITH_MIPS)
+// The AMX tiles are usable when the cpu has AMX-TILE and AMX-BF16, which are
+// bits 24 and 22 of CPUID.(EAX=7,ECX=0):EDX, and Linux has granted the tile
+// data to the process, which fails on the kernels without AMX support.
+static bool AMXTileDataUsable(unsigned int cpuid7_edx) {
+  if (!(cpuid7_edx & (1u << 24)) || !(cpuid7_edx & (1u << 22))) {
+    return false;
+  }
+#if defined(__linux__) && defined(__x86_64__)
+  static const bool permitted = [] {
+    constexpr int kArchReqXcompPerm = 0x1023;
+    constexpr int kXFeatureXTileData = 18;
+    return syscall(SYS_arch_prctl, kArchReqXcompPerm, kXFeatureXTileData) == 0;
+  }();
+  return permitted;
+#else
+  return false;
+#endif
+}
+#endif
+
 #ifdef PADDLE_WITH_XBYAK
 static Xbyak::util::Cpu cpu;
 bool MayIUse(const cpu_isa_t cpu_isa) {
@@ -155,6 +185,11 @@ bool MayIUse(const cpu_isa_t cpu_isa) {
              cpu.has(Cpu::tAVX512_4VNNIW);
     case avx512_bf16:
       return true && cpu.has(Cpu::tAVX512_BF16);
+    case amx_bf16: {
+      unsigned int reg[4];
+      Cpu::getCpuidEx(0x00000007, 0, reg);
+      return cpu.has(Cpu::tAVX512_BF16) && AMXTileDataUsable(reg[3]);
+    }
     case isa_any:
       return true;
   }
@@ -198,12 +233,16 @@ bool MayIUse(const cpu_isa_t cpu_isa) {
         return ((reg[1] & avx512f_mask) && (reg[1] & avx512dq_mask) &&
                 (reg[1] & avx512bw_mask) && (reg[1] & avx512vl_mask));
       }
+      unsigned int edx = reg[3];
       // EAX = 7, ECX = 1
-      cpuid(reg, 0x00010007);
+      cpuidex(reg, 0x00000007, 1);
       if (cpu_isa == avx512_bf16) {
         // AVX512BF16: EAX Bit 5
         int avx512bf16_mask = (1 << 5);
         return (reg[0] & avx512bf16_mask) != 0;
+      } else if (cpu_isa == amx_bf16) {
+        int avx512bf16_mask = (1 << 5);
+        return (reg[0] & avx512bf16_mask) != 0 && AMXTileDataUsable(edx);
       }
     }
 #endif
@@ -212,6 +251,81 @@ bool MayIUse(const cpu_isa_t cpu_isa) {
 }
 #endif
 
+#ifdef __linux__
+// Parse a list like "0-11,24-35" of /sys/devices/system/node, and call
+// func for every number in it.
+template <typename Func>
+static bool ForEachInSysfsList(const std::string& path, Func func) {
+  std::ifstream file(path);
+  std::string list;
+  if (!std::getline(file, list) || list.empty()) {
+    return false;
+  }
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last =
+        dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int i = first; i <= last; ++i) {
+      func(i);
+    }
+    pos = end + 1;
+  }
+  return true;
+}
+#endif
+
+int CpuNumaNodeCount() {
+#ifdef __linux__
+  static int count = [] {
+    int max_node = -1;
+    ForEachInSysfsList("/sys/devices/system/node/online",
+                       [&max_node](int node) {
+                         max_node = std::max(max_node, node);
+                       });
+    return std::max(max_node + 1, 1);
+  }();
+  return count;
+#else
+  return 1;
+#endif
+}
+
+int CpuNumaNodeOfCurrentThread() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return 0;
+}
+
+bool BindCurrentThreadToNumaNode(int node) {
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  bool found = ForEachInSysfsList(
+      "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist",
+      [&cpus](int cpu) {
+        if (cpu < CPU_SETSIZE) {
+          CPU_SET(cpu, &cpus);
+        }
+      });
+  return found && CPU_COUNT(&cpus) > 0 &&
+         sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+  return false;
+#endif
+}
+
 }  // namespace cpu
 }  // namespace backends
 }  // namespace phi
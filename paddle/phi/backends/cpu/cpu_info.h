@@ -39,6 +39,7 @@
 #ifndef PADDLE_WITH_XBYAK
 #ifdef _WIN32
 #define cpuid(reg, x) __cpuidex(reg, x, 0)
+#define cpuidex(reg, x, y) __cpuidex(reg, x, y)
 #else
 #if !defined(WITH_NV_JETSON) && !defined(PADDLE_WITH_ARM) && \
     !defined(PADDLE_WITH_SW) && !defined(PADDLE_WITH_MIPS)
@@ -46,6 +47,9 @@
 inline void cpuid(int reg[4], int x) {
   __cpuid_count(x, 0, reg[0], reg[1], reg[2], reg[3]);
 }
+inline void cpuidex(int reg[4], int x, int y) {
+  __cpuid_count(x, y, reg[0], reg[1], reg[2], reg[3]);
+}
 #endif
 #endif
 #endif
@@ -94,10 +98,21 @@ typedef enum {
   avx512_mic,
   avx512_mic_4ops,
   avx512_bf16,
+  amx_bf16,
 } cpu_isa_t;  // Instruction set architecture
 
 // May I use some instruction
 bool MayIUse(const cpu_isa_t cpu_isa);
+
+//! Get the number of NUMA nodes, 1 if NUMA is not supported.
+int CpuNumaNodeCount();
+
+//! Get the NUMA node of the CPU running the calling thread, 0 if unknown.
+int CpuNumaNodeOfCurrentThread();
+
+//! Bind the calling thread to the CPUs of a NUMA node, so that the memory it
+//! touches first is allocated on the node. Return false if not supported.
+bool BindCurrentThreadToNumaNode(int node);
 }  // namespace cpu
 }  // namespace backends
 }  // namespace phi
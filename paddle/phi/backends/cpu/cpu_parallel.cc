@@ -0,0 +1,179 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/core/flags.h"
+#include "paddle/phi/core/threadpool.h"
+
+DECLARE_int32(inner_op_parallelism);
+
+namespace phi {
+namespace backends {
+namespace cpu {
+
+namespace {
+
+thread_local int intra_op_num_threads = 0;
+thread_local bool in_intra_op_parallel_region = false;
+
+// Threads of the intra-op pool are shared by all the callers, and a caller
+// only hands chunks to the threads which are not reserved by others.
+class IntraOpThreadPool {
+ public:
+  static IntraOpThreadPool& Instance() {
+    static IntraOpThreadPool pool;
+    return pool;
+  }
+
+  // Reserves at most `num` idle threads and returns how many are reserved.
+  int Reserve(int num) {
+    int busy = busy_.load();
+    while (true) {
+      int reserved = std::min(num, num_threads_ - busy);
+      if (reserved <= 0) {
+        return 0;
+      }
+      if (busy_.compare_exchange_weak(busy, busy + reserved)) {
+        return reserved;
+      }
+    }
+  }
+
+  void Release() { busy_.fetch_sub(1); }
+
+  template <typename Callback>
+  std::future<void> Run(Callback fn) {
+    return pool_->Run(fn);
+  }
+
+ private:
+  IntraOpThreadPool() {
+    num_threads_ = FLAGS_inner_op_parallelism > 1
+                       ? FLAGS_inner_op_parallelism
+                       : static_cast<int>(std::thread::hardware_concurrency());
+    // The calling thread always works on its own loop.
+    num_threads_ = std::max(num_threads_ - 1, 1);
+    VLOG(1) << "Init intra-op thread pool with " << num_threads_
+            << " threads.";
+    pool_.reset(new ThreadPool(num_threads_));
+  }
+
+  int num_threads_;
+  std::atomic<int> busy_{0};
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+class ParallelRegionGuard {
+ public:
+  ParallelRegionGuard() : prev_(in_intra_op_parallel_region) {
+    in_intra_op_parallel_region = true;
+  }
+  ~ParallelRegionGuard() { in_intra_op_parallel_region = prev_; }
+
+ private:
+  bool prev_;
+};
+
+}  // namespace
+
+int GetIntraOpNumThreads() {
+  if (intra_op_num_threads > 0) {
+    return intra_op_num_threads;
+  }
+  return std::max(FLAGS_inner_op_parallelism, 1);
+}
+
+void SetIntraOpNumThreads(int num_threads) {
+  intra_op_num_threads = std::max(num_threads, 0);
+}
+
+bool InIntraOpParallelRegion() { return in_intra_op_parallel_region; }
+
+int GetIntraOpChunkNum(int64_t begin, int64_t end, int64_t grain_size) {
+  if (end - begin <= 0 || in_intra_op_parallel_region) {
+    return 1;
+  }
+  int64_t max_chunks = (end - begin) / std::max<int64_t>(grain_size, 1);
+  return static_cast<int>(std::max<int64_t>(
+      1, std::min<int64_t>(GetIntraOpNumThreads(), max_chunks)));
+}
+
+void IntraOpParallelFor(int64_t begin,
+                        int64_t end,
+                        int64_t grain_size,
+                        const std::function<void(int64_t, int64_t)>& fn) {
+  if (begin >= end) {
+    return;
+  }
+  const int num_chunks = GetIntraOpChunkNum(begin, end, grain_size);
+  if (num_chunks <= 1) {
+    fn(begin, end);
+    return;
+  }
+  const int64_t chunk_size = (end - begin + num_chunks - 1) / num_chunks;
+
+  // Chunks are claimed through a shared counter, so the calling thread
+  // finishes the loop alone when no thread of the pool is available.
+  std::atomic<int> next_chunk{0};
+  std::exception_ptr exception = nullptr;
+  std::mutex exception_mutex;
+  auto run_chunks = [&]() {
+    ParallelRegionGuard guard;
+    try {
+      for (int i = next_chunk++; i < num_chunks; i = next_chunk++) {
+        int64_t chunk_begin = begin + i * chunk_size;
+        fn(chunk_begin, std::min(end, chunk_begin + chunk_size));
+      }
+    } catch (...) {
+      next_chunk = num_chunks;
+      std::lock_guard<std::mutex> lock(exception_mutex);
+      if (exception == nullptr) {
+        exception = std::current_exception();
+      }
+    }
+  };
+
+  auto& pool = IntraOpThreadPool::Instance();
+  int num_workers = pool.Reserve(num_chunks - 1);
+  std::vector<std::future<void>> futures;
+  futures.reserve(num_workers);
+  for (int i = 0; i < num_workers; ++i) {
+    futures.emplace_back(pool.Run([&]() {
+      run_chunks();
+      pool.Release();
+    }));
+  }
+  run_chunks();
+  for (auto& f : futures) {
+    f.wait();
+  }
+  if (exception != nullptr) {
+    std::rethrow_exception(exception);
+  }
+}
+
+}  // namespace cpu
+}  // namespace backends
+}  // namespace phi
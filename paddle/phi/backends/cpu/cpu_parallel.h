@@ -0,0 +1,60 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace phi {
+namespace backends {
+namespace cpu {
+
+//! Default minimal number of elements processed by one chunk of an intra-op
+//! parallel loop. Smaller chunks cost more to dispatch than to compute.
+constexpr int64_t kIntraOpGrainSize = 32768;
+
+//! Get the number of threads, including the calling one, that intra-op
+//! parallel loops started from the calling thread may use. It defaults to
+//! FLAGS_inner_op_parallelism.
+int GetIntraOpNumThreads();
+
+//! Set the intra-op thread budget of the calling thread. Threads that
+//! already run in parallel with each other, like trainer workers or
+//! predictor threads, use it to share the cores instead of oversubscribing
+//! them. A value <= 0 restores the default.
+void SetIntraOpNumThreads(int num_threads);
+
+//! Whether the calling thread is running a chunk of an intra-op parallel
+//! loop. Loops nested inside a chunk run serially.
+bool InIntraOpParallelRegion();
+
+//! Get the number of chunks IntraOpParallelFor splits [begin, end) into.
+//! All the chunks have ceil((end - begin) / num_chunks) items except the
+//! last one, so that the chunk index can be derived from chunk_begin.
+int GetIntraOpChunkNum(int64_t begin, int64_t end, int64_t grain_size);
+
+//! Split [begin, end) into chunks of at least grain_size items and run
+//! fn(chunk_begin, chunk_end) on every chunk. The calling thread takes part
+//! in the work and is joined by the idle threads of the intra-op thread
+//! pool, so it never waits behind the loops of other threads. The first
+//! exception thrown by fn is rethrown after all the chunks have stopped.
+void IntraOpParallelFor(int64_t begin,
+                        int64_t end,
+                        int64_t grain_size,
+                        const std::function<void(int64_t, int64_t)>& fn);
+
+}  // namespace cpu
+}  // namespace backends
+}  // namespace phi
@@ -2987,6 +2987,84 @@ void MoeInferMeta(const MetaTensor& x,
   out->set_layout(x.layout());
 }
 
+void FusedWeightOnlyFCInferMeta(const MetaTensor& input,
+                                const MetaTensor& qweight,
+                                const MetaTensor& scale,
+                                const MetaTensor& bias,
+                                int in_num_col_dims,
+                                const std::string& activation_type,
+                                int weight_bits,
+                                MetaTensor* out) {
+  PADDLE_ENFORCE_EQ(
+      weight_bits == 8 || weight_bits == 4,
+      true,
+      phi::errors::InvalidArgument(
+          "The weight_bits of fused_weight_only_fc must be 8 or 4, but "
+          "received %d.",
+          weight_bits));
+  PADDLE_ENFORCE_EQ(
+      activation_type.empty() || activation_type == "relu",
+      true,
+      phi::errors::InvalidArgument(
+          "The activation_type of fused_weight_only_fc is expected to be "
+          "empty or \"relu\", but received %s.",
+          activation_type));
+
+  auto in_dims = input.dims();
+  auto w_dims = qweight.dims();
+  PADDLE_ENFORCE_LT(
+      in_num_col_dims,
+      in_dims.size(),
+      phi::errors::InvalidArgument(
+          "The attribute in_num_col_dims of fused_weight_only_fc is expected "
+          "to be less than the number of Input's dimensions. But received "
+          "in_num_col_dims is %d, Input's shape is %s.",
+          in_num_col_dims,
+          in_dims));
+  PADDLE_ENFORCE_EQ(
+      w_dims.size(),
+      2,
+      phi::errors::InvalidArgument(
+          "The quantized weight of fused_weight_only_fc is expected to be a "
+          "2-D tensor, but received its shape %s.",
+          w_dims));
+  PADDLE_ENFORCE_EQ(qweight.dtype(),
+                    phi::DataType::INT8,
+                    phi::errors::InvalidArgument(
+                        "The quantized weight of fused_weight_only_fc is "
+                        "expected to be int8."));
+  PADDLE_ENFORCE_EQ(
+      scale.dims().size() == 1 && scale.dims()[0] == w_dims[0],
+      true,
+      phi::errors::InvalidArgument(
+          "The scale of fused_weight_only_fc is expected to have one value "
+          "per output channel, i.e. the shape [%d], but received %s.",
+          w_dims[0],
+          scale.dims()));
+  if (bias) {
+    auto bias_dims = bias.dims();
+    PADDLE_ENFORCE_EQ(
+        bias_dims[bias_dims.size() - 1],
+        w_dims[0],
+        phi::errors::InvalidArgument(
+            "The last dimension of the Bias of fused_weight_only_fc is "
+            "expected to be %d, but received the shape %s.",
+            w_dims[0],
+            bias_dims));
+  }
+
+  std::vector<int64_t> out_dims;
+  out_dims.reserve(static_cast<size_t>(in_num_col_dims + 1));
+  for (int i = 0; i < in_num_col_dims; ++i) {
+    out_dims.push_back(in_dims[i]);
+  }
+  out_dims.push_back(w_dims[0]);
+  out->set_dims(phi::make_ddim(out_dims));
+  out->share_lod(input);
+  out->set_dtype(input.dtype());
+  out->set_layout(input.layout());
+}
+
 }  // namespace phi
 
 PD_REGISTER_INFER_META_FN(batch_norm_infer, phi::BatchNormInferInferMeta);
@@ -541,4 +541,13 @@ void MoeInferMeta(const MetaTensor& x,
                   const std::string& act_type,
                   MetaTensor* out);
 
+void FusedWeightOnlyFCInferMeta(const MetaTensor& input,
+                                const MetaTensor& qweight,
+                                const MetaTensor& scale,
+                                const MetaTensor& bias,
+                                int in_num_col_dims,
+                                const std::string& activation_type,
+                                int weight_bits,
+                                MetaTensor* out);
+
 }  // namespace phi
@@ -14,17 +14,9 @@
 
 #include "paddle/phi/kernels/layer_norm_kernel.h"
 
-#include "paddle/phi/kernels/cpu/elementwise.h"
-#include "paddle/phi/kernels/funcs/layer_norm_util.h"
-#if !defined(PADDLE_WITH_CUDA) && !defined(_WIN32) && !defined(__APPLE__) && \
-    !defined(__OSX__)
-#include "paddle/fluid/operators/jit/kernels.h"
-#endif
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
-#include "paddle/phi/kernels/funcs/elementwise_base.h"
-#include "paddle/phi/kernels/funcs/elementwise_functor.h"
-#include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/cpu_layer_norm.h"
 
 namespace phi {
 
@@ -47,52 +39,9 @@ void LayerNormKernel(const Context& dev_ctx,
   dev_ctx.template Alloc<T>(var);
 
   auto matrix_dim = phi::flatten_to_2d(x_dims, begin_norm_axis);
-  int left = static_cast<int>(matrix_dim[0]);
-  int right = static_cast<int>(matrix_dim[1]);
-  DDim matrix_shape({left, right});
+  int64_t left = matrix_dim[0];
+  int64_t right = matrix_dim[1];
 
-  auto x_tmp = x;
-  x_tmp.Resize(matrix_shape);
-  DenseTensor out;
-  out.ShareDataWith(*y);
-  out.Resize(matrix_shape);
-
-#if defined(PADDLE_WITH_CUDA) || defined(_WIN32) || defined(__APPLE__) || \
-    defined(__OSX__)
-
-  funcs::RowwiseMean2D<phi::CPUContext, T> row_mean(left, right, dev_ctx);
-
-  // get mean
-  row_mean(dev_ctx, x_tmp, mean);
-
-  // get variance
-
-  phi::funcs::ElementwiseCompute<funcs::SubAndSquareFunctor<T>, T, T>(
-      dev_ctx, x_tmp, *mean, 0, funcs::SubAndSquareFunctor<T>(), &out);
-
-  row_mean(dev_ctx, out, var);
-
-  // get x_norm
-  phi::funcs::ElementwiseCompute<funcs::SubtractFunctor<T>, T, T>(
-      dev_ctx, x_tmp, *mean, 0, funcs::SubtractFunctor<T>(), &out);
-
-  phi::funcs::ElementwiseCompute<funcs::DivAndSqrtFunctor<T>, T, T>(
-      dev_ctx,
-      out,
-      *var,
-      0,
-      funcs::DivAndSqrtFunctor<T>(static_cast<T>(epsilon)),
-      &out);
-
-  if (scale) {
-    phi::funcs::ElementwiseCompute<funcs::MultiplyFunctor<T>, T, T>(
-        dev_ctx, out, *scale, 1, funcs::MultiplyFunctor<T>(), &out);
-  }
-  if (bias) {
-    phi::funcs::ElementwiseCompute<funcs::AddFunctor<T>, T, T>(
-        dev_ctx, out, *bias, 1, funcs::AddFunctor<T>(), &out);
-  }
-#else
   PADDLE_ENFORCE_EQ(mean->numel(),
                     left,
                     phi::errors::InvalidArgument(
@@ -123,20 +72,16 @@ void LayerNormKernel(const Context& dev_ctx,
                           right));
   }
 
-  auto ker = paddle::operators::jit::KernelFuncs<
-                 paddle::operators::jit::LayerNormTuple<T>,
-                 phi::CPUPlace>::Cache()
-                 .At(right);
-  ker(x_tmp.data<T>(),
-      out.data<T>(),
-      mean->data<T>(),
-      var->data<T>(),
-      scale ? scale->data<T>() : nullptr,
-      bias ? bias->data<T>() : nullptr,
-      static_cast<int>(left),
-      static_cast<float>(epsilon),
-      right);
-#endif
+  funcs::LayerNormForwardCPU<T>(dev_ctx,
+                                x.data<T>(),
+                                scale ? scale->data<T>() : nullptr,
+                                bias ? bias->data<T>() : nullptr,
+                                left,
+                                right,
+                                static_cast<T>(epsilon),
+                                y->data<T>(),
+                                mean->data<T>(),
+                                var->data<T>());
 }
 
 }  // namespace phi
@@ -47,19 +47,30 @@ struct ConcatFunctor<phi::CPUContext, T> {
 
     // computation
     auto output_data = output->data<T>();
-    int64_t col_idx = 0;
+    std::vector<const T*> input_data(num);
     for (size_t j = 0; j < num; ++j) {
-      int64_t col_len = input_cols[j];
-      auto input_data = input[j].data<T>();
-      for (int64_t k = 0; k < out_rows; ++k) {
-        paddle::memory::Copy(cpu_place,
-                             output_data + k * out_cols + col_idx,
-                             cpu_place,
-                             input_data + k * col_len,
-                             sizeof(T) * col_len);
-      }
-      col_idx += col_len;
+      input_data[j] = input[j].data<T>();
     }
+    // Rows of the output are independent, so they are split across threads.
+    const int64_t grain_size =
+        std::max<int64_t>(1,
+                          phi::backends::cpu::kIntraOpGrainSize /
+                              std::max<int64_t>(out_cols, 1));
+    context.ParallelFor(
+        0, out_rows, grain_size, [&](int64_t begin, int64_t end) {
+          int64_t col_idx = 0;
+          for (size_t j = 0; j < num; ++j) {
+            int64_t col_len = input_cols[j];
+            for (int64_t k = begin; k < end; ++k) {
+              paddle::memory::Copy(cpu_place,
+                                   output_data + k * out_cols + col_idx,
+                                   cpu_place,
+                                   input_data[j] + k * col_len,
+                                   sizeof(T) * col_len);
+            }
+            col_idx += col_len;
+          }
+        });
   }
 };
 
@@ -101,23 +112,36 @@ struct SplitFunctor<phi::CPUContext, T> {
     auto cpu_place = context.GetPlace();
 
     // computation
-    for (int k = 0; k < input_rows; ++k) {
-      const T* src_ptr = input.data<T>() + k * input_cols;
-      int col_idx = 0;
-      for (size_t j = 0; j < num; ++j) {
-        int col_len = output_cols[j];
-        auto* out_tensor = outputs->at(j);
-        if (out_tensor != nullptr) {
-          T* dst_ptr = out_tensor->data<T>() + k * col_len;
-          paddle::memory::Copy(cpu_place,
-                               dst_ptr,
-                               cpu_place,
-                               src_ptr + col_idx,
-                               sizeof(T) * col_len);
-        }
-        col_idx += col_len;
+    const T* input_data = input.data<T>();
+    std::vector<T*> output_data(num, nullptr);
+    for (size_t j = 0; j < num; ++j) {
+      auto* out_tensor = outputs->at(j);
+      if (out_tensor != nullptr) {
+        output_data[j] = out_tensor->data<T>();
       }
     }
+    // Rows of the input are independent, so they are split across threads.
+    const int64_t grain_size = std::max<int64_t>(
+        1, phi::backends::cpu::kIntraOpGrainSize / std::max(input_cols, 1));
+    context.ParallelFor(
+        0, input_rows, grain_size, [&](int64_t begin, int64_t end) {
+          for (int64_t k = begin; k < end; ++k) {
+            const T* src_ptr = input_data + k * input_cols;
+            int col_idx = 0;
+            for (size_t j = 0; j < num; ++j) {
+              int col_len = output_cols[j];
+              if (output_data[j] != nullptr) {
+                T* dst_ptr = output_data[j] + k * col_len;
+                paddle::memory::Copy(cpu_place,
+                                     dst_ptr,
+                                     cpu_place,
+                                     src_ptr + col_idx,
+                                     sizeof(T) * col_len);
+              }
+              col_idx += col_len;
+            }
+          }
+        });
   }
 };
 
@@ -0,0 +1,396 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/dims_simplifier.h"
+
+namespace phi {
+namespace funcs {
+
+// Minimal number of output elements computed by one thread. Below this
+// threshold the cost of waking up threads exceeds the gain.
+constexpr int64_t kCPUBroadcastGrainSize = 32768;
+
+/*
+ * Binary broadcast on CPU after merging dimensions with
+ * BroadcastDimsSimplifier. For example:
+ *   x.shape = [N, C, H, W], y.shape = [C, 1, 1]
+ *   -> out = [N, C, H*W], x = [N, C, H*W], y = [1, C, 1]
+ *   x.shape = [B, T, D], y.shape = [D]
+ *   -> out = [B*T, D], x = [B*T, D], y = [1, D]
+ * The innermost merged dimension is a contiguous run in output, in which
+ * every input either advances by 1 or stays at the same element. Such a run
+ * is computed by a tight loop which is vectorized by the compiler, and the
+ * outer dimensions are split across threads by CPUContext::ParallelFor.
+ * NOTE: dims and strides are stored from the innermost dimension, which is
+ * the order produced by BroadcastDimsSimplifier.
+ */
+struct CPUBroadcastPlan {
+  CPUBroadcastPlan(const int *x_dims_array,
+                   const int *y_dims_array,
+                   const int *out_dims_array,
+                   int max_dim) {
+    numel = 1;
+    for (int i = 0; i < max_dim; ++i) {
+      numel *= std::max(out_dims_array[i], 0);
+    }
+    if (numel == 0) {
+      return;
+    }
+    std::vector<BroadcastDimsSimplifier::DimVector> ins_dims = {
+        BroadcastDimsSimplifier::DimVector(x_dims_array,
+                                           x_dims_array + max_dim),
+        BroadcastDimsSimplifier::DimVector(y_dims_array,
+                                           y_dims_array + max_dim)};
+    BroadcastDimsSimplifier::DimVector dims(out_dims_array,
+                                            out_dims_array + max_dim);
+    if (max_dim == 0) {
+      ins_dims[0].push_back(1);
+      ins_dims[1].push_back(1);
+      dims.push_back(1);
+    }
+    BroadcastDimsSimplifier simplifier(ins_dims, dims);
+
+    rank = simplifier.rank;
+    out_dims = simplifier.out_dims;
+    out_dims.resize(rank);
+    x_strides = GetStrides(simplifier.in_dims[0]);
+    y_strides = GetStrides(simplifier.in_dims[1]);
+    inner = out_dims[0];
+    outer = numel / inner;
+    x_inner_contiguous = x_strides[0] != 0;
+    y_inner_contiguous = y_strides[0] != 0;
+  }
+
+  int rank{0};
+  int64_t numel{0};
+  // Length of the contiguous run in output, and the number of runs.
+  int64_t inner{1};
+  int64_t outer{0};
+  bool x_inner_contiguous{true};
+  bool y_inner_contiguous{true};
+  std::vector<int64_t> out_dims;
+  // Strides of inputs for every merged dimension, 0 means broadcast.
+  std::vector<int64_t> x_strides;
+  std::vector<int64_t> y_strides;
+
+ private:
+  std::vector<int64_t> GetStrides(
+      const BroadcastDimsSimplifier::DimVector &in_dims) const {
+    std::vector<int64_t> strides(rank, 0);
+    int64_t stride = 1;
+    for (int i = 0; i < rank; ++i) {
+      strides[i] = in_dims[i] == 1 ? 0 : stride;
+      stride *= in_dims[i];
+    }
+    return strides;
+  }
+};
+
+// Walks the outer dimensions of a CPUBroadcastPlan, keeping the offsets of
+// x and y up to date without any division after construction.
+class CPUBroadcastOuterIterator {
+ public:
+  CPUBroadcastOuterIterator(const CPUBroadcastPlan &plan, int64_t outer_index)
+      : plan_(plan), index_(plan.rank, 0) {
+    for (int i = 1; i < plan_.rank; ++i) {
+      index_[i] = outer_index % plan_.out_dims[i];
+      outer_index /= plan_.out_dims[i];
+      x_offset_ += index_[i] * plan_.x_strides[i];
+      y_offset_ += index_[i] * plan_.y_strides[i];
+    }
+  }
+
+  int64_t x_offset() const { return x_offset_; }
+  int64_t y_offset() const { return y_offset_; }
+
+  void Next() {
+    for (int i = 1; i < plan_.rank; ++i) {
+      ++index_[i];
+      x_offset_ += plan_.x_strides[i];
+      y_offset_ += plan_.y_strides[i];
+      if (index_[i] < plan_.out_dims[i]) {
+        return;
+      }
+      x_offset_ -= index_[i] * plan_.x_strides[i];
+      y_offset_ -= index_[i] * plan_.y_strides[i];
+      index_[i] = 0;
+    }
+  }
+
+ private:
+  const CPUBroadcastPlan &plan_;
+  std::vector<int64_t> index_;
+  int64_t x_offset_{0};
+  int64_t y_offset_{0};
+};
+
+template <bool XContiguous,
+          bool YContiguous,
+          typename Functor,
+          typename T,
+          typename OutType>
+inline void BroadcastInnerRunCPU(
+    const T *x, const T *y, OutType *out, int64_t n, Functor func) {
+  if (XContiguous && YContiguous) {
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i], y[i]);
+    }
+  } else if (XContiguous) {
+    const T y_value = y[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i], y_value);
+    }
+  } else if (YContiguous) {
+    const T x_value = x[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x_value, y[i]);
+    }
+  } else {
+    std::fill(out, out + n, static_cast<OutType>(func(x[0], y[0])));
+  }
+}
+
+template <bool XContiguous,
+          bool YContiguous,
+          typename Functor,
+          typename T,
+          typename OutType>
+void BroadcastForwardCPUImpl(const CPUContext &ctx,
+                             const CPUBroadcastPlan &plan,
+                             const T *x,
+                             const T *y,
+                             OutType *out,
+                             Functor func) {
+  const int64_t inner = plan.inner;
+  const int64_t grain_size =
+      std::max<int64_t>(1, kCPUBroadcastGrainSize / inner);
+  ctx.ParallelFor(
+      0, plan.outer, grain_size, [&](int64_t begin, int64_t end) {
+        CPUBroadcastOuterIterator iter(plan, begin);
+        for (int64_t i = begin; i < end; ++i) {
+          BroadcastInnerRunCPU<XContiguous, YContiguous>(x + iter.x_offset(),
+                                                         y + iter.y_offset(),
+                                                         out + i * inner,
+                                                         inner,
+                                                         func);
+          iter.Next();
+        }
+      });
+}
+
+// out = func(x, y), where x and y are broadcast to the shape of out.
+template <typename Functor, typename T, typename OutType = T>
+void BroadcastForwardCPU(const CPUContext &ctx,
+                         const CPUBroadcastPlan &plan,
+                         const T *x,
+                         const T *y,
+                         OutType *out,
+                         Functor func) {
+  if (plan.numel == 0) {
+    return;
+  }
+  if (plan.x_inner_contiguous && plan.y_inner_contiguous) {
+    BroadcastForwardCPUImpl<true, true>(ctx, plan, x, y, out, func);
+  } else if (plan.x_inner_contiguous) {
+    BroadcastForwardCPUImpl<true, false>(ctx, plan, x, y, out, func);
+  } else if (plan.y_inner_contiguous) {
+    BroadcastForwardCPUImpl<false, true>(ctx, plan, x, y, out, func);
+  } else {
+    BroadcastForwardCPUImpl<false, false>(ctx, plan, x, y, out, func);
+  }
+}
+
+template <bool XContiguous,
+          bool YContiguous,
+          typename T,
+          typename Tout,
+          typename DX_OP,
+          typename DY_OP>
+inline void BroadcastGradInnerRunCPU(const T *x,
+                                     const T *y,
+                                     const Tout *out,
+                                     const Tout *dout,
+                                     int64_t n,
+                                     DX_OP dx_op,
+                                     DY_OP dy_op,
+                                     T *dx,
+                                     T *dy) {
+  // Gradient of a broadcast input is reduced within the run first.
+  T dx_sum = static_cast<T>(0);
+  T dy_sum = static_cast<T>(0);
+  for (int64_t i = 0; i < n; ++i) {
+    const T x_value = XContiguous ? x[i] : x[0];
+    const T y_value = YContiguous ? y[i] : y[0];
+    if (dx != nullptr) {
+      T tmp = dx_op(x_value, y_value, out[i], dout[i]);
+      if (XContiguous) {
+        dx[i] += tmp;
+      } else {
+        dx_sum += tmp;
+      }
+    }
+    if (dy != nullptr) {
+      T tmp = dy_op(x_value, y_value, out[i], dout[i]);
+      if (YContiguous) {
+        dy[i] += tmp;
+      } else {
+        dy_sum += tmp;
+      }
+    }
+  }
+  if (dx != nullptr && !XContiguous) {
+    dx[0] += dx_sum;
+  }
+  if (dy != nullptr && !YContiguous) {
+    dy[0] += dy_sum;
+  }
+}
+
+template <bool XContiguous,
+          bool YContiguous,
+          typename T,
+          typename Tout,
+          typename DX_OP,
+          typename DY_OP>
+void BroadcastGradCPUImpl(const CPUContext &ctx,
+                          const CPUBroadcastPlan &plan,
+                          const T *x,
+                          const T *y,
+                          const Tout *out,
+                          const Tout *dout,
+                          int64_t x_numel,
+                          int64_t y_numel,
+                          DX_OP dx_op,
+                          DY_OP dy_op,
+                          T *dx,
+                          T *dy) {
+  const int64_t inner = plan.inner;
+  const int64_t grain_size =
+      std::max<int64_t>(1, kCPUBroadcastGrainSize / inner);
+  int num_chunks =
+      backends::cpu::GetIntraOpChunkNum(0, plan.outer, grain_size);
+
+  // Chunks may accumulate into the same element of a broadcast input's
+  // gradient, so each chunk owns a private partial buffer for it, which
+  // are summed in the chunk order. This is only worthwhile when the
+  // gradient is small compared with output.
+  const bool dx_reduced = dx != nullptr && x_numel != plan.numel;
+  const bool dy_reduced = dy != nullptr && y_numel != plan.numel;
+  const int64_t partial_numel =
+      (dx_reduced ? x_numel : 0) + (dy_reduced ? y_numel : 0);
+  if (partial_numel * num_chunks > plan.numel) {
+    num_chunks = 1;
+  }
+  std::vector<T> partials;
+  if (num_chunks > 1 && partial_numel > 0) {
+    partials.assign(partial_numel * num_chunks, static_cast<T>(0));
+  }
+
+  const int64_t chunk_size = (plan.outer + num_chunks - 1) / num_chunks;
+  auto run_chunk = [&](int64_t begin, int64_t end) {
+    T *dx_buf = dx;
+    T *dy_buf = dy;
+    if (!partials.empty()) {
+      T *partial = partials.data() + begin / chunk_size * partial_numel;
+      if (dx_reduced) {
+        dx_buf = partial;
+        partial += x_numel;
+      }
+      if (dy_reduced) {
+        dy_buf = partial;
+      }
+    }
+    CPUBroadcastOuterIterator iter(plan, begin);
+    for (int64_t i = begin; i < end; ++i) {
+      const int64_t x_offset = iter.x_offset();
+      const int64_t y_offset = iter.y_offset();
+      BroadcastGradInnerRunCPU<XContiguous, YContiguous>(
+          x + x_offset,
+          y + y_offset,
+          out + i * inner,
+          dout + i * inner,
+          inner,
+          dx_op,
+          dy_op,
+          dx_buf == nullptr ? nullptr : dx_buf + x_offset,
+          dy_buf == nullptr ? nullptr : dy_buf + y_offset);
+      iter.Next();
+    }
+  };
+  if (num_chunks > 1) {
+    ctx.ParallelFor(0, plan.outer, chunk_size, run_chunk);
+  } else {
+    run_chunk(0, plan.outer);
+  }
+
+  if (!partials.empty()) {
+    for (int t = 0; t < num_chunks; ++t) {
+      const T *partial = partials.data() + t * partial_numel;
+      if (dx_reduced) {
+        for (int64_t i = 0; i < x_numel; ++i) {
+          dx[i] += partial[i];
+        }
+        partial += x_numel;
+      }
+      if (dy_reduced) {
+        for (int64_t i = 0; i < y_numel; ++i) {
+          dy[i] += partial[i];
+        }
+      }
+    }
+  }
+}
+
+// dx += reduce(dx_op(x, y, out, dout)), dy += reduce(dy_op(x, y, out, dout)),
+// where the reduction is over the broadcast dimensions of x and y. dx and dy
+// must be zero-initialized, and either of them can be nullptr.
+template <typename T, typename DX_OP, typename DY_OP, typename Tout = T>
+void BroadcastGradCPU(const CPUContext &ctx,
+                      const CPUBroadcastPlan &plan,
+                      const T *x,
+                      const T *y,
+                      const Tout *out,
+                      const Tout *dout,
+                      int64_t x_numel,
+                      int64_t y_numel,
+                      DX_OP dx_op,
+                      DY_OP dy_op,
+                      T *dx,
+                      T *dy) {
+  if (plan.numel == 0) {
+    return;
+  }
+  if (plan.x_inner_contiguous && plan.y_inner_contiguous) {
+    BroadcastGradCPUImpl<true, true>(
+        ctx, plan, x, y, out, dout, x_numel, y_numel, dx_op, dy_op, dx, dy);
+  } else if (plan.x_inner_contiguous) {
+    BroadcastGradCPUImpl<true, false>(
+        ctx, plan, x, y, out, dout, x_numel, y_numel, dx_op, dy_op, dx, dy);
+  } else if (plan.y_inner_contiguous) {
+    BroadcastGradCPUImpl<false, true>(
+        ctx, plan, x, y, out, dout, x_numel, y_numel, dx_op, dy_op, dx, dy);
+  } else {
+    BroadcastGradCPUImpl<false, false>(
+        ctx, plan, x, y, out, dout, x_numel, y_numel, dx_op, dy_op, dx, dy);
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
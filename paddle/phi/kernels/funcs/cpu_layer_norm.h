@@ -0,0 +1,289 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * Fused layer_norm on CPU. The input is viewed as a [left, right] matrix
+ * normalized along its rows. Every row is read from memory once: the
+ * statistics are computed in one sweep and the following sweeps over the
+ * same row hit the cache. Rows are split across threads by
+ * CPUContext::ParallelFor.
+ *
+ * The loops work on kLayerNormLanes independent accumulators updated in
+ * lockstep, so that the compiler vectorizes them without reordering the
+ * floating point operations itself.
+ */
+constexpr int kLayerNormLanes = 8;
+
+// Rows whose gradients of scale and bias are reduced into one partial
+// buffer are grouped by the shape only, so that the result of the backward
+// does not depend on the number of threads.
+constexpr int64_t kLayerNormGradMaxBlocks = 64;
+
+// Mean and variance of x[0, n) by Welford's algorithm, which keeps the
+// precision for rows with a large mean.
+template <typename T>
+inline void LayerNormRowMoments(const T *x, int64_t n, T *mean, T *var) {
+  T lane_mean[kLayerNormLanes] = {0};
+  T lane_m2[kLayerNormLanes] = {0};
+  const int64_t steps = n / kLayerNormLanes;
+  for (int64_t k = 0; k < steps; ++k) {
+    const T inv_count = static_cast<T>(1) / static_cast<T>(k + 1);
+    const T *px = x + k * kLayerNormLanes;
+    for (int l = 0; l < kLayerNormLanes; ++l) {
+      const T delta = px[l] - lane_mean[l];
+      lane_mean[l] += delta * inv_count;
+      lane_m2[l] += delta * (px[l] - lane_mean[l]);
+    }
+  }
+
+  // Merge the lanes, each of which holds `steps` elements, by Chan's
+  // formula, and then add the tail of the row.
+  T m = static_cast<T>(0);
+  T m2 = static_cast<T>(0);
+  int64_t count = 0;
+  if (steps > 0) {
+    for (int l = 0; l < kLayerNormLanes; ++l) {
+      const int64_t new_count = count + steps;
+      const T delta = lane_mean[l] - m;
+      const T weight = static_cast<T>(steps) / static_cast<T>(new_count);
+      m += delta * weight;
+      m2 += lane_m2[l] + delta * delta * static_cast<T>(count) * weight;
+      count = new_count;
+    }
+  }
+  for (int64_t i = steps * kLayerNormLanes; i < n; ++i) {
+    ++count;
+    const T delta = x[i] - m;
+    m += delta / static_cast<T>(count);
+    m2 += delta * (x[i] - m);
+  }
+  *mean = m;
+  *var = count > 0 ? m2 / static_cast<T>(count) : static_cast<T>(0);
+}
+
+template <typename T>
+inline void LayerNormRowForward(const T *x,
+                                const T *scale,
+                                const T *bias,
+                                int64_t n,
+                                T epsilon,
+                                T *y,
+                                T *mean,
+                                T *var) {
+  LayerNormRowMoments(x, n, mean, var);
+  const T m = *mean;
+  const T rstd = static_cast<T>(1) / std::sqrt(*var + epsilon);
+  if (scale != nullptr && bias != nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = (x[i] - m) * rstd * scale[i] + bias[i];
+    }
+  } else if (scale != nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = (x[i] - m) * rstd * scale[i];
+    }
+  } else if (bias != nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = (x[i] - m) * rstd + bias[i];
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = (x[i] - m) * rstd;
+    }
+  }
+}
+
+// y = (x - mean) / sqrt(var + epsilon) * scale + bias, where scale and bias
+// may be nullptr.
+template <typename T>
+void LayerNormForwardCPU(const CPUContext &ctx,
+                         const T *x,
+                         const T *scale,
+                         const T *bias,
+                         int64_t left,
+                         int64_t right,
+                         T epsilon,
+                         T *y,
+                         T *mean,
+                         T *var) {
+  const int64_t grain_size = std::max<int64_t>(
+      1, backends::cpu::kIntraOpGrainSize / std::max<int64_t>(right, 1));
+  ctx.ParallelFor(0, left, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      LayerNormRowForward(x + i * right,
+                          scale,
+                          bias,
+                          right,
+                          epsilon,
+                          y + i * right,
+                          mean + i,
+                          var + i);
+    }
+  });
+}
+
+// Gradient of one row. The gradients of scale and bias of the row are
+// accumulated into d_scale_acc and d_bias_acc when they are not nullptr.
+template <typename T>
+inline void LayerNormRowBackward(const T *x,
+                                 const T *dy,
+                                 const T *scale,
+                                 T mean,
+                                 T var,
+                                 int64_t n,
+                                 T epsilon,
+                                 T *dx,
+                                 T *d_scale_acc,
+                                 T *d_bias_acc) {
+  const T rstd = static_cast<T>(1) / std::sqrt(var + epsilon);
+  if (d_scale_acc != nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      d_scale_acc[i] += dy[i] * (x[i] - mean) * rstd;
+    }
+  }
+  if (d_bias_acc != nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      d_bias_acc[i] += dy[i];
+    }
+  }
+  if (dx == nullptr) {
+    return;
+  }
+
+  // With g = dy * scale and x_norm = (x - mean) * rstd,
+  // dx = rstd * (g - mean(g) - x_norm * mean(g * x_norm)).
+  T lane_g[kLayerNormLanes] = {0};
+  T lane_g_norm[kLayerNormLanes] = {0};
+  const int64_t body = n / kLayerNormLanes * kLayerNormLanes;
+  for (int64_t k = 0; k < body; k += kLayerNormLanes) {
+    for (int l = 0; l < kLayerNormLanes; ++l) {
+      const T g = scale == nullptr ? dy[k + l] : dy[k + l] * scale[k + l];
+      lane_g[l] += g;
+      lane_g_norm[l] += g * (x[k + l] - mean) * rstd;
+    }
+  }
+  T sum_g = static_cast<T>(0);
+  T sum_g_norm = static_cast<T>(0);
+  for (int l = 0; l < kLayerNormLanes; ++l) {
+    sum_g += lane_g[l];
+    sum_g_norm += lane_g_norm[l];
+  }
+  for (int64_t i = body; i < n; ++i) {
+    const T g = scale == nullptr ? dy[i] : dy[i] * scale[i];
+    sum_g += g;
+    sum_g_norm += g * (x[i] - mean) * rstd;
+  }
+  const T mean_g = sum_g / static_cast<T>(n);
+  const T mean_g_norm = sum_g_norm / static_cast<T>(n);
+  if (scale != nullptr) {
+    for (int64_t i = 0; i < n; ++i) {
+      const T x_norm = (x[i] - mean) * rstd;
+      dx[i] = (dy[i] * scale[i] - mean_g - x_norm * mean_g_norm) * rstd;
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      const T x_norm = (x[i] - mean) * rstd;
+      dx[i] = (dy[i] - mean_g - x_norm * mean_g_norm) * rstd;
+    }
+  }
+}
+
+// Gradients of LayerNormForwardCPU. Any of dx, d_scale and d_bias may be
+// nullptr, and a nullptr scale stands for a scale of ones.
+template <typename T>
+void LayerNormBackwardCPU(const CPUContext &ctx,
+                          const T *x,
+                          const T *mean,
+                          const T *var,
+                          const T *dy,
+                          const T *scale,
+                          int64_t left,
+                          int64_t right,
+                          T epsilon,
+                          T *dx,
+                          T *d_scale,
+                          T *d_bias) {
+  if (right <= 0) {
+    return;
+  }
+  const int64_t block_rows = std::max<int64_t>(
+      1, (left + kLayerNormGradMaxBlocks - 1) / kLayerNormGradMaxBlocks);
+  const int64_t num_blocks = (left + block_rows - 1) / block_rows;
+  std::vector<T> d_scale_partial;
+  std::vector<T> d_bias_partial;
+  if (d_scale != nullptr) {
+    d_scale_partial.assign(num_blocks * right, static_cast<T>(0));
+  }
+  if (d_bias != nullptr) {
+    d_bias_partial.assign(num_blocks * right, static_cast<T>(0));
+  }
+
+  const int64_t grain_size = std::max<int64_t>(
+      1, backends::cpu::kIntraOpGrainSize / (block_rows * right));
+  ctx.ParallelFor(0, num_blocks, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t block = begin; block < end; ++block) {
+      T *d_scale_acc = d_scale == nullptr
+                           ? nullptr
+                           : d_scale_partial.data() + block * right;
+      T *d_bias_acc =
+          d_bias == nullptr ? nullptr : d_bias_partial.data() + block * right;
+      const int64_t row_end = std::min(left, (block + 1) * block_rows);
+      for (int64_t i = block * block_rows; i < row_end; ++i) {
+        LayerNormRowBackward(x + i * right,
+                             dy + i * right,
+                             scale,
+                             mean[i],
+                             var[i],
+                             right,
+                             epsilon,
+                             dx == nullptr ? nullptr : dx + i * right,
+                             d_scale_acc,
+                             d_bias_acc);
+      }
+    }
+  });
+
+  // Sum up the partial gradients of scale and bias in the block order.
+  if (d_scale != nullptr) {
+    std::fill(d_scale, d_scale + right, static_cast<T>(0));
+    for (int64_t block = 0; block < num_blocks; ++block) {
+      const T *partial = d_scale_partial.data() + block * right;
+      for (int64_t j = 0; j < right; ++j) {
+        d_scale[j] += partial[j];
+      }
+    }
+  }
+  if (d_bias != nullptr) {
+    std::fill(d_bias, d_bias + right, static_cast<T>(0));
+    for (int64_t block = 0; block < num_blocks; ++block) {
+      const T *partial = d_bias_partial.data() + block * right;
+      for (int64_t j = 0; j < right; ++j) {
+        d_bias[j] += partial[j];
+      }
+    }
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
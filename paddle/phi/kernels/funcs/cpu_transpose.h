@@ -0,0 +1,331 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/dims_simplifier.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * Transpose on CPU. Consecutive axes which stay consecutive after the
+ * permutation are merged first by PermuteDimsSimplifier, then:
+ * 1. if the innermost axis is kept, the output is built from contiguous
+ *    runs of the input;
+ * 2. otherwise the innermost axis of the input and the innermost axis of
+ *    the output form a 2D plane, transposed in kCPUTransposeBlock square
+ *    blocks of micro tiles, which are SIMD on AVX for 4 and 8 byte types.
+ * Work is split across threads by CPUContext::ParallelFor. The transpose
+ * only moves data, so elements are handled as unsigned integers of the
+ * same size and every type of 1, 2, 4 or 8 bytes shares the same code.
+ */
+constexpr int64_t kCPUTransposeBlock = 32;
+
+// Transpose a kSize x kSize tile: dst[j * dst_ld + i] = src[i * src_ld + j].
+template <typename T>
+struct TransposeMicroKernel {
+  static constexpr int kSize = 8;
+  static inline void Run(const T *src,
+                         int64_t src_ld,
+                         T *dst,
+                         int64_t dst_ld) {
+    for (int i = 0; i < kSize; ++i) {
+      for (int j = 0; j < kSize; ++j) {
+        dst[j * dst_ld + i] = src[i * src_ld + j];
+      }
+    }
+  }
+};
+
+#ifdef __AVX__
+template <>
+struct TransposeMicroKernel<uint32_t> {
+  static constexpr int kSize = 8;
+  static inline void Run(const uint32_t *src,
+                         int64_t src_ld,
+                         uint32_t *dst,
+                         int64_t dst_ld) {
+    const float *s = reinterpret_cast<const float *>(src);
+    float *d = reinterpret_cast<float *>(dst);
+    __m256 r0 = _mm256_loadu_ps(s);
+    __m256 r1 = _mm256_loadu_ps(s + src_ld);
+    __m256 r2 = _mm256_loadu_ps(s + 2 * src_ld);
+    __m256 r3 = _mm256_loadu_ps(s + 3 * src_ld);
+    __m256 r4 = _mm256_loadu_ps(s + 4 * src_ld);
+    __m256 r5 = _mm256_loadu_ps(s + 5 * src_ld);
+    __m256 r6 = _mm256_loadu_ps(s + 6 * src_ld);
+    __m256 r7 = _mm256_loadu_ps(s + 7 * src_ld);
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+    __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+    __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+    r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    _mm256_storeu_ps(d, _mm256_permute2f128_ps(r0, r4, 0x20));
+    _mm256_storeu_ps(d + dst_ld, _mm256_permute2f128_ps(r1, r5, 0x20));
+    _mm256_storeu_ps(d + 2 * dst_ld, _mm256_permute2f128_ps(r2, r6, 0x20));
+    _mm256_storeu_ps(d + 3 * dst_ld, _mm256_permute2f128_ps(r3, r7, 0x20));
+    _mm256_storeu_ps(d + 4 * dst_ld, _mm256_permute2f128_ps(r0, r4, 0x31));
+    _mm256_storeu_ps(d + 5 * dst_ld, _mm256_permute2f128_ps(r1, r5, 0x31));
+    _mm256_storeu_ps(d + 6 * dst_ld, _mm256_permute2f128_ps(r2, r6, 0x31));
+    _mm256_storeu_ps(d + 7 * dst_ld, _mm256_permute2f128_ps(r3, r7, 0x31));
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint64_t> {
+  static constexpr int kSize = 4;
+  static inline void Run(const uint64_t *src,
+                         int64_t src_ld,
+                         uint64_t *dst,
+                         int64_t dst_ld) {
+    const double *s = reinterpret_cast<const double *>(src);
+    double *d = reinterpret_cast<double *>(dst);
+    __m256d r0 = _mm256_loadu_pd(s);
+    __m256d r1 = _mm256_loadu_pd(s + src_ld);
+    __m256d r2 = _mm256_loadu_pd(s + 2 * src_ld);
+    __m256d r3 = _mm256_loadu_pd(s + 3 * src_ld);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(d + dst_ld, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(d + 2 * dst_ld, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(d + 3 * dst_ld, _mm256_permute2f128_pd(t1, t3, 0x31));
+  }
+};
+#endif
+
+// Transpose a rows x cols block: dst[j * dst_ld + i] = src[i * src_ld + j].
+template <typename T>
+inline void TransposeBlockCPU(const T *src,
+                              int64_t src_ld,
+                              T *dst,
+                              int64_t dst_ld,
+                              int64_t rows,
+                              int64_t cols) {
+  constexpr int kSize = TransposeMicroKernel<T>::kSize;
+  int64_t i = 0;
+  for (; i + kSize <= rows; i += kSize) {
+    int64_t j = 0;
+    for (; j + kSize <= cols; j += kSize) {
+      TransposeMicroKernel<T>::Run(
+          src + i * src_ld + j, src_ld, dst + j * dst_ld + i, dst_ld);
+    }
+    for (; j < cols; ++j) {
+      for (int64_t k = i; k < i + kSize; ++k) {
+        dst[j * dst_ld + k] = src[k * src_ld + j];
+      }
+    }
+  }
+  for (; i < rows; ++i) {
+    for (int64_t j = 0; j < cols; ++j) {
+      dst[j * dst_ld + i] = src[i * src_ld + j];
+    }
+  }
+}
+
+template <typename T>
+void TransposeCPUImpl(const CPUContext &ctx,
+                      const T *in,
+                      T *out,
+                      const PermuteDimsSimplifier &simplifier) {
+  const int rank = simplifier.GetRank();
+  const int64_t numel = simplifier.GetCount();
+  const std::vector<int> &perm = simplifier.GetPerm();
+  const std::vector<int64_t> &src_dims = simplifier.GetSrcDims();
+  const std::vector<int64_t> &dst_dims = simplifier.GetDstDims();
+
+  if (rank == 1) {
+    auto copy = [&](int64_t begin, int64_t end) {
+      std::memcpy(out + begin, in + begin, (end - begin) * sizeof(T));
+    };
+    ctx.ParallelFor(0, numel, backends::cpu::kIntraOpGrainSize, copy);
+    return;
+  }
+
+  std::vector<int64_t> src_strides(rank, 1);
+  std::vector<int64_t> dst_strides(rank, 1);
+  for (int i = rank - 2; i >= 0; --i) {
+    src_strides[i] = src_strides[i + 1] * src_dims[i + 1];
+    dst_strides[i] = dst_strides[i + 1] * dst_dims[i + 1];
+  }
+  // Stride in the input of every axis of the output.
+  std::vector<int64_t> src_strides_of_dst(rank);
+  for (int i = 0; i < rank; ++i) {
+    src_strides_of_dst[i] = src_strides[perm[i]];
+  }
+
+  if (perm[rank - 1] == rank - 1) {
+    // The output is made of contiguous runs of the input.
+    const int64_t run = dst_dims[rank - 1];
+    const int64_t grain_size =
+        std::max<int64_t>(1, backends::cpu::kIntraOpGrainSize / run);
+    ctx.ParallelFor(
+        0, numel / run, grain_size, [&](int64_t begin, int64_t end) {
+          std::vector<int64_t> index(rank - 1, 0);
+          int64_t src_offset = 0;
+          int64_t remain = begin;
+          for (int i = rank - 2; i >= 0; --i) {
+            index[i] = remain % dst_dims[i];
+            remain /= dst_dims[i];
+            src_offset += index[i] * src_strides_of_dst[i];
+          }
+          for (int64_t row = begin; row < end; ++row) {
+            std::memcpy(out + row * run, in + src_offset, run * sizeof(T));
+            for (int i = rank - 2; i >= 0; --i) {
+              src_offset += src_strides_of_dst[i];
+              if (++index[i] < dst_dims[i]) {
+                break;
+              }
+              src_offset -= index[i] * src_strides_of_dst[i];
+              index[i] = 0;
+            }
+          }
+        });
+    return;
+  }
+
+  // The innermost axis of the output is axis `row_axis` of the input, and
+  // the innermost axis of the input is axis `col_axis` of the output.
+  const int row_axis = perm[rank - 1];
+  const int col_axis = static_cast<int>(
+      std::find(perm.begin(), perm.end(), rank - 1) - perm.begin());
+  const int64_t rows = src_dims[row_axis];
+  const int64_t cols = src_dims[rank - 1];
+  const int64_t src_ld = src_strides[row_axis];
+  const int64_t dst_ld = dst_strides[col_axis];
+
+  // The other axes, in the order of the output, index the planes.
+  std::vector<int64_t> batch_dims;
+  std::vector<int64_t> batch_src_strides;
+  std::vector<int64_t> batch_dst_strides;
+  for (int i = 0; i < rank; ++i) {
+    if (i != col_axis && i != rank - 1) {
+      batch_dims.push_back(dst_dims[i]);
+      batch_src_strides.push_back(src_strides_of_dst[i]);
+      batch_dst_strides.push_back(dst_strides[i]);
+    }
+  }
+  const int batch_rank = batch_dims.size();
+
+  const int64_t row_blocks =
+      (rows + kCPUTransposeBlock - 1) / kCPUTransposeBlock;
+  const int64_t col_blocks =
+      (cols + kCPUTransposeBlock - 1) / kCPUTransposeBlock;
+  const int64_t plane_blocks = row_blocks * col_blocks;
+  auto transpose_blocks = [&](int64_t begin, int64_t end) {
+    for (int64_t block = begin; block < end; ++block) {
+      int64_t remain = block / plane_blocks;
+      int64_t src_offset = 0;
+      int64_t dst_offset = 0;
+      for (int i = batch_rank - 1; i >= 0; --i) {
+        const int64_t index = remain % batch_dims[i];
+        remain /= batch_dims[i];
+        src_offset += index * batch_src_strides[i];
+        dst_offset += index * batch_dst_strides[i];
+      }
+      const int64_t plane_block = block % plane_blocks;
+      const int64_t row_begin = plane_block / col_blocks * kCPUTransposeBlock;
+      const int64_t col_begin = plane_block % col_blocks * kCPUTransposeBlock;
+      TransposeBlockCPU(in + src_offset + row_begin * src_ld + col_begin,
+                        src_ld,
+                        out + dst_offset + col_begin * dst_ld + row_begin,
+                        dst_ld,
+                        std::min(kCPUTransposeBlock, rows - row_begin),
+                        std::min(kCPUTransposeBlock, cols - col_begin));
+    }
+  };
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      backends::cpu::kIntraOpGrainSize /
+          (kCPUTransposeBlock * kCPUTransposeBlock));
+  ctx.ParallelFor(0,
+                  numel / (rows * cols) * plane_blocks,
+                  grain_size,
+                  transpose_blocks);
+}
+
+// Type by which the elements of T are moved.
+template <typename T, size_t Size = sizeof(T)>
+struct TransposeElement {
+  using Type = T;
+};
+template <typename T>
+struct TransposeElement<T, 1> {
+  using Type = uint8_t;
+};
+template <typename T>
+struct TransposeElement<T, 2> {
+  using Type = uint16_t;
+};
+template <typename T>
+struct TransposeElement<T, 4> {
+  using Type = uint32_t;
+};
+template <typename T>
+struct TransposeElement<T, 8> {
+  using Type = uint64_t;
+};
+
+// out = transpose(in, axis) for any rank and any element type.
+template <typename T>
+void TransposeCPU(const CPUContext &ctx,
+                  const DenseTensor &in,
+                  DenseTensor *out,
+                  const std::vector<int> &axis) {
+  const int64_t numel = in.numel();
+  if (numel == 0) {
+    return;
+  }
+  const int rank = axis.size();
+  const T *in_data = in.data<T>();
+  T *out_data = out->data<T>();
+  if (rank <= 1) {
+    std::memcpy(out_data, in_data, numel * sizeof(T));
+    return;
+  }
+  PermuteDimsSimplifier simplifier(
+      rank, numel, axis, phi::vectorize<int64_t>(in.dims()));
+  using U = typename TransposeElement<T>::Type;
+  TransposeCPUImpl<U>(ctx,
+                      reinterpret_cast<const U *>(in_data),
+                      reinterpret_cast<U *>(out_data),
+                      simplifier);
+}
+
+}  // namespace funcs
+}  // namespace phi
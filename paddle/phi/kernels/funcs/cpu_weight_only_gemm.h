@@ -0,0 +1,187 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/weight_only_quant.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * Weight-only quantized matrix multiplication on CPU, out = x * w + bias,
+ * where x is a [m, k] float matrix and w a [k, n] weight quantized as
+ * described in weight_only_quant.h.
+ */
+constexpr int kWeightOnlyLanes = 8;
+
+// Output channels whose weight rows are decoded and multiplied together.
+constexpr int64_t kWeightOnlyRowGroup = 4;
+
+// Above this number of rows of x the multiplication is compute bound. The
+// weight is then dequantized panel by panel and handed to the BLAS GEMM.
+constexpr int64_t kWeightOnlyGemvMaxRows = 16;
+constexpr int64_t kWeightOnlyPanelCols = 64;
+
+template <typename T>
+inline T WeightOnlyEpilogue(
+    T acc, float scale, const T* bias, int64_t j, bool with_relu) {
+  T val = acc * static_cast<T>(scale);
+  if (bias != nullptr) {
+    val += bias[j];
+  }
+  return with_relu && val < static_cast<T>(0) ? static_cast<T>(0) : val;
+}
+
+// Multiply every row of x by the `rows` decoded weight rows in w, which
+// are k apart, and write the results of the output channels [j, j + rows).
+template <typename T>
+inline void WeightOnlyGemvGroup(const T* x,
+                                const T* w,
+                                const float* scale,
+                                const T* bias,
+                                int64_t m,
+                                int64_t n,
+                                int64_t k,
+                                int64_t j,
+                                int64_t rows,
+                                bool with_relu,
+                                T* out) {
+  const int64_t body = k / kWeightOnlyLanes * kWeightOnlyLanes;
+  for (int64_t i = 0; i < m; ++i) {
+    const T* px = x + i * k;
+    T acc[kWeightOnlyRowGroup][kWeightOnlyLanes] = {{0}};
+    for (int64_t p = 0; p < body; p += kWeightOnlyLanes) {
+      for (int64_t r = 0; r < kWeightOnlyRowGroup; ++r) {
+        const T* pw = w + r * k + p;
+        for (int l = 0; l < kWeightOnlyLanes; ++l) {
+          acc[r][l] += px[p + l] * pw[l];
+        }
+      }
+    }
+    for (int64_t r = 0; r < rows; ++r) {
+      T sum = static_cast<T>(0);
+      for (int l = 0; l < kWeightOnlyLanes; ++l) {
+        sum += acc[r][l];
+      }
+      for (int64_t p = body; p < k; ++p) {
+        sum += px[p] * w[r * k + p];
+      }
+      out[i * n + j + r] =
+          WeightOnlyEpilogue(sum, scale[j + r], bias, j + r, with_relu);
+    }
+  }
+}
+
+/*
+ * out[m, n] = x[m, k] * dequant(qweight) + bias, followed by relu if
+ * with_relu. bias may be nullptr.
+ *
+ * Small batches are memory bound: every group of output channels is
+ * decoded once into a buffer that stays in L1 and multiplied by all rows
+ * of x, so the weight is read from memory as integers only. The groups are
+ * split across threads by CPUContext::ParallelFor.
+ */
+template <typename T>
+void WeightOnlyGemmCPU(const CPUContext& ctx,
+                       const T* x,
+                       const int8_t* qweight,
+                       const float* scale,
+                       const T* bias,
+                       int64_t m,
+                       int64_t n,
+                       int64_t k,
+                       int bits,
+                       bool with_relu,
+                       T* out) {
+  CheckWeightOnlyBits(bits);
+  if (m <= 0 || n <= 0) {
+    return;
+  }
+  const int64_t row_bytes = WeightOnlyRowBytes(k, bits);
+
+  if (m > kWeightOnlyGemvMaxRows) {
+    auto blas = GetBlas<CPUContext, T>(ctx);
+    std::vector<T> panel(kWeightOnlyPanelCols * k);
+    for (int64_t j0 = 0; j0 < n; j0 += kWeightOnlyPanelCols) {
+      const int64_t cols = std::min(kWeightOnlyPanelCols, n - j0);
+      ctx.ParallelFor(0, cols, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t c = begin; c < end; ++c) {
+          T* row = panel.data() + c * k;
+          WeightOnlyDecodeRow(qweight + (j0 + c) * row_bytes, k, bits, row);
+          const T s = static_cast<T>(scale[j0 + c]);
+          for (int64_t p = 0; p < k; ++p) {
+            row[p] *= s;
+          }
+        }
+      });
+      blas.GEMM(CblasNoTrans,
+                CblasTrans,
+                static_cast<int>(m),
+                static_cast<int>(cols),
+                static_cast<int>(k),
+                static_cast<T>(1),
+                x,
+                static_cast<int>(k),
+                panel.data(),
+                static_cast<int>(k),
+                static_cast<T>(0),
+                out + j0,
+                static_cast<int>(n));
+    }
+    if (bias != nullptr || with_relu) {
+      const int64_t grain_size = std::max<int64_t>(
+          1, backends::cpu::kIntraOpGrainSize / std::max<int64_t>(n, 1));
+      ctx.ParallelFor(0, m, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          T* pout = out + i * n;
+          for (int64_t j = 0; j < n; ++j) {
+            pout[j] = WeightOnlyEpilogue(pout[j], 1.f, bias, j, with_relu);
+          }
+        }
+      });
+    }
+    return;
+  }
+
+  const int64_t num_groups =
+      (n + kWeightOnlyRowGroup - 1) / kWeightOnlyRowGroup;
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      backends::cpu::kIntraOpGrainSize /
+          std::max<int64_t>(kWeightOnlyRowGroup * k * m, 1));
+  ctx.ParallelFor(0, num_groups, grain_size, [&](int64_t begin, int64_t end) {
+    // The rows of the last group past n are computed but never written.
+    std::vector<T> w(kWeightOnlyRowGroup * k, static_cast<T>(0));
+    for (int64_t g = begin; g < end; ++g) {
+      const int64_t j = g * kWeightOnlyRowGroup;
+      const int64_t rows = std::min(kWeightOnlyRowGroup, n - j);
+      for (int64_t r = 0; r < rows; ++r) {
+        WeightOnlyDecodeRow(
+            qweight + (j + r) * row_bytes, k, bits, w.data() + r * k);
+      }
+      WeightOnlyGemvGroup(
+          x, w.data(), scale, bias, m, n, k, j, rows, with_relu, out);
+    }
+  });
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -49,7 +49,26 @@ struct BroadcastDimsSimplifier {
       }
     }
     ExtendInputDimensions(N, axis);
+    SimplifyDimensions();
+  }
 
+  // Used by the CPU broadcast path, whose input shapes have already been
+  // aligned to the rank of output by GetBroadcastDimsArrays.
+  BroadcastDimsSimplifier(const std::vector<DimVector> &ins_dims,
+                          const DimVector &dims) {
+    N = std::max(static_cast<int>(ins_dims.size()), 2);
+    rank = dims.size();
+    out_dims = dims;
+    in_dims = ins_dims;
+    if (ins_dims.size() == 1) {
+      in_dims.emplace_back(out_dims);
+    }
+    ExtendInputDimensions(N, 0);
+    SimplifyDimensions();
+  }
+
+ private:
+  void SimplifyDimensions() {
     // To Merge the dimensions of input_tensors while the consequtive
     // equal-dimensions appears. Example below :
     //   in_1.shape = [2, 3, 4, 5]    in_1.shape = [2, 12, 5]
@@ -99,14 +118,13 @@ struct BroadcastDimsSimplifier {
     }
   }
 
- private:
   // To compensate the lackage of input_tensors' dimension with axis.
   void ExtendInputDimensions(int N, int axis) {
     for (auto &in_dim : in_dims) {
-      if (in_dim.size() < rank) {
+      if (static_cast<int>(in_dim.size()) < rank) {
         DimVector extended_in_dim(rank, 1);
         int out_idx = axis;
-        for (int in_idx = 0; in_idx < in_dim.size(); in_idx++) {
+        for (size_t in_idx = 0; in_idx < in_dim.size(); in_idx++) {
           if (in_dim[in_idx] == out_dims[out_idx] || in_dim[in_idx] == 1) {
             extended_in_dim[out_idx] = in_dim[in_idx];
             out_idx++;
@@ -150,7 +168,7 @@ struct BroadcastDimsSimplifier {
   // Merge sequential dimension to shrink calculation cost for
   // offset computation in CUDA Kernel.
   template <typename MergeFunctor>
-  __inline__ void MergeDimensions(MergeFunctor merge_func, int N) {
+  inline void MergeDimensions(MergeFunctor merge_func, int N) {
     auto VectorReorganise = [](DimVector *vec, int l_idx, int m_idx) {
       (*vec)[m_idx - 1] = std::accumulate(vec->begin() + l_idx,
                                           vec->begin() + m_idx,
@@ -228,7 +246,7 @@ struct PermuteDimsSimplifier {
                         const int64_t numel,
                         const std::vector<int32_t> &perm,
                         const std::vector<int64_t> &dims)
-      : perm_(rank), src_dims_(rank), count_(numel) {
+      : count_(numel), perm_(rank), src_dims_(rank) {
     SimplifyPermAndDims(rank, dims, perm);
     perm_.resize(rank_);
     src_dims_.resize(rank_);
@@ -291,7 +309,7 @@ struct PermuteDimsSimplifier {
     // valid_map is [0, -1, 1, -1] and generate simplified
     // dims as [32, 10]
     for (auto i = 0; i < rank; ++i) {
-      const int dim_val = combined_dims[i];
+      const int64_t dim_val = combined_dims[i];
       if (dim_val == 1) {
         valid_map[i] = -1;
       } else {
@@ -19,6 +19,7 @@ limitations under the License. */
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/kernels/empty_kernel.h"
 #include "paddle/phi/kernels/funcs/common_shape.h"
+#include "paddle/phi/kernels/funcs/cpu_broadcast.h"
 #include "paddle/phi/kernels/funcs/elementwise_utils.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
@@ -224,44 +225,6 @@ class TransformFunctor {
     trans(ctx_, x_, x_ + nx_, y_, z_, func_);
   }
 
-  inline void RunRowWise(int n, int pre) const {
-    paddle::platform::Transform<DeviceContext> trans;
-    if (is_xsize_larger_) {
-      trans(ctx_,
-            x_,
-            x_ + nx_,
-            RowwiseTransformIterator<T, DeviceContext>(y_, n),
-            z_,
-            func_);
-    } else {
-      trans(ctx_,
-            y_,
-            y_ + nx_,
-            RowwiseTransformIterator<T, DeviceContext>(x_, n),
-            z_,
-            func_);
-    }
-  }
-
-  inline void RunMidWise(int n, int pre, int post) const {
-    paddle::platform::Transform<DeviceContext> trans;
-    if (is_xsize_larger_) {
-      trans(ctx_,
-            x_,
-            x_ + nx_,
-            MidWiseTransformIterator<T, DeviceContext>(y_, n, post),
-            z_,
-            func_);
-    } else {
-      trans(ctx_,
-            y_,
-            y_ + nx_,
-            MidWiseTransformIterator<T, DeviceContext>(x_, n, post),
-            z_,
-            func_);
-    }
-  }
-
  private:
   const T *x_;
   const T *y_;
@@ -283,7 +246,6 @@ void CommonForwardBroadcastCPU(const DenseTensor &x,
                                const CPUContext &ctx,
                                Functor func,
                                const bool is_xsize_larger = true) {
-  std::vector<int> index_array(max_dim, 0);
   const T *x_data = x.data<T>();
   const T *y_data = y.data<T>();
   PADDLE_ENFORCE_NOT_NULL(
@@ -292,19 +254,14 @@ void CommonForwardBroadcastCPU(const DenseTensor &x,
       y_data, errors::InvalidArgument("The input Y should not be empty."));
   OutType *out_data = ctx.Alloc<OutType>(z);
 
-  const int out_size = std::accumulate(
-      out_dims_array, out_dims_array + max_dim, 1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (is_xsize_larger) {
-      out_data[out_index] = func(x_data[x_index], y_data[y_index]);
-    } else {
-      out_data[out_index] = func(y_data[y_index], x_data[x_index]);
-    }
-
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
+  if (is_xsize_larger) {
+    CPUBroadcastPlan plan(x_dims_array, y_dims_array, out_dims_array, max_dim);
+    BroadcastForwardCPU<Functor, T, OutType>(
+        ctx, plan, x_data, y_data, out_data, func);
+  } else {
+    CPUBroadcastPlan plan(y_dims_array, x_dims_array, out_dims_array, max_dim);
+    BroadcastForwardCPU<Functor, T, OutType>(
+        ctx, plan, y_data, x_data, out_data, func);
   }
 }
 
@@ -363,6 +320,8 @@ void CommonElementwiseBroadcastForward(const CPUContext &dev_ctx,
 //    like AddFunctor and InverseAddFunctor.
 // 2. The corresponding GPU implementation supports all the broadcast cases,
 //    thus there is no need to define and call with XxxInverseFunctor.
+// 3. All the broadcast cases go through CPUBroadcastPlan, see
+//    cpu_broadcast.h.
 // TODO(liuyiqun): optimize the CPU implementation to support all broadcast
 // cases and avoid the need of XxxInverseFunctor.
 template <typename Functor, typename T, typename OutType = T>
@@ -403,44 +362,8 @@ void ElementwiseCompute(const CPUContext &dev_ctx,
           max_dim,
           axis));
 
-  int pre, n, post, is_run_common_broadcast, axis_trim = 0;
-  if (is_xsize_larger) {
-    auto y_dims_trimed = TrimTrailingSingularDims(y_dims);
-    axis_trim = (y_dims_trimed.size() == 0) ? x_dims.size() : axis;
-    GetMidDims(x_dims,
-               y_dims_trimed,
-               axis_trim,
-               &pre,
-               &n,
-               &post,
-               &is_run_common_broadcast);
-  } else {
-    auto x_dims_trimed = TrimTrailingSingularDims(x_dims);
-    axis_trim = (x_dims_trimed.size() == 0) ? y_dims.size() : axis;
-    GetMidDims(y_dims,
-               x_dims_trimed,
-               axis_trim,
-               &pre,
-               &n,
-               &post,
-               &is_run_common_broadcast);
-  }
-  // special case for common implementation.
-  // case 1: x=[2,3,1,5], y=[2,1,4,1]
-  // case 2: x=[2,3,4], y=[1,1,4]
-  if (is_run_common_broadcast == 1) {
-    CommonElementwiseBroadcastForward<Functor, T, OutType>(
-        dev_ctx, x, y, z, x_dims, y_dims, func, axis, is_xsize_larger);
-    return;
-  }
-
-  if (post == 1) {
-    functor.RunRowWise(n, pre);
-    return;
-  } else {
-    functor.RunMidWise(n, pre, post);
-    return;
-  }
+  CommonElementwiseBroadcastForward<Functor, T, OutType>(
+      dev_ctx, x, y, z, x_dims, y_dims, func, axis, is_xsize_larger);
 }
 
 // for broadcast backwards
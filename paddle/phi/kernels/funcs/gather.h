@@ -18,6 +18,7 @@ limitations under the License. */
 #include <cstring>
 #include <vector>
 
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/ddim.h"
 #include "paddle/phi/core/dense_tensor.h"
@@ -71,27 +72,37 @@ void CPUGather(const phi::CPUContext& ctx,
 
   const size_t slice_bytes = slice_size * sizeof(T);
 
-  for (int64_t i = 0; i < index_size; ++i) {
-    IndexT index_ = p_index[i];
-    PADDLE_ENFORCE_LT(p_index[i],
-                      input_size,
-                      phi::errors::OutOfRange(
-                          "The element of Index must be less than the size of "
-                          "input dim size of axis which is %d, but received "
-                          "index element which is %d in the %d index.",
-                          input_size,
-                          p_index[i],
-                          i));
-    PADDLE_ENFORCE_GE(p_index[i],
-                      0,
-                      phi::errors::OutOfRange(
-                          "The element of Index must be greater than or equal "
-                          "to 0, but received index element which is %d in the "
-                          "%d index.",
-                          p_index[i],
-                          i));
-    memcpy(p_output + i * slice_size, p_src + index_ * slice_size, slice_bytes);
-  }
+  // Slices are copied in parallel, an invalid index found by any chunk is
+  // rethrown by ParallelFor.
+  const int64_t grain_size =
+      std::max<int64_t>(1,
+                        phi::backends::cpu::kIntraOpGrainSize /
+                            std::max<int64_t>(slice_size, 1));
+  ctx.ParallelFor(0, index_size, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      IndexT index_ = p_index[i];
+      PADDLE_ENFORCE_LT(p_index[i],
+                        input_size,
+                        phi::errors::OutOfRange(
+                            "The element of Index must be less than the size "
+                            "of input dim size of axis which is %d, but "
+                            "received index element which is %d in the %d "
+                            "index.",
+                            input_size,
+                            p_index[i],
+                            i));
+      PADDLE_ENFORCE_GE(p_index[i],
+                        0,
+                        phi::errors::OutOfRange(
+                            "The element of Index must be greater than or "
+                            "equal to 0, but received index element which is "
+                            "%d in the %d index.",
+                            p_index[i],
+                            i));
+      memcpy(
+          p_output + i * slice_size, p_src + index_ * slice_size, slice_bytes);
+    }
+  });
 }
 
 template <typename T, typename IndexT = int>
@@ -120,28 +131,35 @@ void CPUGatherNd(const phi::CPUContext& ctx,
   }
   const size_t slice_bytes = slice_size * sizeof(T);
 
-  for (int64_t i = 0; i < remain_numel; ++i) {
-    int64_t index_ = 0;
-    int64_t temp = 1;
-    for (int64_t j = end_size - 1; j >= 0; --j) {
-      IndexT index_value = p_index[i * end_size + j];
-      PADDLE_ENFORCE_LT(
-          index_value,
-          input_dims[j],
-          phi::errors::InvalidArgument(
-              "Input(index[-1)] has wrong value, it is [%d]", index_value));
-      PADDLE_ENFORCE_GE(
-          index_value,
-          0,
-          phi::errors::InvalidArgument(
-              "The value of Input(index) must be no less than 0"));
-
-      index_ += (index_value * temp);
-      temp *= input_dims[j];
+  const int64_t grain_size =
+      std::max<int64_t>(1,
+                        phi::backends::cpu::kIntraOpGrainSize /
+                            std::max<int64_t>(slice_size, 1));
+  ctx.ParallelFor(0, remain_numel, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t index_ = 0;
+      int64_t temp = 1;
+      for (int64_t j = end_size - 1; j >= 0; --j) {
+        IndexT index_value = p_index[i * end_size + j];
+        PADDLE_ENFORCE_LT(
+            index_value,
+            input_dims[j],
+            phi::errors::InvalidArgument(
+                "Input(index[-1)] has wrong value, it is [%d]", index_value));
+        PADDLE_ENFORCE_GE(
+            index_value,
+            0,
+            phi::errors::InvalidArgument(
+                "The value of Input(index) must be no less than 0"));
+
+        index_ += (index_value * temp);
+        temp *= input_dims[j];
+      }
+      memcpy(p_output + i * slice_size,
+             p_input + index_ * slice_size,
+             slice_bytes);
     }
-    memcpy(
-        p_output + i * slice_size, p_input + index_ * slice_size, slice_bytes);
-  }
+  });
 }
 
 template <typename T, typename U>
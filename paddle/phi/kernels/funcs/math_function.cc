@@ -30,6 +30,7 @@ limitations under the License. */
 #include "paddle/phi/common/bfloat16.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/common/float16.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/math_function_impl.h"
 #include "unsupported/Eigen/CXX11/Tensor"
@@ -82,6 +83,15 @@ template struct SetConstant<phi::XPUContext, phi::dtype::complex<double>>;
 
 #endif
 
+template <typename T, int Rank>
+void Transpose<phi::CPUContext, T, Rank>::operator()(
+    const phi::CPUContext& context,
+    const phi::DenseTensor& in,
+    phi::DenseTensor* out,
+    const std::vector<int>& axis) {
+  TransposeCPU<T>(context, in, out, axis);
+}
+
 #define DEFINE_CPU_TRANS(RANK)                                            \
   template struct Transpose<phi::CPUContext, phi::dtype::float16, RANK>;  \
   template struct Transpose<phi::CPUContext, phi::dtype::bfloat16, RANK>; \
@@ -105,32 +115,13 @@ DEFINE_CPU_TRANS(4);
 DEFINE_CPU_TRANS(5);
 DEFINE_CPU_TRANS(6);
 
-template <typename DeviceContext, typename T>
-void TransposeNormal<DeviceContext, T>::operator()(
-    const DeviceContext& context,
+template <typename T>
+void TransposeNormal<phi::CPUContext, T>::operator()(
+    const phi::CPUContext& context,
     const phi::DenseTensor& in,
     phi::DenseTensor* out,
     const std::vector<int>& axis) {
-  const int rank = axis.size();
-  auto in_stride = phi::stride(in.dims());
-  auto out_stride = phi::stride(out->dims());
-  const T* in_ptr = in.data<T>();
-  T* out_ptr = out->data<T>();
-
-  auto transpose_helper = [&](int64_t beg, int64_t end) {
-    for (int64_t out_idx = beg; out_idx < end; ++out_idx) {
-      int64_t in_idx = 0;
-      int64_t tmp_idx = out_idx;
-      // calculate the input index
-      for (int i = 0; i < rank; ++i) {
-        const int64_t coordinate = tmp_idx / out_stride[i];
-        tmp_idx -= coordinate * out_stride[i];
-        in_idx += coordinate * in_stride[axis[i]];
-      }
-      out_ptr[out_idx] = in_ptr[in_idx];
-    }
-  };
-  transpose_helper(0, out->numel());
+  TransposeCPU<T>(context, in, out, axis);
 }
 
 // define transpose normal
@@ -49,6 +49,24 @@ struct Transpose {
                   const std::vector<int>& axis);
 };
 
+// CPU transposes of any rank share the cache-blocked, multi-threaded
+// TransposeCPU in cpu_transpose.h.
+template <typename T>
+struct TransposeNormal<phi::CPUContext, T> {
+  void operator()(const phi::CPUContext& context,
+                  const phi::DenseTensor& in,
+                  phi::DenseTensor* out,
+                  const std::vector<int>& axis);
+};
+
+template <typename T, int Rank>
+struct Transpose<phi::CPUContext, T, Rank> {
+  void operator()(const phi::CPUContext& context,
+                  const phi::DenseTensor& in,
+                  phi::DenseTensor* out,
+                  const std::vector<int>& axis);
+};
+
 template <typename DeviceContext, typename T>
 struct SetConstant {
   void operator()(const DeviceContext& context,
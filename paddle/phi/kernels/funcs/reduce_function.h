@@ -57,6 +57,7 @@ using dim3 = phi::kps::dim3;
 
 #endif
 
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/core/kernel_utils.h"
@@ -1237,6 +1238,99 @@ void HandleLargeDim(const DeviceContext& dev_ctx,
   output->ResizeAndAllocate(output_dim);
 }
 
+//////////////// ReduceInParallel
+
+// Returns false when the reduction is not run by this functor.
+template <typename DeviceContext, typename OutT, typename Functor>
+struct ReduceInParallel {
+  bool operator()(const DeviceContext& dev_ctx,
+                  const phi::DenseTensor& input,
+                  phi::DenseTensor* output,
+                  const std::vector<int64_t>& dims) {
+    return false;
+  }
+};
+
+// On CPU, a reduction over the trailing dims of the input is split into
+// independent rows, and a reduction over the leading dims into independent
+// columns. Every output element is reduced the same way whatever the chunk
+// it falls in, so the result does not depend on the number of threads.
+template <typename OutT, typename Functor>
+struct ReduceInParallel<phi::CPUContext, OutT, Functor> {
+  bool operator()(const phi::CPUContext& dev_ctx,
+                  const phi::DenseTensor& input,
+                  phi::DenseTensor* output,
+                  const std::vector<int64_t>& dims) {
+    const int ndim = input.dims().size();
+    const int rdim = dims.size();
+    if (rdim == 0 || rdim >= ndim || input.numel() == 0) {
+      return false;
+    }
+    std::vector<int64_t> sorted_dims = dims;
+    for (auto& dim : sorted_dims) {
+      if (dim < 0) dim += ndim;
+    }
+    std::sort(sorted_dims.begin(), sorted_dims.end());
+    for (int i = 1; i < rdim; ++i) {
+      if (sorted_dims[i] != sorted_dims[0] + i) {
+        return false;
+      }
+    }
+    const bool reduce_trailing = sorted_dims[0] == ndim - rdim;
+    const bool reduce_leading = sorted_dims[0] == 0;
+    if (!reduce_trailing && !reduce_leading) {
+      return false;
+    }
+
+    const int64_t unreduced = output->numel();
+    const int64_t reduced = input.numel() / unreduced;
+    const int64_t rows = reduce_trailing ? unreduced : reduced;
+    const int64_t cols = reduce_trailing ? reduced : unreduced;
+    const OutT* x_data = input.data<OutT>();
+    OutT* out_data = output->data<OutT>();
+    auto& place = *dev_ctx.eigen_device();
+    using DSizes2 = Eigen::DSizes<Eigen::DenseIndex, 2>;
+    using DSizes1 = Eigen::DSizes<Eigen::DenseIndex, 1>;
+    if (reduce_trailing) {
+      const int64_t grain_size =
+          std::max<int64_t>(1, backends::cpu::kIntraOpGrainSize / cols);
+      dev_ctx.ParallelFor(
+          0, rows, grain_size, [&](int64_t begin, int64_t end) {
+            typename EigenMatrix<OutT>::ConstType x(
+                x_data + begin * cols, DSizes2(end - begin, cols));
+            typename EigenVector<OutT>::Type out(out_data + begin,
+                                                 DSizes1(end - begin));
+            Functor functor;
+            functor(place, &x, &out, Eigen::array<int, 1>({{1}}));
+          });
+    } else {
+      // Eigen vectorizes a column reduction across the columns, so columns
+      // are reduced in fixed blocks to keep the rounding of every column
+      // independent of the chunk boundaries.
+      constexpr int64_t kColumnBlock = 64;
+      const int64_t num_blocks = (cols + kColumnBlock - 1) / kColumnBlock;
+      const int64_t grain_size = std::max<int64_t>(
+          1, backends::cpu::kIntraOpGrainSize / (rows * kColumnBlock));
+      typename EigenMatrix<OutT>::ConstType x(x_data, DSizes2(rows, cols));
+      dev_ctx.ParallelFor(
+          0, num_blocks, grain_size, [&](int64_t begin, int64_t end) {
+            Functor functor;
+            for (int64_t block = begin; block < end; ++block) {
+              const int64_t col_begin = block * kColumnBlock;
+              const int64_t col_num =
+                  std::min(kColumnBlock, cols - col_begin);
+              auto x_cols =
+                  x.slice(DSizes2(0, col_begin), DSizes2(rows, col_num));
+              typename EigenVector<OutT>::Type out(out_data + col_begin,
+                                                   DSizes1(col_num));
+              functor(place, &x_cols, &out, Eigen::array<int, 1>({{0}}));
+            }
+          });
+    }
+    return true;
+  }
+};
+
 ////////////// ReduceKernel
 
 template <typename DeviceContext, typename T, typename OutT, typename Functor>
@@ -1260,6 +1354,10 @@ void ReduceKernelImpl(const DeviceContext& dev_ctx,
   } else {
     int ndim = input.dims().size();
     int rdim = dims.size();
+    if (ReduceInParallel<DeviceContext, OutT, Functor>()(
+            dev_ctx, input, output, dims)) {
+      return;
+    }
     if (ndim > 6) {
       HandleLargeDim<DeviceContext, OutT, Functor>(
           dev_ctx, input, output, dims, keep_dim);
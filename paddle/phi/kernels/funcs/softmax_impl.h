@@ -247,26 +247,33 @@ class SoftmaxFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
 
     if (num_remain == 1 &&
         phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
-      const T* in_data = X->data<T>();
-      T* out_data = Y->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T max_val = *std::max_element(in_data, in_data + num_classes);
-        max_val *= static_cast<T>(-1);
-        vec_add_bias<T, phi::backends::cpu::avx>(
-            num_classes, max_val, in_data, out_data);
-        vec_clip<T, phi::backends::cpu::avx>(
-            num_classes, static_cast<T>(-64), out_data, out_data);
-        vec_exp<T>(num_classes, out_data, out_data);
-
-        T sum = 0;
-        vec_sum<T, phi::backends::cpu::avx>(num_classes, out_data, &sum);
-        sum = static_cast<T>(1) / sum;
-        vec_scal<T, phi::backends::cpu::avx>(
-            num_classes, sum, out_data, out_data);
-
-        in_data += num_classes;
-        out_data += num_classes;
-      }
+      const T* in_data_base = X->data<T>();
+      T* out_data_base = Y->data<T>();
+      const int64_t grain_size = std::max<int64_t>(
+          1, phi::backends::cpu::kIntraOpGrainSize / num_classes);
+      context.ParallelFor(
+          0, batch_size, grain_size, [&](int64_t begin, int64_t end) {
+            const T* in_data = in_data_base + begin * num_classes;
+            T* out_data = out_data_base + begin * num_classes;
+            for (int64_t bs = begin; bs < end; ++bs) {
+              T max_val = *std::max_element(in_data, in_data + num_classes);
+              max_val *= static_cast<T>(-1);
+              vec_add_bias<T, phi::backends::cpu::avx>(
+                  num_classes, max_val, in_data, out_data);
+              vec_clip<T, phi::backends::cpu::avx>(
+                  num_classes, static_cast<T>(-64), out_data, out_data);
+              vec_exp<T>(num_classes, out_data, out_data);
+
+              T sum = 0;
+              vec_sum<T, phi::backends::cpu::avx>(num_classes, out_data, &sum);
+              sum = static_cast<T>(1) / sum;
+              vec_scal<T, phi::backends::cpu::avx>(
+                  num_classes, sum, out_data, out_data);
+
+              in_data += num_classes;
+              out_data += num_classes;
+            }
+          });
     } else {
       SoftmaxEigen<DeviceContext, T>()(context, axis_dim, X, Y);
     }
@@ -403,22 +410,30 @@ class SoftmaxGradFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
 
     if (num_remain == 1 &&
         phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
-      const T* out_data = y->data<T>();
-      const T* out_grad = y_grad->data<T>();
-      T* in_grad = x_grad->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T scalar;
-        vec_mul_reduce<T, phi::backends::cpu::avx>(
-            num_classes, out_grad, out_data, &scalar);
-        scalar *= static_cast<T>(-1);
-        vec_add_bias<T, phi::backends::cpu::avx>(
-            num_classes, scalar, out_grad, in_grad);
-        vec_mul<T, phi::backends::cpu::avx>(
-            num_classes, out_data, in_grad, in_grad);
-        out_data += num_classes;
-        out_grad += num_classes;
-        in_grad += num_classes;
-      }
+      const T* out_data_base = y->data<T>();
+      const T* out_grad_base = y_grad->data<T>();
+      T* in_grad_base = x_grad->data<T>();
+      const int64_t grain_size = std::max<int64_t>(
+          1, phi::backends::cpu::kIntraOpGrainSize / num_classes);
+      context.ParallelFor(
+          0, batch_size, grain_size, [&](int64_t begin, int64_t end) {
+            const T* out_data = out_data_base + begin * num_classes;
+            const T* out_grad = out_grad_base + begin * num_classes;
+            T* in_grad = in_grad_base + begin * num_classes;
+            for (int64_t bs = begin; bs < end; ++bs) {
+              T scalar;
+              vec_mul_reduce<T, phi::backends::cpu::avx>(
+                  num_classes, out_grad, out_data, &scalar);
+              scalar *= static_cast<T>(-1);
+              vec_add_bias<T, phi::backends::cpu::avx>(
+                  num_classes, scalar, out_grad, in_grad);
+              vec_mul<T, phi::backends::cpu::avx>(
+                  num_classes, out_data, in_grad, in_grad);
+              out_data += num_classes;
+              out_grad += num_classes;
+              in_grad += num_classes;
+            }
+          });
     } else {
       SoftmaxGradEigen<DeviceContext, T>()(
           context, axis_dim, y, y_grad, x_grad);
@@ -0,0 +1,543 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/core/visit_type.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+
+/************* CSR MATRIX OF THE CPU KERNELS ************/
+
+// A batch of sparse matrices in CSR, in which the rows of all the batches
+// are concatenated, so that the row i of batch b is the row b * rows + i.
+template <typename T>
+struct CpuCsrMatrix {
+  int64_t batch_size = 1;
+  int64_t rows = 0;
+  int64_t cols = 0;
+  // batch_size * rows + 1 offsets into col_indices and values.
+  std::vector<int64_t> crows;
+  std::vector<int64_t> col_indices;
+  // Points to the values of the tensor, or to values_buffer if they are
+  // reordered.
+  const T* values = nullptr;
+  std::vector<T> values_buffer;
+};
+
+inline void GetBatchMatrixDims(const DDim& dims,
+                               int64_t* batch_size,
+                               int64_t* rows,
+                               int64_t* cols) {
+  int ndims = dims.size();
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of the matrix must be "
+                                   "greater than or eaqual to 2."));
+  *batch_size = 1;
+  for (int i = 0; i < ndims - 2; ++i) {
+    *batch_size *= dims[i];
+  }
+  *rows = dims[ndims - 2];
+  *cols = dims[ndims - 1];
+}
+
+// Build the CSR matrix of the entries (batch, row, col) of a batch of
+// rows x cols matrices by counting sort, the entries of a row keep their
+// order. for_each_entry(fn) calls fn(batch, row, col, value_index) on the
+// entries.
+template <typename T, typename ForEachEntry>
+void BuildCpuCsrMatrix(int64_t batch_size,
+                       int64_t rows,
+                       int64_t cols,
+                       int64_t nnz,
+                       const T* values,
+                       ForEachEntry for_each_entry,
+                       CpuCsrMatrix<T>* mat) {
+  mat->batch_size = batch_size;
+  mat->rows = rows;
+  mat->cols = cols;
+  mat->crows.assign(batch_size * rows + 1, 0);
+  for_each_entry([&](int64_t batch, int64_t row, int64_t col, int64_t idx) {
+    ++mat->crows[batch * rows + row + 1];
+  });
+  for (int64_t i = 0; i < batch_size * rows; ++i) {
+    mat->crows[i + 1] += mat->crows[i];
+  }
+  std::vector<int64_t> next(mat->crows.begin(), mat->crows.end() - 1);
+  mat->col_indices.resize(nnz);
+  mat->values_buffer.resize(nnz);
+  for_each_entry([&](int64_t batch, int64_t row, int64_t col, int64_t idx) {
+    int64_t pos = next[batch * rows + row]++;
+    mat->col_indices[pos] = col;
+    mat->values_buffer[pos] = values[idx];
+  });
+  mat->values = mat->values_buffer.data();
+}
+
+template <typename T, typename IntT>
+void CsrToCpuCsrMatrix(const phi::SparseCsrTensor& x,
+                       bool trans,
+                       CpuCsrMatrix<T>* mat) {
+  int64_t batch_size, rows, cols;
+  GetBatchMatrixDims(x.dims(), &batch_size, &rows, &cols);
+  const IntT* crows = x.non_zero_crows().data<IntT>();
+  const IntT* col_indices = x.non_zero_cols().data<IntT>();
+  const T* values = x.non_zero_elements().data<T>();
+  if (trans) {
+    // The crows of every batch start from 0.
+    auto for_each_entry = [&](auto fn) {
+      int64_t offset = 0;
+      for (int64_t b = 0; b < batch_size; ++b) {
+        const IntT* batch_crows = crows + b * (rows + 1);
+        for (int64_t i = 0; i < rows; ++i) {
+          for (int64_t j = offset + batch_crows[i];
+               j < offset + batch_crows[i + 1];
+               ++j) {
+            fn(b, static_cast<int64_t>(col_indices[j]), i, j);
+          }
+        }
+        offset += batch_crows[rows];
+      }
+    };
+    BuildCpuCsrMatrix<T>(
+        batch_size, cols, rows, x.nnz(), values, for_each_entry, mat);
+    return;
+  }
+  mat->batch_size = batch_size;
+  mat->rows = rows;
+  mat->cols = cols;
+  mat->crows.resize(batch_size * rows + 1);
+  int64_t offset = 0;
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const IntT* batch_crows = crows + b * (rows + 1);
+    for (int64_t i = 0; i < rows; ++i) {
+      mat->crows[b * rows + i] = offset + batch_crows[i];
+    }
+    offset += batch_crows[rows];
+  }
+  mat->crows[batch_size * rows] = offset;
+  mat->col_indices.assign(col_indices, col_indices + x.nnz());
+  mat->values = values;
+}
+
+template <typename T, typename IntT>
+void CooToCpuCsrMatrix(const phi::SparseCooTensor& x,
+                       bool trans,
+                       CpuCsrMatrix<T>* mat) {
+  int64_t batch_size, rows, cols;
+  GetBatchMatrixDims(x.dims(), &batch_size, &rows, &cols);
+  int ndims = x.dims().size();
+  int64_t nnz = x.nnz();
+  const IntT* indices = x.non_zero_indices().data<IntT>();
+  const IntT* row_indices = indices + (ndims - 2) * nnz;
+  const IntT* col_indices = indices + (ndims - 1) * nnz;
+  auto for_each_entry = [&](auto fn) {
+    for (int64_t j = 0; j < nnz; ++j) {
+      int64_t b = 0;
+      for (int i = 0; i < ndims - 2; ++i) {
+        b = b * x.dims()[i] + indices[i * nnz + j];
+      }
+      if (trans) {
+        fn(b, static_cast<int64_t>(col_indices[j]), row_indices[j], j);
+      } else {
+        fn(b, static_cast<int64_t>(row_indices[j]), col_indices[j], j);
+      }
+    }
+  };
+  BuildCpuCsrMatrix<T>(batch_size,
+                       trans ? cols : rows,
+                       trans ? rows : cols,
+                       nnz,
+                       x.non_zero_elements().data<T>(),
+                       for_each_entry,
+                       mat);
+}
+
+// The CSR matrix of x, or of the transpose of every batch of x if trans.
+template <typename T>
+CpuCsrMatrix<T> MakeCpuCsrMatrix(const phi::SparseCsrTensor& x, bool trans) {
+  int64_t batch_size, rows, cols;
+  GetBatchMatrixDims(x.dims(), &batch_size, &rows, &cols);
+  PADDLE_ENFORCE_EQ(x.non_zero_crows().numel(),
+                    batch_size * (rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+  CpuCsrMatrix<T> mat;
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      x.non_zero_crows().dtype(), "CsrToCpuCsrMatrix", ([&] {
+        CsrToCpuCsrMatrix<T, data_t>(x, trans, &mat);
+      }));
+  return mat;
+}
+
+// The CSR matrix of x, or of the transpose of every batch of x if trans.
+// The indices of x need not be sorted.
+template <typename T>
+CpuCsrMatrix<T> MakeCpuCsrMatrix(const phi::SparseCooTensor& x, bool trans) {
+  PADDLE_ENFORCE_EQ(x.non_zero_indices().dims()[0],
+                    x.dims().size(),
+                    phi::errors::Unimplemented(
+                        "the SparseCooTensor of matmul must not have dense "
+                        "dims."));
+  CpuCsrMatrix<T> mat;
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      x.non_zero_indices().dtype(), "CooToCpuCsrMatrix", ([&] {
+        CooToCpuCsrMatrix<T, data_t>(x, trans, &mat);
+      }));
+  return mat;
+}
+
+// Transpose every rows x cols matrix of a batch.
+template <typename T>
+void TransposeBatchMatrix(const T* in,
+                          int64_t batch_size,
+                          int64_t rows,
+                          int64_t cols,
+                          T* out) {
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const T* in_mat = in + b * rows * cols;
+    T* out_mat = out + b * rows * cols;
+    for (int64_t i = 0; i < rows; ++i) {
+      for (int64_t j = 0; j < cols; ++j) {
+        out_mat[j * rows + i] = in_mat[i * cols + j];
+      }
+    }
+  }
+}
+
+template <typename T>
+using CpuRowArray = Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>>;
+template <typename T>
+using ConstCpuRowArray = Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>;
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+// Every row of out is computed by a chunk of ParallelFor, as the sum of the
+// rows of mat_b scaled by the non zero elements of the row of mat_a, which
+// is vectorized by Eigen.
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  CpuCsrMatrix<T> a = MakeCpuCsrMatrix<T>(mat_a, transa);
+  int64_t b_batch_size, b_rows, b_cols;
+  GetBatchMatrixDims(mat_b.dims(), &b_batch_size, &b_rows, &b_cols);
+  int64_t k = transb ? b_cols : b_rows;
+  int64_t n = transb ? b_rows : b_cols;
+  PADDLE_ENFORCE_EQ(a.cols,
+                    k,
+                    phi::errors::InvalidArgument(
+                        "The columns of mat_a and the rows of mat_b of SPMM "
+                        "must be equal, but received %d and %d.",
+                        a.cols,
+                        k));
+  PADDLE_ENFORCE_EQ(b_batch_size,
+                    a.batch_size,
+                    phi::errors::InvalidArgument(
+                        "The batch size of mat_a and mat_b of SPMM must be "
+                        "equal, but received %d and %d.",
+                        a.batch_size,
+                        b_batch_size));
+  PADDLE_ENFORCE_EQ(
+      mat_out->numel(),
+      a.batch_size * a.rows * n,
+      phi::errors::InvalidArgument("The numel of mat_out of SPMM is wrong."));
+
+  const T* b_data = mat_b.data<T>();
+  std::vector<T> b_trans;
+  if (transb) {
+    b_trans.resize(mat_b.numel());
+    TransposeBatchMatrix(b_data, b_batch_size, b_rows, b_cols, b_trans.data());
+    b_data = b_trans.data();
+  }
+  T* out_data = mat_out->data<T>();
+  int64_t num_rows = a.batch_size * a.rows;
+  int64_t row_work =
+      n * (1 + (num_rows > 0 ? a.crows[num_rows] / num_rows : 0));
+  int64_t grain_size =
+      std::max<int64_t>(1,
+                        phi::backends::cpu::kIntraOpGrainSize /
+                            std::max<int64_t>(row_work, 1));
+  dev_ctx_.ParallelFor(
+      0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const T* b_mat = b_data + (i / a.rows) * k * n;
+          CpuRowArray<T> out_row(out_data + i * n, n);
+          if (beta == static_cast<T>(0)) {
+            out_row.setZero();
+          } else if (beta != static_cast<T>(1)) {
+            out_row *= beta;
+          }
+          for (int64_t j = a.crows[i]; j < a.crows[i + 1]; ++j) {
+            out_row += (alpha * a.values[j]) *
+                       ConstCpuRowArray<T>(b_mat + a.col_indices[j] * n, n);
+          }
+        }
+      });
+}
+
+/************* SPARSE*DENSE->DENSE MV ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMV(bool transa,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& vec_x,
+                                       T beta,
+                                       phi::DenseTensor* vec_out) const {
+  CpuCsrMatrix<T> a = MakeCpuCsrMatrix<T>(mat_a, transa);
+  PADDLE_ENFORCE_EQ(
+      a.cols,
+      vec_x.numel(),
+      phi::errors::InvalidArgument(
+          "The columns of mat_a and the length of vec_x of SPMV must be "
+          "equal, but received %d and %d.",
+          a.cols,
+          vec_x.numel()));
+  PADDLE_ENFORCE_EQ(
+      vec_out->numel(),
+      a.batch_size * a.rows,
+      phi::errors::InvalidArgument("The numel of vec_out of SPMV is wrong."));
+  const T* x_data = vec_x.data<T>();
+  T* out_data = vec_out->data<T>();
+  int64_t num_rows = a.batch_size * a.rows;
+  int64_t row_work = 1 + (num_rows > 0 ? a.crows[num_rows] / num_rows : 0);
+  int64_t grain_size =
+      std::max<int64_t>(1, phi::backends::cpu::kIntraOpGrainSize / row_work);
+  dev_ctx_.ParallelFor(
+      0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          T sum = 0;
+          for (int64_t j = a.crows[i]; j < a.crows[i + 1]; ++j) {
+            sum += a.values[j] * x_data[a.col_indices[j]];
+          }
+          out_data[i] = beta == static_cast<T>(0)
+                            ? alpha * sum
+                            : alpha * sum + beta * out_data[i];
+        }
+      });
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+// The rows of mat_a and the columns of mat_b are made contiguous, so every
+// non zero element of mat_out is a dot product vectorized by Eigen.
+template <typename T>
+class CpuSddmmOperands {
+ public:
+  CpuSddmmOperands(bool transa,
+                   bool transb,
+                   const phi::DenseTensor& mat_a,
+                   const phi::DenseTensor& mat_b,
+                   int64_t out_batch_size,
+                   int64_t out_rows,
+                   int64_t out_cols) {
+    int64_t a_batch_size, a_rows, a_cols;
+    GetBatchMatrixDims(mat_a.dims(), &a_batch_size, &a_rows, &a_cols);
+    int64_t b_batch_size, b_rows, b_cols;
+    GetBatchMatrixDims(mat_b.dims(), &b_batch_size, &b_rows, &b_cols);
+    k_ = transa ? a_rows : a_cols;
+    PADDLE_ENFORCE_EQ(
+        (transb ? b_cols : b_rows),
+        k_,
+        phi::errors::InvalidArgument(
+            "The columns of mat_a and the rows of mat_b of SDDMM must be "
+            "equal."));
+    PADDLE_ENFORCE_EQ(
+        (transa ? a_cols : a_rows) == out_rows &&
+            (transb ? b_rows : b_cols) == out_cols,
+        true,
+        phi::errors::InvalidArgument("The shape of mat_out of SDDMM is "
+                                     "wrong."));
+    PADDLE_ENFORCE_EQ(
+        a_batch_size == out_batch_size && b_batch_size == out_batch_size,
+        true,
+        phi::errors::InvalidArgument(
+            "The batch size of the matrices of SDDMM must be equal."));
+    rows_ = out_rows;
+    cols_ = out_cols;
+
+    a_data_ = mat_a.data<T>();
+    if (transa) {
+      a_trans_.resize(mat_a.numel());
+      TransposeBatchMatrix(
+          a_data_, a_batch_size, a_rows, a_cols, a_trans_.data());
+      a_data_ = a_trans_.data();
+    }
+    b_data_ = mat_b.data<T>();
+    if (!transb) {
+      b_trans_.resize(mat_b.numel());
+      TransposeBatchMatrix(
+          b_data_, b_batch_size, b_rows, b_cols, b_trans_.data());
+      b_data_ = b_trans_.data();
+    }
+  }
+
+  T Dot(int64_t batch, int64_t row, int64_t col) const {
+    ConstCpuRowArray<T> a_row(a_data_ + (batch * rows_ + row) * k_, k_);
+    ConstCpuRowArray<T> b_col(b_data_ + (batch * cols_ + col) * k_, k_);
+    return (a_row * b_col).sum();
+  }
+
+  int64_t k() const { return k_; }
+
+ private:
+  int64_t k_;
+  int64_t rows_;
+  int64_t cols_;
+  const T* a_data_;
+  const T* b_data_;
+  std::vector<T> a_trans_;
+  std::vector<T> b_trans_;
+};
+
+template <typename T, typename IntT>
+void CpuCsrSddmm(const phi::CPUContext& dev_ctx,
+                 const CpuSddmmOperands<T>& operands,
+                 T alpha,
+                 T beta,
+                 const phi::SparseCsrTensor& mask,
+                 phi::SparseCsrTensor* mat_out) {
+  int64_t batch_size, rows, cols;
+  GetBatchMatrixDims(mat_out->dims(), &batch_size, &rows, &cols);
+  const IntT* crows = mask.non_zero_crows().data<IntT>();
+  const IntT* col_indices = mask.non_zero_cols().data<IntT>();
+  T* values = mat_out->mutable_non_zero_elements()->data<T>();
+  // The crows of every batch start from 0.
+  std::vector<int64_t> offsets(batch_size, 0);
+  for (int64_t b = 1; b < batch_size; ++b) {
+    offsets[b] = offsets[b - 1] + crows[b * (rows + 1) - 1];
+  }
+  int64_t num_rows = batch_size * rows;
+  int64_t nnz = mat_out->non_zero_elements().numel();
+  int64_t row_work =
+      operands.k() * (1 + (num_rows > 0 ? nnz / num_rows : 0));
+  int64_t grain_size =
+      std::max<int64_t>(1,
+                        phi::backends::cpu::kIntraOpGrainSize /
+                            std::max<int64_t>(row_work, 1));
+  dev_ctx.ParallelFor(0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t b = i / rows;
+      int64_t row = i % rows;
+      const IntT* row_crows = crows + b * (rows + 1) + row;
+      for (int64_t j = offsets[b] + row_crows[0];
+           j < offsets[b] + row_crows[1];
+           ++j) {
+        T dot = operands.Dot(b, row, col_indices[j]);
+        values[j] = beta == static_cast<T>(0) ? alpha * dot
+                                              : alpha * dot + beta * values[j];
+      }
+    }
+  });
+}
+
+template <typename T>
+void CpuSddmm(const phi::CPUContext& dev_ctx,
+              const CpuSddmmOperands<T>& operands,
+              T alpha,
+              T beta,
+              const phi::SparseCsrTensor& mask,
+              phi::SparseCsrTensor* mat_out) {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      mask.non_zero_crows().dtype(), "CpuCsrSddmm", ([&] {
+        CpuCsrSddmm<T, data_t>(dev_ctx, operands, alpha, beta, mask, mat_out);
+      }));
+}
+
+template <typename T, typename IntT>
+void CpuCooSddmm(const phi::CPUContext& dev_ctx,
+                 const CpuSddmmOperands<T>& operands,
+                 T alpha,
+                 T beta,
+                 const phi::SparseCooTensor& mask,
+                 phi::SparseCooTensor* mat_out) {
+  const DDim& dims = mat_out->dims();
+  int ndims = dims.size();
+  int64_t nnz = mask.nnz();
+  const IntT* indices = mask.non_zero_indices().data<IntT>();
+  T* values = mat_out->mutable_non_zero_elements()->data<T>();
+  int64_t grain_size = std::max<int64_t>(
+      1,
+      phi::backends::cpu::kIntraOpGrainSize /
+          std::max<int64_t>(operands.k(), 1));
+  dev_ctx.ParallelFor(0, nnz, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+      int64_t b = 0;
+      for (int i = 0; i < ndims - 2; ++i) {
+        b = b * dims[i] + indices[i * nnz + j];
+      }
+      T dot = operands.Dot(
+          b, indices[(ndims - 2) * nnz + j], indices[(ndims - 1) * nnz + j]);
+      values[j] = beta == static_cast<T>(0) ? alpha * dot
+                                            : alpha * dot + beta * values[j];
+    }
+  });
+}
+
+template <typename T>
+void CpuSddmm(const phi::CPUContext& dev_ctx,
+              const CpuSddmmOperands<T>& operands,
+              T alpha,
+              T beta,
+              const phi::SparseCooTensor& mask,
+              phi::SparseCooTensor* mat_out) {
+  PADDLE_ENFORCE_EQ(mask.non_zero_indices().dims()[0],
+                    mask.dims().size(),
+                    phi::errors::Unimplemented(
+                        "the SparseCooTensor of SDDMM must not have dense "
+                        "dims."));
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      mask.non_zero_indices().dtype(), "CpuCooSddmm", ([&] {
+        CpuCooSddmm<T, data_t>(dev_ctx, operands, alpha, beta, mask, mat_out);
+      }));
+}
+
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  int64_t batch_size, rows, cols;
+  GetBatchMatrixDims(mat_out->dims(), &batch_size, &rows, &cols);
+  CpuSddmmOperands<T> operands(
+      transa, transb, mat_a, mat_b, batch_size, rows, cols);
+  CpuSddmm<T>(dev_ctx_, operands, alpha, beta, *mat_out, mat_out);
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,121 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "paddle/phi/core/enforce.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * Layout of the weights of weight-only quantization. A [k, n] float weight
+ * is stored as signed integers with one float scale per output channel,
+ * as n rows of k values, so that every output channel is a contiguous row.
+ * 8-bit weights take one byte per value. 4-bit weights are packed two per
+ * byte along k: the value of an even index is in the low nibble and the
+ * next one in the high nibble. Both use the symmetric range [-qmax, qmax]
+ * with qmax = 2^(bits - 1) - 1.
+ */
+inline int WeightOnlyQMax(int bits) { return (1 << (bits - 1)) - 1; }
+
+// Number of bytes of one quantized row of k values.
+inline int64_t WeightOnlyRowBytes(int64_t k, int bits) {
+  return bits == 4 ? (k + 1) / 2 : k;
+}
+
+inline void CheckWeightOnlyBits(int bits) {
+  PADDLE_ENFORCE_EQ(
+      bits == 8 || bits == 4,
+      true,
+      phi::errors::InvalidArgument(
+          "The weight_bits of weight-only quantization must be 8 or 4, "
+          "but received %d.",
+          bits));
+}
+
+/*
+ * Quantize a [k, n] weight, or a [n, k] one if trans_weight is true, per
+ * output channel. qweight holds n * WeightOnlyRowBytes(k, bits) bytes and
+ * scale n floats.
+ */
+template <typename T>
+void WeightOnlyQuantize(const T* weight,
+                        int64_t k,
+                        int64_t n,
+                        bool trans_weight,
+                        int bits,
+                        int8_t* qweight,
+                        float* scale) {
+  CheckWeightOnlyBits(bits);
+  const int qmax = WeightOnlyQMax(bits);
+  const int64_t row_bytes = WeightOnlyRowBytes(k, bits);
+  std::vector<float> row(k);
+  for (int64_t j = 0; j < n; ++j) {
+    float abs_max = 0.f;
+    for (int64_t i = 0; i < k; ++i) {
+      row[i] = static_cast<float>(trans_weight ? weight[j * k + i]
+                                               : weight[i * n + j]);
+      abs_max = std::max(abs_max, std::abs(row[i]));
+    }
+    scale[j] = abs_max / qmax;
+    const float inv_scale = abs_max > 0.f ? qmax / abs_max : 0.f;
+
+    int8_t* qrow = qweight + j * row_bytes;
+    std::fill(qrow, qrow + row_bytes, 0);
+    for (int64_t i = 0; i < k; ++i) {
+      const int q = std::max(
+          -qmax,
+          std::min(qmax, static_cast<int>(std::round(row[i] * inv_scale))));
+      if (bits == 8) {
+        qrow[i] = static_cast<int8_t>(q);
+      } else {
+        const uint8_t nibble = static_cast<uint8_t>(q) & 0x0F;
+        qrow[i / 2] |= static_cast<int8_t>(i % 2 == 0 ? nibble : nibble << 4);
+      }
+    }
+  }
+}
+
+// Convert one quantized row of k values to T, without the scale.
+template <typename T>
+inline void WeightOnlyDecodeRow(const int8_t* qrow,
+                                int64_t k,
+                                int bits,
+                                T* row) {
+  if (bits == 8) {
+    for (int64_t i = 0; i < k; ++i) {
+      row[i] = static_cast<T>(qrow[i]);
+    }
+    return;
+  }
+  const uint8_t* packed = reinterpret_cast<const uint8_t*>(qrow);
+  const int64_t pairs = k / 2;
+  for (int64_t i = 0; i < pairs; ++i) {
+    // Shift the nibble to the top of a signed byte and back to extend it.
+    row[2 * i] = static_cast<T>(static_cast<int8_t>(packed[i] << 4) >> 4);
+    row[2 * i + 1] = static_cast<T>(static_cast<int8_t>(packed[i]) >> 4);
+  }
+  if (k % 2 != 0) {
+    row[k - 1] = static_cast<T>(static_cast<int8_t>(packed[pairs] << 4) >> 4);
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
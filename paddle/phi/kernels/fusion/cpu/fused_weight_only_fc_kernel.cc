@@ -0,0 +1,75 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/fusion/fused_weight_only_fc_kernel.h"
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_weight_only_gemm.h"
+
+namespace phi {
+namespace fusion {
+
+template <typename T, typename Context>
+void FusedWeightOnlyFCKernel(const Context& dev_ctx,
+                             const DenseTensor& input,
+                             const DenseTensor& qweight,
+                             const DenseTensor& scale,
+                             const paddle::optional<DenseTensor>& bias,
+                             int in_num_col_dims,
+                             const std::string& activation_type,
+                             int weight_bits,
+                             DenseTensor* out) {
+  auto in_mat_dims = phi::flatten_to_2d(input.dims(), in_num_col_dims);
+  const int64_t m = in_mat_dims[0];
+  const int64_t k = in_mat_dims[1];
+  const int64_t n = qweight.dims()[0];
+  PADDLE_ENFORCE_EQ(
+      qweight.dims()[1],
+      funcs::WeightOnlyRowBytes(k, weight_bits),
+      phi::errors::InvalidArgument(
+          "The quantized weight of fused_weight_only_fc is expected to have "
+          "%d bytes per output channel for an input of width %d and "
+          "weight_bits %d, but received %d.",
+          funcs::WeightOnlyRowBytes(k, weight_bits),
+          k,
+          weight_bits,
+          qweight.dims()[1]));
+
+  T* out_data = dev_ctx.template Alloc<T>(out);
+  funcs::WeightOnlyGemmCPU<T>(dev_ctx,
+                              input.data<T>(),
+                              qweight.data<int8_t>(),
+                              scale.data<float>(),
+                              bias ? bias->data<T>() : nullptr,
+                              m,
+                              n,
+                              k,
+                              weight_bits,
+                              activation_type == "relu",
+                              out_data);
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(fused_weight_only_fc,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::FusedWeightOnlyFCKernel,
+                   float,
+                   double) {
+  kernel->InputAt(1).SetDataType(phi::DataType::INT8);
+  kernel->InputAt(2).SetDataType(phi::DataType::FLOAT32);
+}
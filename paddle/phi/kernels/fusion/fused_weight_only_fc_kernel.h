@@ -0,0 +1,40 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/utils/optional.h"
+
+namespace phi {
+namespace fusion {
+
+// fc whose weight is quantized per output channel to 8 or 4 bits by
+// weight_only_quant_pass. qweight is [N, K] int8, or [N, (K + 1) / 2] with
+// two 4-bit values per byte, and scale is [N].
+template <typename T, typename Context>
+void FusedWeightOnlyFCKernel(const Context& dev_ctx,
+                             const DenseTensor& input,
+                             const DenseTensor& qweight,
+                             const DenseTensor& scale,
+                             const paddle::optional<DenseTensor>& bias,
+                             int in_num_col_dims,
+                             const std::string& activation_type,
+                             int weight_bits,
+                             DenseTensor* out);
+
+}  // namespace fusion
+}  // namespace phi
@@ -14,12 +14,17 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
 
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/sparse_coo_tensor.h"
 #include "paddle/phi/core/tensor_meta.h"
+#include "paddle/phi/core/tensor_utils.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/sparse/conv_kernel.h"
 
@@ -28,9 +33,105 @@ namespace sparse {
 
 using Dims4D = phi::funcs::sparse::Dims4D;
 
+// Open addressing hash table with linear probing, from the flattened index
+// of a voxel to a value, such as its position in the indices. The table
+// grows to keep the load factor under 1/2. Find is thread-safe when there
+// is no concurrent Insert.
+template <typename IntT>
+class VoxelHashTable {
+ public:
+  explicit VoxelHashTable(int64_t expected_size) {
+    int bits = 4;
+    while ((int64_t{1} << bits) < expected_size * 2) {
+      ++bits;
+    }
+    Reset(bits);
+  }
+
+  // Insert key, or assign value to it if it is already in the table.
+  // Returns whether key is new.
+  bool Insert(const IntT key, const IntT value) {
+    if ((size_ + 1) * 2 > static_cast<int64_t>(keys_.size())) {
+      Grow();
+    }
+    uint64_t slot = Slot(key);
+    while (keys_[slot] != kEmpty && keys_[slot] != key) {
+      slot = (slot + 1) & mask_;
+    }
+    values_[slot] = value;
+    if (keys_[slot] == key) {
+      return false;
+    }
+    keys_[slot] = key;
+    ++size_;
+    return true;
+  }
+
+  // Returns -1 if key is not in the table.
+  IntT Find(const IntT key) const {
+    uint64_t slot = Slot(key);
+    while (keys_[slot] != kEmpty) {
+      if (keys_[slot] == key) {
+        return values_[slot];
+      }
+      slot = (slot + 1) & mask_;
+    }
+    return -1;
+  }
+
+  int64_t size() const { return size_; }
+
+ private:
+  // The flattened indices are not negative.
+  static constexpr IntT kEmpty = -1;
+
+  void Reset(int bits) {
+    bits_ = bits;
+    mask_ = (uint64_t{1} << bits) - 1;
+    keys_.assign(mask_ + 1, kEmpty);
+    values_.resize(mask_ + 1);
+    size_ = 0;
+  }
+
+  void Grow() {
+    std::vector<IntT> keys, values;
+    keys.swap(keys_);
+    values.swap(values_);
+    Reset(bits_ + 1);
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] != kEmpty) {
+        Insert(keys[i], values[i]);
+      }
+    }
+  }
+
+  // Fibonacci hashing, the neighbouring voxels are spread over the table.
+  uint64_t Slot(const IntT key) const {
+    return (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >>
+           (64 - bits_);
+  }
+
+  int bits_;
+  uint64_t mask_;
+  int64_t size_;
+  std::vector<IntT> keys_;
+  std::vector<IntT> values_;
+};
+
+template <typename IntT>
+constexpr IntT VoxelHashTable<IntT>::kEmpty;
+
+// The minimal number of non zero elements in a chunk of the rulebook, every
+// one of them checks all the kernel offsets.
+constexpr int64_t kRulebookGrainSize = 1024;
+
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
+// The non zero elements are split into chunks, and every chunk collects its
+// rules of each kernel offset into its own buffers in one pass, which are
+// then concatenated in the order of the kernel offsets and the chunks. So
+// the rulebook is the same as a sequential sweep of every kernel offset
+// over the non zero elements.
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -48,82 +149,91 @@ void ProductRuleBook(const Context& dev_ctx,
   int kernel_size = kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
   memset(counter_per_kernel, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
   const Dims4D c_x_dims(x_dims[0], x_dims[3], x_dims[2], x_dims[1]);
   const Dims4D c_kernel_dims(
       1, kernel_sizes[2], kernel_sizes[1], kernel_sizes[0]);
-  const Dims4D c_out_dims(out_dims[0], out_dims[3], out_dims[2], out_dims[1]);
   const Dims4D c_paddings(1, paddings[2], paddings[1], paddings[0]);
   const Dims4D c_strides(1, strides[2], strides[1], strides[0]);
   const Dims4D c_dilations(1, dilations[2], dilations[1], dilations[0]);
 
-  std::set<IntT> hash_in;
+  VoxelHashTable<IntT> hash_in(subm ? non_zero_num : 0);
   if (subm) {
-    for (int i = 0; i < non_zero_num; i++) {
+    for (int64_t i = 0; i < non_zero_num; i++) {
       IntT batch = indices_ptr[i];
       IntT in_z = indices_ptr[i + non_zero_num];
       IntT in_y = indices_ptr[i + 2 * non_zero_num];
       IntT in_x = indices_ptr[i + 3 * non_zero_num];
       IntT index = phi::funcs::sparse::PointToIndex<DDim>(
           batch, in_x, in_y, in_z, x_dims);
-      hash_in.insert(index);
+      hash_in.Insert(index, static_cast<IntT>(i));
     }
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
-    for (int kz = 0; kz < kernel_sizes[0]; kz++) {
-      for (int ky = 0; ky < kernel_sizes[1]; ky++) {
-        for (int kx = 0; kx < kernel_sizes[2]; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = indices_ptr[i + non_zero_num];
-            IntT in_y = indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = indices_ptr[i + 3 * non_zero_num];
+  // buffers[chunk * kernel_size + kernel_index]: (in_i, out_index) pairs
+  const int num_chunks = std::max(
+      1,
+      phi::backends::cpu::GetIntraOpChunkNum(
+          0, non_zero_num, kRulebookGrainSize));
+  const int64_t chunk_size =
+      std::max<int64_t>(1, (non_zero_num + num_chunks - 1) / num_chunks);
+  std::vector<std::vector<IntT>> buffers(num_chunks * kernel_size);
+  dev_ctx.ParallelFor(0, non_zero_num, kRulebookGrainSize, [&](int64_t begin,
+                                                                int64_t end) {
+    std::vector<IntT>* chunk_buffers =
+        &buffers[begin / chunk_size * kernel_size];
+    for (int64_t i = begin; i < end; i++) {
+      IntT batch = indices_ptr[i];
+      IntT in_z = indices_ptr[i + non_zero_num];
+      IntT in_y = indices_ptr[i + 2 * non_zero_num];
+      IntT in_x = indices_ptr[i + 3 * non_zero_num];
+      int kernel_index = 0;
+      for (int kz = 0; kz < kernel_sizes[0]; kz++) {
+        for (int ky = 0; ky < kernel_sizes[1]; ky++) {
+          for (int kx = 0; kx < kernel_sizes[2]; kx++, kernel_index++) {
+            if (!phi::funcs::sparse::Check(c_x_dims,
+                                           c_kernel_dims,
+                                           c_paddings,
+                                           c_dilations,
+                                           c_strides,
+                                           in_x,
+                                           in_y,
+                                           in_z,
+                                           kx,
+                                           ky,
+                                           kz)) {
+              continue;
+            }
             IntT out_z = (in_z + paddings[0] - kz * dilations[0]) / strides[0];
             IntT out_y = (in_y + paddings[1] - ky * dilations[1]) / strides[1];
             IntT out_x = (in_x + paddings[2] - kx * dilations[2]) / strides[2];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
-                    batch, out_x, out_y, out_z, out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_per_kernel[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<DDim>(
-                        batch, out_x, out_y, out_z, out_dims);  // out_index
-                ++rulebook_index;
-              }
+            IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
+                batch, out_x, out_y, out_z, out_dims);
+            if (subm && hash_in.Find(out_index) == -1) {
+              continue;
             }
+            chunk_buffers[kernel_index].push_back(static_cast<IntT>(i));
+            chunk_buffers[kernel_index].push_back(out_index);
           }
         }
       }
     }
-  };
+  });
+
+  // buffer_offsets[chunk * kernel_size + kernel_index]: where the rules of
+  // the buffer start in the rulebook
+  std::vector<int> buffer_offsets(num_chunks * kernel_size);
+  int rulebook_len = 0;
+  for (int kernel_index = 0; kernel_index < kernel_size; kernel_index++) {
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+      const int idx = chunk * kernel_size + kernel_index;
+      const int count = static_cast<int>(buffers[idx].size() / 2);
+      buffer_offsets[idx] = rulebook_len;
+      counter_per_kernel[kernel_index] += count;
+      rulebook_len += count;
+    }
+  }
 
-  f_calc_rulebook(nullptr);
   // alloc the rulebook
   *rulebook = phi::Empty(
       dev_ctx,
@@ -131,7 +241,25 @@ void ProductRuleBook(const Context& dev_ctx,
                       {3, rulebook_len},
                       DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+  const int num_buffers = num_chunks * kernel_size;
+  const int64_t buffer_grain_size = std::max<int64_t>(
+      1,
+      phi::backends::cpu::kIntraOpGrainSize * num_buffers /
+          std::max(rulebook_len, 1));
+  dev_ctx.ParallelFor(
+      0, num_buffers, buffer_grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; idx++) {
+          const IntT kernel_index = idx % kernel_size;
+          const std::vector<IntT>& buffer = buffers[idx];
+          const int count = static_cast<int>(buffer.size() / 2);
+          IntT* ptr = rulebook_ptr + buffer_offsets[idx];
+          for (int j = 0; j < count; j++) {
+            ptr[j] = kernel_index;
+            ptr[j + rulebook_len] = buffer[j * 2];          // in_i
+            ptr[j + rulebook_len * 2] = buffer[j * 2 + 1];  // out_index
+          }
+        }
+      });
 }
 
 template <typename T, typename Context, typename IntT = int>
@@ -142,12 +270,17 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const DDim& out_dims,
                                DenseTensor* rulebook,
                                SparseCooTensor* out) {
-  std::set<IntT> out_indexs;
   int n = rulebook->dims()[1];
   IntT* rulebook_ptr = rulebook->data<IntT>();
+  // Dedup the out indexs by the hash table, and sort the unique ones only.
+  VoxelHashTable<IntT> out_table(x.nnz());
+  std::vector<IntT> out_indexs;
   for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
+    if (out_table.Insert(rulebook_ptr[i + n * 2], 0)) {
+      out_indexs.push_back(rulebook_ptr[i + n * 2]);
+    }
   }
+  std::sort(out_indexs.begin(), out_indexs.end());
 
   int out_non_zero_num = out_indexs.size();
   const int64_t sparse_dim = 4;
@@ -160,9 +293,9 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   phi::DenseTensor out_indices = phi::Empty(dev_ctx, std::move(indices_meta));
   phi::DenseTensor out_values = phi::Empty(dev_ctx, std::move(values_meta));
   IntT* out_indices_ptr = out_indices.data<IntT>();
-  int i = 0;
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
+  for (int i = 0; i < out_non_zero_num; i++) {
+    const IntT index = out_indexs[i];
+    out_table.Insert(index, static_cast<IntT>(i));
     IntT batch, x, y, z;
     phi::funcs::sparse::IndexToPoint<DDim>(index, out_dims, &batch, &x, &y, &z);
     out_indices_ptr[i] = batch;
@@ -170,33 +303,139 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
     out_indices_ptr[i + out_non_zero_num * 2] = y;
     out_indices_ptr[i + out_non_zero_num * 3] = x;
   }
-  for (i = 0; i < n; i++) {
-    IntT out_index = rulebook_ptr[i + n * 2];
-    rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
-  }
+  dev_ctx.ParallelFor(
+      0, n, phi::backends::cpu::kIntraOpGrainSize, [&](int64_t begin,
+                                                       int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          rulebook_ptr[i + n * 2] = out_table.Find(rulebook_ptr[i + n * 2]);
+        }
+      });
 
   out->SetMember(out_indices, out_values, out_dims, true);
 }
 
-template <typename T, typename IntT = int>
-void Gather(
-    const T* x, const IntT* indexs, const int n, const int channels, T* out) {
-  for (int i = 0; i < n; i++) {
-    IntT real_i = indexs[i];
-    memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
+// The key to cache the rulebook of a subm conv which is called without a
+// key, by the kernel sizes, the dilations and the hash of the indices. The
+// layers of the same geometry over the same indices reuse the rulebook of
+// the first one. Returns "" if the indices are not sorted and unique, as
+// the out indices are sorted and the rulebook doesn't apply to the layers
+// with them.
+template <typename IntT>
+std::string GetSubmRulebookKey(const SparseCooTensor& x,
+                               const std::vector<int>& kernel_sizes,
+                               const std::vector<int>& dilations) {
+  const int64_t non_zero_num = x.nnz();
+  const IntT* indices_ptr = x.indices().data<IntT>();
+  const auto& x_dims = x.dims();
+  // FNV-1a over the flattened indices
+  uint64_t hash = 14695981039346656037ULL;
+  IntT prev_index = -1;
+  for (int64_t i = 0; i < non_zero_num; i++) {
+    IntT batch = indices_ptr[i];
+    IntT in_z = indices_ptr[i + non_zero_num];
+    IntT in_y = indices_ptr[i + 2 * non_zero_num];
+    IntT in_x = indices_ptr[i + 3 * non_zero_num];
+    IntT index = phi::funcs::sparse::PointToIndex<DDim>(
+        batch, in_x, in_y, in_z, x_dims);
+    if (index <= prev_index) {
+      return "";
+    }
+    prev_index = index;
+    hash = (hash ^ static_cast<uint64_t>(index)) * 1099511628211ULL;
+  }
+  std::ostringstream key;
+  key << "__subm_rulebook";
+  for (int i = 0; i < 3; i++) {
+    key << "_" << kernel_sizes[i] << "_" << dilations[i];
   }
+  key << "_" << non_zero_num << "_" << std::hex << hash;
+  return key.str();
+}
+
+// The indices a rulebook of GetSubmRulebookKey is built for are saved next to
+// it, and compared before it is reused, so that the indices of the same hash
+// never share a rulebook.
+template <typename Context>
+void SaveSubmRulebookIndices(const Context& dev_ctx,
+                             const SparseCooTensor& x,
+                             const std::string& key,
+                             SparseCooTensor* out) {
+  DenseTensor indices;
+  phi::Copy(dev_ctx, x.indices(), dev_ctx.GetPlace(), false, &indices);
+  out->SaveIndicesPairs(key + "_indices",
+                        std::make_pair(indices, DenseTensor()));
+}
+
+template <typename IntT>
+bool SubmRulebookIndicesMatch(const SparseCooTensor& x,
+                              const std::string& key) {
+  const auto* saved = x.IndicesPairs(key + "_indices");
+  if (saved == nullptr) {
+    return false;
+  }
+  const DenseTensor& indices = saved->first;
+  const int64_t numel = x.indices().numel();
+  if (indices.numel() != numel) {
+    return false;
+  }
+  const IntT* saved_ptr = indices.data<IntT>();
+  return std::equal(saved_ptr, saved_ptr + numel, x.indices().data<IntT>());
 }
 
 template <typename T, typename IntT = int>
-void Scatter(
-    const T* x, const IntT* indexs, const int n, const int channels, T* out) {
-  for (int i = 0; i < n; i++) {
-    IntT real_i = indexs[i];
-    for (int j = 0; j < channels; j++) {
-      out[real_i * channels + j] += x[i * channels + j];
+void Gather(const CPUContext& dev_ctx,
+            const T* x,
+            const IntT* indexs,
+            const int n,
+            const int channels,
+            T* out) {
+  const int64_t grain_size = std::max<int64_t>(
+      1, phi::backends::cpu::kIntraOpGrainSize / std::max(channels, 1));
+  dev_ctx.ParallelFor(0, n, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      IntT real_i = indexs[i];
+      memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
     }
+  });
+}
+
+// The rows are grouped by their out index first, so every out row is summed
+// by one thread, in the same order as a sequential scatter.
+template <typename T, typename IntT = int>
+void Scatter(const CPUContext& dev_ctx,
+             const T* x,
+             const IntT* indexs,
+             const int n,
+             const int out_n,
+             const int channels,
+             T* out) {
+  std::vector<int> offsets(out_n + 1, 0);
+  for (int i = 0; i < n; i++) {
+    ++offsets[indexs[i] + 1];
+  }
+  for (int i = 0; i < out_n; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<int> rows(n);
+  std::vector<int> next(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < n; i++) {
+    rows[next[indexs[i]]++] = i;
   }
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      phi::backends::cpu::kIntraOpGrainSize * out_n /
+          std::max<int64_t>(int64_t{n} * channels, 1));
+  dev_ctx.ParallelFor(0, out_n, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t real_i = begin; real_i < end; real_i++) {
+      T* out_row = out + real_i * channels;
+      for (int k = offsets[real_i]; k < offsets[real_i + 1]; k++) {
+        const T* x_row = x + rows[k] * channels;
+        for (int j = 0; j < channels; j++) {
+          out_row[j] += x_row[j];
+        }
+      }
+    }
+  });
 }
 
 }  // namespace sparse
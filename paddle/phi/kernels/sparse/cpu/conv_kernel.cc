@@ -79,17 +79,29 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   const IntT* rulebook_ptr = nullptr;
   int n = 0;
   bool need_product_rulebook = true;
-  if (subm && !key.empty()) {
+  // Without a key, the rulebook of subm conv is cached by the indices.
+  const std::string subm_key =
+      subm && key.empty()
+          ? GetSubmRulebookKey<IntT>(x, kernel_sizes, dilations)
+          : key;
+  if (subm && !subm_key.empty() &&
+      (!key.empty() || SubmRulebookIndicesMatch<IntT>(x, subm_key))) {
     rulebook_ptr = phi::funcs::sparse::PrepareSubm<T, IntT, CPUContext>(
         dev_ctx,
         x,
-        key,
+        subm_key,
         out_dims,
         out,
         h_counter_ptr,
         h_offsets_ptr,
         &n,
         &need_product_rulebook);
+    if (!need_product_rulebook && key.empty()) {
+      // the grad kernel reads the rulebook from the outputs without a key
+      const auto* indices_pairs = x.IndicesPairs(subm_key);
+      *rulebook = indices_pairs->first;
+      *counter = indices_pairs->second;
+    }
   }
   if (need_product_rulebook) {
     DenseTensor tmp_rulebook;
@@ -111,6 +123,10 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
 
     phi::funcs::sparse::SaveToTable(
         dev_ctx, x, key, tmp_rulebook, h_counter, out, rulebook, counter);
+    if (key.empty() && !subm_key.empty()) {
+      out->SaveIndicesPairs(subm_key, std::make_pair(*rulebook, *counter));
+      SaveSubmRulebookIndices(dev_ctx, x, subm_key, out);
+    }
   }
   // int n = rulebook->dims()[1];
 
@@ -126,8 +142,12 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   T* in_features_ptr = in_features.data<T>();
   T* out_features_ptr = out_features.data<T>();
 
-  Gather<T, IntT>(
-      x.values().data<T>(), rulebook_ptr + n, n, in_channels, in_features_ptr);
+  Gather<T, IntT>(dev_ctx,
+                  x.values().data<T>(),
+                  rulebook_ptr + n,
+                  n,
+                  in_channels,
+                  in_features_ptr);
 
   // 3. call gemm for every werght
   auto blas = phi::funcs::GetBlas<CPUContext, T>(dev_ctx);
@@ -138,36 +158,49 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   }
   h_offsets_ptr[kernel_size] = offset;
 
+  // the gemms of the kernel offsets write to different rows
   const T* kernel_ptr = kernel.data<T>();
-  for (int i = 0; i < kernel_size; i++) {
-    if (h_counter_ptr[i] <= 0) {
-      continue;
-    }
-
-    // call gemm: (n, in_channels) * (in_channels, out_channels)
-    const int M = h_counter_ptr[i];
-    const int K = in_channels;   // in_channels
-    const int N = out_channels;  // out_channels
-    T* tmp_in_ptr = in_features_ptr + h_offsets_ptr[i] * in_channels;
-    const T* tmp_kernel_ptr = kernel_ptr + i * K * N;
-    T* tmp_out_ptr = out_features_ptr + h_offsets_ptr[i] * out_channels;
-    blas.GEMM(CblasNoTrans,
-              CblasNoTrans,
-              M,
-              N,
-              K,
-              static_cast<T>(1),
-              tmp_in_ptr,
-              tmp_kernel_ptr,
-              static_cast<T>(0),
-              tmp_out_ptr);
-  }
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      phi::backends::cpu::kIntraOpGrainSize * kernel_size /
+          std::max<int64_t>(int64_t{n} * in_channels * out_channels, 1));
+  dev_ctx.ParallelFor(
+      0, kernel_size, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          if (h_counter_ptr[i] <= 0) {
+            continue;
+          }
+
+          // call gemm: (n, in_channels) * (in_channels, out_channels)
+          const int M = h_counter_ptr[i];
+          const int K = in_channels;   // in_channels
+          const int N = out_channels;  // out_channels
+          T* tmp_in_ptr = in_features_ptr + h_offsets_ptr[i] * in_channels;
+          const T* tmp_kernel_ptr = kernel_ptr + i * K * N;
+          T* tmp_out_ptr = out_features_ptr + h_offsets_ptr[i] * out_channels;
+          blas.GEMM(CblasNoTrans,
+                    CblasNoTrans,
+                    M,
+                    N,
+                    K,
+                    static_cast<T>(1),
+                    tmp_in_ptr,
+                    tmp_kernel_ptr,
+                    static_cast<T>(0),
+                    tmp_out_ptr);
+        }
+      });
 
   // 4. scatter
   T* out_values_ptr = out->mutable_values()->data<T>();
   memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
-  Scatter<T, IntT>(
-      out_features_ptr, rulebook_ptr + n * 2, n, out_channels, out_values_ptr);
+  Scatter<T, IntT>(dev_ctx,
+                   out_features_ptr,
+                   rulebook_ptr + n * 2,
+                   n,
+                   out->nnz(),
+                   out_channels,
+                   out_values_ptr);
 }
 
 template <typename T, typename Context>
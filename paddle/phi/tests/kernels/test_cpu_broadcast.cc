@@ -0,0 +1,187 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <sys/time.h>
+
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/kernels/funcs/cpu_broadcast.h"
+#include "paddle/phi/kernels/funcs/elementwise_utils.h"
+
+namespace phi {
+namespace tests {
+
+inline double GetCurrentUS() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return 1e+6 * time.tv_sec + time.tv_usec;
+}
+constexpr int repeat = 20;
+
+template <typename T>
+void RandomVec(const int64_t n, T* a) {
+  static unsigned int seed = 100;
+  std::mt19937 rng(seed++);
+  std::uniform_int_distribution<int> dist(-8, 8);
+  for (int64_t i = 0; i < n; ++i) {
+    a[i] = static_cast<T>(dist(rng));
+  }
+}
+
+template <typename T>
+struct MulAddFunctor {
+  inline T operator()(const T a, const T b) const { return a * b + a; }
+};
+
+template <typename T>
+struct MulAddDxFunctor {
+  inline T operator()(T x, T y, T out, T dout) const {
+    return dout * (y + static_cast<T>(1));
+  }
+};
+
+template <typename T>
+struct MulAddDyFunctor {
+  inline T operator()(T x, T y, T out, T dout) const { return dout * x; }
+};
+
+// The element-by-element implementation replaced by CPUBroadcastPlan.
+template <typename T>
+void RefBroadcast(const std::vector<int>& x_dims,
+                  const std::vector<int>& y_dims,
+                  const std::vector<int>& out_dims,
+                  const T* x,
+                  const T* y,
+                  const T* dout,
+                  T* out,
+                  T* dx,
+                  T* dy) {
+  const int max_dim = out_dims.size();
+  int64_t out_size = 1;
+  for (auto d : out_dims) {
+    out_size *= d;
+  }
+  std::vector<int> index_array(max_dim, 0);
+  for (int64_t i = 0; i < out_size; ++i) {
+    int x_index =
+        funcs::GetElementwiseIndex(x_dims.data(), max_dim, index_array.data());
+    int y_index =
+        funcs::GetElementwiseIndex(y_dims.data(), max_dim, index_array.data());
+    out[i] = MulAddFunctor<T>()(x[x_index], y[y_index]);
+    dx[x_index] +=
+        MulAddDxFunctor<T>()(x[x_index], y[y_index], out[i], dout[i]);
+    dy[y_index] +=
+        MulAddDyFunctor<T>()(x[x_index], y[y_index], out[i], dout[i]);
+    funcs::UpdateElementwiseIndexArray(
+        out_dims.data(), max_dim, index_array.data());
+  }
+}
+
+template <typename T>
+void TestAndBench(const std::vector<int>& x_dims,
+                  const std::vector<int>& y_dims) {
+  std::vector<int> out_dims(x_dims.size());
+  int64_t x_numel = 1, y_numel = 1, out_numel = 1;
+  for (size_t i = 0; i < x_dims.size(); ++i) {
+    out_dims[i] = std::max(x_dims[i], y_dims[i]);
+    x_numel *= x_dims[i];
+    y_numel *= y_dims[i];
+    out_numel *= out_dims[i];
+  }
+  std::vector<T> x(x_numel), y(y_numel), dout(out_numel);
+  RandomVec<T>(x_numel, x.data());
+  RandomVec<T>(y_numel, y.data());
+  RandomVec<T>(out_numel, dout.data());
+
+  std::vector<T> out_ref(out_numel), dx_ref(x_numel), dy_ref(y_numel);
+  std::vector<T> out_tgt(out_numel), dx_tgt(x_numel), dy_tgt(y_numel);
+
+  auto st = GetCurrentUS();
+  for (int i = 0; i < repeat; ++i) {
+    std::fill(dx_ref.begin(), dx_ref.end(), static_cast<T>(0));
+    std::fill(dy_ref.begin(), dy_ref.end(), static_cast<T>(0));
+    RefBroadcast<T>(x_dims,
+                    y_dims,
+                    out_dims,
+                    x.data(),
+                    y.data(),
+                    dout.data(),
+                    out_ref.data(),
+                    dx_ref.data(),
+                    dy_ref.data());
+  }
+  phi::CPUContext ctx;
+  auto mt = GetCurrentUS();
+  for (int i = 0; i < repeat; ++i) {
+    std::fill(dx_tgt.begin(), dx_tgt.end(), static_cast<T>(0));
+    std::fill(dy_tgt.begin(), dy_tgt.end(), static_cast<T>(0));
+    funcs::CPUBroadcastPlan plan(
+        x_dims.data(), y_dims.data(), out_dims.data(), out_dims.size());
+    funcs::BroadcastForwardCPU(
+        ctx, plan, x.data(), y.data(), out_tgt.data(), MulAddFunctor<T>());
+    funcs::BroadcastGradCPU<T>(ctx,
+                               plan,
+                               x.data(),
+                               y.data(),
+                               out_tgt.data(),
+                               dout.data(),
+                               x_numel,
+                               y_numel,
+                               MulAddDxFunctor<T>(),
+                               MulAddDyFunctor<T>(),
+                               dx_tgt.data(),
+                               dy_tgt.data());
+  }
+  auto et = GetCurrentUS();
+
+  VLOG(3) << "Broadcast [" << phi::make_ddim(x_dims) << "] x ["
+          << phi::make_ddim(y_dims) << "]: refer takes: " << (mt - st) / repeat
+          << " us, tgt takes: " << (et - mt) / repeat << " us.";
+  for (int64_t i = 0; i < out_numel; ++i) {
+    EXPECT_EQ(out_tgt[i], out_ref[i]);
+  }
+  for (int64_t i = 0; i < x_numel; ++i) {
+    EXPECT_EQ(dx_tgt[i], dx_ref[i]);
+  }
+  for (int64_t i = 0; i < y_numel; ++i) {
+    EXPECT_EQ(dy_tgt[i], dy_ref[i]);
+  }
+}
+
+TEST(CpuBroadcastTest, nchw_with_channel) {
+  // (N, C, H, W) x (C, 1, 1)
+  TestAndBench<float>({8, 64, 28, 28}, {1, 64, 1, 1});
+  TestAndBench<float>({1, 3, 224, 224}, {1, 3, 1, 1});
+  TestAndBench<double>({2, 16, 7, 7}, {1, 16, 1, 1});
+}
+
+TEST(CpuBroadcastTest, btd_with_hidden) {
+  // (B, T, D) x (D)
+  TestAndBench<float>({32, 128, 768}, {1, 1, 768});
+  TestAndBench<float>({4, 7, 3}, {1, 1, 3});
+  TestAndBench<double>({16, 50, 64}, {1, 1, 64});
+}
+
+TEST(CpuBroadcastTest, both_broadcast) {
+  TestAndBench<float>({64, 1, 128}, {1, 32, 128});
+  TestAndBench<float>({2, 3, 1, 5}, {2, 1, 4, 1});
+  TestAndBench<int>({1, 1, 1}, {3, 4, 5});
+  TestAndBench<int>({1}, {1});
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,163 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/cpu_layer_norm.h"
+
+namespace phi {
+namespace tests {
+
+template <typename T>
+void RandomVec(const int64_t n, T* a, T offset) {
+  static unsigned int seed = 100;
+  std::mt19937 rng(seed++);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  for (int64_t i = 0; i < n; ++i) {
+    a[i] = static_cast<T>(dist(rng)) + offset;
+  }
+}
+
+// The unfused layer_norm computed in double by two passes.
+template <typename T>
+void RefLayerNorm(const std::vector<T>& x,
+                  const std::vector<T>& scale,
+                  const std::vector<T>& bias,
+                  const std::vector<T>& dy,
+                  int64_t left,
+                  int64_t right,
+                  double epsilon,
+                  std::vector<double>* y,
+                  std::vector<double>* mean,
+                  std::vector<double>* var,
+                  std::vector<double>* dx,
+                  std::vector<double>* d_scale,
+                  std::vector<double>* d_bias) {
+  d_scale->assign(right, 0.0);
+  d_bias->assign(right, 0.0);
+  for (int64_t i = 0; i < left; ++i) {
+    const T* px = x.data() + i * right;
+    const T* pdy = dy.data() + i * right;
+    double m = 0, v = 0;
+    for (int64_t j = 0; j < right; ++j) m += px[j];
+    m /= right;
+    for (int64_t j = 0; j < right; ++j) v += (px[j] - m) * (px[j] - m);
+    v /= right;
+    (*mean)[i] = m;
+    (*var)[i] = v;
+    const double rstd = 1.0 / std::sqrt(v + epsilon);
+    double mean_g = 0, mean_g_norm = 0;
+    for (int64_t j = 0; j < right; ++j) {
+      const double x_norm = (px[j] - m) * rstd;
+      (*y)[i * right + j] = x_norm * scale[j] + bias[j];
+      (*d_scale)[j] += pdy[j] * x_norm;
+      (*d_bias)[j] += pdy[j];
+      mean_g += pdy[j] * scale[j];
+      mean_g_norm += pdy[j] * scale[j] * x_norm;
+    }
+    mean_g /= right;
+    mean_g_norm /= right;
+    for (int64_t j = 0; j < right; ++j) {
+      const double x_norm = (px[j] - m) * rstd;
+      (*dx)[i * right + j] =
+          (pdy[j] * scale[j] - mean_g - x_norm * mean_g_norm) * rstd;
+    }
+  }
+}
+
+template <typename T>
+void TestLayerNorm(int64_t left, int64_t right, T offset, double tolerance) {
+  std::vector<T> x(left * right), dy(left * right), scale(right), bias(right);
+  RandomVec<T>(x.size(), x.data(), offset);
+  RandomVec<T>(dy.size(), dy.data(), static_cast<T>(0));
+  RandomVec<T>(right, scale.data(), static_cast<T>(1));
+  RandomVec<T>(right, bias.data(), static_cast<T>(0));
+  const T epsilon = static_cast<T>(1e-5);
+
+  std::vector<double> y_ref(left * right), mean_ref(left), var_ref(left);
+  std::vector<double> dx_ref(left * right), d_scale_ref, d_bias_ref;
+  RefLayerNorm(x,
+               scale,
+               bias,
+               dy,
+               left,
+               right,
+               epsilon,
+               &y_ref,
+               &mean_ref,
+               &var_ref,
+               &dx_ref,
+               &d_scale_ref,
+               &d_bias_ref);
+
+  phi::CPUContext ctx;
+  std::vector<T> y(left * right), mean(left), var(left);
+  std::vector<T> dx(left * right), d_scale(right), d_bias(right);
+  funcs::LayerNormForwardCPU<T>(ctx,
+                                x.data(),
+                                scale.data(),
+                                bias.data(),
+                                left,
+                                right,
+                                epsilon,
+                                y.data(),
+                                mean.data(),
+                                var.data());
+  funcs::LayerNormBackwardCPU<T>(ctx,
+                                 x.data(),
+                                 mean.data(),
+                                 var.data(),
+                                 dy.data(),
+                                 scale.data(),
+                                 left,
+                                 right,
+                                 epsilon,
+                                 dx.data(),
+                                 d_scale.data(),
+                                 d_bias.data());
+
+  for (int64_t i = 0; i < left; ++i) {
+    EXPECT_NEAR(mean[i], mean_ref[i], tolerance * (1 + std::abs(offset)));
+    EXPECT_NEAR(var[i], var_ref[i], tolerance);
+  }
+  for (int64_t i = 0; i < left * right; ++i) {
+    EXPECT_NEAR(y[i], y_ref[i], tolerance);
+    EXPECT_NEAR(dx[i], dx_ref[i], tolerance);
+  }
+  for (int64_t j = 0; j < right; ++j) {
+    EXPECT_NEAR(d_scale[j], d_scale_ref[j], tolerance * left);
+    EXPECT_NEAR(d_bias[j], d_bias_ref[j], tolerance * left);
+  }
+}
+
+TEST(CpuLayerNormTest, float) {
+  TestLayerNorm<float>(1, 1, 0.f, 1e-4);
+  TestLayerNorm<float>(3, 7, 0.f, 1e-4);
+  TestLayerNorm<float>(128, 768, 0.f, 1e-4);
+  TestLayerNorm<float>(1000, 37, 0.f, 1e-4);
+  // Rows with a large mean are where a single-pass sum of squares fails.
+  TestLayerNorm<float>(64, 1024, 1000.f, 1e-2);
+}
+
+TEST(CpuLayerNormTest, double) {
+  TestLayerNorm<double>(5, 9, 0.0, 1e-10);
+  TestLayerNorm<double>(256, 512, 100.0, 1e-8);
+}
+
+}  // namespace tests
+}  // namespace phi
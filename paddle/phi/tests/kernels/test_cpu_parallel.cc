@@ -0,0 +1,112 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
+
+namespace phi {
+namespace tests {
+
+namespace cpu = phi::backends::cpu;
+
+TEST(CpuParallelTest, cover_range_once) {
+  phi::CPUContext ctx;
+  cpu::SetIntraOpNumThreads(4);
+  for (int64_t n : {0, 1, 7, 100, 1001}) {
+    for (int64_t grain : {1, 3, 64, 2000}) {
+      std::vector<int> hits(n, 0);
+      ctx.ParallelFor(5, 5 + n, grain, [&](int64_t begin, int64_t end) {
+        EXPECT_LT(begin, end);
+        for (int64_t i = begin; i < end; ++i) {
+          ++hits[i - 5];
+        }
+      });
+      for (int64_t i = 0; i < n; ++i) {
+        EXPECT_EQ(hits[i], 1);
+      }
+    }
+  }
+  cpu::SetIntraOpNumThreads(0);
+}
+
+TEST(CpuParallelTest, chunk_num) {
+  cpu::SetIntraOpNumThreads(4);
+  EXPECT_EQ(cpu::GetIntraOpNumThreads(), 4);
+  EXPECT_EQ(cpu::GetIntraOpChunkNum(0, 0, 1), 1);
+  EXPECT_EQ(cpu::GetIntraOpChunkNum(0, 10, 100), 1);
+  EXPECT_EQ(cpu::GetIntraOpChunkNum(0, 300, 100), 3);
+  EXPECT_EQ(cpu::GetIntraOpChunkNum(0, 1000, 1), 4);
+
+  // Chunks are of equal size except the last one.
+  std::atomic<int> num_chunks{0};
+  cpu::IntraOpParallelFor(0, 1000, 1, [&](int64_t begin, int64_t end) {
+    EXPECT_EQ(begin % 250, 0);
+    EXPECT_EQ(end - begin, 250);
+    ++num_chunks;
+  });
+  EXPECT_EQ(num_chunks, 4);
+
+  cpu::SetIntraOpNumThreads(1);
+  EXPECT_EQ(cpu::GetIntraOpChunkNum(0, 1000, 1), 1);
+  cpu::SetIntraOpNumThreads(0);
+}
+
+TEST(CpuParallelTest, nested_loop_is_serial) {
+  phi::CPUContext ctx;
+  cpu::SetIntraOpNumThreads(4);
+  EXPECT_FALSE(cpu::InIntraOpParallelRegion());
+  std::atomic<int64_t> sum{0};
+  ctx.ParallelFor(0, 8, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      EXPECT_EQ(cpu::GetIntraOpChunkNum(0, 1000, 1), 1);
+      ctx.ParallelFor(0, 100, 1, [&](int64_t inner_begin, int64_t inner_end) {
+        EXPECT_EQ(inner_begin, 0);
+        EXPECT_EQ(inner_end, 100);
+        sum += inner_end - inner_begin;
+      });
+    }
+  });
+  EXPECT_EQ(sum, 800);
+  EXPECT_FALSE(cpu::InIntraOpParallelRegion());
+  cpu::SetIntraOpNumThreads(0);
+}
+
+TEST(CpuParallelTest, rethrow_exception) {
+  phi::CPUContext ctx;
+  cpu::SetIntraOpNumThreads(4);
+  EXPECT_THROW(ctx.ParallelFor(0,
+                               1000,
+                               1,
+                               [](int64_t begin, int64_t end) {
+                                 if (begin <= 600 && 600 < end) {
+                                   throw std::runtime_error("bad index");
+                                 }
+                               }),
+               std::runtime_error);
+  // The pool is still usable after an exception.
+  std::atomic<int64_t> count{0};
+  ctx.ParallelFor(0, 1000, 1, [&](int64_t begin, int64_t end) {
+    count += end - begin;
+  });
+  EXPECT_EQ(count, 1000);
+  cpu::SetIntraOpNumThreads(0);
+}
+
+}  // namespace tests
+}  // namespace phi
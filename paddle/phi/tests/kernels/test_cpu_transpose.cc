@@ -0,0 +1,134 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <sys/time.h>
+
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
+#include "paddle/phi/common/complex.h"
+#include "paddle/phi/common/float16.h"
+#include "paddle/phi/kernels/funcs/math_function.h"
+
+namespace phi {
+namespace tests {
+
+inline double GetCurrentUS() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return 1e+6 * time.tv_sec + time.tv_usec;
+}
+
+// The element-by-element implementation replaced by TransposeCPU.
+template <typename T>
+void RefTranspose(const DenseTensor& in,
+                  const std::vector<int>& axis,
+                  DenseTensor* out) {
+  const int rank = axis.size();
+  auto in_stride = phi::stride(in.dims());
+  auto out_stride = phi::stride(out->dims());
+  const T* in_ptr = in.data<T>();
+  T* out_ptr = out->data<T>();
+  for (int64_t out_idx = 0; out_idx < out->numel(); ++out_idx) {
+    int64_t in_idx = 0;
+    int64_t tmp_idx = out_idx;
+    for (int i = 0; i < rank; ++i) {
+      const int64_t coordinate = tmp_idx / out_stride[i];
+      tmp_idx -= coordinate * out_stride[i];
+      in_idx += coordinate * in_stride[axis[i]];
+    }
+    out_ptr[out_idx] = in_ptr[in_idx];
+  }
+}
+
+template <typename T>
+void TestTranspose(const std::vector<int64_t>& dims,
+                   const std::vector<int>& axis) {
+  phi::CPUPlace place;
+  phi::CPUContext context(place);
+  std::vector<int64_t> out_dims(dims.size());
+  for (size_t i = 0; i < axis.size(); ++i) {
+    out_dims[i] = dims[axis[i]];
+  }
+  DenseTensor in, out, out_ref;
+  T* in_data = in.mutable_data<T>(phi::make_ddim(dims), place);
+  out.mutable_data<T>(phi::make_ddim(out_dims), place);
+  out_ref.mutable_data<T>(phi::make_ddim(out_dims), place);
+  for (int64_t i = 0; i < in.numel(); ++i) {
+    in_data[i] = static_cast<T>(i % 251);
+  }
+
+  auto st = GetCurrentUS();
+  RefTranspose<T>(in, axis, &out_ref);
+  auto mt = GetCurrentUS();
+  phi::funcs::TransCompute<phi::CPUContext, T>(
+      axis.size(), context, in, &out, axis);
+  auto et = GetCurrentUS();
+  VLOG(3) << "Transpose [" << in.dims() << "] with " << axis.size()
+          << " axes: refer takes: " << mt - st << " us, tgt takes: " << et - mt
+          << " us.";
+
+  const T* out_data = out.data<T>();
+  const T* out_ref_data = out_ref.data<T>();
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    ASSERT_EQ(out_data[i], out_ref_data[i]) << "at " << i;
+  }
+}
+
+template <typename T>
+void TestTransposeShapes() {
+  // Innermost axis kept.
+  TestTranspose<T>({4, 5, 6}, {1, 0, 2});
+  // 2D plane, with sizes below, equal to and above a block.
+  TestTranspose<T>({3, 7}, {1, 0});
+  TestTranspose<T>({32, 32}, {1, 0});
+  TestTranspose<T>({67, 45}, {1, 0});
+  // NCHW <-> NHWC
+  TestTranspose<T>({2, 3, 17, 19}, {0, 2, 3, 1});
+  TestTranspose<T>({2, 17, 19, 3}, {0, 3, 1, 2});
+  // Attention heads: [B, S, H, D] -> [B, H, S, D] and [B, H, D, S].
+  TestTranspose<T>({2, 33, 4, 16}, {0, 2, 1, 3});
+  TestTranspose<T>({2, 33, 4, 16}, {0, 2, 3, 1});
+  // Axes of size one and identity permutations.
+  TestTranspose<T>({1, 9, 1, 10}, {3, 2, 1, 0});
+  TestTranspose<T>({5, 6, 7}, {0, 1, 2});
+  // Rank above 6 goes through TransposeNormal.
+  TestTranspose<T>({2, 3, 2, 3, 2, 3, 5}, {6, 4, 2, 0, 1, 3, 5});
+}
+
+TEST(CpuTransposeTest, float) { TestTransposeShapes<float>(); }
+
+TEST(CpuTransposeTest, double) { TestTransposeShapes<double>(); }
+
+TEST(CpuTransposeTest, float16) { TestTransposeShapes<phi::dtype::float16>(); }
+
+TEST(CpuTransposeTest, int8) { TestTransposeShapes<int8_t>(); }
+
+TEST(CpuTransposeTest, complex128) {
+  TestTransposeShapes<phi::dtype::complex<double>>();
+}
+
+TEST(CpuTransposeTest, multi_thread) {
+  phi::backends::cpu::SetIntraOpNumThreads(4);
+  TestTranspose<float>({64, 512, 512}, {0, 2, 1});
+  TestTranspose<float>({32, 128, 12, 64}, {0, 2, 1, 3});
+  TestTranspose<int8_t>({8, 3, 224, 224}, {0, 2, 3, 1});
+  TestTranspose<double>({3, 4, 5, 6, 7, 8, 9}, {1, 0, 6, 2, 5, 3, 4});
+  phi::backends::cpu::SetIntraOpNumThreads(0);
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,147 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_parallel.h"
+#include "paddle/phi/kernels/funcs/cpu_weight_only_gemm.h"
+
+namespace phi {
+namespace tests {
+
+template <typename T>
+void RandomVec(const int64_t n, T* a) {
+  static unsigned int seed = 100;
+  std::mt19937 rng(seed++);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  for (int64_t i = 0; i < n; ++i) {
+    a[i] = static_cast<T>(dist(rng));
+  }
+}
+
+TEST(CpuWeightOnlyGemmTest, quantize) {
+  for (int bits : {8, 4}) {
+    for (int64_t k : {1, 2, 7, 64}) {
+      const int64_t n = 5;
+      std::vector<float> w(k * n);
+      RandomVec<float>(w.size(), w.data());
+      // Channel 3 is all zero.
+      for (int64_t i = 0; i < k; ++i) {
+        w[i * n + 3] = 0.f;
+      }
+      std::vector<int8_t> qw(n * funcs::WeightOnlyRowBytes(k, bits));
+      std::vector<float> scale(n);
+      funcs::WeightOnlyQuantize<float>(
+          w.data(), k, n, false, bits, qw.data(), scale.data());
+
+      std::vector<float> row(k);
+      const int qmax = funcs::WeightOnlyQMax(bits);
+      for (int64_t j = 0; j < n; ++j) {
+        funcs::WeightOnlyDecodeRow(qw.data() + j * (qw.size() / n),
+                                   k,
+                                   bits,
+                                   row.data());
+        float abs_max = 0.f;
+        for (int64_t i = 0; i < k; ++i) {
+          EXPECT_LE(std::abs(row[i]), qmax);
+          EXPECT_NEAR(row[i] * scale[j], w[i * n + j], scale[j] / 2 + 1e-6);
+          abs_max = std::max(abs_max, std::abs(w[i * n + j]));
+        }
+        EXPECT_FLOAT_EQ(scale[j], abs_max / qmax);
+      }
+    }
+  }
+}
+
+template <typename T>
+void TestWeightOnlyGemm(
+    int64_t m, int64_t n, int64_t k, int bits, bool with_bias, bool relu) {
+  std::vector<T> x(m * k), w(k * n), bias(n);
+  RandomVec<T>(x.size(), x.data());
+  RandomVec<T>(w.size(), w.data());
+  RandomVec<T>(n, bias.data());
+  std::vector<int8_t> qw(n * funcs::WeightOnlyRowBytes(k, bits));
+  std::vector<float> scale(n);
+  funcs::WeightOnlyQuantize<T>(
+      w.data(), k, n, false, bits, qw.data(), scale.data());
+
+  // Reference on the dequantized weight in double.
+  std::vector<double> w_deq(k * n);
+  std::vector<T> row(k);
+  for (int64_t j = 0; j < n; ++j) {
+    funcs::WeightOnlyDecodeRow(
+        qw.data() + j * (qw.size() / n), k, bits, row.data());
+    for (int64_t i = 0; i < k; ++i) {
+      w_deq[i * n + j] = static_cast<double>(row[i]) * scale[j];
+    }
+  }
+
+  phi::CPUContext ctx;
+  std::vector<T> out(m * n);
+  funcs::WeightOnlyGemmCPU<T>(ctx,
+                              x.data(),
+                              qw.data(),
+                              scale.data(),
+                              with_bias ? bias.data() : nullptr,
+                              m,
+                              n,
+                              k,
+                              bits,
+                              relu,
+                              out.data());
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      double ref = with_bias ? bias[j] : 0.0;
+      for (int64_t p = 0; p < k; ++p) {
+        ref += static_cast<double>(x[i * k + p]) * w_deq[p * n + j];
+      }
+      if (relu && ref < 0) {
+        ref = 0;
+      }
+      EXPECT_NEAR(out[i * n + j], ref, 1e-4 * k) << i << " " << j;
+    }
+  }
+}
+
+TEST(CpuWeightOnlyGemmTest, gemv) {
+  for (int bits : {8, 4}) {
+    TestWeightOnlyGemm<float>(1, 1, 1, bits, false, false);
+    TestWeightOnlyGemm<float>(1, 37, 129, bits, true, false);
+    TestWeightOnlyGemm<float>(3, 64, 256, bits, true, true);
+    TestWeightOnlyGemm<float>(16, 7, 33, bits, false, true);
+    TestWeightOnlyGemm<double>(2, 9, 17, bits, true, false);
+  }
+}
+
+TEST(CpuWeightOnlyGemmTest, gemm) {
+  for (int bits : {8, 4}) {
+    TestWeightOnlyGemm<float>(17, 70, 65, bits, true, true);
+    TestWeightOnlyGemm<float>(64, 128, 32, bits, false, false);
+  }
+}
+
+TEST(CpuWeightOnlyGemmTest, multi_thread) {
+  phi::backends::cpu::SetIntraOpNumThreads(4);
+  TestWeightOnlyGemm<float>(4, 1023, 512, 8, true, false);
+  TestWeightOnlyGemm<float>(4, 1023, 511, 4, true, false);
+  TestWeightOnlyGemm<float>(33, 200, 64, 4, true, true);
+  phi::backends::cpu::SetIntraOpNumThreads(0);
+}
+
+}  // namespace tests
+}  // namespace phi
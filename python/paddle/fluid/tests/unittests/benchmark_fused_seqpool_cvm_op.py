@@ -0,0 +1,121 @@
+#   Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import time
+import unittest
+
+import numpy as np
+
+import paddle
+from paddle import fluid
+from paddle.fluid import core
+
+# Compares the CPU fused_seqpool_cvm op with the unfused sequence_pool, cvm
+# and concat ops on CTR-like slots, forward and backward.
+
+
+class BenchmarkFusedSeqpoolCVM(unittest.TestCase):
+    def setUp(self):
+        self.slot_num = 26
+        self.batch_size = 512
+        self.w = 11
+        self.max_seq_len = 10
+        self.iters = 100
+
+    def build_program(self, fused, use_cvm):
+        main_program = fluid.Program()
+        with fluid.program_guard(main_program, fluid.Program()):
+            xs = [
+                paddle.static.data(
+                    name='x_{0}'.format(i),
+                    shape=[-1, self.w],
+                    dtype='float32',
+                    lod_level=1,
+                )
+                for i in range(self.slot_num)
+            ]
+            for x in xs:
+                x.stop_gradient = False
+            cvm = paddle.static.data(name='cvm', shape=[-1, 2], dtype='float32')
+            cvm.stop_gradient = True
+            if fused:
+                outs = fluid.contrib.layers.fused_seqpool_cvm(
+                    xs, 'sum', cvm, use_cvm=use_cvm
+                )
+            else:
+                outs = [
+                    paddle.static.nn.continuous_value_model(
+                        fluid.layers.sequence_pool(x, 'sum'), cvm, use_cvm
+                    )
+                    for x in xs
+                ]
+            out = paddle.concat(outs, axis=1)
+            loss = paddle.sum(out)
+            grads = paddle.static.gradients(loss, xs)
+        return main_program, [out] + grads
+
+    def make_feed(self, place):
+        bs = self.batch_size
+        feed = {
+            'cvm': np.random.uniform(0.1, 1, [bs, 2]).astype('float32'),
+        }
+        for i in range(self.slot_num):
+            lod = np.random.randint(1, self.max_seq_len + 1, bs).tolist()
+            x = np.random.uniform(0.1, 1, [sum(lod), self.w]).astype('float32')
+            feed['x_{0}'.format(i)] = fluid.create_lod_tensor(x, [lod], place)
+        return feed
+
+    def timeit(self, exe, program, feed, fetch_list):
+        results = exe.run(program, feed=feed, fetch_list=fetch_list)
+        start = time.time()
+        for _ in range(self.iters):
+            exe.run(program, feed=feed, fetch_list=fetch_list)
+        return (time.time() - start) / self.iters, results
+
+    def run_benchmark(self, use_cvm):
+        paddle.enable_static()
+        place = core.CPUPlace()
+        exe = fluid.Executor(place)
+        feed = self.make_feed(place)
+        costs = {}
+        results = {}
+        for fused in (False, True):
+            program, fetch_list = self.build_program(fused, use_cvm)
+            costs[fused], results[fused] = self.timeit(
+                exe, program, feed, fetch_list
+            )
+        for unfused_out, fused_out in zip(results[False], results[True]):
+            np.testing.assert_allclose(
+                np.array(fused_out), np.array(unfused_out), rtol=1e-5
+            )
+        print(
+            'use_cvm={}: sequence_pool+cvm+concat {:.3f} ms, '
+            'fused_seqpool_cvm {:.3f} ms, speedup {:.2f}x'.format(
+                use_cvm,
+                costs[False] * 1000,
+                costs[True] * 1000,
+                costs[False] / costs[True],
+            )
+        )
+        paddle.disable_static()
+
+    def test_use_cvm(self):
+        self.run_benchmark(use_cvm=True)
+
+    def test_no_cvm(self):
+        self.run_benchmark(use_cvm=False)
+
+
+if __name__ == '__main__':
+    unittest.main()
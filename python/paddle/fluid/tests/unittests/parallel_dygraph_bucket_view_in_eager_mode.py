@@ -0,0 +1,111 @@
+# Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+
+import paddle
+import paddle.distributed as dist
+import paddle.fluid as fluid
+from paddle.nn import Linear
+
+paddle.seed(1024)
+np.random.seed(2021)
+
+batch = 5
+in_dim = 64
+hidden_dim = 128
+out_dim = 10
+
+
+class SimpleNet(fluid.Layer):
+    def __init__(self):
+        super().__init__()
+        self.linears = paddle.nn.LayerList(
+            [Linear(in_dim, hidden_dim)]
+            + [Linear(hidden_dim, hidden_dim) for _ in range(4)]
+            + [Linear(hidden_dim, out_dim)]
+        )
+
+    def forward(self, x):
+        for linear in self.linears:
+            x = paddle.tanh(linear(x))
+        return x
+
+
+class TestDistTraning(unittest.TestCase):
+    def test_multiple_cpus(self):
+        self.trainer_id = dist.get_rank()
+        self.pg = dist.init_parallel_env()
+
+        model_a = SimpleNet()
+        model_b = SimpleNet()
+        model_b.set_state_dict(model_a.state_dict())
+
+        # model_a uses the reducer of concat and split, model_b the bucket
+        # views, allreduced in chunks of 1KB and regrouped after two steps.
+        model_a = paddle.DataParallel(
+            model_a, comm_buffer_size=0.1, group=self.pg
+        )
+        paddle.set_flags(
+            {
+                'FLAGS_eager_reducer_cpu_comm_overlap': True,
+                'FLAGS_eager_reducer_chunk_size_kb': 1,
+                'FLAGS_eager_reducer_rebuild_steps': 2,
+            }
+        )
+        model_b = paddle.DataParallel(
+            model_b, comm_buffer_size=0.1, group=self.pg
+        )
+        paddle.set_flags(
+            {
+                'FLAGS_eager_reducer_cpu_comm_overlap': False,
+                'FLAGS_eager_reducer_chunk_size_kb': 1024,
+                'FLAGS_eager_reducer_rebuild_steps': 0,
+            }
+        )
+
+        opt_a = paddle.optimizer.SGD(0.1, parameters=model_a.parameters())
+        opt_b = paddle.optimizer.SGD(0.1, parameters=model_b.parameters())
+
+        for step_id in range(6):
+            x = paddle.to_tensor(
+                np.random.rand(batch, in_dim).astype('float32')
+                * (self.trainer_id + 1)
+            )
+            model_a(x).sum().backward()
+            model_b(x).sum().backward()
+
+            for param_a, param_b in zip(
+                model_a.parameters(), model_b.parameters()
+            ):
+                np.testing.assert_array_equal(
+                    param_a.grad.numpy(), param_b.grad.numpy()
+                )
+
+            opt_a.step()
+            opt_b.step()
+            # Accumulate the grads of two steps, which are added to the
+            # bucket views in place.
+            if step_id % 2 == 1:
+                opt_a.clear_grad()
+                opt_b.clear_grad()
+
+        for param_a, param_b in zip(model_a.parameters(), model_b.parameters()):
+            np.testing.assert_array_equal(param_a.numpy(), param_b.numpy())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,132 @@
+#   Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+from op_test import OpTest
+from sequence.test_sequence_pool import compute_seqpool_sum
+from test_cvm_op import cvm_compute
+from test_fusion_seqpool_cvm_concat_op import convert_to_offset
+
+import paddle
+from paddle import fluid
+from paddle.fluid import core
+
+
+class TestFusedSeqpoolCVMOp(OpTest):
+    def setUp(self):
+        self.w = 11
+        self.use_cvm = True
+        self.lods = [[[2, 3, 5]], [[1, 5, 2]]]
+        self.set_conf()
+        self.op_type = 'fused_seqpool_cvm'
+        bs = len(self.lods[0][0])
+        inputs = []
+        outs = []
+        cvm = np.random.uniform(0.1, 1, [bs, 2]).astype("float32")
+        for i, lod in enumerate(self.lods):
+            x = np.random.uniform(0.1, 1, [sum(lod[0]), self.w]).astype(
+                'float32'
+            )
+            offset = convert_to_offset(lod)
+            out = np.zeros((bs, self.w)).astype('float32')
+            compute_seqpool_sum(x, offset, out)
+            out = cvm_compute(out, self.w, self.use_cvm)
+            inputs.append(('x_{0}'.format(i), (x, lod)))
+            outs.append(('out_{0}'.format(i), out))
+
+        self.inputs = {'X': inputs, 'CVM': cvm}
+        self.outputs = {'Out': outs}
+        self.attrs = {
+            'pooltype': 'SUM',
+            'use_cvm': self.use_cvm,
+            'cvm_offset': 2,
+        }
+
+    def set_conf(self):
+        pass
+
+    def test_check_output(self):
+        self.check_output_with_place(core.CPUPlace())
+
+
+class TestFusedSeqpoolCVMOpCase1(TestFusedSeqpoolCVMOp):
+    def set_conf(self):
+        self.lods = [[[1, 0, 4, 6]], [[0, 3, 4, 1]], [[2, 2, 2, 2]]]
+        self.w = 10
+
+
+class TestFusedSeqpoolCVMOpNoCVM(TestFusedSeqpoolCVMOp):
+    def set_conf(self):
+        self.use_cvm = False
+
+
+class TestFusedSeqpoolCVMGrad(unittest.TestCase):
+    def check_grad(self, use_cvm):
+        paddle.enable_static()
+        w = 6
+        lods = [[2, 0, 3], [1, 4, 1]]
+        bs = len(lods[0])
+        main_program = fluid.Program()
+        with fluid.program_guard(main_program, fluid.Program()):
+            xs = [
+                paddle.static.data(
+                    name='x_{0}'.format(i),
+                    shape=[-1, w],
+                    dtype='float32',
+                    lod_level=1,
+                )
+                for i in range(len(lods))
+            ]
+            for x in xs:
+                x.stop_gradient = False
+            cvm = paddle.static.data(name='cvm', shape=[-1, 2], dtype='float32')
+            cvm.stop_gradient = True
+            outs = fluid.contrib.layers.fused_seqpool_cvm(
+                xs, 'sum', cvm, use_cvm=use_cvm
+            )
+            loss = paddle.add_n([paddle.sum(out) for out in outs])
+            grads = paddle.static.gradients(loss, xs)
+
+        place = core.CPUPlace()
+        cvm_data = np.random.uniform(0.1, 1, [bs, 2]).astype("float32")
+        feed = {'cvm': cvm_data}
+        for i, lod in enumerate(lods):
+            x_data = np.random.uniform(0.1, 1, [sum(lod), w]).astype('float32')
+            feed['x_{0}'.format(i)] = fluid.create_lod_tensor(
+                x_data, [lod], place
+            )
+        exe = fluid.Executor(place)
+        results = exe.run(main_program, feed=feed, fetch_list=grads)
+        for lod, grad in zip(lods, results):
+            # the show and click of the instance, and the grad of the sum
+            rows = [
+                np.concatenate([cvm_data[i], np.ones(w - 2)]) for i in range(bs)
+            ]
+            expected = np.concatenate(
+                [np.tile(rows[i], (n, 1)) for i, n in enumerate(lod)]
+            )
+            np.testing.assert_allclose(np.array(grad), expected, rtol=1e-6)
+        paddle.disable_static()
+
+    def test_grad(self):
+        self.check_grad(use_cvm=True)
+
+    def test_grad_no_cvm(self):
+        self.check_grad(use_cvm=False)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -71,6 +71,36 @@ class TestSparseConv(unittest.TestCase):
         )
         assert np.array_equal(sparse_x.indices().numpy(), y.indices().numpy())
 
+    def test_subm_conv3d_reuse_rulebook(self):
+        # the subm convs of the same geometry without a key reuse the
+        # rulebook of the first one, the same as with a key
+        paddle.seed(0)
+        x = paddle.randn([2, 4, 4, 4, 2])
+        x = paddle.nn.functional.relu(x)
+        weights = [
+            paddle.randn((3, 3, 3, 2, 2), dtype='float32') for _ in range(3)
+        ]
+
+        def forward(key):
+            sp_x = x.detach().to_sparse_coo(4)
+            sp_x.stop_gradient = False
+            y = sp_x
+            for weight in weights:
+                y = paddle.sparse.nn.functional.subm_conv3d(y, weight, key=key)
+            y.backward(y)
+            return y, sp_x.grad
+
+        out, x_grad = forward(None)
+        expected_out, expected_x_grad = forward('subm_conv')
+        np.testing.assert_allclose(
+            out.values().numpy(), expected_out.values().numpy(), rtol=1e-5
+        )
+        np.testing.assert_allclose(
+            x_grad.values().numpy(),
+            expected_x_grad.values().numpy(),
+            rtol=1e-5,
+        )
+
     def test_Conv3D(self):
         # (4, non_zero_num), 4-D:(N, D, H, W)
         indices = [[0, 0, 0, 0], [0, 0, 0, 0], [0, 0, 1, 2], [1, 3, 2, 3]]
@@ -115,5 +115,20 @@ class TestCooMv(unittest.TestCase):
         )
 
 
+class TestMvCPU(unittest.TestCase):
+    def setUp(self):
+        self.device = paddle.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.device)
+
+    def test_csr_mv(self):
+        TestCsrMv.test_mv(self)
+
+    def test_coo_mv(self):
+        TestCooMv.test_mv(self)
+
+
 if __name__ == "__main__":
     unittest.main()